@@ -21,6 +21,12 @@
 #ifndef VOTCA_XTP_ERIS_H
 #define VOTCA_XTP_ERIS_H
 
+// Standard includes
+#include <array>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 // Local VOTCA includes
 #include "fourcenter.h"
 #include "threecenter.h"
@@ -38,15 +44,37 @@ namespace xtp {
 class ERIs {
 
  public:
-  void Initialize(const AOBasis& dftbasis, const AOBasis& auxbasis);
+  // three-center integrals larger than max_memory_mb are stored in a scratch
+  // file in scratchdir, max_memory_mb<=0 means the physical memory. Blocks
+  // with a Schwarz bound below screening_eps are skipped.
+  void Initialize(const AOBasis& dftbasis, const AOBasis& auxbasis,
+                  double max_memory_mb = 0.0,
+                  const std::string& scratchdir = ".",
+                  double screening_eps = 1e-12);
   void Initialize_4c_small_molecule(const AOBasis& dftbasis);
   void Initialize_4c_screening(const AOBasis& dftbasis,
                                double eps);  // Pre-screening
+  // shell quartets are screened with Schwarz bounds and density magnitudes,
+  // the most expensive quartets are cached up to max_memory_mb
+  void Initialize_4c_semidirect(const AOBasis& dftbasis, double eps,
+                                double max_memory_mb);
 
   Mat_p_Energy CalculateERIs(const Eigen::MatrixXd& DMAT) const;
+  // coefficients of DMAT fitted into the aux basis, orthonormalized with
+  // the inverse square root of the aux Coulomb metric
+  Eigen::VectorXd FitDensity(const Eigen::MatrixXd& DMAT) const;
+  // Coulomb matrix of a density given by coefficients from FitDensity, the
+  // aux basis has to be the one used for the fit
+  Eigen::MatrixXd ContractFit(const Eigen::VectorXd& coefficients) const;
   Mat_p_Energy CalculateEXX(const Eigen::MatrixXd& DMAT) const;
   Mat_p_Energy CalculateEXX(const Eigen::MatrixXd& occMos,
                             const Eigen::MatrixXd& DMAT) const;
+  // Coulomb and exchange matrices of a density difference dDMAT, used for
+  // incremental Fock builds, contributions smaller than eps are skipped
+  Eigen::MatrixXd CalculateERIs_diff(const Eigen::MatrixXd& dDMAT,
+                                     double eps) const;
+  Eigen::MatrixXd CalculateEXX_diff(const Eigen::MatrixXd& dDMAT,
+                                    double eps) const;
   Mat_p_Energy CalculateERIs_4c_small_molecule(
       const Eigen::MatrixXd& DMAT) const;
   Mat_p_Energy CalculateEXX_4c_small_molecule(
@@ -55,10 +83,30 @@ class ERIs {
   Mat_p_Energy CalculateERIs_4c_direct(const AOBasis& dftbasis,
                                        const Eigen::MatrixXd& DMAT) const;
 
+  // Coulomb (first) and exchange (second) matrix from one pass over the
+  // shell quartets, with_exchange=false only builds the Coulomb matrix
+  std::pair<Mat_p_Energy, Mat_p_Energy> CalculateERIs_EXX_4c_semidirect(
+      const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT,
+      bool with_exchange) const;
+  // unrestricted version, Coulomb matrix of DMAT_alpha+DMAT_beta followed by
+  // the exchange matrices of DMAT_alpha and DMAT_beta, from one pass
+  std::array<Eigen::MatrixXd, 3> CalculateERIs_EXX_4c_semidirect(
+      const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT_alpha,
+      const Eigen::MatrixXd& DMAT_beta) const;
+  Index CachedQuartets() const { return Index(_quartet_cache.size()); }
+
   Index Removedfunctions() const { return _threecenter.Removedfunctions(); }
+  bool ThreeCenterInCore() const { return _threecenter.isInCore(); }
+
+  // memory for one batch of unpacked and half-transformed three-center
+  // integrals in the RI exchange build
+  void setExchangeBatchMemory(double max_memory_mb) {
+    _exchange_batch_memory = max_memory_mb;
+  }
 
  private:
   bool _with_screening = false;
+  double _exchange_batch_memory = 256.0;
   double _screening_eps;
   Eigen::MatrixXd _diagonals;  // Square matrix containing <ab|ab> for all basis
                                // functions a, b
@@ -71,8 +119,40 @@ class ERIs {
   TCMatrix_dft _threecenter;
   FCMatrix _fourcenter;
 
+  struct ShellPair {
+    Index shell_1;  // shell_1>=shell_2
+    Index shell_2;
+    double schwarz;  // sqrt(max (ab|ab))
+  };
+  // significant shell pairs sorted by descending Schwarz bound
+  std::vector<ShellPair> _shellpairs;
+  // cached quartets (p,q) with q>=p, key is p*_shellpairs.size()+q
+  std::unordered_map<Index, Index> _quartet_index;
+  std::vector<Eigen::Tensor<double, 4>> _quartet_cache;
+
+  Eigen::Tensor<double, 4> ComputeQuartet(const AOBasis& dftbasis,
+                                          const ShellPair& pair_ab,
+                                          const ShellPair& pair_cd) const;
+  // Coulomb matrix of DMAT_J followed by the exchange matrices of DMATs_K
+  std::vector<Eigen::MatrixXd> ContractSemidirect(
+      const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT_J,
+      const std::vector<const Eigen::MatrixXd*>& DMATs_K) const;
+  // maximum absolute element of each shell block of DMAT
+  Eigen::MatrixXd ShellBlockMax(const AOBasis& dftbasis,
+                                const Eigen::MatrixXd& DMAT) const;
+
   double CalculateEnergy(const Eigen::MatrixXd& DMAT,
                          const Eigen::MatrixXd& matrix_operator) const;
+  // packs the lower triangle of a symmetric matrix in the pair order of
+  // TCMatrix_dft, off-diagonal elements are counted twice
+  Eigen::VectorXd PackDensity(const Eigen::MatrixXd& DMAT) const;
+  Eigen::MatrixXd UnpackMatrix(const Eigen::VectorXd& packed,
+                               Index dim) const;
+  Eigen::MatrixXd ContractRI(const Eigen::MatrixXd& DMAT, double eps) const;
+  Eigen::MatrixXd ContractExchange(const Eigen::MatrixXd& positive,
+                                   const Eigen::MatrixXd& negative) const;
+  std::pair<Eigen::MatrixXd, Eigen::MatrixXd> SplitDensity(
+      const Eigen::MatrixXd& DMAT, double eps) const;
   template <bool transposed_block>
   void FillERIsBlock(Eigen::MatrixXd& ERIsCur, const Eigen::MatrixXd& DMAT,
                      const Eigen::Tensor<double, 4>& block,
@@ -21,6 +21,9 @@
 #ifndef VOTCA_XTP_AOBASIS_H
 #define VOTCA_XTP_AOBASIS_H
 
+// Standard includes
+#include <memory>
+
 // Local VOTCA includes
 #include "aoshell.h"
 #include "eigen.h"
@@ -29,6 +32,8 @@ namespace votca {
 namespace xtp {
 class QMMolecule;
 class BasisSet;
+class AOShellPairs;
+class AOShellTrafos;
 
 /**
  * \brief Container to hold Basisfunctions for all atoms
@@ -53,6 +58,12 @@ class AOBasis {
 
   const std::vector<Index>& getFuncPerAtom() const { return _FuncperAtom; }
 
+  // screened primitive pair data of all shell pairs, built on first use and
+  // shared with copies of this basis
+  const AOShellPairs& ShellPairs() const;
+  // transformations of all primitives, for integrals without screened pairs
+  const AOShellTrafos& ShellTrafos() const;
+
  private:
   AOShell& addShell(const Shell& shell, const QMAtom& atom, Index startIndex);
 
@@ -61,6 +72,9 @@ class AOBasis {
   std::vector<Index> _FuncperAtom;
 
   Index _AOBasisSize;
+
+  mutable std::shared_ptr<const AOShellPairs> _shellpairs = nullptr;
+  mutable std::shared_ptr<const AOShellTrafos> _shelltrafos = nullptr;
 };
 
 }  // namespace xtp
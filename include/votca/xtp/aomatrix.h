@@ -23,6 +23,7 @@
 
 // Local VOTCA includes
 #include "aobasis.h"
+#include "aoshellpairs.h"
 
 namespace votca {
 namespace xtp {
@@ -35,17 +36,22 @@ class AOMatrix {
 
  protected:
   virtual void FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                         const AOShell& shell_row,
-                         const AOShell& shell_col) const = 0;
+                         const AOShell& shell_row, const AOShell& shell_col,
+                         const AOShellPairs* shellpairs) const = 0;
+  // integrals without screened primitive pairs only need the transformations
+  // of the shells, Fill then passes no pair table to FillBlock
+  virtual bool UsesShellPairs() const { return true; }
   Eigen::MatrixXd _aomatrix;
+  // transformations of the basis during Fill, nullptr otherwise
+  const AOShellTrafos* _shelltrafos = nullptr;
 };
 
 // derived class for kinetic energy
 class AOKinetic : public AOMatrix {
  protected:
   void FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                 const AOShell& shell_row,
-                 const AOShell& shell_col) const override;
+                 const AOShell& shell_row, const AOShell& shell_col,
+                 const AOShellPairs* shellpairs) const override;
 };
 
 // derived class for atomic orbital overlap
@@ -58,14 +64,16 @@ class AOOverlap : public AOMatrix {
   Eigen::MatrixXd Pseudo_InvSqrt(double etol);
   Eigen::MatrixXd Sqrt();
 
-  Eigen::MatrixXd Primitive_Overlap(const AOGaussianPrimitive& g_row,
-                                    const AOGaussianPrimitive& g_col,
+  // unnormalized cartesian overlap of a primitive pair of the two shells
+  Eigen::MatrixXd Primitive_Overlap(const AOPrimitivePair& pair,
+                                    const AOShell& shell_row,
+                                    const AOShell& shell_col,
                                     Index l_offset = 0) const;
 
  protected:
   void FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                 const AOShell& shell_row,
-                 const AOShell& shell_col) const override;
+                 const AOShell& shell_row, const AOShell& shell_col,
+                 const AOShellPairs* shellpairs) const override;
 
  private:
   Index removedfunctions;
@@ -82,8 +90,9 @@ class AOCoulomb : public AOMatrix {
 
  protected:
   void FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                 const AOShell& shell_row,
-                 const AOShell& shell_col) const override;
+                 const AOShell& shell_row, const AOShell& shell_col,
+                 const AOShellPairs* shellpairs) const override;
+  bool UsesShellPairs() const override { return false; }
 
  private:
   Index removedfunctions;
@@ -23,6 +23,7 @@
 
 // Local VOTCA includes
 #include "aobasis.h"
+#include "aoshellpairs.h"
 
 namespace votca {
 namespace xtp {
@@ -36,8 +37,8 @@ class AOMatrix3D {
  protected:
   std::array<Eigen::MatrixXd, 3> _aomatrix;
   virtual void FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd>>& matrix,
-                         const AOShell& shell_row,
-                         const AOShell& shell_col) const = 0;
+                         const AOShell& shell_row, const AOShell& shell_col,
+                         const AOShellPairs* shellpairs) const = 0;
 };
 
 /* derived class for atomic orbital gradient matrices, required for
@@ -46,8 +47,8 @@ class AOMatrix3D {
 class AOMomentum : public AOMatrix3D {
  protected:
   void FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd>>& matrix,
-                 const AOShell& shell_row,
-                 const AOShell& shell_col) const override;
+                 const AOShell& shell_row, const AOShell& shell_col,
+                 const AOShellPairs* shellpairs) const override;
 };
 
 /* derived class for atomic orbital electrical dipole matrices, required for
@@ -60,8 +61,8 @@ class AODipole : public AOMatrix3D {
   }  // definition of a center around which the moment should be calculated
  protected:
   void FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd>>& matrix,
-                 const AOShell& shell_row,
-                 const AOShell& shell_col) const override;
+                 const AOShell& shell_row, const AOShell& shell_col,
+                 const AOShellPairs* shellpairs) const override;
 
  private:
   Eigen::Vector3d _r = Eigen::Vector3d::Zero();
@@ -23,6 +23,7 @@
 
 // Local VOTCA includes
 #include "aobasis.h"
+#include "aoshellpairs.h"
 #include "ecpaobasis.h"
 #include "staticsite.h"
 
@@ -45,7 +46,8 @@ class AOPotential {
       const AOBasis& aobasis) const;
   virtual void FillBlock(
       Eigen::Block<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>& matrix,
-      const AOShell& shell_row, const AOShell& shell_col) const = 0;
+      const AOShell& shell_row, const AOShell& shell_col,
+      const AOShellPairs* shellpairs) const = 0;
   Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> _aopotential;
 };
 
@@ -56,20 +58,42 @@ class AOECP : public AOPotential<double> {
 
  protected:
   void FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                 const AOShell& shell_row,
-                 const AOShell& shell_col) const override;
+                 const AOShell& shell_row, const AOShell& shell_col,
+                 const AOShellPairs* shellpairs) const override;
 
  private:
+  // non-local parts of the ecp of one element, one column per angular
+  // momentum, one row per gaussian
+  struct ECPParameters {
+    Index lmax;
+    Eigen::MatrixXi power;
+    Eigen::MatrixXd decay;
+    Eigen::MatrixXd coef;
+  };
+  struct ECPCentre {
+    Eigen::Vector3d pos;
+    // index into _ecp_types
+    Index type;
+  };
+  // expansion of the spherical functions of a shell around an ecp centre
+  struct AngularCoefficients {
+    Eigen::Tensor<double, 3> BLC;
+    Eigen::Tensor<double, 3> C;
+  };
+
   Eigen::VectorXd ExpandContractions(const AOGaussianPrimitive& gaussian,
                                      const AOShell& shell) const;
-  void setECP(const ECPAOBasis* ecp) { _ecp = ecp; }
-  const ECPAOBasis* _ecp;
-  Eigen::MatrixXd calcVNLmatrix(
-      Index lmax_ecp, const Eigen::Vector3d& posC,
-      const AOGaussianPrimitive& g_row, const AOGaussianPrimitive& g_col,
-      const Eigen::Matrix<int, 4, 5>& power_ecp,
-      const Eigen::Matrix<double, 4, 5>& gamma_ecp,
-      const Eigen::Matrix<double, 4, 5>& pref_ecp) const;
+  void setECP(const ECPAOBasis& ecp);
+  std::vector<ECPParameters> _ecp_types;
+  std::vector<ECPCentre> _ecp_centres;
+  Eigen::MatrixXd calcRadialIntegrals(const ECPParameters& ecp, double decay,
+                                      Index nmax) const;
+  Eigen::MatrixXd calcVNLmatrix(Index lmax_ecp, const Eigen::Vector3d& posC,
+                                const AOGaussianPrimitive& g_row,
+                                const AOGaussianPrimitive& g_col,
+                                const Eigen::MatrixXd& XI,
+                                const AngularCoefficients& angular_row,
+                                const AngularCoefficients& angular_col) const;
 
   void getBLMCOF(Index lmax_ecp, Index lmax_dft, const Eigen::Vector3d& pos,
                  Eigen::Tensor<double, 3>& BLC,
@@ -85,13 +109,31 @@ class AOMultipole : public AOPotential<double> {
   void FillPotential(
       const AOBasis& aobasis,
       const std::vector<std::unique_ptr<StaticSite>>& externalsites);
+  // for every shell pair the sites outside the region, where its density is
+  // above density_threshold, may be merged into clusters, whose potentials
+  // deviate by less than tolerance from the exact ones, tolerance<=0 means
+  // all sites are treated exactly
+  void FillPotential(
+      const AOBasis& aobasis,
+      const std::vector<std::unique_ptr<StaticSite>>& externalsites,
+      double tolerance, double density_threshold);
+
+  // sites and clusters per shell pair in the last FillPotential
+  double AverageExactSites() const { return _avg_exact_sites; }
+  double AverageClusters() const { return _avg_clusters; }
 
  protected:
   void FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                 const AOShell& shell_row,
-                 const AOShell& shell_col) const override;
+                 const AOShell& shell_row, const AOShell& shell_col,
+                 const AOShellPairs* shellpairs) const override;
 
  private:
+  void FillSiteBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
+                     const AOShell& shell_row, const AOShell& shell_col,
+                     const StaticSite& site,
+                     const AOShellPairs* shellpairs) const;
+  double _avg_exact_sites = 0.0;
+  double _avg_clusters = 0.0;
   void setSite(const StaticSite* site) { _site = site; };
 
   const StaticSite* _site;
@@ -104,8 +146,8 @@ class AOPlanewave : public AOPotential<std::complex<double>> {
 
  protected:
   void FillBlock(Eigen::Block<Eigen::MatrixXcd>& matrix,
-                 const AOShell& shell_row,
-                 const AOShell& shell_col) const override;
+                 const AOShell& shell_row, const AOShell& shell_col,
+                 const AOShellPairs* shellpairs) const override;
 
  private:
   void setkVector(const Eigen::Vector3d& k) { _k = k; };
@@ -94,6 +94,8 @@ class AOShell {
     for (const auto& gaus : shell._gaussians) {
       _gaussians.push_back(AOGaussianPrimitive(gaus, *this));
     }
+    _decays = shell._decays;
+    _radialcoeffs = shell._radialcoeffs;
   }
 
   L getL() const { return _l; }
@@ -125,6 +127,17 @@ class AOShell {
                    Eigen::Block<Eigen::MatrixX3d>& AODervalues,
                    const Eigen::Vector3d& grid_pos) const;
 
+  // evaluate the shell on many points at once, points has one row per point,
+  // the result blocks one row per point and one column per function, values
+  // are added to the blocks
+  void EvalAOspace(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                   Eigen::Ref<Eigen::MatrixXd> AOvalues) const;
+  void EvalAOspace(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                   Eigen::Ref<Eigen::MatrixXd> AOvalues,
+                   Eigen::Ref<Eigen::MatrixXd> AODer_x,
+                   Eigen::Ref<Eigen::MatrixXd> AODer_y,
+                   Eigen::Ref<Eigen::MatrixXd> AODer_z) const;
+
   // iterator over pairs (decay constant; contraction coefficient)
   using GaussianIterator = std::vector<AOGaussianPrimitive>::const_iterator;
   GaussianIterator begin() const { return _gaussians.begin(); }
@@ -133,6 +146,7 @@ class AOShell {
   // adds a Gaussian
   void addGaussian(const GaussianPrimitive& gaussian) {
     _gaussians.push_back(AOGaussianPrimitive(gaussian, *this));
+    UpdateRadialCoefficients();
     return;
   }
 
@@ -142,6 +156,10 @@ class AOShell {
 
  private:
   // only class aobasis can construct shells
+  // copies decays and normalised contractions into contiguous arrays for
+  // the multi-point kernel
+  void UpdateRadialCoefficients();
+
   AOShell(const Shell& shell, const QMAtom& atom, Index startIndex)
       : _l(shell.getL()),
         _scale(shell.getScale()),
@@ -170,6 +188,10 @@ class AOShell {
 
   // vector of pairs of decay constants and contraction coefficients
   std::vector<AOGaussianPrimitive> _gaussians;
+  // same data as structure of arrays, the contraction already contains the
+  // powfactor and the normalisation of the angular part
+  Eigen::VectorXd _decays;
+  Eigen::VectorXd _radialcoeffs;
 };
 }  // namespace xtp
 }  // namespace votca
@@ -0,0 +1,192 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_AOSHELLPAIRS_H
+#define VOTCA_XTP_AOSHELLPAIRS_H
+
+// Standard includes
+#include <vector>
+
+// Local VOTCA includes
+#include "aoshell.h"
+#include "eigen.h"
+
+namespace votca {
+namespace xtp {
+
+class AOBasis;
+
+// Gaussian product of two primitives of a shell pair
+struct AOPrimitivePair {
+  double decay_row;
+  double decay_col;
+  // exp(-decay_row*decay_col/(decay_row+decay_col)*|A-B|^2)
+  double expfactor;
+  // product center
+  Eigen::Vector3d P;
+  // contracted cartesian to spherical transformations of both primitives
+  const Eigen::MatrixXd* trafo_row;
+  const Eigen::MatrixXd* trafo_col;
+};
+
+// primitive pairs of one shell pair, grouped by the primitive of the row
+// shell
+class AOShellPair {
+ public:
+  class Range {
+   public:
+    Range(const AOPrimitivePair* begin, const AOPrimitivePair* end)
+        : _begin(begin), _end(end) {}
+    const AOPrimitivePair* begin() const { return _begin; }
+    const AOPrimitivePair* end() const { return _end; }
+    Index size() const { return Index(_end - _begin); }
+
+   private:
+    const AOPrimitivePair* _begin;
+    const AOPrimitivePair* _end;
+  };
+
+  AOShellPair(const AOPrimitivePair* pairs, const Index* rowstarts,
+              Index rowprimitives)
+      : _pairs(pairs), _rowstarts(rowstarts), _rowprimitives(rowprimitives) {}
+
+  Index NumRowPrimitives() const { return _rowprimitives; }
+
+  // pairs of primitive i of the row shell with all significant primitives of
+  // the column shell
+  Range Row(Index i) const {
+    return Range(_pairs + _rowstarts[i], _pairs + _rowstarts[i + 1]);
+  }
+
+  const AOPrimitivePair* begin() const { return _pairs + _rowstarts[0]; }
+  const AOPrimitivePair* end() const {
+    return _pairs + _rowstarts[_rowprimitives];
+  }
+  Index size() const { return Index(end() - begin()); }
+
+ private:
+  const AOPrimitivePair* _pairs;
+  const Index* _rowstarts;
+  Index _rowprimitives;
+};
+
+/**
+ * \brief Transformations of all primitives of a basis to spherical functions
+ *
+ * Integrals which need the transformations of single shells but no screened
+ * pairs, e.g. the Coulomb metric or the auxiliary shell of the three-center
+ * integrals, take them from this table, which grows only linearly with the
+ * number of shells.
+ */
+class AOShellTrafos {
+ public:
+  AOShellTrafos() = default;
+  explicit AOShellTrafos(const AOBasis& aobasis);
+  // shells have to be ordered by their start index to be found by ShellIndex
+  explicit AOShellTrafos(const std::vector<const AOShell*>& shells);
+
+  // transformations of all primitives of shell from table if it holds the
+  // shell, otherwise computed into buffer
+  static const Eigen::MatrixXd* Lookup(const AOShellTrafos* table,
+                                       const AOShell& shell,
+                                       std::vector<Eigen::MatrixXd>& buffer);
+
+  Index NumShells() const { return Index(_startindex.size()); }
+
+  // transformations of the primitives of the shell with index in the table
+  const Eigen::MatrixXd* Trafos(Index index) const {
+    return _trafos.data() + _primstart[index];
+  }
+
+  // index of shell in the table or -1 if no shell starts at its start index,
+  // throws if the shell at its start index is a different one
+  Index ShellIndex(const AOShell& shell) const;
+
+ private:
+  std::vector<Eigen::MatrixXd> _trafos;
+  // first primitive of each shell in _trafos, one entry more than shells
+  std::vector<Index> _primstart;
+  // first function, angular momentum and center of each shell, to find a
+  // shell in the table
+  std::vector<Index> _startindex;
+  std::vector<L> _l;
+  std::vector<Eigen::Vector3d> _pos;
+};
+
+/**
+ * \brief Screened primitive pair data of all shell pairs of a basis
+ *
+ * Product centers, exponents and the transformations of all primitives to
+ * spherical functions are computed once per basis, i.e. once per geometry,
+ * and stored contiguously for all integral fills on this basis. Pairs
+ * (row,col) with row>=col are stored, primitive pairs whose product is
+ * smaller than exp(-ExpargCutoff) are dropped.
+ */
+class AOShellPairs {
+ public:
+  static constexpr double ExpargCutoff = 30.0;
+
+  AOShellPairs() = default;
+  explicit AOShellPairs(const AOBasis& aobasis);
+  // holds only the pair of the two shells
+  AOShellPairs(const AOShell& shell_row, const AOShell& shell_col);
+
+  // the pairs point to the transformations in _shelltrafos, which a move
+  // keeps
+  AOShellPairs(const AOShellPairs&) = delete;
+  AOShellPairs& operator=(const AOShellPairs&) = delete;
+  AOShellPairs(AOShellPairs&&) = default;
+  AOShellPairs& operator=(AOShellPairs&&) = default;
+
+  // pair data from table if it holds the pair, otherwise computed into buffer
+  static AOShellPair Lookup(const AOShellPairs* table, const AOShell& shell_row,
+                            const AOShell& shell_col, AOShellPairs& buffer);
+
+  // product of two primitives without transformations
+  static AOPrimitivePair Product(const AOGaussianPrimitive& gaussian_row,
+                                 const AOGaussianPrimitive& gaussian_col);
+
+  const AOShellTrafos& ShellTrafos() const { return _shelltrafos; }
+
+  Index NumShells() const { return _shelltrafos.NumShells(); }
+  Index NumShellPairs() const { return Index(_rowoffset.size()); }
+  Index NumPrimitivePairs() const { return Index(_pairs.size()); }
+
+ private:
+  AOShellTrafos _shelltrafos;
+
+  std::vector<AOPrimitivePair> _pairs;
+  // for each shell pair the first pair of each row primitive, one entry more
+  // than row primitives
+  std::vector<Index> _rowstarts;
+  // first entry of each shell pair in _rowstarts
+  std::vector<Index> _rowoffset;
+  // all pairs row>=col of a basis are stored, otherwise a single pair
+  bool _basistable = false;
+
+  void AddPair(const AOShell& shell_row, Index row, const AOShell& shell_col,
+               Index col);
+  AOShellPair Pair(Index index, const AOShell& shell_row) const;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_AOSHELLPAIRS_H
@@ -89,6 +89,8 @@ class AOTransform {
   static Index getBlockSize(Index lmax);
   static Eigen::MatrixXd getTrafo(const AOGaussianPrimitive& gaussian);
   static Eigen::VectorXd XIntegrate(Index size, double U);
+  // fills all FmU.size() orders of the Boys function without allocating
+  static void XIntegrate(Eigen::Ref<Eigen::VectorXd> FmU, double U);
 
  private:
   // clang-format off
@@ -0,0 +1,86 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_ATOMICGUESSCACHE_H
+#define VOTCA_XTP_ATOMICGUESSCACHE_H
+
+// Standard includes
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+
+// Local VOTCA includes
+#include "eigen.h"
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Process wide cache of converged atomic densities for the atomic
+ * guess of DFTEngine
+ *
+ * The key has to contain everything the atomic density depends on, e.g.
+ * element, basisset, ecp and functional. Optionally the densities are also
+ * stored in an hdf5 file, so that later runs can skip the atomic calculations.
+ * All methods are threadsafe.
+ */
+class AtomicGuessCache {
+ public:
+  static AtomicGuessCache& Instance();
+
+  static std::string MakeKey(const std::string& element,
+                             const std::string& basisset,
+                             const std::string& auxbasisset,
+                             const std::string& ecp,
+                             const std::string& functional,
+                             const std::string& grid);
+
+  // returns true and sets dmat if the density for key is known, densities
+  // stored in filename are loaded first, an empty filename disables the file
+  bool Find(const std::string& key, const std::string& filename,
+            Eigen::MatrixXd& dmat);
+
+  // adds the density to the cache and to filename if not empty, the file is
+  // replaced atomically, so that several jobs can share it
+  void Add(const std::string& key, const std::string& filename,
+           const Eigen::MatrixXd& dmat);
+
+  void Clear();
+
+ private:
+  AtomicGuessCache() = default;
+
+  static std::string GroupName(const std::string& key);
+  static std::map<std::string, Eigen::MatrixXd> ReadFile(
+      const std::string& filename);
+  void LoadFile(const std::string& filename);
+  void WriteFile(const std::string& filename, const std::string& key,
+                 const Eigen::MatrixXd& dmat) const;
+
+  std::mutex _mutex;
+  std::map<std::string, Eigen::MatrixXd> _densities;
+  std::set<std::string> _loadedfiles;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_ATOMICGUESSCACHE_H
@@ -21,6 +21,9 @@
 #ifndef VOTCA_XTP_CONVERGENCEACC_H
 #define VOTCA_XTP_CONVERGENCEACC_H
 
+// Standard includes
+#include <array>
+
 // VOTCA includes
 #include <votca/tools/linalg.h>
 
@@ -48,6 +51,9 @@ class ConvergenceAcc {
     double levelshift;
     double levelshiftend;
     Index numberofelectrons;
+    // only used by the unrestricted Iterate, in open mode numberofelectrons
+    // then counts the alpha electrons
+    Index numberofelectrons_beta = 0;
     double mixingparameter;
     double Econverged;
     double error_converged;
@@ -59,6 +65,7 @@ class ConvergenceAcc {
       _nocclevels = _opt.numberofelectrons / 2;
     } else if (_opt.mode == KSmode::open) {
       _nocclevels = _opt.numberofelectrons;
+      _nocclevels_beta = _opt.numberofelectrons_beta;
     } else if (_opt.mode == KSmode::fractional) {
       _nocclevels = 0;
     }
@@ -92,17 +99,40 @@ class ConvergenceAcc {
 
   Eigen::MatrixXd Iterate(const Eigen::MatrixXd& dmat, Eigen::MatrixXd& H,
                           tools::EigenSystem& MOs, double totE);
+  // unrestricted Kohn-Sham in open mode, index 0 is alpha and 1 beta. Both
+  // spins share one history, so their Fock matrices are extrapolated with the
+  // same (A)DIIS coefficients, which minimise the error of both together.
+  std::array<Eigen::MatrixXd, 2> Iterate(
+      const std::array<Eigen::MatrixXd, 2>& dmat,
+      std::array<Eigen::MatrixXd, 2>& H,
+      std::array<tools::EigenSystem, 2>& MOs, double totE);
   tools::EigenSystem SolveFockmatrix(const Eigen::MatrixXd& H) const;
   void Levelshift(Eigen::MatrixXd& H, const Eigen::MatrixXd& MOs_old) const;
 
   Eigen::MatrixXd DensityMatrix(const tools::EigenSystem& MOs) const;
+  std::array<Eigen::MatrixXd, 2> DensityMatrix(
+      const std::array<tools::EigenSystem, 2>& MOs) const;
 
  private:
   options _opt;
 
+  void UpdateEnergyHistory(double totE);
+  void LevelshiftIfRequired(Eigen::MatrixXd& H, const tools::EigenSystem& MOs,
+                            Index nocclevels) const;
+  void Levelshift(Eigen::MatrixXd& H, const Eigen::MatrixXd& MOs_old,
+                  Index nocclevels) const;
+  Eigen::MatrixXd ErrorMatrix(const Eigen::MatrixXd& dmat,
+                              const Eigen::MatrixXd& H) const;
+  // adds H to the history and returns the extrapolated Fock matrix
+  Eigen::MatrixXd Extrapolate(const Eigen::MatrixXd& dmat,
+                              const Eigen::MatrixXd& H,
+                              const Eigen::MatrixXd& errormatrix,
+                              bool& diis_error);
+  bool UseMixing(bool diis_error);
+
   Eigen::MatrixXd DensityMatrixGroundState(const Eigen::MatrixXd& MOs) const;
-  Eigen::MatrixXd DensityMatrixGroundState_unres(
-      const Eigen::MatrixXd& MOs) const;
+  Eigen::MatrixXd DensityMatrixGroundState_unres(const Eigen::MatrixXd& MOs,
+                                                 Index nocclevels) const;
   Eigen::MatrixXd DensityMatrixGroundState_frac(
       const tools::EigenSystem& MOs) const;
 
@@ -117,6 +147,7 @@ class ConvergenceAcc {
   std::vector<double> _totE;
 
   Index _nocclevels;
+  Index _nocclevels_beta = 0;
   Index _maxerrorindex = 0;
   double _maxerror = 0.0;
   ADIIS _adiis;
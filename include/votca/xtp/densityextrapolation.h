@@ -0,0 +1,81 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_DENSITYEXTRAPOLATION_H
+#define VOTCA_XTP_DENSITYEXTRAPOLATION_H
+
+// Standard includes
+#include <deque>
+#include <string>
+
+// Local VOTCA includes
+#include "eigen.h"
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Extrapolates the initial density of a DFT calculation from the
+ * converged densities of previous, closely related calculations
+ *
+ * Uses the predictor of the always stable predictor corrector (ASPC) scheme
+ * of Kolafa, J. Comput. Chem. 25, 335 (2004). Order k needs the last k+2
+ * densities, with fewer densities in the history the order is reduced.
+ * Order 0 is a linear extrapolation from the last two densities.
+ */
+class DensityExtrapolation {
+ public:
+  void setOrder(Index order);
+  Index getOrder() const { return _order; }
+
+  // newest density is added to the front, the oldest one is discarded. The
+  // fingerprint identifies the basis, e.g. basisset name and elements
+  void Push(const Eigen::MatrixXd& dmat, const std::string& fingerprint);
+
+  // true if there is at least one density for a basis with this fingerprint
+  bool hasGuess(const std::string& fingerprint) const {
+    return !_history.empty() && _fingerprint == fingerprint;
+  }
+
+  Index size() const { return Index(_history.size()); }
+
+  Eigen::MatrixXd Extrapolate() const;
+
+  // history holding only the newest density, whose guess is that density
+  // and which leaves this history untouched by later pushes
+  DensityExtrapolation Reference() const;
+
+  void Clear() {
+    _history.clear();
+    _fingerprint = "";
+  }
+
+  static Eigen::VectorXd Coefficients(Index order);
+
+ private:
+  Index _order = 2;
+  std::deque<Eigen::MatrixXd> _history;
+  std::string _fingerprint = "";
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_DENSITYEXTRAPOLATION_H
@@ -36,6 +36,7 @@
 namespace votca {
 namespace xtp {
 class Orbitals;
+class DensityExtrapolation;
 
 /**
  * \brief Electronic ground-state via Density-Functional Theory
@@ -51,12 +52,24 @@ class DFTEngine {
 
   void setLogger(Logger* pLog) { _pLog = pLog; }
 
+  // overrides the charge and spin multiplicity of the options
+  void setChargeAndSpin(Index charge, Index spin) {
+    _charge = charge;
+    _spin = spin;
+  }
+
   void setExternalcharges(
       std::vector<std::unique_ptr<StaticSite> >* externalsites) {
     _externalsites = externalsites;
     _addexternalsites = true;
   }
 
+  // converged densities are added to history and the initial guess is
+  // extrapolated from it, if it holds densities for the same basis
+  void setDensityHistory(DensityExtrapolation* history) {
+    _density_history = history;
+  }
+
   bool Evaluate(Orbitals& orb);
 
   std::string getDFTBasisName() const { return _dftbasis_name; };
@@ -66,12 +79,23 @@ class DFTEngine {
 
   Vxc_Potential<Vxc_Grid> SetupVxc(const QMMolecule& mol);
 
+  bool EvaluateUnrestricted(Orbitals& orb, const Mat_p_Energy& H0,
+                            const Vxc_Potential<Vxc_Grid>& vxcpotential,
+                            std::array<tools::EigenSystem, 2> MOs);
+
   Eigen::MatrixXd OrthogonalizeGuess(const Eigen::MatrixXd& GuessMOs) const;
-  void PrintMOs(const Eigen::VectorXd& MOEnergies, Log::Level level);
+  void PrintMOs(const Eigen::VectorXd& MOEnergies, Index occupied_levels,
+                Index occupation, Log::Level level);
   void CalcElDipole(const Orbitals& orb) const;
   Mat_p_Energy CalculateERIs(const Eigen::MatrixXd& DMAT) const;
   Mat_p_Energy CalcEXXs(const Eigen::MatrixXd& MOCoeff,
                         const Eigen::MatrixXd& Dmat) const;
+  // exchange matrix of the density of one spin, which has nocc singly
+  // occupied levels
+  Eigen::MatrixXd CalcEXXs_spin(const Eigen::MatrixXd& MOCoeff, Index nocc,
+                                const Eigen::MatrixXd& Dmat_spin) const;
+  Eigen::MatrixXd CalculateERIs_diff(const Eigen::MatrixXd& dDMAT) const;
+  Eigen::MatrixXd CalcEXXs_diff(const Eigen::MatrixXd& dDMAT) const;
   void ConfigOrbfile(Orbitals& orb);
   void SetupInvariantMatrices();
 
@@ -88,9 +112,15 @@ class DFTEngine {
   tools::EigenSystem ModelPotentialGuess(
       const Mat_p_Energy& H0, const QMMolecule& mol,
       const Vxc_Potential<Vxc_Grid>& vxcpotential) const;
+  tools::EigenSystem DensityGuess(
+      const Mat_p_Energy& H0, const Eigen::MatrixXd& Dmat,
+      const Vxc_Potential<Vxc_Grid>& vxcpotential) const;
 
   Eigen::MatrixXd AtomicGuess(const QMMolecule& mol) const;
 
+  // identifies the basis of a molecule independent of its geometry
+  std::string BasisFingerprint(const QMMolecule& mol) const;
+
   Eigen::MatrixXd RunAtomicDFT_unrestricted(const QMAtom& uniqueAtom) const;
 
   double NuclearRepulsion(const QMMolecule& mol) const;
@@ -111,23 +141,55 @@ class DFTEngine {
 
   bool _with_ecp;
 
-  std::string _four_center_method;  // direct | cache
+  std::string _four_center_method;  // direct | cache | semidirect | RI
 
   // Pre-screening
   bool _with_screening;
   double _screening_eps;
+  // memory for cached shell quartets of the semidirect method in MB
+  double _semidirect_max_memory = 1024.0;
+
+  // incremental Fock build from density differences
+  bool _incremental_fock = false;
+  double _incremental_fock_eps;
+  Index _incremental_fock_rebuild;
+
+  // memory limit for the RI three-center integrals in MB, <=0 means the
+  // physical memory, beyond it they are stored in _scratch_dir
+  double _threecenter_max_memory = 0.0;
+  // Schwarz bound below which RI three-center blocks are skipped
+  double _threecenter_screening_eps = 1e-12;
+  // memory in MB for a batch of half-transformed integrals in RI exchange
+  double _exchange_batch_memory = 256.0;
+  std::string _scratch_dir = ".";
 
   // numerical integration Vxc
   std::string _grid_name;
+  // reuse grids of earlier calculations on the same geometry
+  bool _reuse_grid = false;
+  // reuse ECP matrices of earlier calculations on the same geometry
+  bool _reuse_ecp = false;
+  // memory for cached AO values on the grid in MB, 0 disables the cache
+  double _ao_cache_memory = 0.0;
+  bool _ao_cache_single = false;
 
   // AO Matrices
   AOOverlap _dftAOoverlap;
 
   bool _with_guess;
   std::string _initial_guess;
+  // hdf5 file in which converged atomic densities are kept between runs
+  std::string _atomic_guess_file = "";
+  DensityExtrapolation* _density_history = nullptr;
 
   // Convergence
   Index _numofelectrons = 0;
+  Index _charge = 0;
+  Index _spin = 1;  // 2S+1
+  Index _numofalpha = 0;
+  Index _numofbeta = 0;
+  // unrestricted Kohn-Sham, always used for spin>1
+  bool _unrestricted = false;
   Index _max_iter;
   ConvergenceAcc::options _conv_opt;
   // DIIS variables
@@ -138,6 +200,11 @@ class DFTEngine {
   // external charges
   std::vector<std::unique_ptr<StaticSite> >* _externalsites;
   bool _addexternalsites = false;
+  // distant external sites are merged into clusters with this potential
+  // error, 0 treats all sites exactly
+  double _external_multipole_tolerance = 0.0;
+  // sites where the density of a shell pair is above this are never merged
+  double _external_multipole_density_threshold = 1e-10;
 
   // exchange and correlation
   double _ScaHFX;
@@ -0,0 +1,80 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_ECPMATRIXCACHE_H
+#define VOTCA_XTP_ECPMATRIXCACHE_H
+
+// Standard includes
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Local VOTCA includes
+#include "eigen.h"
+
+namespace votca {
+namespace xtp {
+class AOBasis;
+class ECPAOBasis;
+
+/**
+ * \brief Process wide cache of ECP matrices, so that DFT calculations on the
+ * same geometry, e.g. consecutive QM/MM iterations, skip the ECP integrals
+ *
+ * Matrices are identified by the positions, angular momenta and primitives of
+ * all shells of the basis and of the ECP, which are compared exactly on a hash
+ * hit. Only the last few matrices are kept. All methods are threadsafe.
+ */
+class ECPMatrixCache {
+ public:
+  static ECPMatrixCache& Instance();
+
+  // returns true and sets matrix if a matrix for this basis and ecp exists
+  bool Find(const AOBasis& aobasis, const ECPAOBasis& ecp,
+            Eigen::MatrixXd& matrix) const;
+
+  void Add(const AOBasis& aobasis, const ECPAOBasis& ecp,
+           const Eigen::MatrixXd& matrix);
+
+  void Clear();
+
+  Index size() const;
+
+ private:
+  ECPMatrixCache() = default;
+
+  struct Entry {
+    std::size_t hash;
+    std::vector<double> key;
+    Eigen::MatrixXd matrix;
+  };
+
+  static std::vector<double> Key(const AOBasis& aobasis,
+                                 const ECPAOBasis& ecp);
+
+  static constexpr Index _max_entries = 2;
+  mutable std::mutex _mutex;
+  std::deque<Entry> _entries;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_ECPMATRIXCACHE_H
@@ -21,6 +21,9 @@
 #ifndef VOTCA_XTP_GRIDBOX_H
 #define VOTCA_XTP_GRIDBOX_H
 
+// Standard includes
+#include <memory>
+
 // Local VOTCA includes
 #include "aoshell.h"
 #include "grid_containers.h"
@@ -32,13 +35,50 @@ struct GridboxRange {
   Index start;
   Index size;
 };
+
+// AO values and their gradients for all points of a box, one row per
+// gridpoint, one column per significant basisfunction
+struct AOValues {
+  AOValues(Index pointsize, Index aosize)
+      : values(Eigen::MatrixXd::Zero(pointsize, aosize)),
+        derivatives_x(Eigen::MatrixXd::Zero(pointsize, aosize)),
+        derivatives_y(Eigen::MatrixXd::Zero(pointsize, aosize)),
+        derivatives_z(Eigen::MatrixXd::Zero(pointsize, aosize)){};
+  Eigen::MatrixXd values;
+  Eigen::MatrixXd derivatives_x;
+  Eigen::MatrixXd derivatives_y;
+  Eigen::MatrixXd derivatives_z;
+};
+
 class GridBox {
 
  public:
   void FindSignificantShells(const AOBasis& basis);
   Eigen::VectorXd CalcAOValue_and_Grad(Eigen::MatrixX3d& ao_grad,
                                        const Eigen::Vector3d& point) const;
+  AOValues CalcAOValues_and_Grad() const;
   Eigen::VectorXd CalcAOValues(const Eigen::Vector3d& pos) const;
+  // AO values of all points of the box, one row per gridpoint
+  Eigen::MatrixXd CalcAOValues() const;
+
+  // like CalcAOValues_and_Grad but uses the AO cache if it was filled
+  AOValues getAOValues() const;
+  void CacheAOValues(bool single_precision);
+  void ClearAOCache() {
+    _aocache_d.reset();
+    _aocache_f.reset();
+  }
+  bool hasAOCache() const { return _aocache_d || _aocache_f; }
+  // memory in bytes the AO cache of this box needs
+  Index AOCacheSize(bool single_precision) const {
+    Index bytes = single_precision ? Index(sizeof(float))
+                                   : Index(sizeof(double));
+    return 4 * size() * matrix_size * bytes;
+  }
+
+  // points the significant shells to the shells of basis, which has to be
+  // identical to the basis the box was set up with
+  void RebindShells(const AOBasis& basis);
 
   const std::vector<Eigen::Vector3d>& getGridPoints() const { return grid_pos; }
 
@@ -56,9 +96,15 @@ class GridBox {
 
   Index Matrixsize() const { return matrix_size; }
 
+  // rough number of operations for AO values and the Vxc GEMMs of this box
+  double EstimatedCost() const {
+    return double(size()) * double(matrix_size) * double(matrix_size + 4);
+  }
+
   void addGridBox(const GridBox& box) {
     grid_pos.insert(grid_pos.end(), box.grid_pos.begin(), box.grid_pos.end());
     weights.insert(weights.end(), box.weights.begin(), box.weights.end());
+    ClearAOCache();
     return;
   }
 
@@ -67,8 +113,9 @@ class GridBox {
     weights.push_back(point.grid_weight);
   };
 
-  void addShell(const AOShell* shell) {
+  void addShell(const AOShell* shell, Index shellindex) {
     significant_shells.push_back(shell);
+    significant_shell_indices.push_back(shellindex);
     matrix_size += shell->getNumFunc();
   };
 
@@ -97,13 +144,20 @@ class GridBox {
   }
 
  private:
+  Eigen::MatrixX3d GridPointMatrix() const;
+
   Index matrix_size = 0;
   std::vector<GridboxRange> aoranges;
   std::vector<GridboxRange> ranges;
   std::vector<GridboxRange> inv_ranges;
   std::vector<Eigen::Vector3d> grid_pos;
   std::vector<const AOShell*> significant_shells;
+  std::vector<Index> significant_shell_indices;
   std::vector<double> weights;
+  // AO values and x,y,z derivatives stacked on top of each other, shared
+  // between copies of the box, at most one of them is filled
+  std::shared_ptr<const Eigen::MatrixXd> _aocache_d = nullptr;
+  std::shared_ptr<const Eigen::MatrixXf> _aocache_f = nullptr;
 };
 
 }  // namespace xtp
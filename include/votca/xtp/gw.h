@@ -55,6 +55,8 @@ class GW {
     double shift = 0;
     double ScaHFX = 0.0;
     std::string sigma_integration;
+    double quadrature_tolerance = 1e-6;
+    double residue_memory = 0.0;
     Index reset_3c;  // how often the 3c integrals in iterate should be
                      // rebuilt
     std::string qp_solver;
@@ -94,6 +94,8 @@ class GWBSE {
   // basis sets
   std::string _auxbasis_name;
   std::string _dftbasis_name;
+  double _naf_threshold = 0.0;
+  double _threecenter_screening_eps = 1e-12;
 
   std::vector<QMFragment<BSE_Population> > _fragments;
 };
@@ -51,6 +51,9 @@ class GWBSEEngine {
 
   void setQMPackage(QMPackage* qmpackage) { _qmpackage = qmpackage; }
 
+  // see QMPackage::setDisplacedGeometry
+  void setDisplacedGeometry(bool displaced);
+
   std::string GetDFTLog() const { return _dftlog_file; };
 
   void setLoggerFile(std::string logger_file) { _logger_file = logger_file; };
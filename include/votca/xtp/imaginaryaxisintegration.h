@@ -0,0 +1,92 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_IMAGINARYAXISINTEGRATION_H
+#define VOTCA_XTP_IMAGINARYAXISINTEGRATION_H
+
+// Standard includes
+#include <complex>
+#include <vector>
+
+// Local VOTCA includes
+#include "eigen.h"
+
+namespace votca {
+namespace xtp {
+
+class RPA;
+
+// Screened interaction 1-eps^-1(it) on a Gauss-Legendre grid mapped onto the
+// positive imaginary axis. From it sums over RPA poles of the form
+// Sum_s r_s^2/(omega+Omega_s) are evaluated without the RPA eigensystem.
+class ImaginaryAxisIntegration {
+ public:
+  ImaginaryAxisIntegration(const RPA& rpa) : _rpa(rpa){};
+
+  void configure(Index order);
+
+  Index order() const { return _gridpoints.size(); }
+
+  // frees the screening matrices until the next configure
+  void clear();
+
+  // 1/4 M1^T (1-eps^-1(it)) M2 for each pair of rows of Mmn1 and Mmn2. The
+  // first column is the static value, every further column holds one
+  // gridpoint with the static value subtracted.
+  Eigen::MatrixXd CalcKernel(const Eigen::MatrixXd& Mmn1,
+                             const Eigen::MatrixXd& Mmn2) const;
+  // CalcKernel of Mmn1 with each matrix of Mmn2, the screening is applied to
+  // Mmn1 only once for all of them
+  std::vector<Eigen::MatrixXd> CalcKernels(
+      const Eigen::MatrixXd& Mmn1,
+      const std::vector<const Eigen::MatrixXd*>& Mmn2) const;
+
+  // Sum_s r_s^2/(omega+Omega_s) for Re(omega)>=0 and
+  // Sum_s r_s^2/(omega-Omega_s) for Re(omega)<0.
+  double PoleSum(const Eigen::Ref<const Eigen::RowVectorXd>& kernel,
+                 double omega) const;
+  // Same for complex omega, where the lorentzian peaks at t=Im(omega) and is
+  // therefore integrated analytically against the interpolated screening.
+  std::complex<double> PoleSum(
+      const Eigen::Ref<const Eigen::RowVectorXd>& kernel,
+      std::complex<double> omega) const;
+
+  double PoleSumDerivative(const Eigen::Ref<const Eigen::RowVectorXd>& kernel,
+                           double omega) const;
+
+ private:
+  // scale of the mapping of [-1,1] onto the positive imaginary axis
+  static constexpr double _scale = 0.5;
+
+  const RPA& _rpa;
+
+  Eigen::VectorXd _gridpoints;
+  Eigen::VectorXd _weights;
+  // 1-eps^-1 at zero and at the imaginary gridpoints
+  Eigen::MatrixXd _screening_static;
+  std::vector<Eigen::MatrixXd> _screening;
+
+  Eigen::MatrixXd CalcScreening(const Eigen::MatrixXd& eps) const;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_IMAGINARYAXISINTEGRATION_H
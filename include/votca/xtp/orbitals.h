@@ -79,6 +79,13 @@ class Orbitals {
     _number_alpha_electrons = electrons;
   }
 
+  // only set for unrestricted calculations
+  Index getNumberOfBetaElectrons() const { return _number_beta_electrons; };
+
+  void setNumberOfBetaElectrons(Index electrons) {
+    _number_beta_electrons = electrons;
+  }
+
   bool hasECPName() const { return (_ECP != "") ? true : false; }
 
   const std::string &getECPName() const { return _ECP; };
@@ -99,6 +106,13 @@ class Orbitals {
   const tools::EigenSystem &MOs() const { return _mos; }
   tools::EigenSystem &MOs() { return _mos; }
 
+  // beta orbitals of unrestricted calculations, MOs() then holds the alpha
+  // orbitals and getLumo/getHomo refer to them
+  bool hasBetaMOs() const { return (_mos_beta.eigenvalues().size() > 0); }
+
+  const tools::EigenSystem &MOs_beta() const { return _mos_beta; }
+  tools::EigenSystem &MOs_beta() { return _mos_beta; }
+
   // access to DFT molecular orbital energy of a specific level
   double getMOEnergy(Index level) const {
     if (level < _mos.eigenvalues().size()) {
@@ -352,10 +366,12 @@ class Orbitals {
   Index _basis_set_size;
   Index _occupied_levels;
   Index _number_alpha_electrons;
+  Index _number_beta_electrons = 0;
   std::string _ECP = "";
   bool _useTDA;
 
   tools::EigenSystem _mos;
+  tools::EigenSystem _mos_beta;
 
   QMMolecule _atoms;
 
@@ -396,7 +412,7 @@ class Orbitals {
 
   bool _use_Hqp_offdiag = true;
 
-  static constexpr int orbitals_version() { return 1; }
+  static constexpr int orbitals_version() { return 2; }
 };
 
 }  // namespace xtp
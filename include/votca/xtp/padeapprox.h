@@ -0,0 +1,52 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_PADEAPPROX_H
+#define VOTCA_XTP_PADEAPPROX_H
+
+// Standard includes
+#include <complex>
+
+// Local VOTCA includes
+#include "eigen.h"
+
+namespace votca {
+namespace xtp {
+
+// Rational interpolation of a function of a complex frequency as a Thiele
+// continued fraction through a set of points, H.J. Vidberg and J.W. Serene,
+// J. Low Temp. Phys. 29, 179 (1977)
+class PadeApprox {
+ public:
+  void Fit(const Eigen::VectorXcd& points, const Eigen::VectorXcd& values);
+
+  std::complex<double> value(std::complex<double> frequency) const;
+
+  std::complex<double> derivative(std::complex<double> frequency) const;
+
+ private:
+  Eigen::VectorXcd _points;
+  Eigen::VectorXcd _coeffs;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_PADEAPPROX_H
@@ -77,6 +77,15 @@ class QMPackage {
     }
   }
 
+  // removes the sites added by AddRegion, e.g. before the next QM/MM step
+  void ClearExternalSites() { _externalsites.clear(); }
+
+  // displaced geometries, e.g. of finite difference forces, are no steps of a
+  // trajectory. Packages which extrapolate their guess from earlier steps
+  // start them from the density of the reference geometry and do not add
+  // their results to the history.
+  void setDisplacedGeometry(bool displaced) { _displaced_geometry = displaced; }
+
   void setRunDir(const std::string& run_dir) { _run_dir = run_dir; }
 
   void setInputFileName(const std::string& input_file_name) {
@@ -165,6 +174,7 @@ class QMPackage {
   std::string _run_dir;
   std::string _scratch_dir;
   std::string _shell_file_name;
+  bool _displaced_geometry = false;
 
   Logger* _pLog;
 
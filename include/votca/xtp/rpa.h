@@ -22,6 +22,7 @@
 #define VOTCA_XTP_RPA_H
 
 // Standard includes
+#include <complex>
 #include <vector>
 
 // Local VOTCA includes
@@ -43,15 +44,34 @@ class RPA {
   }
 
   Eigen::MatrixXd calculate_epsilon_i(double frequency) const {
-    return calculate_epsilon<true>(frequency);
+    return calculate_epsilon(Eigen::VectorXd(0),
+                             Eigen::VectorXd::Constant(1, frequency))[0];
   }
 
   Eigen::MatrixXd calculate_epsilon_r(double frequency) const {
-    return calculate_epsilon<false>(frequency);
+    return calculate_epsilon(Eigen::VectorXd::Constant(1, frequency),
+                             Eigen::VectorXd(0))[0];
   }
 
+  std::vector<Eigen::MatrixXd> calculate_epsilon_i(
+      const Eigen::VectorXd& frequencies) const {
+    return calculate_epsilon(Eigen::VectorXd(0), frequencies);
+  }
+
+  // dielectric matrices at real and then imaginary frequencies, built in a
+  // single pass over Mmn
+  std::vector<Eigen::MatrixXd> calculate_epsilon(
+      const Eigen::VectorXd& real_frequencies,
+      const Eigen::VectorXd& imaginary_frequencies) const;
+
+  // dielectric matrix at a complex frequency, no broadening is added
+  Eigen::MatrixXcd calculate_epsilon_complex(
+      std::complex<double> frequency) const;
+
   const Eigen::VectorXd& getRPAInputEnergies() const { return _energies; }
 
+  Logger& getLogger() const { return _log; }
+
   void setRPAInputEnergies(const Eigen::VectorXd& rpaenergies) {
     _energies = rpaenergies;
   }
@@ -75,15 +95,16 @@ class RPA {
   Index _rpamin;
   Index _rpamax;
   const double _eta = 0.0001;
+  // columns of epsilon updated per task in calculate_epsilon
+  static constexpr Index _panelsize = 64;
+  // rows of stacked occupied Mmn blocks per tile in calculate_epsilon
+  static constexpr Index _tilerows = 512;
 
   Eigen::VectorXd _energies;
 
   Logger& _log;
   const TCMatrix_gwbse& _Mmn;
 
-  template <bool imag>
-  Eigen::MatrixXd calculate_epsilon(double frequency) const;
-
   Eigen::VectorXd Calculate_H2p_AmB() const;
   Eigen::MatrixXd Calculate_H2p_ApB() const;
   Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> Diagonalize_H2p_C(
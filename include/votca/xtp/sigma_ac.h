@@ -0,0 +1,100 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_SIGMA_AC_H
+#define VOTCA_XTP_SIGMA_AC_H
+
+// Standard includes
+#include <array>
+#include <vector>
+
+// Local VOTCA includes
+#include "imaginaryaxisintegration.h"
+#include "padeapprox.h"
+#include "rpa.h"
+#include "sigma_base.h"
+
+namespace votca {
+namespace xtp {
+
+class TCMatrix_gwbse;
+class RPA;
+
+// Self-energy on the imaginary axis around the Fermi level, continued to the
+// real axis with a Pade approximant. The imaginary axis values come from the
+// same screening grid as Sigma_CD, but no residues are needed, so the cost
+// per frequency does not grow for levels far from the gap.
+class Sigma_AC : public Sigma_base {
+
+ public:
+  Sigma_AC(TCMatrix_gwbse& Mmn, RPA& rpa)
+      : Sigma_base(Mmn, rpa),
+        _grids{{ImaginaryAxisIntegration(rpa),
+                ImaginaryAxisIntegration(rpa)}} {};
+
+  // Sets up the screening parametrisation
+  void PrepareScreening() final;
+  // Calculates Sigma_c diagonal elements
+  double CalcCorrelationDiagElement(Index gw_level,
+                                    double frequency) const final;
+
+  double CalcCorrelationDiagElementDerivative(Index gw_level,
+                                              double frequency) const final;
+  // Calculates Sigma_c off-diagonal elements
+  double CalcCorrelationOffDiagElement(Index gw_level1, Index gw_level2,
+                                       double frequency1,
+                                       double frequency2) const final;
+
+  Index getQuadratureOrder() const { return _order; }
+
+ private:
+  static constexpr Index _min_order = 16;
+  static constexpr Index _max_order = 256;
+  static constexpr Index _fit_points = 32;
+  // partner levels per call of ImaginaryAxisIntegration::CalcKernels
+  static constexpr Index _kernel_batch = 16;
+
+  // the last two grids of the order doubling, used for Richardson
+  // extrapolation, both are freed at the end of PrepareScreening
+  std::array<ImaginaryAxisIntegration, 2> _grids;
+  Index _fine = 0;
+  Index _order = 0;
+  double _fermi_level = 0.0;
+  // Fermi level + i nu at which sigma is fitted
+  Eigen::VectorXcd _fitpoints;
+  std::vector<PadeApprox> _pade;
+  // pairs gw_level1<gw_level2, see PairIndex
+  std::vector<PadeApprox> _pade_offdiag;
+
+  Index PairIndex(Index gw_level1, Index gw_level2) const {
+    return gw_level1 * _qptotal - (gw_level1 * (gw_level1 + 1)) / 2 +
+           gw_level2 - gw_level1 - 1;
+  }
+  Eigen::VectorXcd CalcImaginaryAxisSigma(const ImaginaryAxisIntegration& grid,
+                                          Index gw_level1,
+                                          Index gw_level2) const;
+  Eigen::VectorXcd CalcImaginaryAxisSigma(const ImaginaryAxisIntegration& grid,
+                                          const Eigen::MatrixXd& kernel) const;
+  void FitOffDiag();
+};
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_SIGMA_AC_H
@@ -43,6 +43,8 @@ class Sigma_base {
     Index rpamin = 0;
     Index rpamax = 0;
     double eta = 1e-3;
+    double quadrature_tolerance = 1e-6;  // only used by cd and ac
+    double residue_memory = 0.0;  // MB, only used by exact, 0 is no limit
   };
 
   void configure(options opt) {
@@ -56,7 +58,7 @@ class Sigma_base {
   // Calculates correlation diagonal
   Eigen::VectorXd CalcCorrelationDiag(const Eigen::VectorXd& frequencies) const;
   // Calculates correlation off-diagonal
-  Eigen::MatrixXd CalcCorrelationOffDiag(
+  virtual Eigen::MatrixXd CalcCorrelationOffDiag(
       const Eigen::VectorXd& frequencies) const;
 
   // Sets up the screening parametrisation
@@ -0,0 +1,112 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_SIGMA_CD_H
+#define VOTCA_XTP_SIGMA_CD_H
+
+// Standard includes
+#include <complex>
+#include <vector>
+
+// Local VOTCA includes
+#include "imaginaryaxisintegration.h"
+#include "rpa.h"
+#include "sigma_base.h"
+
+namespace votca {
+namespace xtp {
+
+class TCMatrix_gwbse;
+class RPA;
+
+// Full frequency self-energy from the auxiliary space resolvent of the RPA
+// problem. The sum over RPA poles of Sigma_Exact is rewritten as an integral
+// of the screened interaction along the imaginary axis, plus residues of the
+// Green's function poles between the frequency and the Fermi level, which
+// need the screened interaction at real frequencies. Both only require
+// aux x aux dielectric matrices, so the two-particle Hamiltonian is never
+// built. The integral is converged to opt.quadrature_tolerance.
+class Sigma_CD : public Sigma_base {
+
+ public:
+  Sigma_CD(TCMatrix_gwbse& Mmn, RPA& rpa)
+      : Sigma_base(Mmn, rpa), _grid(rpa){};
+
+  // Sets up the screening parametrisation
+  void PrepareScreening() final;
+  // Calculates Sigma_c diagonal elements
+  double CalcCorrelationDiagElement(Index gw_level,
+                                    double frequency) const final;
+
+  double CalcCorrelationDiagElementDerivative(Index gw_level,
+                                              double frequency) const final;
+  // Calculates Sigma_c off-diagonal elements
+  double CalcCorrelationOffDiagElement(Index gw_level1, Index gw_level2,
+                                       double frequency1,
+                                       double frequency2) const final;
+  // Calculates all off-diagonal elements, the kernels of the pairs of one
+  // level are built in batches and its residues once
+  Eigen::MatrixXd CalcCorrelationOffDiag(
+      const Eigen::VectorXd& frequencies) const final;
+
+  Index getQuadratureOrder() const { return _grid.order(); }
+
+ private:
+  static constexpr Index _min_order = 16;
+  static constexpr Index _max_order = 256;
+  // partner levels per call of ImaginaryAxisIntegration::CalcKernels
+  static constexpr Index _kernel_batch = 16;
+
+  // eps^-1(-omega+i eta) M_m of the Green's function poles m of gw_level
+  // between frequency and the Fermi level
+  struct ResidueSolutions {
+    Index gw_level = -1;
+    double frequency = 0.0;
+    std::vector<Index> levels;
+    std::vector<Eigen::VectorXcd> solutions;
+  };
+
+  ImaginaryAxisIntegration _grid;
+  // per gw level, see ImaginaryAxisIntegration::CalcKernel
+  std::vector<Eigen::MatrixXd> _kernel;
+  // last solutions per thread, e.g. the derivative of a diagonal element at
+  // the same frequency reuses them
+  mutable std::vector<ResidueSolutions> _residue_cache;
+
+  void SetupGrid(Index order);
+  Eigen::MatrixXd CalcKernel(Index gw_level1, Index gw_level2) const;
+  Eigen::VectorXd CalcImaginaryAxisDiag() const;
+
+  double CalcImaginaryAxis(const Eigen::MatrixXd& kernel, double frequency,
+                           bool derivative) const;
+  void SolveResidues(const Eigen::MatrixXd& Mmn, double frequency,
+                     ResidueSolutions& result) const;
+  const ResidueSolutions& getResidueSolutions(Index gw_level,
+                                              double frequency) const;
+  double ResidueDerivative(const Eigen::VectorXcd& solution,
+                           double omega) const;
+  double CalcResidues(Index gw_level, double frequency,
+                      bool derivative) const;
+  Eigen::VectorXd CalcResidueRow(Index gw_level, double frequency) const;
+};
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_SIGMA_CD_H
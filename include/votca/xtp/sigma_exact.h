@@ -20,6 +20,9 @@
 #ifndef VOTCA_XTP_SIGMA_EXACT_H
 #define VOTCA_XTP_SIGMA_EXACT_H
 
+// Standard includes
+#include <vector>
+
 // Local VOTCA includes
 #include "rpa.h"
 #include "sigma_base.h"
@@ -47,12 +50,29 @@ class Sigma_Exact : public Sigma_base {
   double CalcCorrelationOffDiagElement(Index gw_level1, Index gw_level2,
                                        double frequency1,
                                        double frequency2) const final;
+  // Calculates all off-diagonal elements, the residues of the levels beyond
+  // the memory limit are computed in batches of levels
+  Eigen::MatrixXd CalcCorrelationOffDiag(
+      const Eigen::VectorXd& frequencies) const final;
 
  private:
+  // Residues of a level beyond the memory limit, recomputed per thread
+  struct StreamedResidues {
+    Index gw_level = -1;
+    Eigen::MatrixXd residues;
+  };
+
   RPA::rpa_eigensolution _rpa_solution;    // Eigenvalues, eigenvectors from RPA
-  std::vector<Eigen::MatrixXd> _residues;  // Residues
+  std::vector<Eigen::MatrixXd> _residues;  // Residues of the first levels
+  mutable std::vector<StreamedResidues> _streamed;
+  // levels per batch of the off-diagonal elements beyond _residues
+  Index _batchsize = 0;
 
   Eigen::MatrixXd CalcResidues(Index gw_level) const;
+  const Eigen::MatrixXd& getResidues(Index gw_level) const;
+  double CalcOffDiagElement(const Eigen::MatrixXd& residues1,
+                            const Eigen::MatrixXd& residues2,
+                            double frequency1, double frequency2) const;
 };
 }  // namespace xtp
 }  // namespace votca
@@ -0,0 +1,91 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_SITECLUSTERTREE_H
+#define VOTCA_XTP_SITECLUSTERTREE_H
+
+// Standard includes
+#include <memory>
+#include <vector>
+
+// Local VOTCA includes
+#include "eigen.h"
+#include "staticsite.h"
+
+namespace votca {
+namespace xtp {
+
+/**
+ * \brief Octree over external multipole sites
+ *
+ * Sites far away from a region are merged into cluster sites, which carry
+ * the charge, dipole and quadrupole of all sites of a tree cell around the
+ * cell center. The potential of many distant sites can then be evaluated as
+ * the potential of a few clusters. The sites have to outlive the tree.
+ */
+class SiteClusterTree {
+ public:
+  explicit SiteClusterTree(
+      const std::vector<std::unique_ptr<StaticSite> >& sites,
+      Index leafsize = 8);
+
+  // splits the sites into sites, which have to be treated exactly, and
+  // clusters, whose truncated expansions deviate by about less than
+  // tolerance (root sum square over all clusters) from the exact potential
+  // inside the sphere around center
+  void Partition(const Eigen::Vector3d& center, double radius,
+                 double tolerance, std::vector<const StaticSite*>& exact,
+                 std::vector<StaticSite>& clusters) const;
+
+  Index size() const { return Index(_sites.size()); }
+
+ private:
+  struct Node {
+    Eigen::Vector3d center;
+    double radius;
+    // range in _order
+    Index start;
+    Index end;
+    std::vector<Index> children;
+    // norm of the third moment around center and sums of the absolute
+    // multipoles for the error estimate
+    double third_moment = 0.0;
+    double abs_charge = 0.0;
+    double abs_dipole = 0.0;
+    double abs_quadrupole = 0.0;
+    Index size() const { return end - start; }
+  };
+
+  Index Build(Index start, Index end, Index depth);
+  void Partition(Index node, const Eigen::Vector3d& center, double radius,
+                 double tolerance, std::vector<const StaticSite*>& exact,
+                 std::vector<StaticSite>& clusters) const;
+  StaticSite MakeCluster(const Node& node) const;
+
+  Index _leafsize;
+  std::vector<const StaticSite*> _sites;
+  std::vector<Index> _order;
+  std::vector<Node> _nodes;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_SITECLUSTERTREE_H
@@ -43,6 +43,9 @@ class Symmetric_Matrix {
 
   Symmetric_Matrix(const Eigen::MatrixXd& full);
 
+  // constructs the matrix from the packed lower triangle, row by row
+  Symmetric_Matrix(Index dim, const Eigen::Ref<const Eigen::VectorXd>& packed);
+
   Index size() const { return dimension; }
 
   double TraceofProd(const Symmetric_Matrix& a) const;
@@ -23,6 +23,8 @@
 
 // Standard includes
 #include <array>
+#include <memory>
+#include <vector>
 
 // Local VOTCA includes
 #include "eigen.h"
@@ -45,6 +47,8 @@ namespace xtp {
 
 class AOShell;
 class AOBasis;
+class AOShellPairs;
+class AOShellTrafos;
 
 // due to different requirements for the data format for DFT and GW we have two
 // different classes TCMatrix_gwbse and TCMatrix_dft which inherit from TCMatrix
@@ -53,27 +57,108 @@ class TCMatrix {
  public:
   Index Removedfunctions() const { return _removedfunctions; }
 
+  // (ab|P) blocks whose Schwarz bound sqrt((ab|ab)(P|P)) is below eps are
+  // neither computed nor stored
+  void setScreening(double eps) { _screening_eps = eps; }
+
  protected:
   Index _removedfunctions = 0;
   Eigen::MatrixXd _inv_sqrt;
 
+  double _screening_eps = 1e-12;
+  // sqrt(max (ab|ab)) for dft shells b<=a
+  Eigen::MatrixXd _schwarz_pairs;
+  // sqrt(max (P|P)) for aux shells
+  Eigen::VectorXd _schwarz_aux;
+  // for each dft shell a, the shells b<=a for which (ab|P) is significant for
+  // at least one aux shell P
+  std::vector<std::vector<Index>> _shellpairs;
+
+  void ComputeShellPairs(const AOBasis& dftbasis, const AOBasis& auxbasis,
+                         const Eigen::MatrixXd& auxcoulomb);
+
+  bool isSignificant(Index auxshell, Index shell_a, Index shell_b) const {
+    return _schwarz_aux[auxshell] * _schwarz_pairs(shell_a, shell_b) >=
+           _screening_eps;
+  }
+
+  // shellpairs holds the pairs of the basis of shell_row and shell_col,
+  // auxtrafos the transformations of the basis of shell, both may be nullptr
   bool FillThreeCenterRepBlock(Eigen::Tensor<double, 3>& threec_block,
                                const AOShell& shell, const AOShell& shell_row,
-                               const AOShell& shell_col) const;
+                               const AOShell& shell_col,
+                               const AOShellPairs* shellpairs,
+                               const AOShellTrafos* auxtrafos) const;
 };
 
 class TCMatrix_dft : public TCMatrix {
  public:
+  // Integrals which do not fit into max_memory_mb are written to a scratch
+  // file in scratchdir, max_memory_mb<=0 uses the physical memory of the node
+  void setMemoryLimit(double max_memory_mb, const std::string& scratchdir) {
+    _max_memory_mb = max_memory_mb;
+    _scratchdir = scratchdir;
+  }
+
   void Fill(const AOBasis& auxbasis, const AOBasis& dftbasis);
 
-  Index size() const { return Index(_matrix.size()); }
+  // number of auxiliary functions
+  Index size() const { return _auxsize; }
+
+  // number of dft basisfunctions
+  Index dftsize() const { return _dftsize; }
+
+  // number of stored pairs, pairs whose integrals are negligible for all aux
+  // functions are not stored
+  Index pairsize() const { return Index(_pairindex.size()); }
+
+  // selects the stored pairs from a packed (dftsize*(dftsize+1)/2) vector
+  Eigen::VectorXd GatherPairs(const Eigen::VectorXd& packed) const;
+  // packed vector from stored pairs, all other pairs are zero
+  Eigen::VectorXd ScatterPairs(
+      const Eigen::Ref<const Eigen::VectorXd>& stored) const;
 
-  Symmetric_Matrix& operator[](Index i) { return _matrix[i]; }
+  bool isInCore() const { return _scratch == nullptr; }
 
-  const Symmetric_Matrix& operator[](Index i) const { return _matrix[i]; }
+  // number of aux functions which should be processed at once
+  Index AuxBlocksize() const { return _auxblocksize; }
+
+  // copy of the dftsize x dftsize matrix of auxfunction i
+  Symmetric_Matrix operator[](Index i) const {
+    Eigen::MatrixXd buffer;
+    return Symmetric_Matrix(_dftsize,
+                            ScatterPairs(getAuxBlock(i, 1, buffer).col(0)));
+  }
+
+  // integrals of aux functions [start,start+size) as a (stored pairs x size)
+  // matrix, the packed pair index of (i,j) with i>=j is i*(i+1)/2+j. In core
+  // no copy is made, out of core the block is read into buffer. Reading from
+  // the scratch file is not threadsafe.
+  Eigen::Ref<const Eigen::MatrixXd> getAuxBlock(Index start, Index size,
+                                                Eigen::MatrixXd& buffer) const;
 
  private:
-  std::vector<Symmetric_Matrix> _matrix;
+  class ScratchFile;
+
+  Eigen::MatrixXd _matrix;
+  std::shared_ptr<ScratchFile> _scratch = nullptr;
+  double _max_memory_mb = 0.0;
+  std::string _scratchdir = ".";
+  Index _dftsize = 0;
+  Index _auxsize = 0;
+  Index _auxblocksize = 0;
+  // number of stored pairs which are filled at once
+  Index _pairblocksize = 0;
+  // packed pair index of each stored pair
+  std::vector<Index> _pairindex;
+  // first stored pair of each dft shell
+  std::vector<Index> _shellpairstart;
+
+  void SetupPairs(const AOBasis& dftbasis);
+  void SetupStorage();
+  void FillShells(Index shell_begin, Index shell_end, Eigen::MatrixXd& target,
+                  Index first, const AOBasis& dftbasis,
+                  const AOBasis& auxbasis);
 
   void FillBlock(std::vector<Eigen::MatrixXd>& block, Index shellindex,
                  const AOBasis& dftbasis, const AOBasis& auxbasis);
@@ -114,6 +199,11 @@ class TCMatrix_gwbse : public TCMatrix {
 
   void MultiplyRightWithAuxMatrix(const Eigen::MatrixXd& matrix);
 
+  // natural auxiliary functions, eigenvectors of sum_mn M_mn^T M_mn with an
+  // eigenvalue below threshold times the largest eigenvalue are dropped after
+  // Fill, 0 keeps all and the largest one is always kept
+  void setNAFThreshold(double threshold) { _naf_threshold = threshold; }
+
  private:
   // store vector of matrices
   std::vector<Eigen::MatrixXd> _matrix;
@@ -129,6 +219,7 @@ class TCMatrix_gwbse : public TCMatrix {
   Index _ntotal;
   Index _mtotal;
   Index _auxbasissize;
+  double _naf_threshold = 0.0;
 
   const AOBasis* _auxbasis = nullptr;
   const AOBasis* _dftbasis = nullptr;
@@ -140,11 +231,14 @@ class TCMatrix_gwbse : public TCMatrix {
 
   void MultiplyRightWithAuxMatrixOpenMP(const Eigen::MatrixXd& matrix);
 
+  void CompressAuxBasis();
+
   void FillAllBlocksOpenMP(const AOBasis& gwbasis, const AOBasis& dftbasis,
                            const Eigen::MatrixXd& dft_orbitals);
 
   std::vector<Eigen::MatrixXd> ComputeSymmStorage(
-      const AOShell& auxshell, const AOBasis& dftbasis) const;
+      Index auxshellindex, const AOBasis& gwbasis,
+      const AOBasis& dftbasis) const;
 
 #if defined(USE_CUDA)
   std::array<CudaMatrix, 2> SendDFTMatricesToGPU(
@@ -41,6 +41,28 @@ class Vxc_Grid {
   Index getGridSize() const { return _totalgridsize; }
   Index getBoxesSize() const { return Index(_grid_boxes.size()); }
 
+  // without screening every atom enters the partitioning of every point,
+  // which is only useful to check the screening
+  void setPartitionScreening(bool screening) { _screen_partition = screening; }
+
+  // number of gridpoints at which octree boxes are split, has to be set before
+  // GridSetup
+  void setTargetBoxSize(Index boxsize) { _target_boxsize = boxsize; }
+
+  // caches the AO values of the most expensive boxes, as long as the cache
+  // stays below max_memory_mb, returns the number of cached boxes
+  Index CacheAOValues(double max_memory_mb, bool single_precision);
+
+  void ClearAOCache() {
+    for (GridBox& box : _grid_boxes) {
+      box.ClearAOCache();
+    }
+  }
+
+  // after copying a grid, the boxes have to point to the shells of the new
+  // basis, which must be identical to the one used in GridSetup
+  void RebindShells(const AOBasis& basis);
+
   const GridBox& operator[](Index index) const { return _grid_boxes[index]; }
   GridBox& operator[](Index index) { return _grid_boxes[index]; }
 
@@ -57,6 +79,26 @@ class Vxc_Grid {
   }
 
  private:
+  // atoms sorted into cubic cells, to find all atoms near a point without
+  // looping over the whole molecule
+  class AtomCells {
+   public:
+    AtomCells(const QMMolecule& atoms, double cellsize);
+    // appends the indices of all atoms with a distance <= radius to pos in
+    // ascending order
+    void AtomsInSphere(const Eigen::Vector3d& pos, double radius,
+                       std::vector<Index>& result) const;
+    // distance of each atom to its nearest neighbour, max double for one atom
+    Eigen::VectorXd NearestNeighbourDistances() const;
+
+   private:
+    std::vector<Eigen::Vector3d> _pos;
+    double _cellsize;
+    Eigen::Vector3d _min;
+    Eigen::Array<Index, 3, 1> _ncells;
+    std::vector<std::vector<Index> > _cells;
+  };
+
   void FindSignificantShells(const AOBasis& basis);
 
   double erf1c(double x) const;
@@ -64,8 +106,10 @@ class Vxc_Grid {
   void SortGridpointsintoBlocks(
       const std::vector<std::vector<GridContainers::Cartesian_gridpoint> >&
           grid);
+  void SplitIntoOctants(
+      std::vector<const GridContainers::Cartesian_gridpoint*>& points,
+      const Eigen::Vector3d& center, double halfsize, Index depth);
 
-  Eigen::MatrixXd CalcInverseAtomDist(const QMMolecule& atoms) const;
   Index UpdateOrder(LebedevGrid& sphericalgridofElement, Index maxorder,
                     std::vector<double>& PruningIntervals, double r) const;
 
@@ -77,17 +121,24 @@ class Vxc_Grid {
 
   Eigen::VectorXd SSWpartition(const Eigen::VectorXd& rq_i,
                                const Eigen::MatrixXd& Rij) const;
+  // atoms which enter the partitioning of a point of atom i_atom, if i_atom
+  // is not among them its partition weight vanishes
+  std::vector<Index> PartitionAtoms(const QMMolecule& atoms,
+                                    const AtomCells& cells,
+                                    const Eigen::Vector3d& point,
+                                    Index i_atom) const;
   void SSWpartitionAtom(
       const QMMolecule& atoms,
       std::vector<GridContainers::Cartesian_gridpoint>& atomgrid, Index i_atom,
-      const Eigen::MatrixXd& Rij) const;
-  Eigen::MatrixXd CalcDistanceAtomsGridpoints(
-      const QMMolecule& atoms,
-      std::vector<GridContainers::Cartesian_gridpoint>& atomgrid) const;
+      const AtomCells& cells, double nearest_neighbour) const;
 
   Index _totalgridsize;
+  // number of gridpoints per box, at which octree boxes are split and merged
+  // boxes are closed
+  Index _target_boxsize = 256;
   std::vector<GridBox> _grid_boxes;
   bool _density_set = false;
+  bool _screen_partition = true;
 };
 
 }  // namespace xtp
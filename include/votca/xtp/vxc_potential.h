@@ -21,6 +21,9 @@
 #ifndef VOTCA_XTP_VXC_POTENTIAL_H
 #define VOTCA_XTP_VXC_POTENTIAL_H
 
+// Standard includes
+#include <array>
+
 // Third party includes
 #include <xc.h>
 
@@ -42,16 +45,50 @@ class Vxc_Potential {
   static double getExactExchange(const std::string& functional);
   void setXCfunctional(const std::string& functional);
   Mat_p_Energy IntegrateVXC(const Eigen::MatrixXd& density_matrix) const;
+  // spin polarised, returns the alpha and the beta potential, the exchange
+  // correlation energy of both spins is stored with the alpha potential
+  std::array<Mat_p_Energy, 2> IntegrateVXC(
+      const Eigen::MatrixXd& dmat_alpha,
+      const Eigen::MatrixXd& dmat_beta) const;
 
  private:
+  // all quantities are evaluated for a whole gridbox at once
   struct XC_entry {
-    double f_xc = 0;  // E_xc[n] = int{n(r)*eps_xc[n(r)] d3r} = int{ f_xc(r) d3r
-    double df_drho = 0;    // v_xc_rho(r) = df/drho
-    double df_dsigma = 0;  // df/dsigma ( df/dgrad(rho) = df/dsigma *
-                           // dsigma/dgrad(rho) = df/dsigma * 2*grad(rho))
+    explicit XC_entry(Index size)
+        : f_xc(Eigen::VectorXd::Zero(size)),
+          df_drho(Eigen::VectorXd::Zero(size)),
+          df_dsigma(Eigen::VectorXd::Zero(size)){};
+    Eigen::VectorXd f_xc;  // E_xc[n] = int{n(r)*eps_xc[n(r)] d3r} = int{
+                           // f_xc(r) d3r
+    Eigen::VectorXd df_drho;    // v_xc_rho(r) = df/drho
+    Eigen::VectorXd df_dsigma;  // df/dsigma ( df/dgrad(rho) = df/dsigma *
+                                // dsigma/dgrad(rho) = df/dsigma * 2*grad(rho))
+  };
+
+  // libxc expects the spin components of a point to be adjacent
+  using SpinMatrix2 = Eigen::Matrix<double, Eigen::Dynamic, 2, Eigen::RowMajor>;
+  using SpinMatrix3 = Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor>;
+
+  struct XC_entry_polarized {
+    explicit XC_entry_polarized(Index size)
+        : f_xc(Eigen::VectorXd::Zero(size)),
+          df_drho(SpinMatrix2::Zero(size, 2)),
+          df_dsigma(SpinMatrix3::Zero(size, 3)){};
+    Eigen::VectorXd f_xc;   // per particle of the total density
+    SpinMatrix2 df_drho;    // alpha, beta
+    SpinMatrix3 df_dsigma;  // alpha-alpha, alpha-beta, beta-beta
   };
 
-  XC_entry EvaluateXC(double rho, double sigma) const;
+  XC_entry EvaluateXC(const Eigen::VectorXd& rho,
+                      const Eigen::VectorXd& sigma) const;
+  void EvaluateFunctional(const xc_func_type& func, const Eigen::VectorXd& rho,
+                          const Eigen::VectorXd& sigma,
+                          XC_entry& result) const;
+  XC_entry_polarized EvaluateXC(const SpinMatrix2& rho,
+                                const SpinMatrix3& sigma) const;
+  void EvaluateFunctional(const xc_func_type& func, const SpinMatrix2& rho,
+                          const SpinMatrix3& sigma,
+                          XC_entry_polarized& result) const;
 
   const Grid _grid;
   int xfunc_id;
@@ -60,6 +97,9 @@ class Vxc_Potential {
   int cfunc_id;
   xc_func_type xfunc;  // handle for exchange functional
   xc_func_type cfunc;  // handle for correlation functional
+  // spin polarised versions of both
+  xc_func_type xfunc_polarized;
+  xc_func_type cfunc_polarized;
 };
 
 }  // namespace xtp
@@ -0,0 +1,85 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#pragma once
+#ifndef VOTCA_XTP_VXCGRIDCACHE_H
+#define VOTCA_XTP_VXCGRIDCACHE_H
+
+// Standard includes
+#include <deque>
+#include <mutex>
+#include <string>
+
+// Local VOTCA includes
+#include "vxc_grid.h"
+
+namespace votca {
+namespace xtp {
+class QMMolecule;
+
+/**
+ * \brief Process wide cache of set up Vxc_Grids, so that DFT calculations on
+ * the same geometry, e.g. consecutive QM/MM iterations, skip the grid setup
+ *
+ * Grids are identified by a hash of the elements and positions of the atoms,
+ * the grid type and the basisset name. The stored grids hold no AO values,
+ * so that the cache does not keep memory beyond the ao_cache_memory of the
+ * running calculation. Only the last few grids are kept. All methods are
+ * threadsafe.
+ */
+class VxcGridCache {
+ public:
+  static VxcGridCache& Instance();
+
+  // returns true and sets grid if a grid for this geometry exists, the
+  // shells of the grid are rebound to basis
+  bool Find(const std::string& gridtype, const std::string& basisset,
+            const QMMolecule& mol, const AOBasis& basis, Vxc_Grid& grid);
+
+  void Add(const std::string& gridtype, const std::string& basisset,
+           const QMMolecule& mol, const Vxc_Grid& grid);
+
+  void Clear();
+
+  Index size() const;
+
+ private:
+  VxcGridCache() = default;
+
+  struct Entry {
+    std::size_t hash;
+    std::string gridtype;
+    std::string basisset;
+    std::vector<std::string> elements;
+    std::vector<Eigen::Vector3d> positions;
+    Vxc_Grid grid;
+  };
+
+  static std::size_t GeometryHash(const QMMolecule& mol);
+  static bool isSameGeometry(const Entry& entry, const QMMolecule& mol);
+
+  static constexpr Index _max_entries = 4;
+  mutable std::mutex _mutex;
+  std::deque<Entry> _entries;
+};
+
+}  // namespace xtp
+}  // namespace votca
+
+#endif  // VOTCA_XTP_VXCGRIDCACHE_H
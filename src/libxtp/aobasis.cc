@@ -22,6 +22,7 @@
 
 // Local VOTCA includes
 #include "votca/xtp/aobasis.h"
+#include "votca/xtp/aoshellpairs.h"
 #include "votca/xtp/basisset.h"
 #include "votca/xtp/qmmolecule.h"
 #include "votca/xtp/qmpackage.h"
@@ -45,7 +46,29 @@ const std::vector<const AOShell*> AOBasis::getShellsofAtom(Index AtomId) const {
   return result;
 }
 
+const AOShellPairs& AOBasis::ShellPairs() const {
+#pragma omp critical(aobasis_shellpairs)
+  {
+    if (_shellpairs == nullptr) {
+      _shellpairs = std::make_shared<const AOShellPairs>(*this);
+    }
+  }
+  return *_shellpairs;
+}
+
+const AOShellTrafos& AOBasis::ShellTrafos() const {
+#pragma omp critical(aobasis_shelltrafos)
+  {
+    if (_shelltrafos == nullptr) {
+      _shelltrafos = std::make_shared<const AOShellTrafos>(*this);
+    }
+  }
+  return *_shelltrafos;
+}
+
 void AOBasis::Fill(const BasisSet& bs, const QMMolecule& atoms) {
+  _shellpairs = nullptr;
+  _shelltrafos = nullptr;
   _AOBasisSize = 0;
   _aoshells.clear();
   _FuncperAtom.clear();
@@ -25,8 +25,8 @@ namespace votca {
 namespace xtp {
 
 void AOCoulomb::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                          const AOShell& shell_row,
-                          const AOShell& shell_col) const {
+                          const AOShell& shell_row, const AOShell& shell_col,
+                          const AOShellPairs* shellpairs) const {
 
   // shell info, only lmax tells how far to go
   Index lmax_row = Index(shell_row.getL());
@@ -54,12 +54,24 @@ void AOCoulomb::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
   std::array<int, 165> i_less_y = AOTransform::i_less_y();
   std::array<int, 165> i_less_z = AOTransform::i_less_z();
 
+  // the Coulomb interaction of two functions does not decay exponentially
+  // with their distance, so only the transformations of the shells are used
+  const AOShellTrafos* shelltrafos =
+      (shellpairs != nullptr) ? &shellpairs->ShellTrafos() : _shelltrafos;
+  std::vector<Eigen::MatrixXd> buffer_row;
+  std::vector<Eigen::MatrixXd> buffer_col;
+  const Eigen::MatrixXd* trafo_row =
+      AOShellTrafos::Lookup(shelltrafos, shell_row, buffer_row);
+  const Eigen::MatrixXd* trafos_col =
+      AOShellTrafos::Lookup(shelltrafos, shell_col, buffer_col);
+
   // iterate over Gaussians in this shell_row
   for (const auto& gaussian_row : shell_row) {
     // iterate over Gaussians in this shell_col
     const double decay_row = gaussian_row.getDecay();
     const double rdecay_row = 0.5 / decay_row;
     const double powfactor_row = gaussian_row.getPowfactor();
+    const Eigen::MatrixXd* trafo_col = trafos_col;
     for (const auto& gaussian_col : shell_col) {
 
       // get decay constants
@@ -874,14 +886,15 @@ void AOCoulomb::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
           Eigen::Map<Eigen::MatrixXd>(cou.data(), nrows, ncols);
 
       Eigen::MatrixXd cou_sph =
-          AOTransform::getTrafo(gaussian_row).transpose() *
+          trafo_row->transpose() *
           coumat.bottomRightCorner(shell_row.getCartesianNumFunc(),
                                    shell_col.getCartesianNumFunc()) *
-          AOTransform::getTrafo(gaussian_col);
+          (*trafo_col);
       // save to matrix
       matrix += cou_sph;
-
+      ++trafo_col;
     }  // shell_col Gaussians
+    ++trafo_row;
   }    // shell_row Gaussians
   return;
 }
@@ -26,8 +26,8 @@ namespace votca {
 namespace xtp {
 
 void AODipole::FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd> >& matrix,
-                         const AOShell& shell_row,
-                         const AOShell& shell_col) const {
+                         const AOShell& shell_row, const AOShell& shell_col,
+                         const AOShellPairs* shellpairs) const {
 
   /* Calculating the AO matrix of the gradient operator requires
    * the raw overlap matrix (i.e. in unnormalized cartesians)
@@ -57,8 +57,6 @@ void AODipole::FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd> >& matrix,
   // get shell positions
   const Eigen::Vector3d& pos_row = shell_row.getPos();
   const Eigen::Vector3d& pos_col = shell_col.getPos();
-  const Eigen::Vector3d diff = pos_row - pos_col;
-  double distsq = diff.squaredNorm();
 
   std::array<int, 9> n_orbitals = AOTransform::n_orbitals();
   std::array<int, 165> nx = AOTransform::nx();
@@ -68,32 +66,25 @@ void AODipole::FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd> >& matrix,
   std::array<int, 165> i_less_y = AOTransform::i_less_y();
   std::array<int, 165> i_less_z = AOTransform::i_less_z();
 
-  // iterate over Gaussians in this shell_row
-  for (const auto& gaussian_row : shell_row) {
-    const double decay_row = gaussian_row.getDecay();
+  AOShellPairs buffer;
+  const AOShellPair pairs =
+      AOShellPairs::Lookup(shellpairs, shell_row, shell_col, buffer);
 
-    for (const auto& gaussian_col : shell_col) {
-      const double decay_col = gaussian_col.getDecay();
+  // iterate over Gaussians in this shell_row
+  for (Index i_prim = 0; i_prim < pairs.NumRowPrimitives(); i_prim++) {
 
-      const double fak = 0.5 / (decay_row + decay_col);
-      const double fak2 = 2.0 * fak;
+    // iterate over the significant Gaussians in this shell_col
+    for (const AOPrimitivePair& pair : pairs.Row(i_prim)) {
 
-      double exparg = fak2 * decay_row * decay_col * distsq;
-      // check if distance between postions is big, then skip step
-      if (exparg > 30.0) {
-        continue;
-      }
+      const double fak = 0.5 / (pair.decay_row + pair.decay_col);
 
-      const Eigen::Vector3d PmA =
-          fak2 * (decay_row * pos_row + decay_col * pos_col) - pos_row;
-      const Eigen::Vector3d PmB =
-          fak2 * (decay_row * pos_row + decay_col * pos_col) - pos_col;
-      const Eigen::Vector3d pmc =
-          fak2 * (decay_row * pos_row + decay_col * pos_col) - _r;
+      const Eigen::Vector3d PmA = pair.P - pos_row;
+      const Eigen::Vector3d PmB = pair.P - pos_col;
+      const Eigen::Vector3d pmc = pair.P - _r;
 
       AOOverlap overlap;
       Eigen::MatrixXd ol =
-          overlap.Primitive_Overlap(gaussian_row, gaussian_col);
+          overlap.Primitive_Overlap(pair, shell_row, shell_col);
 
       // s-s dipole moment integrals
       for (Index i_comp = 0; i_comp < 3; i_comp++) {
@@ -475,8 +466,8 @@ void AODipole::FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd> >& matrix,
 
       }  // end if (lmax_col > 3)
 
-      Eigen::MatrixXd trafo_row = AOTransform::getTrafo(gaussian_row);
-      Eigen::MatrixXd trafo_col = AOTransform::getTrafo(gaussian_col);
+      const Eigen::MatrixXd& trafo_row = *pair.trafo_row;
+      const Eigen::MatrixXd& trafo_col = *pair.trafo_col;
 
       // cartesian -> spherical
 
@@ -24,11 +24,327 @@
 namespace votca {
 namespace xtp {
 
+namespace {
+
+// number of terms of the expansion of a gaussian around an ecp centre
+constexpr Index NMAX = 41;
+
+/*
+ * Coefficients of the expansion (CKO) of products of spherical functions
+ * around the ecp centre. They only depend on the angular momenta and the
+ * order of the expansion, so they are tabulated once for all combinations of
+ * l<=4 in the DFT basis and in the ECP. G functions in the DFT basis together
+ * with ECPs with l=4 are not supported and left zero.
+ */
+Eigen::Tensor<double, 4> CalcCKOCoefficients() {
+  const double SQ2 = sqrt(2.);
+  const double SQ3 = sqrt(3.);
+  const double SQ5 = sqrt(5.);
+  const double SQ7 = sqrt(7.);
+  const Index lmax_dft_ecp = 4;
+  const Index lmin_dft_ecp = 3;
+
+  Eigen::Tensor<double, 4> COEF(5, 5, 9, NMAX + 1);
+  COEF.setZero();
+  for (Index i4 = 0; i4 <= NMAX; i4++) {
+    /********** ORIGINAL CKOEF SUBROUTINE *************************/
+    Index NU = i4 % 2;
+    Index NG = (i4 + 1) % 2;
+    double FN1 = double(i4 + 1);
+    double FN2 = double(i4 + 2);
+    double FN3 = double(i4 + 3);
+    double FN4 = double(i4 + 4);
+    double FN5 = double(i4 + 5);
+    double FN6 = double(i4 + 6);
+    double FN7 = double(i4 + 7);
+    double FN8 = double(i4 + 8);
+
+    COEF(0, 0, 4, i4) =
+        double(NG) / FN1;  //  M0                      Mn is a modified
+                           //  spherical Bessel function of the first kind
+
+    if (lmax_dft_ecp > 0) {
+
+      double COEFF = double(NU) / FN2 * SQ3;  //  SQ(3) * M1
+      COEF(0, 1, 4, i4) = COEFF;
+      COEF(1, 0, 4, i4) = COEFF;
+
+      if (lmin_dft_ecp > 0) {
+        COEF(1, 1, 4, i4) = double(NG) * 3.0 / FN3;  //  M0 + 2 * M2
+        COEFF = 3.0 / 2.0 * double(NG) * (1.0 / FN1 - 1.0 / FN3);  //  M0 - M2
+        COEF(1, 1, 3, i4) = COEFF;
+        COEF(1, 1, 5, i4) = COEFF;
+      }
+    }
+
+    if (lmax_dft_ecp > 1) {
+
+      double COEFF =
+          double(NG) / 2.0 * SQ5 * (3.0 / FN3 - 1.0 / FN1);  //  SQ(5) * M2
+      COEF(0, 2, 4, i4) = COEFF;
+      COEF(2, 0, 4, i4) = COEFF;
+
+      if (lmin_dft_ecp > 0) {
+        COEFF =
+            SQ3 * SQ5 / 2.0 * double(NG) *
+            (3.0 / FN4 - 1.0 / FN2);  //  ( SQ(15)/5 ) * ( 2 * M1 + 3 * M3 )
+        COEF(1, 2, 4, i4) = COEFF;
+        COEF(2, 1, 4, i4) = COEFF;
+        COEFF = 3. * SQ5 / 2.0 * double(NU) *
+                (1.0 / FN2 - 1.0 / FN4);  //  ( (3*SQ(5))/5 ) * ( M1 - M3 )
+        COEF(1, 2, 3, i4) = COEFF;
+        COEF(1, 2, 5, i4) = COEFF;
+        COEF(2, 1, 3, i4) = COEFF;
+        COEF(2, 1, 5, i4) = COEFF;
+      }
+
+      if (lmin_dft_ecp > 1) {
+        COEF(2, 2, 4, i4) =
+            5.0 / 4.0 * double(NG) *
+            (9.0 / FN5 - 6.0 / FN3 + 1.0 / FN1);  //  (1/7) * ( 7 * M0 + 10 *
+                                                  //  M2 + 18 * M4 )
+        COEFF = double(NG) * 15.0 / 2.0 *
+                (1.0 / FN3 - 1.0 / FN5);  //  (1/7) * ( 7 * M0 +
+                                          //  5 * M2 - 12 * M4 )
+        COEF(2, 2, 3, i4) = COEFF;
+        COEF(2, 2, 5, i4) = COEFF;
+        COEFF = 15.0 / 8.0 * double(NG) *
+                (1.0 / FN1 - 2.0 / FN3 + 1.0 / FN5);  //  (1/7) * ( 7 * M0 -
+                                                      //  10 * M2 + 3 * M4 )
+        COEF(2, 2, 2, i4) = COEFF;
+        COEF(2, 2, 6, i4) = COEFF;
+      }
+    }
+
+    if (lmax_dft_ecp > 2) {
+
+      double COEFF =
+          double(NU) * .5 * SQ7 * (5. / FN4 - 3. / FN2);  //  SQ(7) * M3
+      COEF(0, 3, 4, i4) = COEFF;
+      COEF(3, 0, 4, i4) = COEFF;
+
+      if (lmin_dft_ecp > 0) {
+        COEFF = double(NG) * .5 * SQ3 * SQ7 *
+                (5. / FN5 - 3. / FN3);  //  ( SQ(21)/7 ) * ( 3 * M2 + 4 * M4 )
+        COEF(1, 3, 4, i4) = COEFF;
+        COEF(3, 1, 4, i4) = COEFF;
+        COEFF = double(NG) * .375 * SQ2 * SQ7 *
+                (-5. / FN5 + 6. / FN3 - 1. / FN1);  //  ( (3*SQ(14))/7 ) * (
+                                                    //  M2 - M4 )
+        COEF(1, 3, 3, i4) = COEFF;
+        COEF(1, 3, 5, i4) = COEFF;
+        COEF(3, 1, 3, i4) = COEFF;
+        COEF(3, 1, 5, i4) = COEFF;
+      }
+
+      if (lmin_dft_ecp > 1) {
+        COEFF =
+            double(NU) * .25 * SQ5 * SQ7 *
+            (15. / FN6 - 14. / FN4 + 3. / FN2);  //  ( SQ(35)/105 ) * ( 27 *
+                                                 //  M1 + 28 * M3 + 50 * M5 )
+        COEF(2, 3, 4, i4) = COEFF;
+        COEF(3, 2, 4, i4) = COEFF;
+        COEFF =
+            double(NU) * .375 * SQ2 * SQ5 * SQ7 *
+            (-5. / FN6 + 6. / FN4 - 1. / FN2);  //  ( SQ(70)/105 ) * ( 18 * M1
+                                                //  + 7 * M3 - 25 * M5 )
+        COEF(2, 3, 3, i4) = COEFF;
+        COEF(2, 3, 5, i4) = COEFF;
+        COEF(3, 2, 3, i4) = COEFF;
+        COEF(3, 2, 5, i4) = COEFF;
+        COEFF = double(NU) * 1.875 * SQ7 *
+                (1. / FN6 - 2. / FN4 + 1. / FN2);  //  ( SQ(7)/21 ) * ( 9 * M1
+                                                   //  - 14 * M3 + 5 * M5 )
+        COEF(2, 3, 2, i4) = COEFF;
+        COEF(2, 3, 6, i4) = COEFF;
+        COEF(3, 2, 2, i4) = COEFF;
+        COEF(3, 2, 6, i4) = COEFF;
+      }
+
+      if (lmin_dft_ecp > 2) {
+        COEF(3, 3, 4, i4) =
+            double(NG) * 1.75 *
+            (50. / FN7 - 30. / FN5 + 9. / FN3);  //  (1/33) * ( 33 * M0 + 44 *
+                                                 //  M2 + 54 * M4 + 100 * M6 )
+        COEFF =
+            double(NG) * 1.3125 *
+            (-25. / FN7 + 35. / FN5 - 11. / FN3 +
+             1. / FN1);  //  (1/11) * ( 11 * M0 + 11 * M2 + 3 * M4 - 25 * M6 )
+        COEF(3, 3, 3, i4) = COEFF;
+        COEF(3, 3, 5, i4) = COEFF;
+        COEFF = double(NG) * 105 * .125 *
+                (1. / FN7 - 2. / FN5 + 1. / FN3);  //  (1/11) * ( 11 * M0 - 21
+                                                   //  * M4 + 10 * M6 )
+        COEF(3, 3, 2, i4) = COEFF;
+        COEF(3, 3, 6, i4) = COEFF;
+        COEFF =
+            double(NG) * 35 * .0625 *
+            (-1. / FN7 + 3. / FN5 - 3. / FN3 +
+             1. / FN1);  //  (1/33) * ( 33 * M0 - 55 * M2 + 27 * M4 - 5 * M6 )
+        COEF(3, 3, 1, i4) = COEFF;
+        COEF(3, 3, 7, i4) = COEFF;
+      }
+    }
+
+    if (lmax_dft_ecp > 3) {
+
+      double COEFF =
+          double(NG) * .375 * (35. / FN5 - 30. / FN3 + 3. / FN1);  //  3 * M4
+      COEF(0, 4, 4, i4) = COEFF;
+      COEF(4, 0, 4, i4) = COEFF;
+
+      if (lmin_dft_ecp > 0) {
+        COEFF = double(NU) * .375 * SQ3 *
+                (35. / FN6 - 30. / FN4 + 3. / FN2);  //  ( SQ(3)/3 ) * ( 4 *
+                                                     //  M3 + 5 * M5 )
+        COEF(1, 4, 4, i4) = COEFF;
+        COEF(4, 1, 4, i4) = COEFF;
+        COEFF = double(NU) * .375 * SQ2 * SQ3 * SQ5 *
+                (-7. / FN6 + 10. / FN4 - 3. / FN2);  //  ( SQ(30)/3 ) * ( M3 -
+                                                     //  M5 )
+        COEF(1, 4, 3, i4) = COEFF;
+        COEF(1, 4, 5, i4) = COEFF;
+        COEF(4, 1, 3, i4) = COEFF;
+        COEF(4, 1, 5, i4) = COEFF;
+      }
+
+      if (lmin_dft_ecp > 1) {
+        COEFF = double(NG) * .1875 * SQ5 *
+                (105. / FN7 - 125. / FN5 + 39. / FN3 -
+                 3. / FN1);  //  ( (3*SQ(5))/77 ) * ( 22 * M2 + 20 * M4 + 35 *
+                             //  M6 )
+        COEF(2, 4, 4, i4) = COEFF;
+        COEF(4, 2, 4, i4) = COEFF;
+        COEFF =
+            double(NG) * 1.875 * SQ2 * SQ3 *
+            (-7. / FN7 + 10. / FN5 - 3. / FN3);  //  ( (5*SQ(6))/77 ) * ( 11 *
+                                                 //  M2 + 3 * M4 - 14 * M6 )
+        COEF(2, 4, 3, i4) = COEFF;
+        COEF(2, 4, 5, i4) = COEFF;
+        COEF(4, 2, 3, i4) = COEFF;
+        COEF(4, 2, 5, i4) = COEFF;
+        COEFF =
+            double(NG) * .9375 * SQ3 *
+            (7. / FN7 - 15. / FN5 + 9. / FN3 -
+             1. / FN1);  //  ( (5*SQ(3))/77 ) * ( 11 * M2 - 18 * M4 + 7 * M6 )
+        COEF(2, 4, 2, i4) = COEFF;
+        COEF(2, 4, 6, i4) = COEFF;
+        COEF(4, 2, 2, i4) = COEFF;
+        COEF(4, 2, 6, i4) = COEFF;
+      }
+
+      if (lmin_dft_ecp > 2) {
+        COEFF = double(NU) * .1875 * SQ7 *
+                (175. / FN8 - 255. / FN6 + 105. / FN4 -
+                 9. / FN2);  //  ( SQ(7)/1001 ) * ( 572 * M1 + 546 * M3 + 660
+                             //  * M5 + 1225 * M7)
+        COEF(3, 4, 4, i4) = COEFF;
+        COEF(4, 3, 4, i4) = COEFF;
+        COEFF = double(NU) * 1.875 * SQ3 * SQ5 * SQ7 *
+                (-35. / FN8 + 57. / FN6 - 25. / FN4 +
+                 3. / FN2);  //  ( SQ(105))/1001 ) * ( 143 * M1 + 91 * M3 + 11
+                             //  * M5 - 245 * M7)
+        COEF(3, 4, 3, i4) = COEFF;
+        COEF(3, 4, 5, i4) = COEFF;
+        COEF(4, 3, 3, i4) = COEFF;
+        COEF(4, 3, 5, i4) = COEFF;
+        COEFF = double(NU) * .9375 * SQ3 * SQ7 *
+                (7. / FN8 - 15. / FN6 + 9. / FN4 -
+                 1. / FN2);  //  ( SQ(21))/1001 ) * ( 286 * M1 - 91 * M3 - 440
+                             //  * M5 + 245 * M7)
+        COEF(3, 4, 2, i4) = COEFF;
+        COEF(3, 4, 6, i4) = COEFF;
+        COEF(4, 3, 2, i4) = COEFF;
+        COEF(4, 3, 6, i4) = COEFF;
+        COEFF = double(NU) * 6.5625 *
+                (-1. / FN8 + 3. / FN6 - 3. / FN4 +
+                 1. / FN2);  //  ( 1/143 ) * ( 143 * M1 - 273 * M3 + 165 * M5
+                             //  - 35 * M7)
+        COEF(3, 4, 1, i4) = COEFF;
+        COEF(3, 4, 7, i4) = COEFF;
+        COEF(4, 3, 1, i4) = COEFF;
+        COEF(4, 3, 7, i4) = COEFF;
+      }
+
+    }
+
+  }  // i4 loop (== CKO )
+  return COEF;
+}
+
+const Eigen::Tensor<double, 4>& CKOCoefficients() {
+  static const Eigen::Tensor<double, 4> coef = CalcCKOCoefficients();
+  return coef;
+}
+
+}  // namespace
+
 void AOECP::FillPotential(const AOBasis& aobasis, const ECPAOBasis& ecp) {
-  this->setECP(&ecp);
+  this->setECP(ecp);
   _aopotential = Fill(aobasis);
 }
 
+void AOECP::setECP(const ECPAOBasis& ecp) {
+  _ecp_types.clear();
+  _ecp_centres.clear();
+  for (const std::vector<const ECPAOShell*>& shells_perAtom :
+       ecp.ShellsPerAtom()) {
+    if (shells_perAtom.empty()) {
+      continue;
+    }
+    ECPParameters params;
+    params.lmax = Index(shells_perAtom[0]->getLmaxElement());
+    Index ngaussians = 0;
+    for (const ECPAOShell* shell_ecp : shells_perAtom) {
+      ngaussians = std::max(ngaussians, shell_ecp->getSize());
+    }
+    // one column per angular momentum of the non-local parts, one row per
+    // gaussian
+    params.power = Eigen::MatrixXi::Zero(ngaussians, params.lmax + 1);
+    params.decay = Eigen::MatrixXd::Zero(ngaussians, params.lmax + 1);
+    params.coef = Eigen::MatrixXd::Zero(ngaussians, params.lmax + 1);
+
+    for (const ECPAOShell* shell_ecp : shells_perAtom) {
+      // only do the non-local parts
+      if (!shell_ecp->isNonLocal()) {
+        // stop if local coefficient is not zero
+        for (const auto& gaussian_ecp : *shell_ecp) {
+          if (std::abs(gaussian_ecp.getContraction()) > 1e-5) {
+            throw std::runtime_error(
+                "ECPs with explicit local parts are not supported. Use "
+                "external DFT instead.");
+          }
+        }
+        continue;
+      }
+      Index index = 0;
+      Index L = Index(shell_ecp->getL());
+      for (const auto& gaussian_ecp : *shell_ecp) {
+        params.power(index, L) = int(gaussian_ecp.getPower());
+        params.decay(index, L) = gaussian_ecp.getDecay();
+        params.coef(index, L) = gaussian_ecp.getContraction();
+        index++;
+      }
+    }
+
+    // atoms of the same element share their radial integrals
+    auto type = std::find_if(
+        _ecp_types.begin(), _ecp_types.end(), [&](const ECPParameters& p) {
+          return p.lmax == params.lmax &&
+                 p.coef.rows() == params.coef.rows() &&
+                 p.power == params.power && p.decay == params.decay &&
+                 p.coef == params.coef;
+        });
+    ECPCentre centre;
+    centre.pos = shells_perAtom[0]->getPos();
+    centre.type = Index(std::distance(_ecp_types.begin(), type));
+    if (type == _ecp_types.end()) {
+      _ecp_types.push_back(params);
+    }
+    _ecp_centres.push_back(centre);
+  }
+}
+
 Eigen::VectorXd AOECP::ExpandContractions(const AOGaussianPrimitive& gaussian,
                                           const AOShell& shell) const {
   return Eigen::VectorXd::Constant(shell.getNumFunc(),
@@ -36,8 +352,8 @@ Eigen::VectorXd AOECP::ExpandContractions(const AOGaussianPrimitive& gaussian,
 }
 
 void AOECP::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                      const AOShell& shell_row,
-                      const AOShell& shell_col) const {
+                      const AOShell& shell_row, const AOShell& shell_col,
+                      const AOShellPairs*) const {
 
   /*
    *
@@ -58,6 +374,24 @@ void AOECP::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
   const Eigen::Vector3d diff = pos_row - pos_col;
   // initialize some helper
   double distsq = diff.squaredNorm();
+  const Index lmax_row = Index(shell_row.getL());
+  const Index lmax_col = Index(shell_col.getL());
+
+  // the expansion of the shells around each ecp centre does not depend on
+  // the primitives
+  std::vector<AngularCoefficients> angular_row(_ecp_centres.size());
+  std::vector<AngularCoefficients> angular_col(_ecp_centres.size());
+  for (Index i = 0; i < Index(_ecp_centres.size()); i++) {
+    const ECPCentre& centre = _ecp_centres[i];
+    const Index lmax_ecp = _ecp_types[centre.type].lmax;
+    getBLMCOF(lmax_ecp, lmax_row, pos_row - centre.pos, angular_row[i].BLC,
+              angular_row[i].C);
+    getBLMCOF(lmax_ecp, lmax_col, pos_col - centre.pos, angular_col[i].BLC,
+              angular_col[i].C);
+  }
+
+  const Index nmax = 2 * NMAX + lmax_row + lmax_col;
+  std::vector<Eigen::MatrixXd> XI(_ecp_types.size());
 
   for (const auto& gaussian_row : shell_row) {
 
@@ -80,49 +414,20 @@ void AOECP::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
 
       Eigen::VectorXd contractions_col =
           ExpandContractions(gaussian_col, shell_col);
-      // for each atom and its pseudopotential, get a matrix
-
-      for (const std::vector<const ECPAOShell*>& shells_perAtom :
-           _ecp->ShellsPerAtom()) {
-        if (shells_perAtom.empty()) {
-          continue;
-        }
 
-        Eigen::Matrix<int, 4, 5> powermatrix =
-            Eigen::Matrix<int, 4, 5>::Zero();  // 4 fit components, non-local
-                                               // ECPs l = 0, 1, 2, 3, 4
-        Eigen::Matrix<double, 4, 5> decaymatrix =
-            Eigen::Matrix<double, 4, 5>::Zero();
-        Eigen::Matrix<double, 4, 5> coefmatrix =
-            Eigen::Matrix<double, 4, 5>::Zero();
-
-        for (const ECPAOShell* shell_ecp : shells_perAtom) {
-          // only do the non-local parts
-          if (!shell_ecp->isNonLocal()) {
-            // stop if local coefficient is not zero
-            for (const auto& gaussian_ecp : *shell_ecp) {
-              if (std::abs(gaussian_ecp.getContraction()) > 1e-5) {
-                throw std::runtime_error(
-                    "ECPs with explicit local parts are not supported. Use "
-                    "external DFT instead.");
-              }
-            }
-            continue;
-          }
-          Index index = 0;
-          Index L = Index(shell_ecp->getL());
-          for (const auto& gaussian_ecp : *shell_ecp) {
-            powermatrix(index, L) = int(gaussian_ecp.getPower());
-            decaymatrix(index, L) = gaussian_ecp.getDecay();
-            coefmatrix(index, L) = gaussian_ecp.getContraction();
-            index++;
-          }
-        }
+      // the radial integrals only depend on the sum of the decays and the
+      // ecp of the element
+      for (Index type = 0; type < Index(_ecp_types.size()); type++) {
+        XI[type] = calcRadialIntegrals(_ecp_types[type],
+                                       decay_row + decay_col, nmax);
+      }
 
-        Eigen::MatrixXd VNL_ECP =
-            calcVNLmatrix(Index(shells_perAtom[0]->getLmaxElement()),
-                          shells_perAtom[0]->getPos(), gaussian_row,
-                          gaussian_col, powermatrix, decaymatrix, coefmatrix);
+      // for each atom and its pseudopotential, get a matrix
+      for (Index i = 0; i < Index(_ecp_centres.size()); i++) {
+        const ECPCentre& centre = _ecp_centres[i];
+        Eigen::MatrixXd VNL_ECP = calcVNLmatrix(
+            _ecp_types[centre.type].lmax, centre.pos, gaussian_row,
+            gaussian_col, XI[centre.type], angular_row[i], angular_col[i]);
 
         auto VNL_ECP_small =
             VNL_ECP.block(shell_row.getOffset(), shell_col.getOffset(),
@@ -135,32 +440,55 @@ void AOECP::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
   }
 }
 
+Eigen::MatrixXd AOECP::calcRadialIntegrals(const ECPParameters& ecp,
+                                           double decay, Index nmax) const {
+  /* radial integrals
+   *    XI(L, N) = sum_I pref(I, L) int r^(N+power) exp(-(decay+gamma) r^2) dr
+   * of the non-local parts of an ecp for even N, odd N are never needed.
+   * The gamma functions and the powers of decay+gamma are built up by
+   * recursion in N.
+   */
+  Eigen::MatrixXd XI = Eigen::MatrixXd::Zero(ecp.lmax + 1, nmax + 1);
+  for (Index L = 0; L <= ecp.lmax; L++) {
+    for (Index I = 0; I < ecp.coef.rows(); I++) {
+      const double pref = ecp.coef(I, L);
+      if (pref == 0.0) {
+        continue;
+      }
+      const double power = double(ecp.power(I, L));
+      const double DLI = decay + ecp.decay(I, L);
+      const double rDLI = 1.0 / DLI;
+      // Gamma((N+1+power)/2)/2 and DLI^(-(N+1+power)/2)
+      double f_even = 0.5 * std::tgamma(0.5 * (power + 1.0));
+      double DLI_pow = std::pow(DLI, -0.5 * (power + 1.0));
+      for (Index N = 0; N <= nmax; N += 2) {
+        XI(L, N) += pref * f_even * DLI_pow;
+        f_even *= 0.5 * (double(N) + 1.0 + power);
+        DLI_pow *= rDLI;
+      }
+    }
+  }
+  return XI;
+}
+
 Eigen::MatrixXd AOECP::calcVNLmatrix(
     Index lmax_ecp, const Eigen::Vector3d& posC,
     const AOGaussianPrimitive& g_row, const AOGaussianPrimitive& g_col,
-    const Eigen::Matrix<int, 4, 5>& power_ecp,
-    const Eigen::Matrix<double, 4, 5>& gamma_ecp,
-    const Eigen::Matrix<double, 4, 5>& pref_ecp) const {
+    const Eigen::MatrixXd& XI, const AngularCoefficients& angular_row,
+    const AngularCoefficients& angular_col) const {
 
   /* calculate the contribution of the nonlocal
    *     ECP of atom at posC with
-   *       decay constants in _gamma_ecp
-   *       coefficients in    _pref_ecp
+   *       radial integrals in XI
    *       with angular momentum of max 4
    *
    * to DFT basis shell pair
    *    with decay alpha at posA
    *         decay beta  at posB
+   * whose expansions around posC are in angular_row and angular_col
    */
 
   const double conv = 1.e-9;  // 1.e-8
-  const Index NMAX = 41;
-  const double PI = boost::math::constants::pi<double>();
-  double SQPI = sqrt(PI);
-  double SQ2 = sqrt(2.);
-  double SQ3 = sqrt(3.);
-  double SQ5 = sqrt(5.);
-  double SQ7 = sqrt(7.);
 
   double alpha = g_row.getDecay();
   double beta = g_col.getDecay();
@@ -186,59 +514,6 @@ Eigen::MatrixXd AOECP::calcVNLmatrix(
     INULL++;
   }
 
-  Eigen::MatrixXd matrix = Eigen::MatrixXd::Zero(nsph_row, nsph_col);
-  const Index nnonsep = gamma_ecp.rows();
-  Index nmax;
-  if (INULL == 0) {
-    nmax = 2 * lmin;
-  } else if (INULL == 3) {
-    nmax = 2 * NMAX + lmax_row + lmax_col;
-  } else {
-    nmax = NMAX + 2 * lmax;
-  }
-  Eigen::MatrixXd XI = Eigen::MatrixXd::Zero(lmax_ecp + 1, nmax + 1);
-
-  double f_even_r0 = .5 * SQPI;
-  double f_even_r1 = .5;
-  double f_even_r2 = .25 * SQPI;
-
-  for (Index N = 0; N <= nmax; N++) {
-
-    if ((N % 2) == 0) {  // N even,   XI(L, odd N) never needed
-
-      if (N > 0) {
-        f_even_r0 = f_even_r2;  // !!
-        f_even_r1 = f_even_r1 * double(N / 2);
-        f_even_r2 = .5 * f_even_r0 * double(N + 1);
-      }
-
-      double DFAK_r0 = .5 * double(N + 1);
-      double DFAK_r1 = .5 * double(N + 2);
-      double DFAK_r2 = .5 * double(N + 3);
-
-      for (Index L = 0; L <= lmax_ecp; L++) {
-
-        for (Index I = 0; I < nnonsep; I++) {
-          Index power = power_ecp(I, L);
-          double DLI = (alpha + beta + gamma_ecp(I, L));
-          if (power == 2) {
-            XI(L, N) += f_even_r2 * pref_ecp(I, L) /
-                        std::pow(DLI, DFAK_r2);  // r^2 terms
-          } else if (power == 0) {
-            XI(L, N) += f_even_r0 * pref_ecp(I, L) /
-                        std::pow(DLI, DFAK_r0);  // r^0 terms
-          } else if (power == 1) {
-            XI(L, N) += f_even_r1 * pref_ecp(I, L) /
-                        std::pow(DLI, DFAK_r1);  // r^1 terms
-          }
-        }
-      }
-
-    }  // end if ( (N % 2) == 0 )
-  }
-
-  /**** PREPARATIONS DONE, NOW START ******/
-
   // some limit determinations
   double G1 = 1.;
   double AVSSQ = 0.;
@@ -351,275 +626,53 @@ Eigen::MatrixXd AOECP::calcVNLmatrix(
 
   /****** ORIGINAL CKO SUBROUTINE **********/
 
-  Eigen::Tensor<double, 4> COEF(5, 5, 9, NMAX + 1);
+  const Eigen::Tensor<double, 4>& COEF = CKOCoefficients();
 
   if (INULL != 0) {
 
     Index lmin_dft_ecp = 0;
-    Index lmax_dft_ecp = 0;
     if (INULL == 2) {
       lmin_dft_ecp = std::min(lmax_row, lmax_ecp);
-      lmax_dft_ecp = std::max(lmax_row, lmax_ecp);
     } else if (INULL == 1) {
       lmin_dft_ecp = std::min(lmax_col, lmax_ecp);
-      lmax_dft_ecp = std::max(lmax_col, lmax_ecp);
     } else if (INULL == 3) {
-      Index lmax_dft = std::max(lmax_row, lmax_col);
-      lmin_dft_ecp = std::min(lmax_dft, lmax_ecp);
-      lmax_dft_ecp = std::max(lmax_dft, lmax_ecp);
+      lmin_dft_ecp = std::min(std::max(lmax_row, lmax_col), lmax_ecp);
     }
+    if (lmin_dft_ecp > 3) {
+      throw std::runtime_error(
+          "Sorry, not yet supported: Combination of G functions in DFT "
+          "basis and ECPs with l = 4.");
+    }
+  }
 
-    for (Index i4 = 0; i4 <= NMAX; i4++) {
-      /********** ORIGINAL CKOEF SUBROUTINE *************************/
-      Index NU = i4 % 2;
-      Index NG = (i4 + 1) % 2;
-      double FN1 = double(i4 + 1);
-      double FN2 = double(i4 + 2);
-      double FN3 = double(i4 + 3);
-      double FN4 = double(i4 + 4);
-      double FN5 = double(i4 + 5);
-      double FN6 = double(i4 + 6);
-      double FN7 = double(i4 + 7);
-      double FN8 = double(i4 + 8);
-
-      COEF(0, 0, 4, i4) =
-          double(NG) / FN1;  //  M0                      Mn is a modified
-                             //  spherical Bessel function of the first kind
-
-      if (lmax_dft_ecp > 0) {
-
-        double COEFF = double(NU) / FN2 * SQ3;  //  SQ(3) * M1
-        COEF(0, 1, 4, i4) = COEFF;
-        COEF(1, 0, 4, i4) = COEFF;
-
-        if (lmin_dft_ecp > 0) {
-          COEF(1, 1, 4, i4) = double(NG) * 3.0 / FN3;  //  M0 + 2 * M2
-          COEFF = 3.0 / 2.0 * double(NG) * (1.0 / FN1 - 1.0 / FN3);  //  M0 - M2
-          COEF(1, 1, 3, i4) = COEFF;
-          COEF(1, 1, 5, i4) = COEFF;
-        }
-      }
-
-      if (lmax_dft_ecp > 1) {
-
-        double COEFF =
-            double(NG) / 2.0 * SQ5 * (3.0 / FN3 - 1.0 / FN1);  //  SQ(5) * M2
-        COEF(0, 2, 4, i4) = COEFF;
-        COEF(2, 0, 4, i4) = COEFF;
-
-        if (lmin_dft_ecp > 0) {
-          COEFF =
-              SQ3 * SQ5 / 2.0 * double(NG) *
-              (3.0 / FN4 - 1.0 / FN2);  //  ( SQ(15)/5 ) * ( 2 * M1 + 3 * M3 )
-          COEF(1, 2, 4, i4) = COEFF;
-          COEF(2, 1, 4, i4) = COEFF;
-          COEFF = 3. * SQ5 / 2.0 * double(NU) *
-                  (1.0 / FN2 - 1.0 / FN4);  //  ( (3*SQ(5))/5 ) * ( M1 - M3 )
-          COEF(1, 2, 3, i4) = COEFF;
-          COEF(1, 2, 5, i4) = COEFF;
-          COEF(2, 1, 3, i4) = COEFF;
-          COEF(2, 1, 5, i4) = COEFF;
-        }
-
-        if (lmin_dft_ecp > 1) {
-          COEF(2, 2, 4, i4) =
-              5.0 / 4.0 * double(NG) *
-              (9.0 / FN5 - 6.0 / FN3 + 1.0 / FN1);  //  (1/7) * ( 7 * M0 + 10 *
-                                                    //  M2 + 18 * M4 )
-          COEFF = double(NG) * 15.0 / 2.0 *
-                  (1.0 / FN3 - 1.0 / FN5);  //  (1/7) * ( 7 * M0 +
-                                            //  5 * M2 - 12 * M4 )
-          COEF(2, 2, 3, i4) = COEFF;
-          COEF(2, 2, 5, i4) = COEFF;
-          COEFF = 15.0 / 8.0 * double(NG) *
-                  (1.0 / FN1 - 2.0 / FN3 + 1.0 / FN5);  //  (1/7) * ( 7 * M0 -
-                                                        //  10 * M2 + 3 * M4 )
-          COEF(2, 2, 2, i4) = COEFF;
-          COEF(2, 2, 6, i4) = COEFF;
-        }
-      }
-
-      if (lmax_dft_ecp > 2) {
-
-        double COEFF =
-            double(NU) * .5 * SQ7 * (5. / FN4 - 3. / FN2);  //  SQ(7) * M3
-        COEF(0, 3, 4, i4) = COEFF;
-        COEF(3, 0, 4, i4) = COEFF;
-
-        if (lmin_dft_ecp > 0) {
-          COEFF = double(NG) * .5 * SQ3 * SQ7 *
-                  (5. / FN5 - 3. / FN3);  //  ( SQ(21)/7 ) * ( 3 * M2 + 4 * M4 )
-          COEF(1, 3, 4, i4) = COEFF;
-          COEF(3, 1, 4, i4) = COEFF;
-          COEFF = double(NG) * .375 * SQ2 * SQ7 *
-                  (-5. / FN5 + 6. / FN3 - 1. / FN1);  //  ( (3*SQ(14))/7 ) * (
-                                                      //  M2 - M4 )
-          COEF(1, 3, 3, i4) = COEFF;
-          COEF(1, 3, 5, i4) = COEFF;
-          COEF(3, 1, 3, i4) = COEFF;
-          COEF(3, 1, 5, i4) = COEFF;
-        }
-
-        if (lmin_dft_ecp > 1) {
-          COEFF =
-              double(NU) * .25 * SQ5 * SQ7 *
-              (15. / FN6 - 14. / FN4 + 3. / FN2);  //  ( SQ(35)/105 ) * ( 27 *
-                                                   //  M1 + 28 * M3 + 50 * M5 )
-          COEF(2, 3, 4, i4) = COEFF;
-          COEF(3, 2, 4, i4) = COEFF;
-          COEFF =
-              double(NU) * .375 * SQ2 * SQ5 * SQ7 *
-              (-5. / FN6 + 6. / FN4 - 1. / FN2);  //  ( SQ(70)/105 ) * ( 18 * M1
-                                                  //  + 7 * M3 - 25 * M5 )
-          COEF(2, 3, 3, i4) = COEFF;
-          COEF(2, 3, 5, i4) = COEFF;
-          COEF(3, 2, 3, i4) = COEFF;
-          COEF(3, 2, 5, i4) = COEFF;
-          COEFF = double(NU) * 1.875 * SQ7 *
-                  (1. / FN6 - 2. / FN4 + 1. / FN2);  //  ( SQ(7)/21 ) * ( 9 * M1
-                                                     //  - 14 * M3 + 5 * M5 )
-          COEF(2, 3, 2, i4) = COEFF;
-          COEF(2, 3, 6, i4) = COEFF;
-          COEF(3, 2, 2, i4) = COEFF;
-          COEF(3, 2, 6, i4) = COEFF;
-        }
-
-        if (lmin_dft_ecp > 2) {
-          COEF(3, 3, 4, i4) =
-              double(NG) * 1.75 *
-              (50. / FN7 - 30. / FN5 + 9. / FN3);  //  (1/33) * ( 33 * M0 + 44 *
-                                                   //  M2 + 54 * M4 + 100 * M6 )
-          COEFF =
-              double(NG) * 1.3125 *
-              (-25. / FN7 + 35. / FN5 - 11. / FN3 +
-               1. / FN1);  //  (1/11) * ( 11 * M0 + 11 * M2 + 3 * M4 - 25 * M6 )
-          COEF(3, 3, 3, i4) = COEFF;
-          COEF(3, 3, 5, i4) = COEFF;
-          COEFF = double(NG) * 105 * .125 *
-                  (1. / FN7 - 2. / FN5 + 1. / FN3);  //  (1/11) * ( 11 * M0 - 21
-                                                     //  * M4 + 10 * M6 )
-          COEF(3, 3, 2, i4) = COEFF;
-          COEF(3, 3, 6, i4) = COEFF;
-          COEFF =
-              double(NG) * 35 * .0625 *
-              (-1. / FN7 + 3. / FN5 - 3. / FN3 +
-               1. / FN1);  //  (1/33) * ( 33 * M0 - 55 * M2 + 27 * M4 - 5 * M6 )
-          COEF(3, 3, 1, i4) = COEFF;
-          COEF(3, 3, 7, i4) = COEFF;
-        }
-      }
-
-      if (lmax_dft_ecp > 3) {
-
-        double COEFF =
-            double(NG) * .375 * (35. / FN5 - 30. / FN3 + 3. / FN1);  //  3 * M4
-        COEF(0, 4, 4, i4) = COEFF;
-        COEF(4, 0, 4, i4) = COEFF;
-
-        if (lmin_dft_ecp > 0) {
-          COEFF = double(NU) * .375 * SQ3 *
-                  (35. / FN6 - 30. / FN4 + 3. / FN2);  //  ( SQ(3)/3 ) * ( 4 *
-                                                       //  M3 + 5 * M5 )
-          COEF(1, 4, 4, i4) = COEFF;
-          COEF(4, 1, 4, i4) = COEFF;
-          COEFF = double(NU) * .375 * SQ2 * SQ3 * SQ5 *
-                  (-7. / FN6 + 10. / FN4 - 3. / FN2);  //  ( SQ(30)/3 ) * ( M3 -
-                                                       //  M5 )
-          COEF(1, 4, 3, i4) = COEFF;
-          COEF(1, 4, 5, i4) = COEFF;
-          COEF(4, 1, 3, i4) = COEFF;
-          COEF(4, 1, 5, i4) = COEFF;
-        }
-
-        if (lmin_dft_ecp > 1) {
-          COEFF = double(NG) * .1875 * SQ5 *
-                  (105. / FN7 - 125. / FN5 + 39. / FN3 -
-                   3. / FN1);  //  ( (3*SQ(5))/77 ) * ( 22 * M2 + 20 * M4 + 35 *
-                               //  M6 )
-          COEF(2, 4, 4, i4) = COEFF;
-          COEF(4, 2, 4, i4) = COEFF;
-          COEFF =
-              double(NG) * 1.875 * SQ2 * SQ3 *
-              (-7. / FN7 + 10. / FN5 - 3. / FN3);  //  ( (5*SQ(6))/77 ) * ( 11 *
-                                                   //  M2 + 3 * M4 - 14 * M6 )
-          COEF(2, 4, 3, i4) = COEFF;
-          COEF(2, 4, 5, i4) = COEFF;
-          COEF(4, 2, 3, i4) = COEFF;
-          COEF(4, 2, 5, i4) = COEFF;
-          COEFF =
-              double(NG) * .9375 * SQ3 *
-              (7. / FN7 - 15. / FN5 + 9. / FN3 -
-               1. / FN1);  //  ( (5*SQ(3))/77 ) * ( 11 * M2 - 18 * M4 + 7 * M6 )
-          COEF(2, 4, 2, i4) = COEFF;
-          COEF(2, 4, 6, i4) = COEFF;
-          COEF(4, 2, 2, i4) = COEFF;
-          COEF(4, 2, 6, i4) = COEFF;
-        }
-
-        if (lmin_dft_ecp > 2) {
-          COEFF = double(NU) * .1875 * SQ7 *
-                  (175. / FN8 - 255. / FN6 + 105. / FN4 -
-                   9. / FN2);  //  ( SQ(7)/1001 ) * ( 572 * M1 + 546 * M3 + 660
-                               //  * M5 + 1225 * M7)
-          COEF(3, 4, 4, i4) = COEFF;
-          COEF(4, 3, 4, i4) = COEFF;
-          COEFF = double(NU) * 1.875 * SQ3 * SQ5 * SQ7 *
-                  (-35. / FN8 + 57. / FN6 - 25. / FN4 +
-                   3. / FN2);  //  ( SQ(105))/1001 ) * ( 143 * M1 + 91 * M3 + 11
-                               //  * M5 - 245 * M7)
-          COEF(3, 4, 3, i4) = COEFF;
-          COEF(3, 4, 5, i4) = COEFF;
-          COEF(4, 3, 3, i4) = COEFF;
-          COEF(4, 3, 5, i4) = COEFF;
-          COEFF = double(NU) * .9375 * SQ3 * SQ7 *
-                  (7. / FN8 - 15. / FN6 + 9. / FN4 -
-                   1. / FN2);  //  ( SQ(21))/1001 ) * ( 286 * M1 - 91 * M3 - 440
-                               //  * M5 + 245 * M7)
-          COEF(3, 4, 2, i4) = COEFF;
-          COEF(3, 4, 6, i4) = COEFF;
-          COEF(4, 3, 2, i4) = COEFF;
-          COEF(4, 3, 6, i4) = COEFF;
-          COEFF = double(NU) * 6.5625 *
-                  (-1. / FN8 + 3. / FN6 - 3. / FN4 +
-                   1. / FN2);  //  ( 1/143 ) * ( 143 * M1 - 273 * M3 + 165 * M5
-                               //  - 35 * M7)
-          COEF(3, 4, 1, i4) = COEFF;
-          COEF(3, 4, 7, i4) = COEFF;
-          COEF(4, 3, 1, i4) = COEFF;
-          COEF(4, 3, 7, i4) = COEFF;
-        }
-
-        if (lmin_dft_ecp > 3) {
-          throw std::runtime_error(
-              "Sorry, not yet supported: Combination of G functions in DFT "
-              "basis and ECPs with l = 4.");
-        }
-      }
-
-    }  // i4 loop (== CKO )
+  // (2 alpha |A-C|)^N / N! and (2 beta |B-C|)^N / N!
+  Eigen::VectorXd powfac1 = Eigen::VectorXd::Ones(NMAX1 + 1);
+  for (Index N = 1; N <= NMAX1; N++) {
+    powfac1(N) = powfac1(N - 1) * 2.0 * alpha * AVSSQ / double(N);
+  }
+  Eigen::VectorXd powfac2 = Eigen::VectorXd::Ones(NMAX2 + 1);
+  for (Index NN = 1; NN <= NMAX2; NN++) {
+    powfac2(NN) = powfac2(NN - 1) * 2.0 * beta * BVSSQ / double(NN);
+  }
 
-  }  // end if (INULL != 0)
+  const Eigen::Tensor<double, 3>& BLMA = angular_row.BLC;
+  const Eigen::Tensor<double, 3>& CA = angular_row.C;
+  const Eigen::Tensor<double, 3>& BLMB = angular_col.BLC;
+  const Eigen::Tensor<double, 3>& CB = angular_col.C;
 
-  Eigen::Tensor<double, 3> BLMA;
-  Eigen::Tensor<double, 3> CA;
-  getBLMCOF(lmax_ecp, lmax_row, AVS, BLMA, CA);
-  Eigen::Tensor<double, 3> BLMB;
-  Eigen::Tensor<double, 3> CB;
-  getBLMCOF(lmax_ecp, lmax_col, BVS, BLMB, CB);
+  // coupling of the components (L1, M1) of the row and (L2, M2) of the
+  // column expansion, with index L + 5 * M, so that
+  // matrix = BLMA * T * BLMB^T
+  Eigen::Matrix<double, 45, 45> T = Eigen::Matrix<double, 45, 45>::Zero();
 
   switch (INULL) {
 
     case 0:  //  AVSSQ <= 0.1 && BVSSQ <= 0.1
     {
-
-      for (Index i = 0; i < nsph_row; i++) {
-        for (Index j = 0; j < nsph_col; j++) {
-          for (Index L = 0; L <= lmin; L++) {
-            double XI_L = XI(L, L + L);
-            for (Index M = 4 - L; M <= 4 + L; M++) {
-              matrix(i, j) += BLMA(i, L, M) * BLMB(j, L, M) * XI_L;
-            }
-          }
+      for (Index L = 0; L <= lmin; L++) {
+        double XI_L = XI(L, L + L);
+        for (Index M = 4 - L; M <= 4 + L; M++) {
+          T(L + 5 * M, L + 5 * M) = XI_L;
         }
       }
       break;
@@ -627,191 +680,86 @@ Eigen::MatrixXd AOECP::calcVNLmatrix(
 
     case 1:  //  AVSSQ <= 0.1
     {
-
-      Eigen::TensorFixedSize<double, Eigen::Sizes<5, 5, 9>> SUMCI3;
-      for (Index L = 0; L <= lmax_ecp; L++) {
+      for (Index L = 0; L <= std::min(lmax_row, lmax_ecp); L++) {
         for (Index L2 = 0; L2 <= lmax_col; L2++) {
           Index range_M2 = std::min(L2, L);
           for (Index M2 = 4 - range_M2; M2 <= 4 + range_M2; M2++) {
 
             double VAR2 = 0.0;
-            double fak = 2.0 * beta * BVSSQ;
-            double pow = 1;
-            double factorialNN = 1;
-
             for (Index NN = 0; NN <= NMAX2; NN++) {
-
-              if (NN != 0) {
-                pow = pow * fak;
-                factorialNN = factorialNN * double(NN);
-              }
-
-              double XDUM = COEF(L, L2, M2, NN) * pow / factorialNN;
-              VAR2 += XDUM * XI(L, NN + L + L2);
+              VAR2 += COEF(L, L2, M2, NN) * powfac2(NN) * XI(L, NN + L + L2);
             }
 
-            SUMCI3(L, L2, M2) = VAR2;
-
+            for (Index M1 = 4 - L; M1 <= 4 + L; M1++) {
+              T(L + 5 * M1, L2 + 5 * M2) += VAR2 * CB(L, M1, M2);
+            }
           }  // end M2
         }    // end L2
       }      // end L
-
-      for (Index i = 0; i < nsph_row; i++) {
-        for (Index j = 0; j < nsph_col; j++) {
-
-          for (Index L = 0; L <= std::min(lmax_row, lmax_ecp); L++) {
-            for (Index L2 = 0; L2 <= lmax_col; L2++) {
-              Index range_M2 = std::min(L2, L);
-              for (Index M2 = 4 - range_M2; M2 <= 4 + range_M2; M2++) {
-
-                for (Index M1 = 4 - L; M1 <= 4 + L; M1++) {
-                  matrix(i, j) += BLMA(i, L, M1) * BLMB(j, L2, M2) *
-                                  SUMCI3(L, L2, M2) * CB(L, M1, M2);
-                }
-              }
-            }
-          }
-        }
-      }
-
       break;
     }
 
     case 2:  //  BVSSQ <= 0.1
     {
-
-      Eigen::TensorFixedSize<double, Eigen::Sizes<5, 5, 9>> SUMCI3;
-      for (Index L = 0; L <= lmax_ecp; L++) {
+      for (Index L = 0; L <= std::min(lmax_col, lmax_ecp); L++) {
         for (Index L1 = 0; L1 <= lmax_row; L1++) {
           Index range_M1 = std::min(L1, L);
           for (Index M1 = 4 - range_M1; M1 <= 4 + range_M1; M1++) {
 
             double VAR1 = 0.0;
-            double fak = 2.0 * alpha * AVSSQ;
-            double pow = 1;
-            double factorialN = 1;
-
             for (Index N = 0; N <= NMAX1; N++) {
-
-              if (N != 0) {
-                pow = pow * fak;
-                factorialN = factorialN * double(N);
-              }
-
-              double XDUM = COEF(L, L1, M1, N) * pow / factorialN;
-              VAR1 += XDUM * XI(L, N + L1 + L);
+              VAR1 += COEF(L, L1, M1, N) * powfac1(N) * XI(L, N + L1 + L);
             }
 
-            SUMCI3(L, L1, M1) = VAR1;
-
+            for (Index M2 = 4 - L; M2 <= 4 + L; M2++) {
+              T(L1 + 5 * M1, L + 5 * M2) += VAR1 * CA(L, M2, M1);
+            }
           }  // end M1
         }    // end L1
       }      // end L
-
-      for (Index i = 0; i < nsph_row; i++) {
-        for (Index j = 0; j < nsph_col; j++) {
-
-          for (Index L = 0; L <= std::min(lmax_col, lmax_ecp); L++) {
-            for (Index L1 = 0; L1 <= lmax_row; L1++) {
-              Index range_M1 = std::min(L1, L);
-              for (Index M1 = 4 - range_M1; M1 <= 4 + range_M1; M1++) {
-
-                for (Index M2 = 4 - L; M2 <= 4 + L; M2++) {
-                  matrix(i, j) += BLMA(i, L1, M1) * BLMB(j, L, M2) *
-                                  SUMCI3(L, L1, M1) * CA(L, M2, M1);
-                }
-              }
-            }
-          }
-        }
-      }
-
       break;
     }
 
     case 3: {
-      Eigen::TensorFixedSize<double, Eigen::Sizes<5, 9, 9>> CC;
-      CC.setZero();
+      Eigen::VectorXd VAR2 = Eigen::VectorXd::Zero(NMAX1 + lmax_row + 1);
       for (Index L = 0; L <= lmax_ecp; L++) {
         Index range_M1 = std::min(lmax_row, Index(L));
         Index range_M2 = std::min(lmax_col, Index(L));
+        Eigen::Matrix<double, 9, 9> CC = Eigen::Matrix<double, 9, 9>::Zero();
         for (Index M1 = 4 - range_M1; M1 <= 4 + range_M1; M1++) {
           for (Index M2 = 4 - range_M2; M2 <= 4 + range_M2; M2++) {
             for (Index M = 4 - L; M <= 4 + L; M++) {
-              CC(L, M1, M2) += CA(L, M, M1) * CB(L, M, M2);
+              CC(M1, M2) += CA(L, M, M1) * CB(L, M, M2);
             }
           }
         }
-      }
 
-      Eigen::TensorFixedSize<double, Eigen::Sizes<5, 5, 5, 9, 9>> SUMCI;
-      SUMCI.setZero();
-
-      for (Index L = 0; L <= lmax_ecp; L++) {
-        for (Index L1 = 0; L1 <= lmax_row; L1++) {
-          Index range_M1 = std::min(L1, L);
-          for (Index L2 = 0; L2 <= lmax_col; L2++) {
-            Index range_M2 = std::min(L2, L);
-            for (Index M1 = 4 - range_M1; M1 <= 4 + range_M1; M1++) {
-              for (Index M2 = 4 - range_M2; M2 <= 4 + range_M2; M2++) {
-
-                double fak1 = 2.0 * alpha * AVSSQ;
-                double pow1 = 1;
-                double factorialN = 1;
+        for (Index L2 = 0; L2 <= lmax_col; L2++) {
+          Index range_M2_L2 = std::min(L2, L);
+          for (Index M2 = 4 - range_M2_L2; M2 <= 4 + range_M2_L2; M2++) {
+            // the sum over NN does not depend on the row, N enters XI only
+            // via N + L1
+            for (Index N = 0; N < VAR2.size(); N++) {
+              double sum = 0.0;
+              for (Index NN = 0; NN <= NMAX2; NN++) {
+                sum += COEF(L, L2, M2, NN) * powfac2(NN) * XI(L, N + NN + L2);
+              }
+              VAR2(N) = sum;
+            }
 
+            for (Index L1 = 0; L1 <= lmax_row; L1++) {
+              Index range_M1_L1 = std::min(L1, L);
+              for (Index M1 = 4 - range_M1_L1; M1 <= 4 + range_M1_L1; M1++) {
+                double SUMCI = 0.0;
                 for (Index N = 0; N <= NMAX1; N++) {
-
-                  if (N != 0) {
-                    pow1 = pow1 * fak1;
-                    factorialN = factorialN * double(N);
-                  }
-
-                  double VAR1 = COEF(L, L1, M1, N) * pow1 / factorialN;
-                  double VAR2 = 0.0;
-                  double fak2 = 2.0 * beta * BVSSQ;
-                  double pow2 = 1;
-                  double factorialNN = 1;
-
-                  for (Index NN = 0; NN <= NMAX2; NN++) {
-
-                    if (NN != 0) {
-                      pow2 = pow2 * fak2;
-                      factorialNN = factorialNN * double(NN);
-                    }
-                    double XDUM = COEF(L, L2, M2, NN) * pow2 / factorialNN;
-                    VAR2 += XDUM * XI(L, N + NN + L1 + L2);
-                  }
-
-                  SUMCI(L, L1, L2, M1, M2) += VAR1 * VAR2;
+                  SUMCI += COEF(L, L1, M1, N) * powfac1(N) * VAR2(N + L1);
                 }
-
-              }  // end M2
-            }    // end M1
-          }      // end L2
-        }        // end L1
+                T(L1 + 5 * M1, L2 + 5 * M2) += SUMCI * CC(M1, M2);
+              }  // end M1
+            }    // end L1
+          }      // end M2
+        }        // end L2
       }          // end L
-
-      for (Index i = 0; i < nsph_row; i++) {
-        for (Index j = 0; j < nsph_col; j++) {
-
-          for (Index L = 0; L <= lmax_ecp; L++) {
-            for (Index L1 = 0; L1 <= lmax_row; L1++) {
-              Index range_M1 = std::min(L1, L);
-              for (Index L2 = 0; L2 <= lmax_col; L2++) {
-                Index range_M2 = std::min(L2, L);
-                for (Index M1 = 4 - range_M1; M1 <= 4 + range_M1; M1++) {
-                  for (Index M2 = 4 - range_M2; M2 <= 4 + range_M2; M2++) {
-
-                    matrix(i, j) += BLMA(i, L1, M1) * BLMB(j, L2, M2) *
-                                    SUMCI(L, L1, L2, M1, M2) * CC(L, M1, M2);
-                  }
-                }
-              }
-            }
-          }
-        }
-      }
-
       break;
     }
 
@@ -819,6 +767,10 @@ Eigen::MatrixXd AOECP::calcVNLmatrix(
       throw std::runtime_error("AOECP::Wrong ECP summation mode");
   }  // switch
 
+  const Eigen::Map<const Eigen::MatrixXd> BLMA_mat(BLMA.data(), nsph_row, 45);
+  const Eigen::Map<const Eigen::MatrixXd> BLMB_mat(BLMB.data(), nsph_col, 45);
+  Eigen::MatrixXd matrix = BLMA_mat * T * BLMB_mat.transpose();
+
   // GET TRAFO HERE ALREADY
   Eigen::VectorXd NormA = CalcNorms(alpha, nsph_row);
   Eigen::VectorXd NormB = CalcNorms(beta, nsph_col);
@@ -25,8 +25,8 @@ namespace votca {
 namespace xtp {
 
 void AOKinetic::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                          const AOShell& shell_row,
-                          const AOShell& shell_col) const {
+                          const AOShell& shell_row, const AOShell& shell_col,
+                          const AOShellPairs* shellpairs) const {
 
   // shell info, only lmax tells how far to go
   Index lmax_row = Index(shell_row.getL());
@@ -55,13 +55,15 @@ void AOKinetic::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
   std::array<int, 165> i_less_x = AOTransform::i_less_x();
   std::array<int, 165> i_less_y = AOTransform::i_less_y();
   std::array<int, 165> i_less_z = AOTransform::i_less_z();
-  for (const auto& gaussian_row : shell_row) {
+  AOShellPairs buffer;
+  const AOShellPair pairs =
+      AOShellPairs::Lookup(shellpairs, shell_row, shell_col, buffer);
+  for (Index i_prim = 0; i_prim < pairs.NumRowPrimitives(); i_prim++) {
 
-    const double decay_row = gaussian_row.getDecay();
+    for (const AOPrimitivePair& pair : pairs.Row(i_prim)) {
 
-    for (const auto& gaussian_col : shell_col) {
-
-      const double decay_col = gaussian_col.getDecay();
+      const double decay_row = pair.decay_row;
+      const double decay_col = pair.decay_col;
 
       // some helpers
       const double fak = 0.5 / (decay_row + decay_col);
@@ -69,16 +71,8 @@ void AOKinetic::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
 
       const double xi = rzeta * decay_row * decay_col;
 
-      // check if distance between postions is big, then skip step
-      double exparg = xi * distsq;
-      if (exparg > 30.0) {
-        continue;
-      }
-
-      const Eigen::Vector3d PmA =
-          rzeta * (decay_row * pos_row + decay_col * _pos_col) - pos_row;
-      const Eigen::Vector3d PmB =
-          rzeta * (decay_row * pos_row + decay_col * _pos_col) - _pos_col;
+      const Eigen::Vector3d PmA = pair.P - pos_row;
+      const Eigen::Vector3d PmB = pair.P - _pos_col;
 
       const double xi2 = 2. * xi;              //////////////
       const double fak_a = rzeta * decay_col;  /////////////
@@ -89,7 +83,7 @@ void AOKinetic::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
       // matrix for unnormalized overlap integrals
       AOOverlap overlap;
       Eigen::MatrixXd ol =
-          overlap.Primitive_Overlap(gaussian_row, gaussian_col);
+          overlap.Primitive_Overlap(pair, shell_row, shell_col);
 
       // s-s- kinetic energy integral
       kin(Cart::s, Cart::s) = ol(Cart::s, Cart::s) * xi * (3 - 2 * xi * distsq);
@@ -389,10 +383,10 @@ void AOKinetic::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
 
       // normalization and cartesian -> spherical factors
       Eigen::MatrixXd kin_sph =
-          AOTransform::getTrafo(gaussian_row).transpose() *
+          pair.trafo_row->transpose() *
           kin.bottomRightCorner(shell_row.getCartesianNumFunc(),
                                 shell_col.getCartesianNumFunc()) *
-          AOTransform::getTrafo(gaussian_col);
+          (*pair.trafo_col);
       // save to matrix
 
       matrix += kin_sph;
@@ -29,6 +29,9 @@ namespace xtp {
 void AOMatrix::Fill(const AOBasis& aobasis) {
   _aomatrix =
       Eigen::MatrixXd::Zero(aobasis.AOBasisSize(), aobasis.AOBasisSize());
+  const AOShellPairs* shellpairs =
+      UsesShellPairs() ? &aobasis.ShellPairs() : nullptr;
+  _shelltrafos = &aobasis.ShellTrafos();
   // AOMatrix is symmetric, restrict explicit calculation of lower triangular
   // matrix
 #pragma omp parallel for schedule(guided)
@@ -42,9 +45,10 @@ void AOMatrix::Fill(const AOBasis& aobasis) {
       Eigen::Block<Eigen::MatrixXd> block = _aomatrix.block(
           row_start, col_start, shell_row.getNumFunc(), shell_col.getNumFunc());
       // Fill block
-      FillBlock(block, shell_row, shell_col);
+      FillBlock(block, shell_row, shell_col, shellpairs);
     }
   }
+  _shelltrafos = nullptr;
   // Fill whole matrix by copying
   _aomatrix = _aomatrix.template selfadjointView<Eigen::Lower>();
   return;
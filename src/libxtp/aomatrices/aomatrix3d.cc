@@ -28,6 +28,7 @@ void AOMatrix3D::Fill(const AOBasis& aobasis) {
     _aomatrix[i] =
         Eigen::MatrixXd::Zero(aobasis.AOBasisSize(), aobasis.AOBasisSize());
   }
+  const AOShellPairs& shellpairs = aobasis.ShellPairs();
   // loop row
 #pragma omp parallel for
   for (Index row = 0; row < aobasis.getNumofShells(); row++) {
@@ -45,7 +46,7 @@ void AOMatrix3D::Fill(const AOBasis& aobasis) {
         submatrix.push_back(block);
       }
       // Fill block
-      FillBlock(submatrix, shell_row, shell_col);
+      FillBlock(submatrix, shell_row, shell_col, &shellpairs);
     }
   }
   return;
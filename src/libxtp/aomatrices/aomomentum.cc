@@ -26,8 +26,8 @@ namespace votca {
 namespace xtp {
 
 void AOMomentum::FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd> >& matrix,
-                           const AOShell& shell_row,
-                           const AOShell& shell_col) const {
+                           const AOShell& shell_row, const AOShell& shell_col,
+                           const AOShellPairs* shellpairs) const {
 
   /* Calculating the AO matrix of the gradient operator requires
    * the raw overlap matrix (i.e. in unnormalized cartesians)
@@ -76,12 +76,6 @@ void AOMomentum::FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd> >& matrix,
     scd_mom[i_comp] = Eigen::MatrixXd ::Zero(nrows, ncols);
   }
 
-  const Eigen::Vector3d& pos_row = shell_row.getPos();
-  const Eigen::Vector3d& pos_col = shell_col.getPos();
-  const Eigen::Vector3d diff = pos_row - pos_col;
-
-  double distsq = diff.squaredNorm();
-
   std::array<int, 165> nx = AOTransform::nx();
   std::array<int, 165> ny = AOTransform::ny();
   std::array<int, 165> nz = AOTransform::nz();
@@ -92,27 +86,21 @@ void AOMomentum::FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd> >& matrix,
   std::array<int, 120> i_more_y = AOTransform::i_more_y();
   std::array<int, 120> i_more_z = AOTransform::i_more_z();
 
-  for (const auto& gaussian_row : shell_row) {
-    const double decay_row = gaussian_row.getDecay();
-
-    for (const auto& gaussian_col : shell_col) {
+  AOShellPairs buffer;
+  const AOShellPair pairs =
+      AOShellPairs::Lookup(shellpairs, shell_row, shell_col, buffer);
 
-      const double decay_col = gaussian_col.getDecay();
+  for (Index i_prim = 0; i_prim < pairs.NumRowPrimitives(); i_prim++) {
 
-      const double fak = 0.5 / (decay_row + decay_col);
-      const double fak2 = 2.0 * fak;
-      double _exparg = fak2 * decay_row * decay_col * distsq;
+    for (const AOPrimitivePair& pair : pairs.Row(i_prim)) {
 
-      /// check if distance between positions is large, then skip step
-
-      if (_exparg > 30.0) {
-        continue;
-      }
+      const double decay_row = pair.decay_row;
+      const double decay_col = pair.decay_col;
 
       AOOverlap overlap;
       Index L_offset = 1;
       Eigen::MatrixXd ol =
-          overlap.Primitive_Overlap(gaussian_row, gaussian_col, L_offset);
+          overlap.Primitive_Overlap(pair, shell_row, shell_col, L_offset);
 
       double alpha2 = 2.0 * decay_row;
       double beta2 = 2.0 * decay_col;
@@ -173,8 +161,8 @@ void AOMomentum::FillBlock(std::vector<Eigen::Block<Eigen::MatrixXd> >& matrix,
         }
       }
 
-      Eigen::MatrixXd trafo_row = AOTransform::getTrafo(gaussian_row);
-      Eigen::MatrixXd trafo_col = AOTransform::getTrafo(gaussian_col);
+      const Eigen::MatrixXd& trafo_row = *pair.trafo_row;
+      const Eigen::MatrixXd& trafo_col = *pair.trafo_col;
       // cartesian -> spherical
       for (Index i = 0; i < 3; i++) {
         Eigen::MatrixXd mom_sph =
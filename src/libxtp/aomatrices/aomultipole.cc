@@ -21,24 +21,33 @@
 #include "votca/xtp/aopotential.h"
 #include "votca/xtp/aotransform.h"
 #include "votca/xtp/qmmolecule.h"
+#include "votca/xtp/siteclustertree.h"
 
 namespace votca {
 namespace xtp {
 
 void AOMultipole::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                            const AOShell& shell_row,
-                            const AOShell& shell_col) const {
+                            const AOShell& shell_row, const AOShell& shell_col,
+                            const AOShellPairs* shellpairs) const {
+  FillSiteBlock(matrix, shell_row, shell_col, *_site, shellpairs);
+}
+
+void AOMultipole::FillSiteBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
+                                const AOShell& shell_row,
+                                const AOShell& shell_col,
+                                const StaticSite& site,
+                                const AOShellPairs* shellpairs) const {
 
   const double pi = boost::math::constants::pi<double>();
 
-  Index rank = _site->getRank();
-  if (rank < 1 && _site->getDipole().norm() > 1e-12) {
+  Index rank = site.getRank();
+  if (rank < 1 && site.getDipole().norm() > 1e-12) {
     rank = 1;
   }
-  const double charge = _site->getCharge();
-  const Eigen::Vector3d dipole = _site->getDipole();
+  const double charge = site.getCharge();
+  const Eigen::Vector3d dipole = site.getDipole();
   // factor 1.5 I am not sure about but then 6 monopoles and this tensor agree
-  const Eigen::Matrix3d quadrupole = 1.5 * _site->CalculateCartesianMultipole();
+  const Eigen::Matrix3d quadrupole = 1.5 * site.CalculateCartesianMultipole();
   // shell info, only lmax tells how far to go
   Index lmax_row = Index(shell_row.getL());
   Index lmax_col = Index(shell_col.getL());
@@ -58,39 +67,27 @@ void AOMultipole::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
   // get shell positions
   const Eigen::Vector3d& pos_row = shell_row.getPos();
   const Eigen::Vector3d& pos_col = shell_col.getPos();
-  const Eigen::Vector3d diff = pos_row - pos_col;
-  // initialize some helper
 
-  double distsq = diff.squaredNorm();
+  AOShellPairs buffer;
+  const AOShellPair pairs =
+      AOShellPairs::Lookup(shellpairs, shell_row, shell_col, buffer);
 
   // iterate over Gaussians in this shell_row
-  for (const auto& gaussian_row : shell_row) {
-    // iterate over Gaussians in this shell_col
-    // get decay constant
-    const double decay_row = gaussian_row.getDecay();
-
-    for (const auto& gaussian_col : shell_col) {
-      // get decay constant
-      const double decay_col = gaussian_col.getDecay();
+  for (Index i_prim = 0; i_prim < pairs.NumRowPrimitives(); i_prim++) {
+    // iterate over the significant Gaussians in this shell_col
+    for (const AOPrimitivePair& pair : pairs.Row(i_prim)) {
+      // get decay constants
+      const double decay_row = pair.decay_row;
+      const double decay_col = pair.decay_col;
 
       const double zeta = decay_row + decay_col;
       const double fak = 0.5 / zeta;
       const double fak2 = 2.0 * fak;
-      const double xi = decay_row * decay_col * fak2;
-
-      double exparg = xi * distsq;
-      // check if distance between postions is big, then skip step
-      if (exparg > 30.0) {
-        continue;
-      }
 
       // some helpers
-      const Eigen::Vector3d PmA =
-          fak2 * (decay_row * pos_row + decay_col * pos_col) - pos_row;
-      const Eigen::Vector3d PmB =
-          fak2 * (decay_row * pos_row + decay_col * pos_col) - pos_col;
-      const Eigen::Vector3d PmC =
-          fak2 * (decay_row * pos_row + decay_col * pos_col) - _site->getPos();
+      const Eigen::Vector3d PmA = pair.P - pos_row;
+      const Eigen::Vector3d PmB = pair.P - pos_col;
+      const Eigen::Vector3d PmC = pair.P - site.getPos();
 
       const double U = zeta * PmC.squaredNorm();
 
@@ -101,7 +98,7 @@ void AOMultipole::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
       nuc3.setZero();
       // (s-s element normiert )
       double prefactor = 4. * sqrt(2. / pi) * pow(decay_row * decay_col, .75) *
-                         fak2 * exp(-exparg);
+                         fak2 * pair.expfactor;
       for (Index m = 0; m < lsum + 1; m++) {
         nuc3(0, 0, m) = prefactor * FmU[m];
       }
@@ -2074,10 +2071,10 @@ void AOMultipole::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
       }
 
       Eigen::MatrixXd multipole_sph =
-          AOTransform::getTrafo(gaussian_row).transpose() *
+          pair.trafo_row->transpose() *
           multipole.bottomRightCorner(shell_row.getCartesianNumFunc(),
                                       shell_col.getCartesianNumFunc()) *
-          AOTransform::getTrafo(gaussian_col);
+          (*pair.trafo_col);
       // save to matrix
 
       matrix += multipole_sph;
@@ -2119,5 +2116,67 @@ void AOMultipole::FillPotential(
   return;
 }
 
+void AOMultipole::FillPotential(
+    const AOBasis& aobasis,
+    const std::vector<std::unique_ptr<StaticSite> >& externalsites,
+    double tolerance, double density_threshold) {
+  if (tolerance <= 0.0) {
+    FillPotential(aobasis, externalsites);
+    _avg_exact_sites = double(externalsites.size());
+    _avg_clusters = 0.0;
+    return;
+  }
+  const SiteClusterTree tree(externalsites);
+  const AOShellPairs& shellpairs = aobasis.ShellPairs();
+  const Index nshells = aobasis.getNumofShells();
+  Eigen::MatrixXd result =
+      Eigen::MatrixXd::Zero(aobasis.AOBasisSize(), aobasis.AOBasisSize());
+  double exact_sites = 0.0;
+  double clusters = 0.0;
+#pragma omp parallel for schedule(dynamic) reduction(+ : exact_sites, clusters)
+  for (Index col = 0; col < nshells; col++) {
+    const AOShell& shell_col = aobasis.getShell(col);
+    std::vector<const StaticSite*> exact;
+    std::vector<StaticSite> merged;
+    for (Index row = col; row < nshells; row++) {
+      const AOShell& shell_row = aobasis.getShell(row);
+      // the product of the two most diffuse primitives is centered at pos
+      // and drops below density_threshold beyond radius, the products of the
+      // other primitives lie between the two shells and are more compact
+      const double decay_row = shell_row.getMinDecay();
+      const double decay_col = shell_col.getMinDecay();
+      const Eigen::Vector3d pos =
+          (decay_row * shell_row.getPos() + decay_col * shell_col.getPos()) /
+          (decay_row + decay_col);
+      const double radius =
+          std::max((pos - shell_row.getPos()).norm(),
+                   (pos - shell_col.getPos()).norm()) +
+          std::sqrt(std::log(1.0 / density_threshold) /
+                    (decay_row + decay_col));
+      exact.clear();
+      merged.clear();
+      tree.Partition(pos, radius, tolerance, exact, merged);
+      exact_sites += double(exact.size());
+      clusters += double(merged.size());
+
+      Eigen::Block<Eigen::MatrixXd> block =
+          result.block(shell_row.getStartIndex(), shell_col.getStartIndex(),
+                       shell_row.getNumFunc(), shell_col.getNumFunc());
+      for (const StaticSite* site : exact) {
+        FillSiteBlock(block, shell_row, shell_col, *site, &shellpairs);
+      }
+      for (const StaticSite& cluster : merged) {
+        FillSiteBlock(block, shell_row, shell_col, cluster, &shellpairs);
+      }
+    }
+  }
+  const double npairs = double(nshells * (nshells + 1) / 2);
+  _avg_exact_sites = (npairs > 0) ? exact_sites / npairs : 0.0;
+  _avg_clusters = (npairs > 0) ? clusters / npairs : 0.0;
+  _aopotential = result.selfadjointView<Eigen::Lower>();
+  _aopotential *= -1.0;
+  return;
+}
+
 }  // namespace xtp
 }  // namespace votca
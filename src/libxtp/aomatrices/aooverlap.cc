@@ -24,8 +24,9 @@
 namespace votca {
 namespace xtp {
 
-Eigen::MatrixXd AOOverlap::Primitive_Overlap(const AOGaussianPrimitive& g_row,
-                                             const AOGaussianPrimitive& g_col,
+Eigen::MatrixXd AOOverlap::Primitive_Overlap(const AOPrimitivePair& pair,
+                                             const AOShell& shell_row,
+                                             const AOShell& shell_col,
                                              Index l_offset) const {
   std::array<int, 9> n_orbitals = AOTransform::n_orbitals();
   std::array<int, 165> nx = AOTransform::nx();
@@ -35,40 +36,28 @@ Eigen::MatrixXd AOOverlap::Primitive_Overlap(const AOGaussianPrimitive& g_row,
   std::array<int, 165> i_less_y = AOTransform::i_less_y();
   std::array<int, 165> i_less_z = AOTransform::i_less_z();
 
-  const AOShell& shell_row = g_row.getShell();
-  const AOShell& shell_col = g_col.getShell();
   Index lmax_row = Index(shell_row.getL()) + l_offset;
   Index lmax_col = Index(shell_col.getL()) + l_offset;
 
-  const double decay_row = g_row.getDecay();
-  const double decay_col = g_col.getDecay();
-  const Eigen::Vector3d& pos_row = shell_row.getPos();
-  const Eigen::Vector3d& pos_col = shell_col.getPos();
-  const Eigen::Vector3d diff = pos_row - pos_col;
-
-  double distsq = diff.squaredNorm();
+  const double decay_row = pair.decay_row;
+  const double decay_col = pair.decay_col;
 
   // some helpers
   const double fak = 0.5 / (decay_row + decay_col);
   const double fak2 = 2.0 * fak;
 
-  // check if distance between postions is big, then skip step
-  double exparg = fak2 * decay_row * decay_col * distsq;
-
   // set size of internal block for recursion
   Index nrows = AOTransform::getBlockSize(lmax_row);
   Index ncols = AOTransform::getBlockSize(lmax_col);
 
   Eigen::MatrixXd ol = Eigen::MatrixXd(nrows, ncols);
 
-  const Eigen::Vector3d PmA =
-      fak2 * (decay_row * pos_row + decay_col * pos_col) - pos_row;
-  const Eigen::Vector3d PmB =
-      fak2 * (decay_row * pos_row + decay_col * pos_col) - pos_col;
+  const Eigen::Vector3d PmA = pair.P - shell_row.getPos();
+  const Eigen::Vector3d PmB = pair.P - shell_col.getPos();
 
   // calculate matrix elements
   ol(0, 0) = pow(4.0 * decay_row * decay_col, 0.75) * pow(fak2, 1.5) *
-             exp(-exparg);  // s-s element
+             pair.expfactor;  // s-s element
 
   // Integrals     p - s
   if (lmax_row > 0) {
@@ -578,8 +567,8 @@ Eigen::MatrixXd AOOverlap::Primitive_Overlap(const AOGaussianPrimitive& g_row,
 }
 
 void AOOverlap::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
-                          const AOShell& shell_row,
-                          const AOShell& shell_col) const {
+                          const AOShell& shell_row, const AOShell& shell_col,
+                          const AOShellPairs* shellpairs) const {
 
   // shell info, only lmax tells how far to go
   Index lmax_row = Index(shell_row.getL());
@@ -596,37 +585,22 @@ void AOOverlap::FillBlock(Eigen::Block<Eigen::MatrixXd>& matrix,
    * COEFFICIENTS, AND ADD TO matrix(i,j)
    */
 
-  // get shell positions
-  const Eigen::Vector3d& pos_row = shell_row.getPos();
-  const Eigen::Vector3d& pos_col = shell_col.getPos();
-  const Eigen::Vector3d diff = pos_row - pos_col;
-
-  double distsq = diff.squaredNorm();
+  AOShellPairs buffer;
+  const AOShellPair pairs =
+      AOShellPairs::Lookup(shellpairs, shell_row, shell_col, buffer);
 
   // iterate over Gaussians in this shell_row
-  for (const auto& gaussian_row : shell_row) {
-    // iterate over Gaussians in this shell_col
-    const double decay_row = gaussian_row.getDecay();
-
-    for (const auto& gaussian_col : shell_col) {
-
-      const double decay_col = gaussian_col.getDecay();
-      const double fak = 0.5 / (decay_row + decay_col);
-      const double fak2 = 2.0 * fak;
-
-      // check if distance between postions is big, then skip step
-      double exparg = fak2 * decay_row * decay_col * distsq;
-      if (exparg > 30.0) {
-        continue;
-      }
+  for (Index i_prim = 0; i_prim < pairs.NumRowPrimitives(); i_prim++) {
+    // iterate over the significant Gaussians in this shell_col
+    for (const AOPrimitivePair& pair : pairs.Row(i_prim)) {
 
-      Eigen::MatrixXd ol = Primitive_Overlap(gaussian_row, gaussian_col);
+      Eigen::MatrixXd ol = Primitive_Overlap(pair, shell_row, shell_col);
 
       Eigen::MatrixXd ol_sph =
-          AOTransform::getTrafo(gaussian_row).transpose() *
+          pair.trafo_row->transpose() *
           ol.bottomRightCorner(shell_row.getCartesianNumFunc(),
                                shell_col.getCartesianNumFunc()) *
-          AOTransform::getTrafo(gaussian_col);
+          (*pair.trafo_col);
       // save to matrix
 
       matrix += ol_sph;
@@ -639,7 +613,7 @@ Eigen::MatrixXd AOOverlap::FillShell(const AOShell& shell) const {
       Eigen::MatrixXd::Zero(shell.getNumFunc(), shell.getNumFunc());
   Eigen::Block<Eigen::MatrixXd> submatrix =
       block.block(0, 0, shell.getNumFunc(), shell.getNumFunc());
-  FillBlock(submatrix, shell, shell);
+  FillBlock(submatrix, shell, shell, nullptr);
   return block;
 }
 
@@ -25,8 +25,8 @@ namespace votca {
 namespace xtp {
 
 void AOPlanewave::FillBlock(Eigen::Block<Eigen::MatrixXcd>& matrix,
-                            const AOShell& shell_row,
-                            const AOShell& shell_col) const {
+                            const AOShell& shell_row, const AOShell& shell_col,
+                            const AOShellPairs*) const {
 
   // shell info, only lmax tells how far to go
   Index lmax_row = Index(shell_row.getL());
@@ -30,6 +30,7 @@ Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> AOPotential<T>::Fill(
 
   MatrixXcdd result =
       MatrixXcdd::Zero(aobasis.AOBasisSize(), aobasis.AOBasisSize());
+  const AOShellPairs& shellpairs = aobasis.ShellPairs();
   // AOMatrix is symmetric, restrict explicit calculation of lower triangular
   // matrix
 #pragma omp parallel for schedule(guided)
@@ -43,7 +44,7 @@ Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> AOPotential<T>::Fill(
       Eigen::Block<MatrixXcdd> block = result.block(
           row_start, col_start, shell_row.getNumFunc(), shell_col.getNumFunc());
       // Fill block
-      FillBlock(block, shell_row, shell_col);
+      FillBlock(block, shell_row, shell_col, &shellpairs);
     }
   }
   // Fill whole matrix by copying
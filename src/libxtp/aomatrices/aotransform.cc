@@ -308,8 +308,13 @@ Eigen::MatrixXd AOTransform::getTrafo(const AOGaussianPrimitive& gaussian) {
 }
 
 Eigen::VectorXd AOTransform::XIntegrate(Index size, double U) {
-  Eigen::VectorXd FmU = Eigen::VectorXd::Zero(size);
-  const Index mm = size - 1;
+  Eigen::VectorXd FmU = Eigen::VectorXd::Zero(std::max(size, Index(0)));
+  XIntegrate(FmU, U);
+  return FmU;
+}
+
+void AOTransform::XIntegrate(Eigen::Ref<Eigen::VectorXd> FmU, double U) {
+  const Index mm = FmU.size() - 1;
   const double pi = boost::math::constants::pi<double>();
   if (mm < 0) {
     throw std::runtime_error("mm is: " + std::to_string(mm) +
@@ -351,8 +356,6 @@ Eigen::VectorXd AOTransform::XIntegrate(Index size, double U) {
           (2.0 * U) / (2.0 * double(m) + 1.0) * (FmU[m + 1] + expU / (2.0 * U));
     }
   }
-
-  return FmU;
 }
 
 Index AOTransform::getBlockSize(Index lmax) {
@@ -0,0 +1,100 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Third party includes
+#include <boost/functional/hash.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/aobasis.h"
+#include "votca/xtp/ecpaobasis.h"
+#include "votca/xtp/ecpmatrixcache.h"
+
+namespace votca {
+namespace xtp {
+
+ECPMatrixCache& ECPMatrixCache::Instance() {
+  static ECPMatrixCache cache;
+  return cache;
+}
+
+std::vector<double> ECPMatrixCache::Key(const AOBasis& aobasis,
+                                        const ECPAOBasis& ecp) {
+  std::vector<double> key;
+  for (const AOShell& shell : aobasis) {
+    key.push_back(double(shell.getL()));
+    key.insert(key.end(), shell.getPos().data(), shell.getPos().data() + 3);
+    key.push_back(double(std::distance(shell.begin(), shell.end())));
+    for (const AOGaussianPrimitive& gaussian : shell) {
+      key.push_back(gaussian.getDecay());
+      key.push_back(gaussian.getContraction());
+    }
+  }
+  for (const ECPAOShell& shell : ecp) {
+    key.push_back(double(shell.getL()));
+    key.push_back(double(shell.getLmaxElement()));
+    key.insert(key.end(), shell.getPos().data(), shell.getPos().data() + 3);
+    key.push_back(double(shell.getSize()));
+    for (const ECPAOGaussianPrimitive& gaussian : shell) {
+      key.push_back(double(gaussian.getPower()));
+      key.push_back(gaussian.getDecay());
+      key.push_back(gaussian.getContraction());
+    }
+  }
+  return key;
+}
+
+bool ECPMatrixCache::Find(const AOBasis& aobasis, const ECPAOBasis& ecp,
+                          Eigen::MatrixXd& matrix) const {
+  const std::vector<double> key = Key(aobasis, ecp);
+  const std::size_t hash = boost::hash_range(key.begin(), key.end());
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (const Entry& entry : _entries) {
+    if (entry.hash == hash && entry.key == key) {
+      matrix = entry.matrix;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ECPMatrixCache::Add(const AOBasis& aobasis, const ECPAOBasis& ecp,
+                         const Eigen::MatrixXd& matrix) {
+  Entry entry;
+  entry.key = Key(aobasis, ecp);
+  entry.hash = boost::hash_range(entry.key.begin(), entry.key.end());
+  entry.matrix = matrix;
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries.push_back(std::move(entry));
+  if (Index(_entries.size()) > _max_entries) {
+    _entries.pop_front();
+  }
+}
+
+void ECPMatrixCache::Clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries.clear();
+}
+
+Index ECPMatrixCache::size() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return Index(_entries.size());
+}
+
+}  // namespace xtp
+}  // namespace votca
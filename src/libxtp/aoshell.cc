@@ -32,6 +32,7 @@ void AOShell::normalizeContraction() {
   for (auto& gaussian : _gaussians) {
     gaussian._contraction /= norm;
   }
+  UpdateRadialCoefficients();
   return;
 }
 
@@ -260,6 +261,264 @@ void AOShell::EvalAOspace(Eigen::VectorBlock<Eigen::VectorXd>& AOvalues,
   EvalAOspace(AOvalues, temp2, grid_pos);
 }
 
+void AOShell::UpdateRadialCoefficients() {
+  const Index nprim = Index(_gaussians.size());
+  _decays.resize(nprim);
+  _radialcoeffs.resize(nprim);
+  for (Index i = 0; i < nprim; i++) {
+    const AOGaussianPrimitive& gaussian = _gaussians[i];
+    const double alpha = gaussian.getDecay();
+    double angular = 1.0;
+    switch (_l) {
+      case L::S:
+        angular = 1.0;
+        break;
+      case L::P:
+        angular = 2. * std::sqrt(alpha);
+        break;
+      case L::D:
+        angular = 2. * alpha;
+        break;
+      case L::F:
+        angular = 2. * std::pow(alpha, 1.5);
+        break;
+      case L::G:
+        angular = 2. / std::sqrt(3.) * alpha * alpha;
+        break;
+      default:
+        // higher shells are rejected in EvalAOspace
+        break;
+    }
+    _decays[i] = alpha;
+    _radialcoeffs[i] =
+        angular * gaussian.getContraction() * gaussian.getPowfactor();
+  }
+}
+
+namespace {
+
+// cartesian coordinates of all points relative to the shell centre and
+// their products
+struct BatchCoordinates {
+  BatchCoordinates(const Eigen::MatrixX3d& center)
+      : x(center.col(0).array()),
+        y(center.col(1).array()),
+        z(center.col(2).array()),
+        xx(x * x),
+        yy(y * y),
+        zz(z * z),
+        xy(x * y),
+        xz(x * z),
+        yz(y * z),
+        r2(xx + yy + zz) {}
+  Eigen::ArrayXd x, y, z;
+  Eigen::ArrayXd xx, yy, zz, xy, xz, yz;
+  Eigen::ArrayXd r2;
+};
+
+// marks a vanishing derivative of the angular part
+struct NoTerm {};
+
+template <class Column, class Expr>
+void AddGradient(Column col, const Eigen::ArrayXd& radial, const Expr& der,
+                 const Eigen::ArrayXd& radial_der) {
+  col.array() += radial * der + radial_der;
+}
+
+template <class Column>
+void AddGradient(Column col, const Eigen::ArrayXd&, NoTerm,
+                 const Eigen::ArrayXd& radial_der) {
+  col.array() += radial_der;
+}
+
+// adds R*Y for each angular function Y
+struct ValueAccumulator {
+  const Eigen::ArrayXd& radial;
+  Eigen::Ref<Eigen::MatrixXd>& values;
+
+  template <class Y, class GX, class GY, class GZ>
+  void operator()(Index i, const Y& y, const GX&, const GY&, const GZ&) {
+    values.col(i).array() += radial * y;
+  }
+};
+
+// adds R*Y and grad(R*Y) = R*grad(Y) + dR/dr^2 * 2r * Y
+struct GradientAccumulator {
+  const BatchCoordinates& c;
+  const Eigen::ArrayXd& radial;
+  const Eigen::ArrayXd& radial_der;
+  Eigen::Ref<Eigen::MatrixXd>& values;
+  Eigen::Ref<Eigen::MatrixXd>& der_x;
+  Eigen::Ref<Eigen::MatrixXd>& der_y;
+  Eigen::Ref<Eigen::MatrixXd>& der_z;
+
+  template <class Y, class GX, class GY, class GZ>
+  void operator()(Index i, const Y& y, const GX& gx, const GY& gy,
+                  const GZ& gz) {
+    const Eigen::ArrayXd ang = y;
+    values.col(i).array() += radial * ang;
+    const Eigen::ArrayXd dr = radial_der * ang;
+    AddGradient(der_x.col(i), radial, gx, dr * c.x);
+    AddGradient(der_y.col(i), radial, gy, dr * c.y);
+    AddGradient(der_z.col(i), radial, gz, dr * c.z);
+  }
+};
+
+// real solid harmonics of a shell and their cartesian derivatives, the
+// normalisation depending on the decay is part of the radial coefficients
+template <L l>
+struct SolidHarmonics;
+
+template <>
+struct SolidHarmonics<L::S> {
+  template <class Acc>
+  static void Eval(const BatchCoordinates& c, Acc& add) {
+    add(0, Eigen::ArrayXd::Ones(c.x.size()), NoTerm(), NoTerm(), NoTerm());
+  }
+};
+
+template <>
+struct SolidHarmonics<L::P> {
+  template <class Acc>
+  static void Eval(const BatchCoordinates& c, Acc& add) {
+    const Eigen::ArrayXd one = Eigen::ArrayXd::Ones(c.x.size());
+    add(0, c.z, NoTerm(), NoTerm(), one);  // Y 1,0
+    add(1, c.y, NoTerm(), one, NoTerm());  // Y 1,-1
+    add(2, c.x, one, NoTerm(), NoTerm());  // Y 1,1
+  }
+};
+
+template <>
+struct SolidHarmonics<L::D> {
+  template <class Acc>
+  static void Eval(const BatchCoordinates& c, Acc& add) {
+    const double f1 = 1. / std::sqrt(3.);
+    add(0, f1 * (3. * c.zz - c.r2), -2. * f1 * c.x, -2. * f1 * c.y,
+        4. * f1 * c.z);                                          // Y 2,0
+    add(1, 2. * c.yz, NoTerm(), 2. * c.z, 2. * c.y);             // Y 2,-1
+    add(2, 2. * c.xz, 2. * c.z, NoTerm(), 2. * c.x);             // Y 2,1
+    add(3, 2. * c.xy, 2. * c.y, 2. * c.x, NoTerm());             // Y 2,-2
+    add(4, c.xx - c.yy, 2. * c.x, -2. * c.y, NoTerm());          // Y 2,2
+  }
+};
+
+template <>
+struct SolidHarmonics<L::F> {
+  template <class Acc>
+  static void Eval(const BatchCoordinates& c, Acc& add) {
+    const double f1 = 2. / std::sqrt(15.);
+    const double f2 = std::sqrt(2.) / std::sqrt(5.);
+    const double f3 = std::sqrt(2.) / std::sqrt(3.);
+    add(0, f1 * c.z * (5. * c.zz - 3. * c.r2), -6. * f1 * c.xz,
+        -6. * f1 * c.yz, 3. * f1 * (3. * c.zz - c.r2));  // Y 3,0
+    add(1, f2 * c.y * (5. * c.zz - c.r2), -2. * f2 * c.xy,
+        f2 * (4. * c.zz - c.xx - 3. * c.yy), 8. * f2 * c.yz);  // Y 3,-1
+    add(2, f2 * c.x * (5. * c.zz - c.r2),
+        f2 * (4. * c.zz - c.yy - 3. * c.xx), -2. * f2 * c.xy,
+        8. * f2 * c.xz);                                       // Y 3,1
+    add(3, 4. * c.xy * c.z, 4. * c.yz, 4. * c.xz, 4. * c.xy);  // Y 3,-2
+    add(4, 2. * c.z * (c.xx - c.yy), 4. * c.xz, -4. * c.yz,
+        2. * (c.xx - c.yy));  // Y 3,2
+    add(5, f3 * c.y * (3. * c.xx - c.yy), 6. * f3 * c.xy,
+        3. * f3 * (c.xx - c.yy), NoTerm());  // Y 3,-3
+    add(6, f3 * c.x * (c.xx - 3. * c.yy), 3. * f3 * (c.xx - c.yy),
+        -6. * f3 * c.xy, NoTerm());  // Y 3,3
+  }
+};
+
+template <>
+struct SolidHarmonics<L::G> {
+  template <class Acc>
+  static void Eval(const BatchCoordinates& c, Acc& add) {
+    const double f1 = 1. / std::sqrt(35.);
+    const double f2 = 4. / std::sqrt(14.);
+    const double f3 = 2. / std::sqrt(7.);
+    const double f4 = 2. * std::sqrt(2.);
+    add(0,
+        f1 * (35. * c.zz * c.zz - 30. * c.zz * c.r2 + 3. * c.r2 * c.r2),
+        12. * f1 * c.x * (c.r2 - 5. * c.zz),
+        12. * f1 * c.y * (c.r2 - 5. * c.zz),
+        16. * f1 * c.z * (5. * c.zz - 3. * c.r2));  // Y 4,0
+    add(1, f2 * c.yz * (7. * c.zz - 3. * c.r2), -6. * f2 * c.x * c.yz,
+        f2 * c.z * (4. * c.zz - 3. * c.xx - 9. * c.yy),
+        3. * f2 * c.y * (5. * c.zz - c.r2));  // Y 4,-1
+    add(2, f2 * c.xz * (7. * c.zz - 3. * c.r2),
+        f2 * c.z * (4. * c.zz - 9. * c.xx - 3. * c.yy),
+        -6. * f2 * c.y * c.xz, 3. * f2 * c.x * (5. * c.zz - c.r2));  // Y 4,1
+    add(3, 2. * f3 * c.xy * (7. * c.zz - c.r2),
+        2. * f3 * c.y * (6. * c.zz - 3. * c.xx - c.yy),
+        2. * f3 * c.x * (6. * c.zz - c.xx - 3. * c.yy),
+        24. * f3 * c.z * c.xy);  // Y 4,-2
+    add(4, f3 * (c.xx - c.yy) * (7. * c.zz - c.r2),
+        4. * f3 * c.x * (3. * c.zz - c.xx), 4. * f3 * c.y * (c.yy - 3. * c.zz),
+        12. * f3 * c.z * (c.xx - c.yy));  // Y 4,2
+    add(5, f4 * c.yz * (3. * c.xx - c.yy), 6. * f4 * c.x * c.yz,
+        3. * f4 * c.z * (c.xx - c.yy), f4 * c.y * (3. * c.xx - c.yy));  // 4,-3
+    add(6, f4 * c.xz * (c.xx - 3. * c.yy), 3. * f4 * c.z * (c.xx - c.yy),
+        -6. * f4 * c.y * c.xz, f4 * c.x * (c.xx - 3. * c.yy));  // Y 4,3
+    add(7, 4. * c.xy * (c.xx - c.yy), 4. * c.y * (3. * c.xx - c.yy),
+        4. * c.x * (c.xx - 3. * c.yy), NoTerm());  // Y 4,-4
+    add(8, c.xx * c.xx - 6. * c.xx * c.yy + c.yy * c.yy,
+        4. * c.x * (c.xx - 3. * c.yy), 4. * c.y * (c.yy - 3. * c.xx),
+        NoTerm());  // Y 4,4
+  }
+};
+
+template <class Acc>
+void EvalSolidHarmonics(L l, const BatchCoordinates& c, Acc& add) {
+  switch (l) {
+    case L::S:
+      SolidHarmonics<L::S>::Eval(c, add);
+      break;
+    case L::P:
+      SolidHarmonics<L::P>::Eval(c, add);
+      break;
+    case L::D:
+      SolidHarmonics<L::D>::Eval(c, add);
+      break;
+    case L::F:
+      SolidHarmonics<L::F>::Eval(c, add);
+      break;
+    case L::G:
+      SolidHarmonics<L::G>::Eval(c, add);
+      break;
+    default:
+      throw std::runtime_error("Shell type:" + EnumToString(l) + " not known");
+      break;
+  }
+}
+}  // namespace
+
+void AOShell::EvalAOspace(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                          Eigen::Ref<Eigen::MatrixXd> AOvalues) const {
+  const Eigen::MatrixX3d center = points.rowwise() - _pos.transpose();
+  const BatchCoordinates c(center);
+  // contracted radial part for all points, one exp per point and primitive
+  const Eigen::MatrixXd expo =
+      (-(c.r2.matrix() * _decays.transpose()).array()).exp().matrix();
+  const Eigen::ArrayXd radial = (expo * _radialcoeffs).array();
+  ValueAccumulator add{radial, AOvalues};
+  EvalSolidHarmonics(_l, c, add);
+}
+
+void AOShell::EvalAOspace(const Eigen::Ref<const Eigen::MatrixX3d>& points,
+                          Eigen::Ref<Eigen::MatrixXd> AOvalues,
+                          Eigen::Ref<Eigen::MatrixXd> AODer_x,
+                          Eigen::Ref<Eigen::MatrixXd> AODer_y,
+                          Eigen::Ref<Eigen::MatrixXd> AODer_z) const {
+  const Eigen::MatrixX3d center = points.rowwise() - _pos.transpose();
+  const BatchCoordinates c(center);
+  const Eigen::MatrixXd expo =
+      (-(c.r2.matrix() * _decays.transpose()).array()).exp().matrix();
+  const Eigen::ArrayXd radial = (expo * _radialcoeffs).array();
+  const Eigen::VectorXd der_coeffs =
+      -2.0 * _decays.cwiseProduct(_radialcoeffs);
+  const Eigen::ArrayXd radial_der = (expo * der_coeffs).array();
+  GradientAccumulator add{c,       radial,  radial_der, AOvalues,
+                          AODer_x, AODer_y, AODer_z};
+  EvalSolidHarmonics(_l, c, add);
+}
+
 std::ostream& operator<<(std::ostream& out, const AOShell& shell) {
   out << "AtomIndex:" << shell.getAtomIndex();
   out << " Shelltype:" << EnumToString(shell.getL())
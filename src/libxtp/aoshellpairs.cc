@@ -0,0 +1,180 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Standard includes
+#include <algorithm>
+#include <stdexcept>
+
+// Local VOTCA includes
+#include "votca/xtp/aobasis.h"
+#include "votca/xtp/aoshellpairs.h"
+#include "votca/xtp/aotransform.h"
+
+namespace votca {
+namespace xtp {
+
+namespace {
+std::vector<const AOShell*> ShellsOfBasis(const AOBasis& aobasis) {
+  std::vector<const AOShell*> shells;
+  shells.reserve(aobasis.getNumofShells());
+  for (const AOShell& shell : aobasis) {
+    shells.push_back(&shell);
+  }
+  return shells;
+}
+}  // namespace
+
+AOShellTrafos::AOShellTrafos(const AOBasis& aobasis)
+    : AOShellTrafos(ShellsOfBasis(aobasis)) {}
+
+AOShellTrafos::AOShellTrafos(const std::vector<const AOShell*>& shells) {
+  _primstart.push_back(0);
+  for (const AOShell* shell : shells) {
+    _startindex.push_back(shell->getStartIndex());
+    _l.push_back(shell->getL());
+    _pos.push_back(shell->getPos());
+    _primstart.push_back(_primstart.back() +
+                         Index(std::distance(shell->begin(), shell->end())));
+  }
+  // all transformations exist before any pair points to them
+  _trafos.reserve(_primstart.back());
+  for (const AOShell* shell : shells) {
+    for (const AOGaussianPrimitive& gaussian : *shell) {
+      _trafos.push_back(AOTransform::getTrafo(gaussian));
+    }
+  }
+}
+
+Index AOShellTrafos::ShellIndex(const AOShell& shell) const {
+  auto it = std::lower_bound(_startindex.begin(), _startindex.end(),
+                             shell.getStartIndex());
+  if (it == _startindex.end() || *it != shell.getStartIndex()) {
+    return -1;
+  }
+  Index index = Index(std::distance(_startindex.begin(), it));
+  if (_primstart[index + 1] - _primstart[index] !=
+          Index(std::distance(shell.begin(), shell.end())) ||
+      _l[index] != shell.getL() || _pos[index] != shell.getPos()) {
+    throw std::runtime_error(
+        "Shell does not belong to the basis of the shell table");
+  }
+  return index;
+}
+
+const Eigen::MatrixXd* AOShellTrafos::Lookup(
+    const AOShellTrafos* table, const AOShell& shell,
+    std::vector<Eigen::MatrixXd>& buffer) {
+  if (table != nullptr) {
+    Index index = table->ShellIndex(shell);
+    if (index >= 0) {
+      return table->Trafos(index);
+    }
+  }
+  buffer.clear();
+  for (const AOGaussianPrimitive& gaussian : shell) {
+    buffer.push_back(AOTransform::getTrafo(gaussian));
+  }
+  return buffer.data();
+}
+
+constexpr double AOShellPairs::ExpargCutoff;
+
+AOShellPairs::AOShellPairs(const AOBasis& aobasis)
+    : _shelltrafos(ShellsOfBasis(aobasis)) {
+  const Index nshells = aobasis.getNumofShells();
+  _rowoffset.reserve((nshells * (nshells + 1)) / 2);
+  for (Index row = 0; row < nshells; row++) {
+    for (Index col = 0; col <= row; col++) {
+      AddPair(aobasis.getShell(row), row, aobasis.getShell(col), col);
+    }
+  }
+  _basistable = true;
+}
+
+AOShellPairs::AOShellPairs(const AOShell& shell_row, const AOShell& shell_col)
+    : _shelltrafos({&shell_row, &shell_col}) {
+  AddPair(shell_row, 0, shell_col, 1);
+}
+
+AOPrimitivePair AOShellPairs::Product(const AOGaussianPrimitive& gaussian_row,
+                                      const AOGaussianPrimitive& gaussian_col) {
+  const Eigen::Vector3d& pos_row = gaussian_row.getShell().getPos();
+  const Eigen::Vector3d& pos_col = gaussian_col.getShell().getPos();
+  AOPrimitivePair pair;
+  pair.decay_row = gaussian_row.getDecay();
+  pair.decay_col = gaussian_col.getDecay();
+  const double zeta = pair.decay_row + pair.decay_col;
+  pair.expfactor = std::exp(-pair.decay_row * pair.decay_col / zeta *
+                            (pos_row - pos_col).squaredNorm());
+  pair.P = (pair.decay_row * pos_row + pair.decay_col * pos_col) / zeta;
+  pair.trafo_row = nullptr;
+  pair.trafo_col = nullptr;
+  return pair;
+}
+
+void AOShellPairs::AddPair(const AOShell& shell_row, Index row,
+                           const AOShell& shell_col, Index col) {
+  _rowoffset.push_back(Index(_rowstarts.size()));
+  const Eigen::Vector3d& pos_row = shell_row.getPos();
+  const Eigen::Vector3d& pos_col = shell_col.getPos();
+  const double distsq = (pos_row - pos_col).squaredNorm();
+  const Eigen::MatrixXd* trafo_row = _shelltrafos.Trafos(row);
+  for (const AOGaussianPrimitive& gaussian_row : shell_row) {
+    _rowstarts.push_back(Index(_pairs.size()));
+    const double decay_row = gaussian_row.getDecay();
+    const Eigen::MatrixXd* trafo_col = _shelltrafos.Trafos(col);
+    for (const AOGaussianPrimitive& gaussian_col : shell_col) {
+      const double decay_col = gaussian_col.getDecay();
+      const double zeta = decay_row + decay_col;
+      const double exparg = decay_row * decay_col / zeta * distsq;
+      if (exparg <= ExpargCutoff) {
+        AOPrimitivePair pair = Product(gaussian_row, gaussian_col);
+        pair.trafo_row = trafo_row;
+        pair.trafo_col = trafo_col;
+        _pairs.push_back(pair);
+      }
+      trafo_col++;
+    }
+    trafo_row++;
+  }
+  _rowstarts.push_back(Index(_pairs.size()));
+}
+
+AOShellPair AOShellPairs::Pair(Index index, const AOShell& shell_row) const {
+  return AOShellPair(_pairs.data(), _rowstarts.data() + _rowoffset[index],
+                     Index(std::distance(shell_row.begin(), shell_row.end())));
+}
+
+AOShellPair AOShellPairs::Lookup(const AOShellPairs* table,
+                                 const AOShell& shell_row,
+                                 const AOShell& shell_col,
+                                 AOShellPairs& buffer) {
+  if (table != nullptr && table->_basistable) {
+    Index row = table->_shelltrafos.ShellIndex(shell_row);
+    Index col = table->_shelltrafos.ShellIndex(shell_col);
+    if (col >= 0 && row >= col) {
+      return table->Pair((row * (row + 1)) / 2 + col, shell_row);
+    }
+  }
+  buffer = AOShellPairs(shell_row, shell_col);
+  return buffer.Pair(0, shell_row);
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -1,439 +1,849 @@
-/*
- *            Copyright 2009-2020 The VOTCA Development Team
- *                       (http://www.votca.org)
- *
- *      Licensed under the Apache License, Version 2.0 (the "License")
- *
- * You may not use this file except in compliance with the License.
- * You may obtain a copy of the License at
- *
- *              http://www.apache.org/licenses/LICENSE-2.0
- *
- *Unless required by applicable law or agreed to in writing, software
- * distributed under the License is distributed on an "AS IS" BASIS,
- * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
- * See the License for the specific language governing permissions and
- * limitations under the License.
- *
- */
-
-// Local VOTCA includes
-#include "votca/xtp/ERIs.h"
-#include "votca/xtp/aobasis.h"
-#include "votca/xtp/symmetric_matrix.h"
-
-namespace votca {
-namespace xtp {
-
-void ERIs::Initialize(const AOBasis& dftbasis, const AOBasis& auxbasis) {
-  _threecenter.Fill(auxbasis, dftbasis);
-  return;
-}
-
-void ERIs::Initialize_4c_small_molecule(const AOBasis& dftbasis) {
-  _fourcenter.Fill_4c_small_molecule(dftbasis);
-  return;
-}
-
-void ERIs::Initialize_4c_screening(const AOBasis& dftbasis, double eps) {
-  _with_screening = true;
-  _screening_eps = eps;
-  CalculateERIsDiagonals(dftbasis);
-  return;
-}
-
-Mat_p_Energy ERIs::CalculateERIs(const Eigen::MatrixXd& DMAT) const {
-  Eigen::MatrixXd ERIs2 = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-  Symmetric_Matrix dmat_sym = Symmetric_Matrix(DMAT);
-#pragma omp parallel for schedule(guided) reduction(+ : ERIs2)
-  for (Index i = 0; i < _threecenter.size(); i++) {
-    const Symmetric_Matrix& threecenter = _threecenter[i];
-    // Trace over prod::DMAT,I(l)=componentwise product over
-    const double factor = threecenter.TraceofProd(dmat_sym);
-    Eigen::SelfAdjointView<Eigen::MatrixXd, Eigen::Upper> m =
-        ERIs2.selfadjointView<Eigen::Upper>();
-    threecenter.AddtoEigenUpperMatrix(m, factor);
-  }
-
-  ERIs2 = ERIs2.selfadjointView<Eigen::Upper>();
-  double energy = CalculateEnergy(DMAT, ERIs2);
-  return Mat_p_Energy(energy, ERIs2);
-}
-
-Mat_p_Energy ERIs::CalculateEXX(const Eigen::MatrixXd& DMAT) const {
-
-  Eigen::MatrixXd EXX = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-
-#pragma omp parallel for schedule(guided) reduction(+ : EXX)
-  for (Index i = 0; i < _threecenter.size(); i++) {
-    const Eigen::MatrixXd threecenter = _threecenter[i].UpperMatrix();
-    EXX += threecenter.selfadjointView<Eigen::Upper>() * DMAT *
-           threecenter.selfadjointView<Eigen::Upper>();
-  }
-  double energy = CalculateEnergy(DMAT, EXX);
-  return Mat_p_Energy(energy, EXX);
-}
-
-Mat_p_Energy ERIs::CalculateEXX(const Eigen::MatrixXd& occMos,
-                                const Eigen::MatrixXd& DMAT) const {
-
-  Eigen::MatrixXd EXX = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-
-#pragma omp parallel for schedule(guided) reduction(+ : EXX)
-  for (Index i = 0; i < _threecenter.size(); i++) {
-    const Eigen::MatrixXd TCxMOs_T =
-        occMos.transpose() *
-        _threecenter[i].UpperMatrix().selfadjointView<Eigen::Upper>();
-    EXX += TCxMOs_T.transpose() * TCxMOs_T;
-  }
-
-  EXX *= 2;
-
-  double energy = CalculateEnergy(DMAT, EXX);
-  return Mat_p_Energy(energy, EXX);
-}
-
-Mat_p_Energy ERIs::CalculateERIs_4c_small_molecule(
-    const Eigen::MatrixXd& DMAT) const {
-
-  Eigen::MatrixXd ERIs2 = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-
-  const Eigen::VectorXd& fourc_vector = _fourcenter.get_4c_vector();
-
-  Index dftBasisSize = DMAT.rows();
-  Index vectorSize = (dftBasisSize * (dftBasisSize + 1)) / 2;
-#pragma omp parallel for
-  for (Index i = 0; i < dftBasisSize; i++) {
-    Index sum_i = (i * (i + 1)) / 2;
-    for (Index j = i; j < dftBasisSize; j++) {
-      Index index_ij = dftBasisSize * i - sum_i + j;
-      Index index_ij_kl_a =
-          vectorSize * index_ij - (index_ij * (index_ij + 1)) / 2;
-      for (Index k = 0; k < dftBasisSize; k++) {
-        Index sum_k = (k * (k + 1)) / 2;
-        for (Index l = k; l < dftBasisSize; l++) {
-          Index index_kl = dftBasisSize * k - sum_k + l;
-
-          Index index_ij_kl = index_ij_kl_a + index_kl;
-          if (index_ij > index_kl) {
-            index_ij_kl = vectorSize * index_kl -
-                          (index_kl * (index_kl + 1)) / 2 + index_ij;
-          }
-
-          if (l == k) {
-            ERIs2(i, j) += DMAT(k, l) * fourc_vector(index_ij_kl);
-          } else {
-            ERIs2(i, j) += 2. * DMAT(k, l) * fourc_vector(index_ij_kl);
-          }
-        }
-      }
-      ERIs2(j, i) = ERIs2(i, j);
-    }
-  }
-
-  double energy = CalculateEnergy(DMAT, ERIs2);
-  return Mat_p_Energy(energy, ERIs2);
-}
-
-Mat_p_Energy ERIs::CalculateEXX_4c_small_molecule(
-    const Eigen::MatrixXd& DMAT) const {
-  Eigen::MatrixXd EXX = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-
-  const Eigen::VectorXd& fourc_vector = _fourcenter.get_4c_vector();
-
-  Index dftBasisSize = DMAT.rows();
-  Index vectorSize = (dftBasisSize * (dftBasisSize + 1)) / 2;
-#pragma omp parallel for reduction(+ : EXX)
-  for (Index i = 0; i < dftBasisSize; i++) {
-    Index sum_i = (i * (i + 1)) / 2;
-    for (Index j = i; j < dftBasisSize; j++) {
-      Index index_ij = DMAT.cols() * i - sum_i + j;
-      Index index_ij_kl_a =
-          vectorSize * index_ij - (index_ij * (index_ij + 1)) / 2;
-      for (Index k = 0; k < dftBasisSize; k++) {
-        Index sum_k = (k * (k + 1)) / 2;
-        for (Index l = k; l < dftBasisSize; l++) {
-          Index index_kl = DMAT.cols() * k - sum_k + l;
-
-          Index _index_ij_kl = index_ij_kl_a + index_kl;
-          if (index_ij > index_kl) {
-            _index_ij_kl = vectorSize * index_kl -
-                           (index_kl * (index_kl + 1)) / 2 + index_ij;
-          }
-          double factorij = 1;
-          if (i == j) {
-            factorij = 0.5;
-          }
-          double factorkl = 1;
-          if (l == k) {
-            factorkl = 0.5;
-          }
-          double factor = factorij * factorkl;
-          EXX(i, l) += factor * DMAT(j, k) * fourc_vector(_index_ij_kl);
-          EXX(j, l) += factor * DMAT(i, k) * fourc_vector(_index_ij_kl);
-          EXX(i, k) += factor * DMAT(j, l) * fourc_vector(_index_ij_kl);
-          EXX(j, k) += factor * DMAT(i, l) * fourc_vector(_index_ij_kl);
-        }
-      }
-    }
-  }
-
-  double energy = CalculateEnergy(DMAT, EXX);
-  return Mat_p_Energy(energy, EXX);
-}
-
-Mat_p_Energy ERIs::CalculateERIs_4c_direct(const AOBasis& dftbasis,
-                                           const Eigen::MatrixXd& DMAT) const {
-
-  // Number of shells
-  Index numShells = dftbasis.getNumofShells();
-
-  // Initialize ERIs matrix
-  Eigen::MatrixXd ERIs2 = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-
-#pragma omp parallel
-  {  // Begin omp parallel
-
-    Eigen::MatrixXd ERIs_thread =
-        Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
-
-#pragma omp for
-    for (Index iShell_3 = 0; iShell_3 < numShells; iShell_3++) {
-      const AOShell& shell_3 = dftbasis.getShell(iShell_3);
-      Index numFunc_3 = shell_3.getNumFunc();
-      for (Index iShell_4 = iShell_3; iShell_4 < numShells; iShell_4++) {
-        const AOShell& shell_4 = dftbasis.getShell(iShell_4);
-        Index numFunc_4 = shell_4.getNumFunc();
-        for (Index iShell_1 = iShell_3; iShell_1 < numShells; iShell_1++) {
-          const AOShell& shell_1 = dftbasis.getShell(iShell_1);
-          Index numFunc_1 = shell_1.getNumFunc();
-          for (Index iShell_2 = iShell_1; iShell_2 < numShells; iShell_2++) {
-            const AOShell& shell_2 = dftbasis.getShell(iShell_2);
-            Index numFunc_2 = shell_2.getNumFunc();
-
-            // Pre-screening
-            if (_with_screening && CheckScreen(_screening_eps, shell_1, shell_2,
-                                               shell_3, shell_4)) {
-              continue;
-            }
-
-            // Get the current 4c block
-            Eigen::Tensor<double, 4> block(numFunc_1, numFunc_2, numFunc_3,
-                                           numFunc_4);
-            block.setZero();
-            bool nonzero = _fourcenter.FillFourCenterRepBlock(
-                block, shell_1, shell_2, shell_3, shell_4);
-
-            // If there are only zeros, we don't need to put anything in the
-            // ERIs matrix
-            if (!nonzero) {
-              continue;
-            }
-
-            // Begin fill ERIs matrix
-
-            FillERIsBlock<false>(ERIs_thread, DMAT, block, shell_1, shell_2,
-                                 shell_3, shell_4);
-
-            // Symmetry 1 <--> 2
-            if (iShell_1 != iShell_2) {
-              FillERIsBlock<false>(ERIs_thread, DMAT, block, shell_2, shell_1,
-                                   shell_3, shell_4);
-            }
-
-            // Symmetry 3 <--> 4
-            if (iShell_3 != iShell_4) {
-              FillERIsBlock<false>(ERIs_thread, DMAT, block, shell_1, shell_2,
-                                   shell_4, shell_3);
-            }
-
-            // Symmetry 1 <--> 2 and 3 <--> 4
-            if (iShell_1 != iShell_2 && iShell_3 != iShell_4) {
-              FillERIsBlock<false>(ERIs_thread, DMAT, block, shell_2, shell_1,
-                                   shell_4, shell_3);
-            }
-
-            // Symmetry (1, 2) <--> (3, 4)
-            if (iShell_1 != iShell_3) {
-
-              FillERIsBlock<true>(ERIs_thread, DMAT, block, shell_3, shell_4,
-                                  shell_1, shell_2);
-
-              // Symmetry 1 <--> 2
-              if (iShell_1 != iShell_2) {
-                FillERIsBlock<true>(ERIs_thread, DMAT, block, shell_3, shell_4,
-                                    shell_2, shell_1);
-              }
-
-              // Symmetry 3 <--> 4
-              if (iShell_3 != iShell_4) {
-                FillERIsBlock<true>(ERIs_thread, DMAT, block, shell_4, shell_3,
-                                    shell_1, shell_2);
-              }
-
-              // Symmetry 1 <--> 2 and 3 <--> 4
-              if (iShell_1 != iShell_2 && iShell_3 != iShell_4) {
-                FillERIsBlock<true>(ERIs_thread, DMAT, block, shell_4, shell_3,
-                                    shell_2, shell_1);
-              }
-            }
-
-            // End fill ERIs matrix
-          }  // End loop over shell 2
-        }    // End loop over shell 1
-      }      // End loop over shell 4
-    }        // End loop over shell 3
-
-#pragma omp critical
-    { ERIs2 += ERIs_thread; }
-  }
-
-  ERIs2 = ERIs2.selfadjointView<Eigen::Upper>();
-  double energy = CalculateEnergy(DMAT, ERIs2);
-  return Mat_p_Energy(energy, ERIs2);
-}
-
-template <bool transposed_block>
-void ERIs::FillERIsBlock(Eigen::MatrixXd& ERIsCur, const Eigen::MatrixXd& DMAT,
-                         const Eigen::Tensor<double, 4>& block,
-                         const AOShell& shell_1, const AOShell& shell_2,
-                         const AOShell& shell_3, const AOShell& shell_4) const {
-
-  for (Index iFunc_3 = 0; iFunc_3 < shell_3.getNumFunc(); iFunc_3++) {
-    Index ind_3 = shell_3.getStartIndex() + iFunc_3;
-    for (Index iFunc_4 = 0; iFunc_4 < shell_4.getNumFunc(); iFunc_4++) {
-      Index ind_4 = shell_4.getStartIndex() + iFunc_4;
-
-      // Symmetry
-      if (ind_3 > ind_4) {
-        continue;
-      }
-
-      for (Index iFunc_1 = 0; iFunc_1 < shell_1.getNumFunc(); iFunc_1++) {
-        Index ind_1 = shell_1.getStartIndex() + iFunc_1;
-        for (Index iFunc_2 = 0; iFunc_2 < shell_2.getNumFunc(); iFunc_2++) {
-          Index ind_2 = shell_2.getStartIndex() + iFunc_2;
-
-          // Symmetry
-          if (ind_1 > ind_2) {
-            continue;
-          }
-
-          // Symmetry for diagonal elements
-          double multiplier = (ind_1 == ind_2 ? 1.0 : 2.0);
-          // Fill ERIs matrix
-          if (!transposed_block) {
-            ERIsCur(ind_3, ind_4) += multiplier * DMAT(ind_1, ind_2) *
-                                     block(iFunc_1, iFunc_2, iFunc_3, iFunc_4);
-          } else {
-            ERIsCur(ind_3, ind_4) += multiplier * DMAT(ind_1, ind_2) *
-                                     block(iFunc_3, iFunc_4, iFunc_1, iFunc_2);
-          }
-
-        }  // End loop over functions in shell 2
-      }    // End loop over functions in shell 1
-    }      // End loop over functions in shell 4
-  }        // End loop over functions in shell 3
-
-  return;
-}
-
-void ERIs::CalculateERIsDiagonals(const AOBasis& dftbasis) {
-  // Number of shells
-  Index numShells = dftbasis.getNumofShells();
-  // Total number of functions
-  Index dftBasisSize = dftbasis.AOBasisSize();
-
-  _diagonals = Eigen::MatrixXd::Zero(dftBasisSize, dftBasisSize);
-
-  for (Index iShell_1 = 0; iShell_1 < numShells; iShell_1++) {
-    const AOShell& shell_1 = dftbasis.getShell(iShell_1);
-    Index numFunc_1 = shell_1.getNumFunc();
-    for (Index iShell_2 = iShell_1; iShell_2 < numShells; iShell_2++) {
-      const AOShell& shell_2 = dftbasis.getShell(iShell_2);
-      Index numFunc_2 = shell_2.getNumFunc();
-
-      // Get the current 4c block
-      Eigen::Tensor<double, 4> block(numFunc_1, numFunc_2, numFunc_1,
-                                     numFunc_2);
-      block.setZero();
-      bool nonzero = _fourcenter.FillFourCenterRepBlock(block, shell_1, shell_2,
-                                                        shell_1, shell_2);
-
-      if (!nonzero) {
-        continue;
-      }
-
-      for (Index iFunc_1 = 0; iFunc_1 < shell_1.getNumFunc(); iFunc_1++) {
-        Index ind_1 = shell_1.getStartIndex() + iFunc_1;
-        for (Index iFunc_2 = 0; iFunc_2 < shell_2.getNumFunc(); iFunc_2++) {
-          Index ind_2 = shell_2.getStartIndex() + iFunc_2;
-
-          // Symmetry
-          if (ind_1 > ind_2) {
-            continue;
-          }
-
-          _diagonals(ind_1, ind_2) = block(iFunc_1, iFunc_2, iFunc_1, iFunc_2);
-
-          // Symmetry
-          if (ind_1 != ind_2) {
-            _diagonals(ind_2, ind_1) = _diagonals(ind_1, ind_2);
-          }
-        }
-      }
-    }
-  }
-
-  return;
-}
-
-bool ERIs::CheckScreen(double eps, const AOShell& shell_1,
-                       const AOShell& shell_2, const AOShell& shell_3,
-                       const AOShell& shell_4) const {
-
-  const double eps2 = eps * eps;
-
-  for (Index iFunc_3 = 0; iFunc_3 < shell_3.getNumFunc(); iFunc_3++) {
-    Index ind_3 = shell_3.getStartIndex() + iFunc_3;
-    for (Index iFunc_4 = 0; iFunc_4 < shell_4.getNumFunc(); iFunc_4++) {
-      Index ind_4 = shell_4.getStartIndex() + iFunc_4;
-
-      // Symmetry
-      if (ind_3 > ind_4) {
-        continue;
-      }
-
-      for (Index iFunc_1 = 0; iFunc_1 < shell_1.getNumFunc(); iFunc_1++) {
-        Index ind_1 = shell_1.getStartIndex() + iFunc_1;
-        for (Index iFunc_2 = 0; iFunc_2 < shell_2.getNumFunc(); iFunc_2++) {
-          Index ind_2 = shell_2.getStartIndex() + iFunc_2;
-
-          // Symmetry
-          if (ind_1 > ind_2) {
-            continue;
-          }
-
-          // Cauchy–Schwarz
-          // <ab|cd> <= sqrt(<ab|ab>) * sqrt(<cd|cd>)
-          double ub = _diagonals(ind_1, ind_2) * _diagonals(ind_3, ind_4);
-
-          // Compare with tolerance
-          if (ub > eps2) {
-            return false;  // We must compute ERIS for the whole block
-          }
-        }
-      }
-    }
-  }
-
-  return true;  // We can skip the whole block
-}
-
-double ERIs::CalculateEnergy(const Eigen::MatrixXd& DMAT,
-                             const Eigen::MatrixXd& matrix_operator) const {
-  return matrix_operator.cwiseProduct(DMAT).sum();
-}
-
-}  // namespace xtp
-}  // namespace votca
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Standard includes
+#include <algorithm>
+#include <queue>
+
+// Local VOTCA includes
+#include "votca/xtp/ERIs.h"
+#include "votca/xtp/aobasis.h"
+#include "votca/xtp/symmetric_matrix.h"
+
+namespace votca {
+namespace xtp {
+
+void ERIs::Initialize(const AOBasis& dftbasis, const AOBasis& auxbasis,
+                      double max_memory_mb, const std::string& scratchdir,
+                      double screening_eps) {
+  _threecenter.setMemoryLimit(max_memory_mb, scratchdir);
+  _threecenter.setScreening(screening_eps);
+  _threecenter.Fill(auxbasis, dftbasis);
+  return;
+}
+
+void ERIs::Initialize_4c_small_molecule(const AOBasis& dftbasis) {
+  _fourcenter.Fill_4c_small_molecule(dftbasis);
+  return;
+}
+
+void ERIs::Initialize_4c_screening(const AOBasis& dftbasis, double eps) {
+  _with_screening = true;
+  _screening_eps = eps;
+  CalculateERIsDiagonals(dftbasis);
+  return;
+}
+
+Eigen::VectorXd ERIs::PackDensity(const Eigen::MatrixXd& DMAT) const {
+  Eigen::VectorXd packed = Eigen::VectorXd((DMAT.rows() + 1) * DMAT.rows() / 2);
+  for (Index i = 0; i < DMAT.rows(); ++i) {
+    const Index start = (i * (i + 1)) / 2;
+    packed.segment(start, i) = 2 * DMAT.row(i).head(i);
+    packed(start + i) = DMAT(i, i);
+  }
+  return packed;
+}
+
+Eigen::MatrixXd ERIs::UnpackMatrix(const Eigen::VectorXd& packed,
+                                   Index dim) const {
+  Eigen::MatrixXd result = Eigen::MatrixXd(dim, dim);
+  for (Index i = 0; i < dim; ++i) {
+    const Index start = (i * (i + 1)) / 2;
+    result.row(i).head(i + 1) = packed.segment(start, i + 1);
+    result.col(i).head(i) = packed.segment(start, i);
+  }
+  return result;
+}
+
+// Contracts the density with the three-center integrals, J=I*(I^T*D), aux
+// functions whose fit coefficient is smaller than eps are skipped
+Eigen::MatrixXd ERIs::ContractRI(const Eigen::MatrixXd& DMAT,
+                                 double eps) const {
+  const Eigen::VectorXd density = _threecenter.GatherPairs(PackDensity(DMAT));
+  Eigen::VectorXd stored = Eigen::VectorXd::Zero(density.size());
+  Eigen::MatrixXd buffer;
+  const Index blocksize = _threecenter.AuxBlocksize();
+  for (Index start = 0; start < _threecenter.size(); start += blocksize) {
+    const Index size = std::min(blocksize, _threecenter.size() - start);
+    Eigen::Ref<const Eigen::MatrixXd> threecenter =
+        _threecenter.getAuxBlock(start, size, buffer);
+    Eigen::VectorXd coefficients = threecenter.transpose() * density;
+    if (eps > 0.0) {
+      coefficients = (coefficients.array().abs() < eps)
+                         .select(0.0, coefficients.array())
+                         .matrix();
+    }
+    stored += threecenter * coefficients;
+  }
+  return UnpackMatrix(_threecenter.ScatterPairs(stored), DMAT.rows());
+}
+
+Eigen::VectorXd ERIs::FitDensity(const Eigen::MatrixXd& DMAT) const {
+  const Eigen::VectorXd density = _threecenter.GatherPairs(PackDensity(DMAT));
+  Eigen::VectorXd coefficients = Eigen::VectorXd(_threecenter.size());
+  Eigen::MatrixXd buffer;
+  const Index blocksize = _threecenter.AuxBlocksize();
+  for (Index start = 0; start < _threecenter.size(); start += blocksize) {
+    const Index size = std::min(blocksize, _threecenter.size() - start);
+    coefficients.segment(start, size) =
+        _threecenter.getAuxBlock(start, size, buffer).transpose() * density;
+  }
+  return coefficients;
+}
+
+Eigen::MatrixXd ERIs::ContractFit(const Eigen::VectorXd& coefficients) const {
+  assert(coefficients.size() == _threecenter.size() &&
+         "Fit coefficients do not match aux basis");
+  Eigen::VectorXd stored = Eigen::VectorXd::Zero(_threecenter.pairsize());
+  Eigen::MatrixXd buffer;
+  const Index blocksize = _threecenter.AuxBlocksize();
+  for (Index start = 0; start < _threecenter.size(); start += blocksize) {
+    const Index size = std::min(blocksize, _threecenter.size() - start);
+    stored += _threecenter.getAuxBlock(start, size, buffer) *
+              coefficients.segment(start, size);
+  }
+  return UnpackMatrix(_threecenter.ScatterPairs(stored),
+                      _threecenter.dftsize());
+}
+
+Mat_p_Energy ERIs::CalculateERIs(const Eigen::MatrixXd& DMAT) const {
+  Eigen::MatrixXd ERIs2 = ContractRI(DMAT, 0.0);
+  double energy = CalculateEnergy(DMAT, ERIs2);
+  return Mat_p_Energy(energy, ERIs2);
+}
+
+// K = sum_P T_P (C+ C+^T - C- C-^T) T_P. The three-center integrals are
+// half-transformed with all coefficients in one GEMM per batch of aux
+// functions, so that K is formed by one rank-k update per batch.
+Eigen::MatrixXd ERIs::ContractExchange(const Eigen::MatrixXd& positive,
+                                       const Eigen::MatrixXd& negative) const {
+  const Index dftsize = _threecenter.dftsize();
+  Eigen::MatrixXd EXX = Eigen::MatrixXd::Zero(dftsize, dftsize);
+  const Index npositive = positive.cols();
+  const Index ncoeffs = npositive + negative.cols();
+  if (ncoeffs == 0) {
+    return EXX;
+  }
+  Eigen::MatrixXd coeffs = Eigen::MatrixXd(dftsize, ncoeffs);
+  coeffs << positive, negative;
+
+  // a batch holds the unpacked and the half-transformed integrals
+  const double batchmemory = _exchange_batch_memory * 1024.0 * 1024.0;
+  const Index batchsize = std::max<Index>(
+      1, Index(batchmemory /
+               (double(dftsize) * double(dftsize + ncoeffs) * sizeof(double))));
+
+  Eigen::MatrixXd buffer;
+  const Index blocksize = _threecenter.AuxBlocksize();
+  for (Index start = 0; start < _threecenter.size(); start += blocksize) {
+    const Index size = std::min(blocksize, _threecenter.size() - start);
+    Eigen::Ref<const Eigen::MatrixXd> block =
+        _threecenter.getAuxBlock(start, size, buffer);
+    for (Index batchstart = 0; batchstart < size; batchstart += batchsize) {
+      const Index batch = std::min(batchsize, size - batchstart);
+      // integrals of the batch stacked as (batch*dftsize x dftsize)
+      Eigen::MatrixXd stacked = Eigen::MatrixXd(batch * dftsize, dftsize);
+#pragma omp parallel for schedule(static)
+      for (Index i = 0; i < batch; i++) {
+        stacked.middleRows(i * dftsize, dftsize) = UnpackMatrix(
+            _threecenter.ScatterPairs(block.col(batchstart + i)), dftsize);
+      }
+      const Eigen::MatrixXd halftransformed = stacked * coeffs;
+      // the column major (batch*dftsize x ncoeffs) result is read as a
+      // (dftsize x batch*ncoeffs) matrix, whose columns are T_P*c for all
+      // aux functions P and coefficients c
+      Eigen::Map<const Eigen::MatrixXd> tc(halftransformed.data(), dftsize,
+                                           batch * ncoeffs);
+      EXX.selfadjointView<Eigen::Lower>().rankUpdate(
+          tc.leftCols(batch * npositive));
+      if (ncoeffs > npositive) {
+        EXX.selfadjointView<Eigen::Lower>().rankUpdate(
+            tc.rightCols(batch * (ncoeffs - npositive)), -1.0);
+      }
+    }
+  }
+  return EXX.selfadjointView<Eigen::Lower>();
+}
+
+// splits a symmetric matrix into C+ C+^T - C- C-^T, eigenvalues with an
+// absolute value not larger than eps are dropped
+std::pair<Eigen::MatrixXd, Eigen::MatrixXd> ERIs::SplitDensity(
+    const Eigen::MatrixXd& DMAT, double eps) const {
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(DMAT);
+  std::vector<Index> positive;
+  std::vector<Index> negative;
+  for (Index i = 0; i < es.eigenvalues().size(); i++) {
+    if (es.eigenvalues()[i] > eps) {
+      positive.push_back(i);
+    } else if (es.eigenvalues()[i] < -eps) {
+      negative.push_back(i);
+    }
+  }
+  auto factor = [&es](const std::vector<Index>& indices) {
+    Eigen::MatrixXd result =
+        Eigen::MatrixXd(es.eigenvectors().rows(), Index(indices.size()));
+    for (Index i = 0; i < Index(indices.size()); i++) {
+      result.col(i) = es.eigenvectors().col(indices[i]) *
+                      std::sqrt(std::abs(es.eigenvalues()[indices[i]]));
+    }
+    return result;
+  };
+  return std::make_pair(factor(positive), factor(negative));
+}
+
+Mat_p_Energy ERIs::CalculateEXX(const Eigen::MatrixXd& DMAT) const {
+  std::pair<Eigen::MatrixXd, Eigen::MatrixXd> factors = SplitDensity(DMAT, 0.0);
+  Eigen::MatrixXd EXX = ContractExchange(factors.first, factors.second);
+  double energy = CalculateEnergy(DMAT, EXX);
+  return Mat_p_Energy(energy, EXX);
+}
+
+Mat_p_Energy ERIs::CalculateEXX(const Eigen::MatrixXd& occMos,
+                                const Eigen::MatrixXd& DMAT) const {
+  // DMAT=2*occMos*occMos^T
+  Eigen::MatrixXd EXX = ContractExchange(std::sqrt(2.0) * occMos,
+                                         Eigen::MatrixXd(occMos.rows(), 0));
+  double energy = CalculateEnergy(DMAT, EXX);
+  return Mat_p_Energy(energy, EXX);
+}
+
+Eigen::MatrixXd ERIs::CalculateERIs_diff(const Eigen::MatrixXd& dDMAT,
+                                         double eps) const {
+  // aux functions in which the change of the fitted density is negligible are
+  // skipped
+  return ContractRI(dDMAT, eps);
+}
+
+Eigen::MatrixXd ERIs::CalculateEXX_diff(const Eigen::MatrixXd& dDMAT,
+                                        double eps) const {
+  // dDMAT is decomposed into its eigenvectors, only eigenvectors with
+  // eigenvalues larger than eps contribute. Close to convergence the density
+  // difference has a very low rank, so this is much cheaper than a full build.
+  std::pair<Eigen::MatrixXd, Eigen::MatrixXd> factors =
+      SplitDensity(dDMAT, eps);
+  return ContractExchange(factors.first, factors.second);
+}
+
+Mat_p_Energy ERIs::CalculateERIs_4c_small_molecule(
+    const Eigen::MatrixXd& DMAT) const {
+
+  Eigen::MatrixXd ERIs2 = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+
+  const Eigen::VectorXd& fourc_vector = _fourcenter.get_4c_vector();
+
+  Index dftBasisSize = DMAT.rows();
+  Index vectorSize = (dftBasisSize * (dftBasisSize + 1)) / 2;
+#pragma omp parallel for
+  for (Index i = 0; i < dftBasisSize; i++) {
+    Index sum_i = (i * (i + 1)) / 2;
+    for (Index j = i; j < dftBasisSize; j++) {
+      Index index_ij = dftBasisSize * i - sum_i + j;
+      Index index_ij_kl_a =
+          vectorSize * index_ij - (index_ij * (index_ij + 1)) / 2;
+      for (Index k = 0; k < dftBasisSize; k++) {
+        Index sum_k = (k * (k + 1)) / 2;
+        for (Index l = k; l < dftBasisSize; l++) {
+          Index index_kl = dftBasisSize * k - sum_k + l;
+
+          Index index_ij_kl = index_ij_kl_a + index_kl;
+          if (index_ij > index_kl) {
+            index_ij_kl = vectorSize * index_kl -
+                          (index_kl * (index_kl + 1)) / 2 + index_ij;
+          }
+
+          if (l == k) {
+            ERIs2(i, j) += DMAT(k, l) * fourc_vector(index_ij_kl);
+          } else {
+            ERIs2(i, j) += 2. * DMAT(k, l) * fourc_vector(index_ij_kl);
+          }
+        }
+      }
+      ERIs2(j, i) = ERIs2(i, j);
+    }
+  }
+
+  double energy = CalculateEnergy(DMAT, ERIs2);
+  return Mat_p_Energy(energy, ERIs2);
+}
+
+Mat_p_Energy ERIs::CalculateEXX_4c_small_molecule(
+    const Eigen::MatrixXd& DMAT) const {
+  Eigen::MatrixXd EXX = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+
+  const Eigen::VectorXd& fourc_vector = _fourcenter.get_4c_vector();
+
+  Index dftBasisSize = DMAT.rows();
+  Index vectorSize = (dftBasisSize * (dftBasisSize + 1)) / 2;
+#pragma omp parallel for reduction(+ : EXX)
+  for (Index i = 0; i < dftBasisSize; i++) {
+    Index sum_i = (i * (i + 1)) / 2;
+    for (Index j = i; j < dftBasisSize; j++) {
+      Index index_ij = DMAT.cols() * i - sum_i + j;
+      Index index_ij_kl_a =
+          vectorSize * index_ij - (index_ij * (index_ij + 1)) / 2;
+      for (Index k = 0; k < dftBasisSize; k++) {
+        Index sum_k = (k * (k + 1)) / 2;
+        for (Index l = k; l < dftBasisSize; l++) {
+          Index index_kl = DMAT.cols() * k - sum_k + l;
+
+          Index _index_ij_kl = index_ij_kl_a + index_kl;
+          if (index_ij > index_kl) {
+            _index_ij_kl = vectorSize * index_kl -
+                           (index_kl * (index_kl + 1)) / 2 + index_ij;
+          }
+          double factorij = 1;
+          if (i == j) {
+            factorij = 0.5;
+          }
+          double factorkl = 1;
+          if (l == k) {
+            factorkl = 0.5;
+          }
+          double factor = factorij * factorkl;
+          EXX(i, l) += factor * DMAT(j, k) * fourc_vector(_index_ij_kl);
+          EXX(j, l) += factor * DMAT(i, k) * fourc_vector(_index_ij_kl);
+          EXX(i, k) += factor * DMAT(j, l) * fourc_vector(_index_ij_kl);
+          EXX(j, k) += factor * DMAT(i, l) * fourc_vector(_index_ij_kl);
+        }
+      }
+    }
+  }
+
+  double energy = CalculateEnergy(DMAT, EXX);
+  return Mat_p_Energy(energy, EXX);
+}
+
+Mat_p_Energy ERIs::CalculateERIs_4c_direct(const AOBasis& dftbasis,
+                                           const Eigen::MatrixXd& DMAT) const {
+
+  // Number of shells
+  Index numShells = dftbasis.getNumofShells();
+
+  // Initialize ERIs matrix
+  Eigen::MatrixXd ERIs2 = Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+
+#pragma omp parallel
+  {  // Begin omp parallel
+
+    Eigen::MatrixXd ERIs_thread =
+        Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+
+#pragma omp for
+    for (Index iShell_3 = 0; iShell_3 < numShells; iShell_3++) {
+      const AOShell& shell_3 = dftbasis.getShell(iShell_3);
+      Index numFunc_3 = shell_3.getNumFunc();
+      for (Index iShell_4 = iShell_3; iShell_4 < numShells; iShell_4++) {
+        const AOShell& shell_4 = dftbasis.getShell(iShell_4);
+        Index numFunc_4 = shell_4.getNumFunc();
+        for (Index iShell_1 = iShell_3; iShell_1 < numShells; iShell_1++) {
+          const AOShell& shell_1 = dftbasis.getShell(iShell_1);
+          Index numFunc_1 = shell_1.getNumFunc();
+          for (Index iShell_2 = iShell_1; iShell_2 < numShells; iShell_2++) {
+            const AOShell& shell_2 = dftbasis.getShell(iShell_2);
+            Index numFunc_2 = shell_2.getNumFunc();
+
+            // Pre-screening
+            if (_with_screening && CheckScreen(_screening_eps, shell_1, shell_2,
+                                               shell_3, shell_4)) {
+              continue;
+            }
+
+            // Get the current 4c block
+            Eigen::Tensor<double, 4> block(numFunc_1, numFunc_2, numFunc_3,
+                                           numFunc_4);
+            block.setZero();
+            bool nonzero = _fourcenter.FillFourCenterRepBlock(
+                block, shell_1, shell_2, shell_3, shell_4);
+
+            // If there are only zeros, we don't need to put anything in the
+            // ERIs matrix
+            if (!nonzero) {
+              continue;
+            }
+
+            // Begin fill ERIs matrix
+
+            FillERIsBlock<false>(ERIs_thread, DMAT, block, shell_1, shell_2,
+                                 shell_3, shell_4);
+
+            // Symmetry 1 <--> 2
+            if (iShell_1 != iShell_2) {
+              FillERIsBlock<false>(ERIs_thread, DMAT, block, shell_2, shell_1,
+                                   shell_3, shell_4);
+            }
+
+            // Symmetry 3 <--> 4
+            if (iShell_3 != iShell_4) {
+              FillERIsBlock<false>(ERIs_thread, DMAT, block, shell_1, shell_2,
+                                   shell_4, shell_3);
+            }
+
+            // Symmetry 1 <--> 2 and 3 <--> 4
+            if (iShell_1 != iShell_2 && iShell_3 != iShell_4) {
+              FillERIsBlock<false>(ERIs_thread, DMAT, block, shell_2, shell_1,
+                                   shell_4, shell_3);
+            }
+
+            // Symmetry (1, 2) <--> (3, 4)
+            if (iShell_1 != iShell_3) {
+
+              FillERIsBlock<true>(ERIs_thread, DMAT, block, shell_3, shell_4,
+                                  shell_1, shell_2);
+
+              // Symmetry 1 <--> 2
+              if (iShell_1 != iShell_2) {
+                FillERIsBlock<true>(ERIs_thread, DMAT, block, shell_3, shell_4,
+                                    shell_2, shell_1);
+              }
+
+              // Symmetry 3 <--> 4
+              if (iShell_3 != iShell_4) {
+                FillERIsBlock<true>(ERIs_thread, DMAT, block, shell_4, shell_3,
+                                    shell_1, shell_2);
+              }
+
+              // Symmetry 1 <--> 2 and 3 <--> 4
+              if (iShell_1 != iShell_2 && iShell_3 != iShell_4) {
+                FillERIsBlock<true>(ERIs_thread, DMAT, block, shell_4, shell_3,
+                                    shell_2, shell_1);
+              }
+            }
+
+            // End fill ERIs matrix
+          }  // End loop over shell 2
+        }    // End loop over shell 1
+      }      // End loop over shell 4
+    }        // End loop over shell 3
+
+#pragma omp critical
+    { ERIs2 += ERIs_thread; }
+  }
+
+  ERIs2 = ERIs2.selfadjointView<Eigen::Upper>();
+  double energy = CalculateEnergy(DMAT, ERIs2);
+  return Mat_p_Energy(energy, ERIs2);
+}
+
+template <bool transposed_block>
+void ERIs::FillERIsBlock(Eigen::MatrixXd& ERIsCur, const Eigen::MatrixXd& DMAT,
+                         const Eigen::Tensor<double, 4>& block,
+                         const AOShell& shell_1, const AOShell& shell_2,
+                         const AOShell& shell_3, const AOShell& shell_4) const {
+
+  for (Index iFunc_3 = 0; iFunc_3 < shell_3.getNumFunc(); iFunc_3++) {
+    Index ind_3 = shell_3.getStartIndex() + iFunc_3;
+    for (Index iFunc_4 = 0; iFunc_4 < shell_4.getNumFunc(); iFunc_4++) {
+      Index ind_4 = shell_4.getStartIndex() + iFunc_4;
+
+      // Symmetry
+      if (ind_3 > ind_4) {
+        continue;
+      }
+
+      for (Index iFunc_1 = 0; iFunc_1 < shell_1.getNumFunc(); iFunc_1++) {
+        Index ind_1 = shell_1.getStartIndex() + iFunc_1;
+        for (Index iFunc_2 = 0; iFunc_2 < shell_2.getNumFunc(); iFunc_2++) {
+          Index ind_2 = shell_2.getStartIndex() + iFunc_2;
+
+          // Symmetry
+          if (ind_1 > ind_2) {
+            continue;
+          }
+
+          // Symmetry for diagonal elements
+          double multiplier = (ind_1 == ind_2 ? 1.0 : 2.0);
+          // Fill ERIs matrix
+          if (!transposed_block) {
+            ERIsCur(ind_3, ind_4) += multiplier * DMAT(ind_1, ind_2) *
+                                     block(iFunc_1, iFunc_2, iFunc_3, iFunc_4);
+          } else {
+            ERIsCur(ind_3, ind_4) += multiplier * DMAT(ind_1, ind_2) *
+                                     block(iFunc_3, iFunc_4, iFunc_1, iFunc_2);
+          }
+
+        }  // End loop over functions in shell 2
+      }    // End loop over functions in shell 1
+    }      // End loop over functions in shell 4
+  }        // End loop over functions in shell 3
+
+  return;
+}
+
+void ERIs::CalculateERIsDiagonals(const AOBasis& dftbasis) {
+  // Number of shells
+  Index numShells = dftbasis.getNumofShells();
+  // Total number of functions
+  Index dftBasisSize = dftbasis.AOBasisSize();
+
+  _diagonals = Eigen::MatrixXd::Zero(dftBasisSize, dftBasisSize);
+
+  for (Index iShell_1 = 0; iShell_1 < numShells; iShell_1++) {
+    const AOShell& shell_1 = dftbasis.getShell(iShell_1);
+    Index numFunc_1 = shell_1.getNumFunc();
+    for (Index iShell_2 = iShell_1; iShell_2 < numShells; iShell_2++) {
+      const AOShell& shell_2 = dftbasis.getShell(iShell_2);
+      Index numFunc_2 = shell_2.getNumFunc();
+
+      // Get the current 4c block
+      Eigen::Tensor<double, 4> block(numFunc_1, numFunc_2, numFunc_1,
+                                     numFunc_2);
+      block.setZero();
+      bool nonzero = _fourcenter.FillFourCenterRepBlock(block, shell_1, shell_2,
+                                                        shell_1, shell_2);
+
+      if (!nonzero) {
+        continue;
+      }
+
+      for (Index iFunc_1 = 0; iFunc_1 < shell_1.getNumFunc(); iFunc_1++) {
+        Index ind_1 = shell_1.getStartIndex() + iFunc_1;
+        for (Index iFunc_2 = 0; iFunc_2 < shell_2.getNumFunc(); iFunc_2++) {
+          Index ind_2 = shell_2.getStartIndex() + iFunc_2;
+
+          // Symmetry
+          if (ind_1 > ind_2) {
+            continue;
+          }
+
+          _diagonals(ind_1, ind_2) = block(iFunc_1, iFunc_2, iFunc_1, iFunc_2);
+
+          // Symmetry
+          if (ind_1 != ind_2) {
+            _diagonals(ind_2, ind_1) = _diagonals(ind_1, ind_2);
+          }
+        }
+      }
+    }
+  }
+
+  return;
+}
+
+bool ERIs::CheckScreen(double eps, const AOShell& shell_1,
+                       const AOShell& shell_2, const AOShell& shell_3,
+                       const AOShell& shell_4) const {
+
+  const double eps2 = eps * eps;
+
+  for (Index iFunc_3 = 0; iFunc_3 < shell_3.getNumFunc(); iFunc_3++) {
+    Index ind_3 = shell_3.getStartIndex() + iFunc_3;
+    for (Index iFunc_4 = 0; iFunc_4 < shell_4.getNumFunc(); iFunc_4++) {
+      Index ind_4 = shell_4.getStartIndex() + iFunc_4;
+
+      // Symmetry
+      if (ind_3 > ind_4) {
+        continue;
+      }
+
+      for (Index iFunc_1 = 0; iFunc_1 < shell_1.getNumFunc(); iFunc_1++) {
+        Index ind_1 = shell_1.getStartIndex() + iFunc_1;
+        for (Index iFunc_2 = 0; iFunc_2 < shell_2.getNumFunc(); iFunc_2++) {
+          Index ind_2 = shell_2.getStartIndex() + iFunc_2;
+
+          // Symmetry
+          if (ind_1 > ind_2) {
+            continue;
+          }
+
+          // Cauchy–Schwarz
+          // <ab|cd> <= sqrt(<ab|ab>) * sqrt(<cd|cd>)
+          double ub = _diagonals(ind_1, ind_2) * _diagonals(ind_3, ind_4);
+
+          // Compare with tolerance
+          if (ub > eps2) {
+            return false;  // We must compute ERIS for the whole block
+          }
+        }
+      }
+    }
+  }
+
+  return true;  // We can skip the whole block
+}
+
+void ERIs::Initialize_4c_semidirect(const AOBasis& dftbasis, double eps,
+                                    double max_memory_mb) {
+  _screening_eps = eps;
+  CalculateERIsDiagonals(dftbasis);
+
+  _shellpairs.clear();
+  for (Index a = 0; a < dftbasis.getNumofShells(); a++) {
+    const AOShell& shell_a = dftbasis.getShell(a);
+    for (Index b = 0; b <= a; b++) {
+      const AOShell& shell_b = dftbasis.getShell(b);
+      double maximum = _diagonals
+                           .block(shell_a.getStartIndex(),
+                                  shell_b.getStartIndex(), shell_a.getNumFunc(),
+                                  shell_b.getNumFunc())
+                           .maxCoeff();
+      if (maximum > 0.0) {
+        _shellpairs.push_back({a, b, std::sqrt(maximum)});
+      }
+    }
+  }
+  std::sort(_shellpairs.begin(), _shellpairs.end(),
+            [](const ShellPair& p1, const ShellPair& p2) {
+              return p1.schwarz > p2.schwarz;
+            });
+
+  // the most expensive quartets are kept, cost is estimated from the number
+  // of primitive quartets times the number of cartesian functions
+  auto nprimitives = [](const AOShell& shell) {
+    return double(std::distance(shell.begin(), shell.end()));
+  };
+  struct Candidate {
+    double cost;
+    Index key;
+    double memory;
+    bool operator>(const Candidate& other) const { return cost > other.cost; }
+  };
+  std::priority_queue<Candidate, std::vector<Candidate>,
+                      std::greater<Candidate>>
+      cheapest;
+  const double max_memory = max_memory_mb * 1024.0 * 1024.0;
+  double memory = 0.0;
+  const Index npairs = Index(_shellpairs.size());
+  for (Index p = 0; p < npairs; p++) {
+    const AOShell& shell_1 = dftbasis.getShell(_shellpairs[p].shell_1);
+    const AOShell& shell_2 = dftbasis.getShell(_shellpairs[p].shell_2);
+    for (Index q = p; q < npairs; q++) {
+      if (_shellpairs[p].schwarz * _shellpairs[q].schwarz < eps) {
+        break;
+      }
+      const AOShell& shell_3 = dftbasis.getShell(_shellpairs[q].shell_1);
+      const AOShell& shell_4 = dftbasis.getShell(_shellpairs[q].shell_2);
+      Candidate candidate;
+      candidate.key = p * npairs + q;
+      candidate.cost = nprimitives(shell_1) * nprimitives(shell_2) *
+                       nprimitives(shell_3) * nprimitives(shell_4) *
+                       double(shell_1.getCartesianNumFunc() *
+                              shell_2.getCartesianNumFunc() *
+                              shell_3.getCartesianNumFunc() *
+                              shell_4.getCartesianNumFunc());
+      // block plus bookkeeping
+      candidate.memory =
+          double(shell_1.getNumFunc() * shell_2.getNumFunc() *
+                 shell_3.getNumFunc() * shell_4.getNumFunc()) *
+              sizeof(double) +
+          64.0;
+      cheapest.push(candidate);
+      memory += candidate.memory;
+      while (memory > max_memory && !cheapest.empty()) {
+        memory -= cheapest.top().memory;
+        cheapest.pop();
+      }
+    }
+  }
+
+  std::vector<Index> keys;
+  keys.reserve(cheapest.size());
+  while (!cheapest.empty()) {
+    keys.push_back(cheapest.top().key);
+    cheapest.pop();
+  }
+  _quartet_index.clear();
+  _quartet_cache = std::vector<Eigen::Tensor<double, 4>>(keys.size());
+#pragma omp parallel for schedule(dynamic)
+  for (Index i = 0; i < Index(keys.size()); i++) {
+    _quartet_cache[i] = ComputeQuartet(dftbasis, _shellpairs[keys[i] / npairs],
+                                       _shellpairs[keys[i] % npairs]);
+  }
+  for (Index i = 0; i < Index(keys.size()); i++) {
+    _quartet_index[keys[i]] = i;
+  }
+  return;
+}
+
+Eigen::Tensor<double, 4> ERIs::ComputeQuartet(const AOBasis& dftbasis,
+                                              const ShellPair& pair_ab,
+                                              const ShellPair& pair_cd) const {
+  const AOShell& shell_1 = dftbasis.getShell(pair_ab.shell_1);
+  const AOShell& shell_2 = dftbasis.getShell(pair_ab.shell_2);
+  const AOShell& shell_3 = dftbasis.getShell(pair_cd.shell_1);
+  const AOShell& shell_4 = dftbasis.getShell(pair_cd.shell_2);
+  Eigen::Tensor<double, 4> block(shell_1.getNumFunc(), shell_2.getNumFunc(),
+                                 shell_3.getNumFunc(), shell_4.getNumFunc());
+  block.setZero();
+  _fourcenter.FillFourCenterRepBlock(block, shell_1, shell_2, shell_3,
+                                     shell_4);
+  return block;
+}
+
+Eigen::MatrixXd ERIs::ShellBlockMax(const AOBasis& dftbasis,
+                                    const Eigen::MatrixXd& DMAT) const {
+  const Index numshells = dftbasis.getNumofShells();
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(numshells, numshells);
+  for (Index a = 0; a < numshells; a++) {
+    const AOShell& shell_a = dftbasis.getShell(a);
+    for (Index b = 0; b <= a; b++) {
+      const AOShell& shell_b = dftbasis.getShell(b);
+      result(a, b) = DMAT.block(shell_a.getStartIndex(), shell_b.getStartIndex(),
+                                shell_a.getNumFunc(), shell_b.getNumFunc())
+                         .cwiseAbs()
+                         .maxCoeff();
+      result(b, a) = result(a, b);
+    }
+  }
+  return result;
+}
+
+/*
+ * Each unique shell quartet (ab|cd) is visited once and weighted with its
+ * degeneracy, J and K are symmetrized at the end. Quartets are skipped if
+ * their Schwarz bound times the largest density element they are contracted
+ * with is below the screening threshold. Because the pairs are sorted by
+ * their Schwarz bound the loop over cd terminates early. The Coulomb matrix
+ * of DMAT_J and the exchange matrices of all DMATs_K are built in the same
+ * pass, the result holds J first and then one K per density.
+ */
+std::vector<Eigen::MatrixXd> ERIs::ContractSemidirect(
+    const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT_J,
+    const std::vector<const Eigen::MatrixXd*>& DMATs_K) const {
+
+  const Index nK = Index(DMATs_K.size());
+  const bool with_exchange = nK > 0;
+  const Eigen::MatrixXd dmax_J = ShellBlockMax(dftbasis, DMAT_J);
+  Eigen::MatrixXd dmax_K = Eigen::MatrixXd::Zero(dmax_J.rows(), dmax_J.cols());
+  for (const Eigen::MatrixXd* DMAT : DMATs_K) {
+    dmax_K = dmax_K.cwiseMax(ShellBlockMax(dftbasis, *DMAT));
+  }
+  const double dmax_all =
+      dmax_J.size() > 0 ? std::max(dmax_J.maxCoeff(), dmax_K.maxCoeff())
+                        : 0.0;
+  const Index npairs = Index(_shellpairs.size());
+  const Index dim = DMAT_J.rows();
+
+  std::vector<Eigen::MatrixXd> result(nK + 1, Eigen::MatrixXd::Zero(dim, dim));
+#pragma omp parallel
+  {
+    std::vector<Eigen::MatrixXd> result_thread(
+        nK + 1, Eigen::MatrixXd::Zero(dim, dim));
+    Eigen::MatrixXd& J_thread = result_thread[0];
+#pragma omp for schedule(dynamic)
+    for (Index p = 0; p < npairs; p++) {
+      const ShellPair& pair_ab = _shellpairs[p];
+      const Index a = pair_ab.shell_1;
+      const Index b = pair_ab.shell_2;
+      for (Index q = p; q < npairs; q++) {
+        const ShellPair& pair_cd = _shellpairs[q];
+        const double schwarz = pair_ab.schwarz * pair_cd.schwarz;
+        if (schwarz * dmax_all < _screening_eps) {
+          break;
+        }
+        const Index c = pair_cd.shell_1;
+        const Index d = pair_cd.shell_2;
+        double density = std::max(dmax_J(a, b), dmax_J(c, d));
+        if (with_exchange) {
+          density = std::max({density, dmax_K(a, c), dmax_K(a, d),
+                              dmax_K(b, c), dmax_K(b, d)});
+        }
+        if (schwarz * density < _screening_eps) {
+          continue;
+        }
+
+        Eigen::Tensor<double, 4> computed;
+        const Eigen::Tensor<double, 4>* block = nullptr;
+        auto cached = _quartet_index.find(p * npairs + q);
+        if (cached != _quartet_index.end()) {
+          block = &_quartet_cache[cached->second];
+        } else {
+          computed = ComputeQuartet(dftbasis, pair_ab, pair_cd);
+          block = &computed;
+        }
+
+        const double degeneracy =
+            (a == b ? 1.0 : 2.0) * (c == d ? 1.0 : 2.0) * (p == q ? 1.0 : 2.0);
+        const AOShell& shell_1 = dftbasis.getShell(a);
+        const AOShell& shell_2 = dftbasis.getShell(b);
+        const AOShell& shell_3 = dftbasis.getShell(c);
+        const AOShell& shell_4 = dftbasis.getShell(d);
+        for (Index l = 0; l < shell_4.getNumFunc(); l++) {
+          const Index ind_4 = shell_4.getStartIndex() + l;
+          for (Index k = 0; k < shell_3.getNumFunc(); k++) {
+            const Index ind_3 = shell_3.getStartIndex() + k;
+            for (Index j = 0; j < shell_2.getNumFunc(); j++) {
+              const Index ind_2 = shell_2.getStartIndex() + j;
+              for (Index i = 0; i < shell_1.getNumFunc(); i++) {
+                const Index ind_1 = shell_1.getStartIndex() + i;
+                const double value = degeneracy * (*block)(i, j, k, l);
+                J_thread(ind_1, ind_2) += DMAT_J(ind_3, ind_4) * value;
+                J_thread(ind_3, ind_4) += DMAT_J(ind_1, ind_2) * value;
+                for (Index s = 0; s < nK; s++) {
+                  const Eigen::MatrixXd& DMAT = *DMATs_K[s];
+                  Eigen::MatrixXd& K_thread = result_thread[s + 1];
+                  K_thread(ind_1, ind_3) += DMAT(ind_2, ind_4) * value;
+                  K_thread(ind_2, ind_4) += DMAT(ind_1, ind_3) * value;
+                  K_thread(ind_1, ind_4) += DMAT(ind_2, ind_3) * value;
+                  K_thread(ind_2, ind_3) += DMAT(ind_1, ind_4) * value;
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+#pragma omp critical
+    {
+      for (Index s = 0; s <= nK; s++) {
+        result[s] += result_thread[s];
+      }
+    }
+  }
+
+  result[0] = 0.25 * (result[0] + result[0].transpose()).eval();
+  for (Index s = 1; s <= nK; s++) {
+    result[s] = 0.125 * (result[s] + result[s].transpose()).eval();
+  }
+  return result;
+}
+
+std::pair<Mat_p_Energy, Mat_p_Energy> ERIs::CalculateERIs_EXX_4c_semidirect(
+    const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT,
+    bool with_exchange) const {
+  std::vector<const Eigen::MatrixXd*> DMATs_K;
+  if (with_exchange) {
+    DMATs_K.push_back(&DMAT);
+  }
+  std::vector<Eigen::MatrixXd> JK =
+      ContractSemidirect(dftbasis, DMAT, DMATs_K);
+  Eigen::MatrixXd K = with_exchange
+                          ? std::move(JK[1])
+                          : Eigen::MatrixXd::Zero(DMAT.rows(), DMAT.cols());
+  double energy_J = CalculateEnergy(DMAT, JK[0]);
+  double energy_K = CalculateEnergy(DMAT, K);
+  return std::make_pair(Mat_p_Energy(energy_J, std::move(JK[0])),
+                        Mat_p_Energy(energy_K, std::move(K)));
+}
+
+std::array<Eigen::MatrixXd, 3> ERIs::CalculateERIs_EXX_4c_semidirect(
+    const AOBasis& dftbasis, const Eigen::MatrixXd& DMAT_alpha,
+    const Eigen::MatrixXd& DMAT_beta) const {
+  const Eigen::MatrixXd DMAT_total = DMAT_alpha + DMAT_beta;
+  std::vector<Eigen::MatrixXd> JK =
+      ContractSemidirect(dftbasis, DMAT_total, {&DMAT_alpha, &DMAT_beta});
+  return {std::move(JK[0]), std::move(JK[1]), std::move(JK[2])};
+}
+
+double ERIs::CalculateEnergy(const Eigen::MatrixXd& DMAT,
+                             const Eigen::MatrixXd& matrix_operator) const {
+  return matrix_operator.cwiseProduct(DMAT).sum();
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -0,0 +1,139 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Third party includes
+#include <boost/filesystem.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/atomicguesscache.h"
+#include "votca/xtp/checkpoint.h"
+
+namespace votca {
+namespace xtp {
+
+AtomicGuessCache& AtomicGuessCache::Instance() {
+  static AtomicGuessCache cache;
+  return cache;
+}
+
+std::string AtomicGuessCache::MakeKey(const std::string& element,
+                                      const std::string& basisset,
+                                      const std::string& auxbasisset,
+                                      const std::string& ecp,
+                                      const std::string& functional,
+                                      const std::string& grid) {
+  return element + "|" + basisset + "|" + auxbasisset + "|" + ecp + "|" +
+         functional + "|" + grid;
+}
+
+bool AtomicGuessCache::Find(const std::string& key, const std::string& filename,
+                            Eigen::MatrixXd& dmat) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!filename.empty() && _loadedfiles.count(filename) == 0) {
+    _loadedfiles.insert(filename);
+    LoadFile(filename);
+  }
+  auto entry = _densities.find(key);
+  if (entry == _densities.end()) {
+    return false;
+  }
+  dmat = entry->second;
+  return true;
+}
+
+void AtomicGuessCache::Add(const std::string& key, const std::string& filename,
+                           const Eigen::MatrixXd& dmat) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  bool inserted = _densities.insert({key, dmat}).second;
+  if (inserted && !filename.empty()) {
+    WriteFile(filename, key, dmat);
+  }
+}
+
+void AtomicGuessCache::Clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _densities.clear();
+  _loadedfiles.clear();
+}
+
+// hdf5 group names cannot contain '/', escaping '%' keeps the names unique
+std::string AtomicGuessCache::GroupName(const std::string& key) {
+  std::string name;
+  for (char c : key) {
+    if (c == '%') {
+      name += "%25";
+    } else if (c == '/') {
+      name += "%2F";
+    } else {
+      name += c;
+    }
+  }
+  return name;
+}
+
+std::map<std::string, Eigen::MatrixXd> AtomicGuessCache::ReadFile(
+    const std::string& filename) {
+  std::map<std::string, Eigen::MatrixXd> densities;
+  if (!boost::filesystem::exists(filename)) {
+    return densities;
+  }
+  CheckpointFile cpf(filename, CheckpointAccessLevel::READ);
+  CheckpointReader r = cpf.getReader("/atomicguesses");
+  CptLoc loc = r.getLoc();
+  for (Index i = 0; i < r.getNumDataSets(); i++) {
+    CheckpointReader entry = r.openChild(loc.getObjnameByIdx(hsize_t(i)));
+    std::string key;
+    entry(key, "key");
+    Eigen::MatrixXd dmat;
+    entry(dmat, "dmat");
+    densities.insert({key, dmat});
+  }
+  return densities;
+}
+
+void AtomicGuessCache::LoadFile(const std::string& filename) {
+  std::map<std::string, Eigen::MatrixXd> densities = ReadFile(filename);
+  _densities.insert(densities.begin(), densities.end());
+}
+
+// Several jobs may share the file. The densities on disk are merged with the
+// new one into a temporary file, which then replaces the file in one rename,
+// so that readers never see a partially written file. If two jobs write at
+// the same time one density may be lost, which a later run recomputes.
+void AtomicGuessCache::WriteFile(const std::string& filename,
+                                 const std::string& key,
+                                 const Eigen::MatrixXd& dmat) const {
+  std::map<std::string, Eigen::MatrixXd> densities = ReadFile(filename);
+  densities.insert({key, dmat});
+  boost::filesystem::path temp = boost::filesystem::path(filename);
+  temp += boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp");
+  {
+    CheckpointFile cpf(temp.string(), CheckpointAccessLevel::CREATE);
+    CheckpointWriter w = cpf.getWriter("/atomicguesses");
+    for (const auto& density : densities) {
+      CheckpointWriter entry = w.openChild(GroupName(density.first));
+      entry(density.first, "key");
+      entry(density.second, "dmat");
+    }
+  }
+  boost::filesystem::rename(temp, filename);
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -35,29 +35,40 @@ void ConvergenceAcc::setOverlap(AOOverlap& S, double etol) {
   return;
 }
 
-Eigen::MatrixXd ConvergenceAcc::Iterate(const Eigen::MatrixXd& dmat,
-                                        Eigen::MatrixXd& H,
-                                        tools::EigenSystem& MOs, double totE) {
-  Eigen::MatrixXd H_guess = Eigen::MatrixXd::Zero(H.rows(), H.cols());
-
+void ConvergenceAcc::UpdateEnergyHistory(double totE) {
   if (int(_mathist.size()) == _opt.histlength) {
     _totE.erase(_totE.begin() + _maxerrorindex);
     _mathist.erase(_mathist.begin() + _maxerrorindex);
     _dmatHist.erase(_dmatHist.begin() + _maxerrorindex);
   }
-
   _totE.push_back(totE);
-  if (_opt.mode != KSmode::fractional) {
-    double gap =
-        MOs.eigenvalues()(_nocclevels) - MOs.eigenvalues()(_nocclevels - 1);
-    if ((_diiserror > _opt.levelshiftend && _opt.levelshift > 0.0) ||
-        gap < 1e-6) {
-      Levelshift(H, MOs.eigenvectors());
-    }
+}
+
+void ConvergenceAcc::LevelshiftIfRequired(Eigen::MatrixXd& H,
+                                          const tools::EigenSystem& MOs,
+                                          Index nocclevels) const {
+  if (nocclevels < 1 || nocclevels >= MOs.eigenvalues().size()) {
+    return;
   }
+  double gap =
+      MOs.eigenvalues()(nocclevels) - MOs.eigenvalues()(nocclevels - 1);
+  if ((_diiserror > _opt.levelshiftend && _opt.levelshift > 0.0) ||
+      gap < 1e-6) {
+    Levelshift(H, MOs.eigenvectors(), nocclevels);
+  }
+}
+
+Eigen::MatrixXd ConvergenceAcc::ErrorMatrix(const Eigen::MatrixXd& dmat,
+                                            const Eigen::MatrixXd& H) const {
   const Eigen::MatrixXd& S = _S->Matrix();
-  Eigen::MatrixXd errormatrix =
-      Sminusahalf.transpose() * (H * dmat * S - S * dmat * H) * Sminusahalf;
+  return Sminusahalf.transpose() * (H * dmat * S - S * dmat * H) * Sminusahalf;
+}
+
+Eigen::MatrixXd ConvergenceAcc::Extrapolate(const Eigen::MatrixXd& dmat,
+                                            const Eigen::MatrixXd& H,
+                                            const Eigen::MatrixXd& errormatrix,
+                                            bool& diis_error) {
+  Eigen::MatrixXd H_guess = Eigen::MatrixXd::Zero(H.rows(), H.cols());
   _diiserror = errormatrix.cwiseAbs().maxCoeff();
 
   _mathist.push_back(H);
@@ -71,7 +82,7 @@ Eigen::MatrixXd ConvergenceAcc::Iterate(const Eigen::MatrixXd& dmat,
   }
 
   _diis.Update(_maxerrorindex, errormatrix);
-  bool diis_error = false;
+  diis_error = false;
   XTP_LOG(Log::error, *_log)
       << TimeStamp() << " DIIs error " << getDIIsError() << std::flush;
 
@@ -113,21 +124,80 @@ Eigen::MatrixXd ConvergenceAcc::Iterate(const Eigen::MatrixXd& dmat,
   } else {
     H_guess = H;
   }
+  return H_guess;
+}
 
-  MOs = SolveFockmatrix(H_guess);
-  Eigen::MatrixXd dmatout = DensityMatrix(MOs);
-
+bool ConvergenceAcc::UseMixing(bool diis_error) {
   if (_diiserror > _opt.adiis_start || !_opt.usediis || diis_error ||
       _mathist.size() <= 2) {
     _usedmixing = true;
-    dmatout =
-        _opt.mixingparameter * dmat + (1.0 - _opt.mixingparameter) * dmatout;
     XTP_LOG(Log::warning, *_log)
         << TimeStamp() << " Using Mixing with alpha=" << _opt.mixingparameter
         << std::flush;
   } else {
     _usedmixing = false;
   }
+  return _usedmixing;
+}
+
+Eigen::MatrixXd ConvergenceAcc::Iterate(const Eigen::MatrixXd& dmat,
+                                        Eigen::MatrixXd& H,
+                                        tools::EigenSystem& MOs, double totE) {
+  UpdateEnergyHistory(totE);
+  if (_opt.mode != KSmode::fractional) {
+    LevelshiftIfRequired(H, MOs, _nocclevels);
+  }
+  bool diis_error = false;
+  Eigen::MatrixXd H_guess =
+      Extrapolate(dmat, H, ErrorMatrix(dmat, H), diis_error);
+
+  MOs = SolveFockmatrix(H_guess);
+  Eigen::MatrixXd dmatout = DensityMatrix(MOs);
+
+  if (UseMixing(diis_error)) {
+    dmatout =
+        _opt.mixingparameter * dmat + (1.0 - _opt.mixingparameter) * dmatout;
+  }
+  return dmatout;
+}
+
+std::array<Eigen::MatrixXd, 2> ConvergenceAcc::Iterate(
+    const std::array<Eigen::MatrixXd, 2>& dmat,
+    std::array<Eigen::MatrixXd, 2>& H, std::array<tools::EigenSystem, 2>& MOs,
+    double totE) {
+  if (_opt.mode != KSmode::open) {
+    throw std::runtime_error(
+        "Unrestricted iterations require the open KS mode");
+  }
+  const std::array<Index, 2> nocclevels = {_nocclevels, _nocclevels_beta};
+  UpdateEnergyHistory(totE);
+  for (Index spin = 0; spin < 2; spin++) {
+    LevelshiftIfRequired(H[spin], MOs[spin], nocclevels[spin]);
+  }
+
+  // both spins side by side in one history
+  const Index size = H[0].rows();
+  Eigen::MatrixXd dmat_spins(size, 2 * size);
+  dmat_spins << dmat[0], dmat[1];
+  Eigen::MatrixXd H_spins(size, 2 * size);
+  H_spins << H[0], H[1];
+  Eigen::MatrixXd error_spins(size, 2 * size);
+  error_spins << ErrorMatrix(dmat[0], H[0]), ErrorMatrix(dmat[1], H[1]);
+  bool diis_error = false;
+  Eigen::MatrixXd H_guess =
+      Extrapolate(dmat_spins, H_spins, error_spins, diis_error);
+  const bool mixing = UseMixing(diis_error);
+
+  std::array<Eigen::MatrixXd, 2> dmatout;
+  for (Index spin = 0; spin < 2; spin++) {
+    MOs[spin] = SolveFockmatrix(H_guess.middleCols(spin * size, size));
+    dmatout[spin] = DensityMatrixGroundState_unres(MOs[spin].eigenvectors(),
+                                                   nocclevels[spin]);
+    if (mixing) {
+      dmatout[spin] = _opt.mixingparameter * dmat[spin] +
+                      (1.0 - _opt.mixingparameter) * dmatout[spin];
+    }
+  }
   return dmatout;
 }
 
@@ -180,11 +250,17 @@ tools::EigenSystem ConvergenceAcc::SolveFockmatrix(
 
 void ConvergenceAcc::Levelshift(Eigen::MatrixXd& H,
                                 const Eigen::MatrixXd& MOs_old) const {
+  Levelshift(H, MOs_old, _nocclevels);
+}
+
+void ConvergenceAcc::Levelshift(Eigen::MatrixXd& H,
+                                const Eigen::MatrixXd& MOs_old,
+                                Index nocclevels) const {
   if (_opt.levelshift < 1e-9) {
     return;
   }
   Eigen::VectorXd virt = Eigen::VectorXd::Zero(H.rows());
-  for (Index i = _nocclevels; i < H.rows(); i++) {
+  for (Index i = nocclevels; i < H.rows(); i++) {
     virt(i) = _opt.levelshift;
   }
 
@@ -203,13 +279,20 @@ Eigen::MatrixXd ConvergenceAcc::DensityMatrix(
   if (_opt.mode == KSmode::closed) {
     result = DensityMatrixGroundState(MOs.eigenvectors());
   } else if (_opt.mode == KSmode::open) {
-    result = DensityMatrixGroundState_unres(MOs.eigenvectors());
+    result = DensityMatrixGroundState_unres(MOs.eigenvectors(), _nocclevels);
   } else if (_opt.mode == KSmode::fractional) {
     result = DensityMatrixGroundState_frac(MOs);
   }
   return result;
 }
 
+std::array<Eigen::MatrixXd, 2> ConvergenceAcc::DensityMatrix(
+    const std::array<tools::EigenSystem, 2>& MOs) const {
+  return {DensityMatrixGroundState_unres(MOs[0].eigenvectors(), _nocclevels),
+          DensityMatrixGroundState_unres(MOs[1].eigenvectors(),
+                                         _nocclevels_beta)};
+}
+
 Eigen::MatrixXd ConvergenceAcc::DensityMatrixGroundState(
     const Eigen::MatrixXd& MOs) const {
   const Eigen::MatrixXd occstates = MOs.leftCols(_nocclevels);
@@ -218,11 +301,11 @@ Eigen::MatrixXd ConvergenceAcc::DensityMatrixGroundState(
 }
 
 Eigen::MatrixXd ConvergenceAcc::DensityMatrixGroundState_unres(
-    const Eigen::MatrixXd& MOs) const {
-  if (_nocclevels == 0) {
+    const Eigen::MatrixXd& MOs, Index nocclevels) const {
+  if (nocclevels == 0) {
     return Eigen::MatrixXd::Zero(MOs.rows(), MOs.rows());
   }
-  Eigen::MatrixXd occstates = MOs.leftCols(_nocclevels);
+  Eigen::MatrixXd occstates = MOs.leftCols(nocclevels);
   Eigen::MatrixXd dmatGS = occstates * occstates.transpose();
   return dmatGS;
 }
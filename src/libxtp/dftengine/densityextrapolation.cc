@@ -0,0 +1,101 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Standard includes
+#include <algorithm>
+#include <stdexcept>
+
+// Local VOTCA includes
+#include "votca/xtp/densityextrapolation.h"
+
+namespace votca {
+namespace xtp {
+
+void DensityExtrapolation::setOrder(Index order) {
+  if (order < 0) {
+    throw std::runtime_error("Order of density extrapolation must be >=0");
+  }
+  _order = order;
+  while (size() > _order + 2) {
+    _history.pop_back();
+  }
+}
+
+void DensityExtrapolation::Push(const Eigen::MatrixXd& dmat,
+                                const std::string& fingerprint) {
+  // a different basis means a different molecule, old densities are useless
+  if (fingerprint != _fingerprint ||
+      (!_history.empty() && _history.front().rows() != dmat.rows())) {
+    _history.clear();
+    _fingerprint = fingerprint;
+  }
+  _history.push_front(dmat);
+  if (size() > _order + 2) {
+    _history.pop_back();
+  }
+}
+
+Eigen::VectorXd DensityExtrapolation::Coefficients(Index order) {
+  // B_j = (-1)^(j+1) j binom(2k+4,k+2-j)/binom(2k+2,k+1) for j=1..k+2
+  auto binomial = [](Index n, Index m) {
+    double result = 1.0;
+    for (Index i = 1; i <= m; i++) {
+      result *= double(n - m + i) / double(i);
+    }
+    return result;
+  };
+  const Index k = order;
+  Eigen::VectorXd coeffs = Eigen::VectorXd::Zero(k + 2);
+  const double norm = binomial(2 * k + 2, k + 1);
+  for (Index j = 1; j <= k + 2; j++) {
+    double sign = (j % 2 == 1) ? 1.0 : -1.0;
+    coeffs(j - 1) = sign * double(j) * binomial(2 * k + 4, k + 2 - j) / norm;
+  }
+  return coeffs;
+}
+
+Eigen::MatrixXd DensityExtrapolation::Extrapolate() const {
+  if (_history.empty()) {
+    throw std::runtime_error("No densities for extrapolation available");
+  }
+  if (size() == 1) {
+    return _history.front();
+  }
+  Index order = std::min(_order, size() - 2);
+  Eigen::VectorXd coeffs = Coefficients(order);
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(_history.front().rows(),
+                                                 _history.front().cols());
+  for (Index j = 0; j < coeffs.size(); j++) {
+    result += coeffs(j) * _history[j];
+  }
+  return result;
+}
+
+DensityExtrapolation DensityExtrapolation::Reference() const {
+  DensityExtrapolation reference;
+  reference._order = _order;
+  if (!_history.empty()) {
+    reference._history.push_back(_history.front());
+    reference._fingerprint = _fingerprint;
+  }
+  return reference;
+}
+
+}  // namespace xtp
+}  // namespace votca
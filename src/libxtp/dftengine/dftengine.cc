@@ -33,6 +33,10 @@
 #include "votca/xtp/aomatrix.h"
 #include "votca/xtp/aomatrix3d.h"
 #include "votca/xtp/aopotential.h"
+#include "votca/xtp/atomicguesscache.h"
+#include "votca/xtp/densityextrapolation.h"
+#include "votca/xtp/ecpmatrixcache.h"
+#include "votca/xtp/vxcgridcache.h"
 #include "votca/xtp/density_integration.h"
 #include "votca/xtp/dftengine.h"
 #include "votca/xtp/eeinteractor.h"
@@ -55,6 +59,10 @@ void DFTEngine::Initialize(Property& options) {
   string key = "package";
   const string key_xtpdft = "package.xtpdft";
   _dftbasis_name = options.get(key + ".basisset").as<string>();
+  _charge = options.ifExistsReturnElseReturnDefault<Index>(key + ".charge", 0);
+  _spin = options.ifExistsReturnElseReturnDefault<Index>(key + ".spin", 1);
+  _unrestricted = options.ifExistsReturnElseReturnDefault<bool>(
+      key_xtpdft + ".unrestricted", false);
 
   if (options.get(key + ".use_auxbasisset").as<bool>()) {
     _auxbasis_name = options.get(key + ".auxbasisset").as<string>();
@@ -67,6 +75,27 @@ void DFTEngine::Initialize(Property& options) {
     _with_screening = options.get(key_xtpdft + ".with_screening").as<bool>();
     _screening_eps = options.get(key_xtpdft + ".screening_eps").as<double>();
   }
+  _semidirect_max_memory = options.ifExistsReturnElseReturnDefault<double>(
+      key_xtpdft + ".semidirect_max_memory", 1024.0);
+
+  _incremental_fock = options.ifExistsReturnElseReturnDefault<bool>(
+      key_xtpdft + ".incremental_fock", false);
+  _incremental_fock_eps = options.ifExistsReturnElseReturnDefault<double>(
+      key_xtpdft + ".incremental_fock_eps", 1e-9);
+  _incremental_fock_rebuild = options.ifExistsReturnElseReturnDefault<Index>(
+      key_xtpdft + ".incremental_fock_rebuild", 10);
+  if (_incremental_fock_rebuild < 1) {
+    throw std::runtime_error("incremental_fock_rebuild has to be at least 1");
+  }
+
+  _threecenter_max_memory = options.ifExistsReturnElseReturnDefault<double>(
+      key_xtpdft + ".threecenter_max_memory", 0.0);
+  _threecenter_screening_eps = options.ifExistsReturnElseReturnDefault<double>(
+      key_xtpdft + ".threecenter_screening_eps", 1e-12);
+  _exchange_batch_memory = options.ifExistsReturnElseReturnDefault<double>(
+      key_xtpdft + ".exchange_batch_memory", 256.0);
+  _scratch_dir =
+      options.ifExistsReturnElseReturnDefault<string>(key + ".scratch", ".");
 
   if (options.get(key + ".use_ecp").as<bool>()) {
     _ecp_name = options.get(key + ".ecp").as<string>();
@@ -76,6 +105,24 @@ void DFTEngine::Initialize(Property& options) {
   }
   _with_guess = options.get(key + ".read_guess").as<bool>();
   _initial_guess = options.get(key_xtpdft + ".initial_guess").as<string>();
+  _atomic_guess_file = options.ifExistsReturnElseReturnDefault<string>(
+      key_xtpdft + ".atomic_guess_file", "");
+
+  _reuse_grid = options.ifExistsReturnElseReturnDefault<bool>(
+      key_xtpdft + ".reuse_grid", false);
+  _reuse_ecp = options.ifExistsReturnElseReturnDefault<bool>(
+      key_xtpdft + ".reuse_ecp", false);
+  _ao_cache_memory = options.ifExistsReturnElseReturnDefault<double>(
+      key_xtpdft + ".ao_cache_memory", 0.0);
+  _ao_cache_single = options.ifExistsReturnElseReturnDefault<bool>(
+      key_xtpdft + ".ao_cache_single_precision", false);
+  _external_multipole_tolerance =
+      options.ifExistsReturnElseReturnDefault<double>(
+          key_xtpdft + ".external_multipole_tolerance", 0.0);
+  _external_multipole_density_threshold =
+      options.ifExistsReturnElseReturnDefault<double>(
+          key_xtpdft + ".external_multipole_density_threshold",
+          _external_multipole_density_threshold);
 
   _grid_name = options.get(key_xtpdft + ".integration_grid").as<string>();
   _xc_functional_name = options.get(key + ".functional").as<string>();
@@ -132,13 +179,15 @@ void DFTEngine::Initialize(Property& options) {
   return;
 }
 
-void DFTEngine::PrintMOs(const Eigen::VectorXd& MOEnergies, Log::Level level) {
+void DFTEngine::PrintMOs(const Eigen::VectorXd& MOEnergies,
+                         Index occupied_levels, Index occupation,
+                         Log::Level level) {
   XTP_LOG(level, *_pLog) << "  Orbital energies: " << flush;
   XTP_LOG(level, *_pLog) << "  index occupation energy(Hartree) " << flush;
   for (Index i = 0; i < MOEnergies.size(); i++) {
     Index occupancy = 0;
-    if (i < _numofelectrons / 2) {
-      occupancy = 2;
+    if (i < occupied_levels) {
+      occupancy = occupation;
     }
     XTP_LOG(level, *_pLog) << (boost::format(" %1$5d      %2$1d   %3$+1.10f") %
                                i % occupancy % MOEnergies(i))
@@ -167,6 +216,8 @@ Mat_p_Energy DFTEngine::CalcEXXs(const Eigen::MatrixXd& MOCoeff,
           MOCoeff.block(0, 0, MOCoeff.rows(), _numofelectrons / 2);
       return _ERIs.CalculateEXX(occblock, Dmat);
     }
+  } else if (_four_center_method == "semidirect") {
+    return _ERIs.CalculateERIs_EXX_4c_semidirect(_dftbasis, Dmat, true).second;
   } else {
     if (_four_center_method == "direct") {
       throw std::runtime_error(
@@ -176,6 +227,35 @@ Mat_p_Energy DFTEngine::CalcEXXs(const Eigen::MatrixXd& MOCoeff,
   }
 }
 
+Eigen::MatrixXd DFTEngine::CalcEXXs_spin(
+    const Eigen::MatrixXd& MOCoeff, Index nocc,
+    const Eigen::MatrixXd& Dmat_spin) const {
+  if (nocc == 0) {
+    return Eigen::MatrixXd::Zero(Dmat_spin.rows(), Dmat_spin.cols());
+  }
+  if (_four_center_method == "RI" && !_conv_accelerator.getUseMixing() &&
+      MOCoeff.rows() > 0) {
+    // the RI exchange expects doubly occupied levels
+    return _ERIs
+        .CalculateEXX(std::sqrt(0.5) * MOCoeff.leftCols(nocc), Dmat_spin)
+        .matrix();
+  }
+  return CalcEXXs(Eigen::MatrixXd::Zero(0, 0), Dmat_spin).matrix();
+}
+
+// semidirect builds J and K of the density change together in the SCF loop
+Eigen::MatrixXd DFTEngine::CalcEXXs_diff(const Eigen::MatrixXd& dDMAT) const {
+  if (_four_center_method == "RI") {
+    return _ERIs.CalculateEXX_diff(dDMAT, _incremental_fock_eps);
+  } else {
+    if (_four_center_method == "direct") {
+      throw std::runtime_error(
+          "direct 4c method only works with LDA and GGA functionals.");
+    }
+    return _ERIs.CalculateEXX_4c_small_molecule(dDMAT).matrix();
+  }
+}
+
 tools::EigenSystem DFTEngine::IndependentElectronGuess(
     const Mat_p_Energy& H0) const {
   return _conv_accelerator.SolveFockmatrix(H0.matrix());
@@ -184,7 +264,12 @@ tools::EigenSystem DFTEngine::IndependentElectronGuess(
 tools::EigenSystem DFTEngine::ModelPotentialGuess(
     const Mat_p_Energy& H0, const QMMolecule& mol,
     const Vxc_Potential<Vxc_Grid>& vxcpotential) const {
-  Eigen::MatrixXd Dmat = AtomicGuess(mol);
+  return DensityGuess(H0, AtomicGuess(mol), vxcpotential);
+}
+
+tools::EigenSystem DFTEngine::DensityGuess(
+    const Mat_p_Energy& H0, const Eigen::MatrixXd& Dmat,
+    const Vxc_Potential<Vxc_Grid>& vxcpotential) const {
   Mat_p_Energy ERIs = CalculateERIs(Dmat);
   Mat_p_Energy e_vxc = vxcpotential.IntegrateVXC(Dmat);
   XTP_LOG(Log::info, *_pLog)
@@ -212,6 +297,12 @@ bool DFTEngine::Evaluate(Orbitals& orb) {
         << TimeStamp() << " Reading guess from orbitals object/file" << flush;
     MOs = orb.MOs();
     MOs.eigenvectors() = OrthogonalizeGuess(MOs.eigenvectors());
+  } else if (_density_history != nullptr &&
+             _density_history->hasGuess(BasisFingerprint(orb.QMAtoms()))) {
+    XTP_LOG(Log::error, *_pLog)
+        << TimeStamp() << " Extrapolating initial guess from "
+        << _density_history->size() << " previous densities" << flush;
+    MOs = DensityGuess(H0, _density_history->Extrapolate(), vxcpotential);
   } else {
     XTP_LOG(Log::error, *_pLog)
         << TimeStamp() << " Setup Initial Guess using: " << _initial_guess
@@ -225,6 +316,17 @@ bool DFTEngine::Evaluate(Orbitals& orb) {
     }
   }
 
+  if (_unrestricted) {
+    // restricted guesses start both spins from the same orbitals
+    std::array<tools::EigenSystem, 2> MOs_spin = {MOs, MOs};
+    if (_with_guess && orb.hasBetaMOs()) {
+      MOs_spin[1] = orb.MOs_beta();
+      MOs_spin[1].eigenvectors() =
+          OrthogonalizeGuess(MOs_spin[1].eigenvectors());
+    }
+    return EvaluateUnrestricted(orb, H0, vxcpotential, MOs_spin);
+  }
+
   Eigen::MatrixXd Dmat = _conv_accelerator.DensityMatrix(MOs);
   XTP_LOG(Log::info, *_pLog)
       << TimeStamp() << " Guess Matrix gives N=" << std::setprecision(9)
@@ -237,6 +339,18 @@ bool DFTEngine::Evaluate(Orbitals& orb) {
          "----------------------------"
       << flush;
 
+  if (_incremental_fock) {
+    XTP_LOG(Log::info, *_pLog)
+        << TimeStamp() << " Using incremental Fock build with eps="
+        << _incremental_fock_eps << " and full rebuild every "
+        << _incremental_fock_rebuild << " iterations" << flush;
+  }
+  // Coulomb and exchange matrices of the previous iteration, updated with the
+  // density difference in incremental mode
+  Eigen::MatrixXd Dmat_prev;
+  Eigen::MatrixXd J;
+  Eigen::MatrixXd K;
+
   for (Index this_iter = 0; this_iter < _max_iter; this_iter++) {
     XTP_LOG(Log::error, *_pLog) << flush;
     XTP_LOG(Log::error, *_pLog) << TimeStamp() << " Iteration " << this_iter + 1
@@ -246,18 +360,49 @@ bool DFTEngine::Evaluate(Orbitals& orb) {
     XTP_LOG(Log::info, *_pLog)
         << TimeStamp() << " Filled DFT Vxc matrix " << flush;
 
-    Mat_p_Energy ERIs = CalculateERIs(Dmat);
-    Eigen::MatrixXd H = H0.matrix() + ERIs.matrix() + e_vxc.matrix();
+    const bool full_build =
+        !_incremental_fock || (this_iter % _incremental_fock_rebuild == 0);
+    Eigen::MatrixXd dDmat;
+    if (!full_build) {
+      dDmat = Dmat - Dmat_prev;
+      XTP_LOG(Log::info, *_pLog)
+          << TimeStamp() << " Incremental Fock build, max density change "
+          << dDmat.cwiseAbs().maxCoeff() << flush;
+    }
+    // the semidirect engine builds J and K in one pass over the integrals
+    const bool joint_JK = (_four_center_method == "semidirect");
+    if (joint_JK) {
+      std::pair<Mat_p_Energy, Mat_p_Energy> JK =
+          _ERIs.CalculateERIs_EXX_4c_semidirect(
+              _dftbasis, full_build ? Dmat : dDmat, _ScaHFX > 0);
+      if (full_build) {
+        J = JK.first.matrix();
+        K = JK.second.matrix();
+      } else {
+        J += JK.first.matrix();
+        K += JK.second.matrix();
+      }
+    } else if (full_build) {
+      J = CalculateERIs(Dmat).matrix();
+    } else {
+      J += CalculateERIs_diff(dDmat);
+    }
+    Eigen::MatrixXd H = H0.matrix() + J + e_vxc.matrix();
     double Eone = Dmat.cwiseProduct(H0.matrix()).sum();
-    double Etwo = 0.5 * ERIs.energy() + e_vxc.energy();
+    double Etwo = 0.5 * Dmat.cwiseProduct(J).sum() + e_vxc.energy();
     double exx = 0.0;
     if (_ScaHFX > 0) {
-      Mat_p_Energy EXXs = CalcEXXs(MOs.eigenvectors(), Dmat);
+      if (!joint_JK && full_build) {
+        K = CalcEXXs(MOs.eigenvectors(), Dmat).matrix();
+      } else if (!joint_JK) {
+        K += CalcEXXs_diff(dDmat);
+      }
       XTP_LOG(Log::info, *_pLog)
           << TimeStamp() << " Filled DFT Electron exchange matrix" << flush;
-      H -= 0.5 * _ScaHFX * EXXs.matrix();
-      exx = -_ScaHFX / 4 * EXXs.energy();
+      H -= 0.5 * _ScaHFX * K;
+      exx = -_ScaHFX / 4 * Dmat.cwiseProduct(K).sum();
     }
+    Dmat_prev = Dmat;
     Etwo += exx;
     double totenergy = Eone + H0.energy() + Etwo;
     XTP_LOG(Log::info, *_pLog) << TimeStamp() << " Single particle energy "
@@ -277,7 +422,7 @@ bool DFTEngine::Evaluate(Orbitals& orb) {
 
     Dmat = _conv_accelerator.Iterate(Dmat, H, MOs, totenergy);
 
-    PrintMOs(MOs.eigenvalues(), Log::info);
+    PrintMOs(MOs.eigenvalues(), _numofelectrons / 2, 2, Log::info);
 
     XTP_LOG(Log::info, *_pLog) << "\t\tGAP "
                                << MOs.eigenvalues()(_numofelectrons / 2) -
@@ -313,9 +458,172 @@ bool DFTEngine::Evaluate(Orbitals& orb) {
           << totenergy - e_vxc.energy() + (1.0 - _ScaHFX) * exx << " Ha"
           << flush;
 
-      PrintMOs(MOs.eigenvalues(), Log::error);
+      PrintMOs(MOs.eigenvalues(), _numofelectrons / 2, 2, Log::error);
       orb.setQMEnergy(totenergy);
       orb.MOs() = MOs;
+      orb.MOs_beta() = tools::EigenSystem();
+      if (_density_history != nullptr) {
+        _density_history->Push(Dmat, BasisFingerprint(orb.QMAtoms()));
+      }
+      CalcElDipole(orb);
+      break;
+    } else if (this_iter == _max_iter - 1) {
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp() << " DFT calculation has not converged after "
+          << _max_iter
+          << " iterations. Use more iterations or another convergence "
+             "acceleration scheme."
+          << std::flush;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DFTEngine::EvaluateUnrestricted(
+    Orbitals& orb, const Mat_p_Energy& H0,
+    const Vxc_Potential<Vxc_Grid>& vxcpotential,
+    std::array<tools::EigenSystem, 2> MOs) {
+  const std::array<Index, 2> nocc = {_numofalpha, _numofbeta};
+  std::array<Eigen::MatrixXd, 2> Dmat = _conv_accelerator.DensityMatrix(MOs);
+  XTP_LOG(Log::info, *_pLog)
+      << TimeStamp() << " Guess Matrix gives N_alpha=" << std::setprecision(9)
+      << Dmat[0].cwiseProduct(_dftAOoverlap.Matrix()).sum()
+      << " N_beta=" << Dmat[1].cwiseProduct(_dftAOoverlap.Matrix()).sum()
+      << " electrons." << flush;
+
+  XTP_LOG(Log::error, *_pLog)
+      << TimeStamp() << " STARTING unrestricted SCF cycle" << flush;
+  XTP_LOG(Log::error, *_pLog)
+      << " ----------------------------------------------"
+         "----------------------------"
+      << flush;
+  if (_incremental_fock) {
+    XTP_LOG(Log::info, *_pLog)
+        << TimeStamp()
+        << " Incremental Fock build is not used for unrestricted calculations"
+        << flush;
+  }
+
+  for (Index this_iter = 0; this_iter < _max_iter; this_iter++) {
+    XTP_LOG(Log::error, *_pLog) << flush;
+    XTP_LOG(Log::error, *_pLog) << TimeStamp() << " Iteration " << this_iter + 1
+                                << " of " << _max_iter << flush;
+
+    std::array<Mat_p_Energy, 2> e_vxc =
+        vxcpotential.IntegrateVXC(Dmat[0], Dmat[1]);
+    const double E_xc = e_vxc[0].energy() + e_vxc[1].energy();
+    XTP_LOG(Log::info, *_pLog)
+        << TimeStamp() << " Filled DFT Vxc matrices " << flush;
+
+    // Coulomb from the total, exchange from the density of each spin
+    const Eigen::MatrixXd Dmat_total = Dmat[0] + Dmat[1];
+    Eigen::MatrixXd J;
+    std::array<Eigen::MatrixXd, 2> K;
+    if (_four_center_method == "semidirect" && _ScaHFX > 0) {
+      std::array<Eigen::MatrixXd, 3> JK =
+          _ERIs.CalculateERIs_EXX_4c_semidirect(_dftbasis, Dmat[0], Dmat[1]);
+      J = std::move(JK[0]);
+      K[0] = std::move(JK[1]);
+      K[1] = std::move(JK[2]);
+    } else {
+      J = CalculateERIs(Dmat_total).matrix();
+      if (_ScaHFX > 0) {
+        for (Index spin = 0; spin < 2; spin++) {
+          K[spin] = CalcEXXs_spin(MOs[spin].eigenvectors(), nocc[spin],
+                                  Dmat[spin]);
+        }
+      }
+    }
+
+    std::array<Eigen::MatrixXd, 2> H;
+    double exx = 0.0;
+    for (Index spin = 0; spin < 2; spin++) {
+      H[spin] = H0.matrix() + J + e_vxc[spin].matrix();
+      if (_ScaHFX > 0) {
+        H[spin] -= _ScaHFX * K[spin];
+        exx -= 0.5 * _ScaHFX * Dmat[spin].cwiseProduct(K[spin]).sum();
+      }
+    }
+    if (_ScaHFX > 0) {
+      XTP_LOG(Log::info, *_pLog)
+          << TimeStamp() << " Filled DFT Electron exchange matrices" << flush;
+    }
+    double Eone = Dmat_total.cwiseProduct(H0.matrix()).sum();
+    double Etwo = 0.5 * Dmat_total.cwiseProduct(J).sum() + E_xc + exx;
+    double totenergy = Eone + H0.energy() + Etwo;
+    XTP_LOG(Log::info, *_pLog) << TimeStamp() << " Single particle energy "
+                               << std::setprecision(12) << Eone << flush;
+    XTP_LOG(Log::info, *_pLog) << TimeStamp() << " Two particle energy "
+                               << std::setprecision(12) << Etwo << flush;
+    XTP_LOG(Log::info, *_pLog) << TimeStamp() << std::setprecision(12)
+                               << " Local Exc contribution " << E_xc << flush;
+    if (_ScaHFX > 0) {
+      XTP_LOG(Log::info, *_pLog)
+          << TimeStamp() << std::setprecision(12)
+          << " Non local Ex contribution " << exx << flush;
+    }
+    XTP_LOG(Log::error, *_pLog) << TimeStamp() << " Total Energy "
+                                << std::setprecision(12) << totenergy << flush;
+
+    Dmat = _conv_accelerator.Iterate(Dmat, H, MOs, totenergy);
+
+    const std::array<std::string, 2> spinname = {"alpha", "beta"};
+    for (Index spin = 0; spin < 2; spin++) {
+      XTP_LOG(Log::info, *_pLog) << "  Spin " << spinname[spin] << flush;
+      PrintMOs(MOs[spin].eigenvalues(), nocc[spin], 1, Log::info);
+      if (nocc[spin] > 0) {
+        XTP_LOG(Log::info, *_pLog)
+            << "\t\tGAP " << spinname[spin] << " "
+            << MOs[spin].eigenvalues()(nocc[spin]) -
+                   MOs[spin].eigenvalues()(nocc[spin] - 1)
+            << flush;
+      }
+    }
+
+    if (_conv_accelerator.isConverged()) {
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp() << " Total Energy has converged to "
+          << std::setprecision(9) << _conv_accelerator.getDeltaE()
+          << "[Ha] after " << this_iter + 1
+          << " iterations. DIIS error is converged up to "
+          << _conv_accelerator.getDIIsError() << flush;
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp() << " Final Single Point Energy "
+          << std::setprecision(12) << totenergy << " Ha" << flush;
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp() << std::setprecision(12)
+          << " Final Local Exc contribution " << E_xc << " Ha" << flush;
+      if (_ScaHFX > 0) {
+        XTP_LOG(Log::error, *_pLog)
+            << TimeStamp() << std::setprecision(12)
+            << " Final Non Local Ex contribution " << exx << " Ha" << flush;
+      }
+
+      double exx_full = 0.0;
+      for (Index spin = 0; spin < 2; spin++) {
+        Eigen::MatrixXd K_full =
+            CalcEXXs_spin(MOs[spin].eigenvectors(), nocc[spin], Dmat[spin]);
+        exx_full -= 0.5 * Dmat[spin].cwiseProduct(K_full).sum();
+      }
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp() << std::setprecision(12) << " EXX energy " << exx_full
+          << " Ha" << flush;
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp() << std::setprecision(12) << " Final EXX Total energy "
+          << totenergy - E_xc + (1.0 - _ScaHFX) * exx_full << " Ha" << flush;
+
+      for (Index spin = 0; spin < 2; spin++) {
+        XTP_LOG(Log::error, *_pLog) << "  Spin " << spinname[spin] << flush;
+        PrintMOs(MOs[spin].eigenvalues(), nocc[spin], 1, Log::error);
+      }
+      orb.setQMEnergy(totenergy);
+      orb.MOs() = MOs[0];
+      orb.MOs_beta() = MOs[1];
+      if (_density_history != nullptr) {
+        _density_history->Push(Dmat[0] + Dmat[1],
+                               BasisFingerprint(orb.QMAtoms()));
+      }
       CalcElDipole(orb);
       break;
     } else if (this_iter == _max_iter - 1) {
@@ -353,11 +661,22 @@ Mat_p_Energy DFTEngine::SetupH0(const QMMolecule& mol) const {
                               << std::setprecision(9) << E0 << flush;
 
   if (_with_ecp) {
-    AOECP dftAOECP;
-    dftAOECP.FillPotential(_dftbasis, _ecp);
-    H0 += dftAOECP.Matrix();
-    XTP_LOG(Log::info, *_pLog)
-        << TimeStamp() << " Filled DFT ECP matrix" << flush;
+    Eigen::MatrixXd ecpmatrix;
+    if (_reuse_ecp &&
+        ECPMatrixCache::Instance().Find(_dftbasis, _ecp, ecpmatrix)) {
+      XTP_LOG(Log::info, *_pLog)
+          << TimeStamp() << " Reused DFT ECP matrix" << flush;
+    } else {
+      AOECP dftAOECP;
+      dftAOECP.FillPotential(_dftbasis, _ecp);
+      ecpmatrix = dftAOECP.Matrix();
+      if (_reuse_ecp) {
+        ECPMatrixCache::Instance().Add(_dftbasis, _ecp, ecpmatrix);
+      }
+      XTP_LOG(Log::info, *_pLog)
+          << TimeStamp() << " Filled DFT ECP matrix" << flush;
+    }
+    H0 += ecpmatrix;
   }
 
   if (_addexternalsites) {
@@ -431,7 +750,13 @@ void DFTEngine::SetupInvariantMatrices() {
   XTP_LOG(Log::info, *_pLog)
       << TimeStamp() << " Filled DFT Overlap matrix." << flush;
 
-  _conv_opt.numberofelectrons = _numofelectrons;
+  if (_unrestricted) {
+    _conv_opt.mode = ConvergenceAcc::KSmode::open;
+    _conv_opt.numberofelectrons = _numofalpha;
+    _conv_opt.numberofelectrons_beta = _numofbeta;
+  } else {
+    _conv_opt.numberofelectrons = _numofelectrons;
+  }
   _conv_accelerator.Configure(_conv_opt);
   _conv_accelerator.setLogger(_pLog);
   _conv_accelerator.setOverlap(_dftAOoverlap, 1e-8);
@@ -439,10 +764,18 @@ void DFTEngine::SetupInvariantMatrices() {
 
   if (_four_center_method == "RI") {
     // prepare invariant part of electron repulsion integrals
-    _ERIs.Initialize(_dftbasis, _auxbasis);
+    _ERIs.Initialize(_dftbasis, _auxbasis, _threecenter_max_memory,
+                     _scratch_dir, _threecenter_screening_eps);
+    _ERIs.setExchangeBatchMemory(_exchange_batch_memory);
     XTP_LOG(Log::info, *_pLog)
         << TimeStamp() << " Inverted AUX Coulomb matrix, removed "
         << _ERIs.Removedfunctions() << " functions from aux basis" << flush;
+    if (!_ERIs.ThreeCenterInCore()) {
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp()
+          << " Three-center integrals exceed the memory limit, stored in "
+          << _scratch_dir << flush;
+    }
     XTP_LOG(Log::error, *_pLog)
         << TimeStamp()
         << " Setup invariant parts of Electron Repulsion integrals " << flush;
@@ -457,6 +790,16 @@ void DFTEngine::SetupInvariantMatrices() {
           << TimeStamp() << " Calculated 4c integrals. " << flush;
     }
 
+    if (_four_center_method == "semidirect") {
+      XTP_LOG(Log::info, *_pLog)
+          << TimeStamp() << " Setting up semidirect 4c integrals. " << flush;
+      _ERIs.Initialize_4c_semidirect(_dftbasis, _screening_eps,
+                                     _semidirect_max_memory);
+      XTP_LOG(Log::info, *_pLog)
+          << TimeStamp() << " Cached " << _ERIs.CachedQuartets()
+          << " shell quartets. " << flush;
+    }
+
     if (_with_screening && _four_center_method == "direct") {
       XTP_LOG(Log::info, *_pLog)
           << TimeStamp() << " Calculating 4c diagonals. " << flush;
@@ -521,28 +864,23 @@ Eigen::MatrixXd DFTEngine::RunAtomicDFT_unrestricted(
   dftAOESP.FillPotential(dftbasis, atom);
   ERIs_atom.Initialize_4c_small_molecule(dftbasis);
 
-  ConvergenceAcc Convergence_alpha;
-  ConvergenceAcc Convergence_beta;
-  ConvergenceAcc::options opt_alpha = _conv_opt;
-  opt_alpha.mode = ConvergenceAcc::KSmode::open;
-  opt_alpha.histlength = 20;
-  opt_alpha.levelshift = 0.1;
-  opt_alpha.levelshiftend = 0.0;
-  opt_alpha.usediis = true;
-  opt_alpha.adiis_start = 0.0;
-  opt_alpha.diis_start = 0.0;
-  opt_alpha.numberofelectrons = alpha_e;
-
-  ConvergenceAcc::options opt_beta = opt_alpha;
-  opt_beta.numberofelectrons = beta_e;
+  // both spins share one DIIS history
+  ConvergenceAcc Convergence;
+  ConvergenceAcc::options opt = _conv_opt;
+  opt.mode = ConvergenceAcc::KSmode::open;
+  opt.histlength = 20;
+  opt.levelshift = 0.1;
+  opt.levelshiftend = 0.0;
+  opt.usediis = true;
+  opt.adiis_start = 0.0;
+  opt.diis_start = 0.0;
+  opt.numberofelectrons = alpha_e;
+  opt.numberofelectrons_beta = beta_e;
 
   Logger log;
-  Convergence_alpha.Configure(opt_alpha);
-  Convergence_alpha.setLogger(&log);
-  Convergence_alpha.setOverlap(dftAOoverlap, 1e-8);
-  Convergence_beta.Configure(opt_beta);
-  Convergence_beta.setLogger(&log);
-  Convergence_beta.setOverlap(dftAOoverlap, 1e-8);
+  Convergence.Configure(opt);
+  Convergence.setLogger(&log);
+  Convergence.setOverlap(dftAOoverlap, 1e-8);
   /**** Construct initial density  ****/
 
   Eigen::MatrixXd H0 = dftAOkinetic.Matrix() + dftAOESP.Matrix();
@@ -550,77 +888,50 @@ Eigen::MatrixXd DFTEngine::RunAtomicDFT_unrestricted(
     dftAOECP.FillPotential(dftbasis, ecp);
     H0 += dftAOECP.Matrix();
   }
-  tools::EigenSystem MOs_alpha = Convergence_alpha.SolveFockmatrix(H0);
-
-  Eigen::MatrixXd dftAOdmat_alpha = Convergence_alpha.DensityMatrix(MOs_alpha);
+  tools::EigenSystem MOs_guess = Convergence.SolveFockmatrix(H0);
+  std::array<tools::EigenSystem, 2> MOs = {MOs_guess, MOs_guess};
+  std::array<Eigen::MatrixXd, 2> dftAOdmat = Convergence.DensityMatrix(MOs);
   if (uniqueAtom.getElement() == "H") {
-    return dftAOdmat_alpha;
+    return dftAOdmat[0];
   }
-  tools::EigenSystem MOs_beta = Convergence_beta.SolveFockmatrix(H0);
-  Eigen::MatrixXd dftAOdmat_beta = Convergence_beta.DensityMatrix(MOs_beta);
 
   Index maxiter = 80;
   for (Index this_iter = 0; this_iter < maxiter; this_iter++) {
-    Mat_p_Energy ERIs = ERIs_atom.CalculateERIs_4c_small_molecule(
-        dftAOdmat_alpha + dftAOdmat_beta);
-    double E_two_alpha = ERIs.matrix().cwiseProduct(dftAOdmat_alpha).sum();
-    double E_two_beta = ERIs.matrix().cwiseProduct(dftAOdmat_beta).sum();
-    Eigen::MatrixXd H_alpha = H0 + ERIs.matrix();
-    Eigen::MatrixXd H_beta = H0 + ERIs.matrix();
-
-    Mat_p_Energy e_vxc = gridIntegration.IntegrateVXC(dftAOdmat_alpha);
-    Eigen::MatrixXd AOVxc_alpha = e_vxc.matrix();
-    double E_vxc_alpha = e_vxc.energy();
-    H_alpha += AOVxc_alpha;
-    E_two_alpha += E_vxc_alpha;
-
-    e_vxc = gridIntegration.IntegrateVXC(dftAOdmat_beta);
-    Eigen::MatrixXd AOVxc_beta = e_vxc.matrix();
-    double E_vxc_beta = e_vxc.energy();
-    H_beta += AOVxc_beta;
-    E_two_beta += E_vxc_beta;
-
-    if (_ScaHFX > 0) {
-      Mat_p_Energy EXXs =
-          ERIs_atom.CalculateEXX_4c_small_molecule(dftAOdmat_alpha);
-      double E_exx_alpha =
-          -0.5 * _ScaHFX * EXXs.matrix().cwiseProduct(dftAOdmat_alpha).sum();
-      H_alpha -= _ScaHFX * EXXs.matrix();
-      E_two_alpha += E_exx_alpha;
-      ERIs_atom.CalculateEXX_4c_small_molecule(dftAOdmat_beta);
-      double E_exx_beta =
-          -0.5 * _ScaHFX * EXXs.matrix().cwiseProduct(dftAOdmat_beta).sum();
-      H_beta -= _ScaHFX * EXXs.matrix();
-      E_two_beta += E_exx_beta;
+    const Eigen::MatrixXd dmat_total = dftAOdmat[0] + dftAOdmat[1];
+    Mat_p_Energy ERIs = ERIs_atom.CalculateERIs_4c_small_molecule(dmat_total);
+    std::array<Mat_p_Energy, 2> e_vxc =
+        gridIntegration.IntegrateVXC(dftAOdmat[0], dftAOdmat[1]);
+
+    double totenergy = dmat_total.cwiseProduct(H0).sum() +
+                       0.5 * dmat_total.cwiseProduct(ERIs.matrix()).sum() +
+                       e_vxc[0].energy() + e_vxc[1].energy();
+    std::array<Eigen::MatrixXd, 2> H;
+    for (Index spin = 0; spin < 2; spin++) {
+      H[spin] = H0 + ERIs.matrix() + e_vxc[spin].matrix();
+      if (_ScaHFX > 0) {
+        Mat_p_Energy EXXs =
+            ERIs_atom.CalculateEXX_4c_small_molecule(dftAOdmat[spin]);
+        H[spin] -= _ScaHFX * EXXs.matrix();
+        totenergy -=
+            0.5 * _ScaHFX * EXXs.matrix().cwiseProduct(dftAOdmat[spin]).sum();
+      }
     }
 
-    double E_one_alpha = dftAOdmat_alpha.cwiseProduct(H0).sum();
-    double E_one_beta = dftAOdmat_beta.cwiseProduct(H0).sum();
-    double E_alpha = E_one_alpha + E_two_alpha;
-    double E_beta = E_one_beta + E_two_beta;
-    double totenergy = E_alpha + E_beta;
-    // evolve alpha
-    dftAOdmat_alpha =
-        Convergence_alpha.Iterate(dftAOdmat_alpha, H_alpha, MOs_alpha, E_alpha);
-    // evolve beta
-    dftAOdmat_beta =
-        Convergence_beta.Iterate(dftAOdmat_beta, H_beta, MOs_beta, E_beta);
+    dftAOdmat = Convergence.Iterate(dftAOdmat, H, MOs, totenergy);
 
     XTP_LOG(Log::debug, *_pLog)
         << TimeStamp() << " Iter " << this_iter << " of " << maxiter << " Etot "
-        << totenergy << " diise_a " << Convergence_alpha.getDIIsError()
-        << " diise_b " << Convergence_beta.getDIIsError() << "\n\t\t a_gap "
-        << MOs_alpha.eigenvalues()(alpha_e) -
-               MOs_alpha.eigenvalues()(alpha_e - 1)
+        << totenergy << " diise " << Convergence.getDIIsError()
+        << "\n\t\t a_gap "
+        << MOs[0].eigenvalues()(alpha_e) - MOs[0].eigenvalues()(alpha_e - 1)
         << " b_gap "
-        << MOs_beta.eigenvalues()(beta_e) - MOs_beta.eigenvalues()(beta_e - 1)
+        << MOs[1].eigenvalues()(beta_e) - MOs[1].eigenvalues()(beta_e - 1)
         << " Nalpha="
-        << dftAOoverlap.Matrix().cwiseProduct(dftAOdmat_alpha).sum()
-        << " Nbeta=" << dftAOoverlap.Matrix().cwiseProduct(dftAOdmat_beta).sum()
+        << dftAOoverlap.Matrix().cwiseProduct(dftAOdmat[0]).sum()
+        << " Nbeta=" << dftAOoverlap.Matrix().cwiseProduct(dftAOdmat[1]).sum()
         << flush;
 
-    bool converged =
-        Convergence_alpha.isConverged() && Convergence_beta.isConverged();
+    bool converged = Convergence.isConverged();
     if (converged || this_iter == maxiter - 1) {
 
       if (converged) {
@@ -630,14 +941,13 @@ Eigen::MatrixXd DFTEngine::RunAtomicDFT_unrestricted(
         XTP_LOG(Log::info, *_pLog)
             << TimeStamp() << " Not converged after " << this_iter + 1
             << " iterations. Unconverged density.\n\t\t\t"
-            << " DIIsError_alpha=" << Convergence_alpha.getDIIsError()
-            << " DIIsError_beta=" << Convergence_beta.getDIIsError() << flush;
+            << " DIIsError=" << Convergence.getDIIsError() << flush;
       }
       break;
     }
   }
   Eigen::MatrixXd avgmatrix =
-      SphericalAverageShells(dftAOdmat_alpha + dftAOdmat_beta, dftbasis);
+      SphericalAverageShells(dftAOdmat[0] + dftAOdmat[1], dftbasis);
   XTP_LOG(Log::info, *_pLog)
       << TimeStamp() << " Atomic density Matrix for " << uniqueAtom.getElement()
       << " gives N=" << std::setprecision(9)
@@ -646,6 +956,15 @@ Eigen::MatrixXd DFTEngine::RunAtomicDFT_unrestricted(
   return avgmatrix;
 }
 
+std::string DFTEngine::BasisFingerprint(const QMMolecule& mol) const {
+  std::string fingerprint =
+      _dftbasis_name + ":" + std::to_string(_dftbasis.AOBasisSize());
+  for (const QMAtom& atom : mol) {
+    fingerprint += ":" + atom.getElement();
+  }
+  return fingerprint;
+}
+
 Eigen::MatrixXd DFTEngine::AtomicGuess(const QMMolecule& mol) const {
 
   std::vector<std::string> elements = mol.FindUniqueElements();
@@ -659,11 +978,37 @@ Eigen::MatrixXd DFTEngine::AtomicGuess(const QMMolecule& mol) const {
   XTP_LOG(Log::info, *_pLog) << TimeStamp() << " " << uniqueelements.size()
                              << " unique elements found" << flush;
   std::vector<Eigen::MatrixXd> uniqueatom_guesses;
+  AtomicGuessCache& cache = AtomicGuessCache::Instance();
   for (QMAtom& unique_atom : uniqueelements) {
-    XTP_LOG(Log::error, *_pLog)
-        << TimeStamp() << " Calculating atom density for "
-        << unique_atom.getElement() << flush;
-    Eigen::MatrixXd dmat_unrestricted = RunAtomicDFT_unrestricted(unique_atom);
+    const std::string key = AtomicGuessCache::MakeKey(
+        unique_atom.getElement(), _dftbasis_name, _auxbasis_name,
+        _with_ecp ? _ecp_name : "", _xc_functional_name, _grid_name);
+    Eigen::MatrixXd dmat_unrestricted;
+    bool found = false;
+    try {
+      found = cache.Find(key, _atomic_guess_file, dmat_unrestricted);
+    } catch (std::runtime_error& error) {
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp() << " Could not read atomic guesses from "
+          << _atomic_guess_file << ": " << error.what() << flush;
+    }
+    if (found) {
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp() << " Using cached atom density for "
+          << unique_atom.getElement() << flush;
+    } else {
+      XTP_LOG(Log::error, *_pLog)
+          << TimeStamp() << " Calculating atom density for "
+          << unique_atom.getElement() << flush;
+      dmat_unrestricted = RunAtomicDFT_unrestricted(unique_atom);
+      try {
+        cache.Add(key, _atomic_guess_file, dmat_unrestricted);
+      } catch (std::runtime_error& error) {
+        XTP_LOG(Log::error, *_pLog)
+            << TimeStamp() << " Could not write atomic guess to "
+            << _atomic_guess_file << ": " << error.what() << flush;
+      }
+    }
     uniqueatom_guesses.push_back(dmat_unrestricted);
   }
 
@@ -726,11 +1071,11 @@ void DFTEngine::ConfigOrbfile(Orbitals& orb) {
                 .str());
       }
     }
-    if (orb.getNumberOfAlphaElectrons() != _numofelectrons / 2) {
+    if (orb.getNumberOfAlphaElectrons() != _numofalpha) {
       throw runtime_error(
           (boost::format("Number of electron in guess orb file: %1% and in "
                          "dftengine: %2% differ.") %
-           orb.getNumberOfAlphaElectrons() % (_numofelectrons / 2))
+           orb.getNumberOfAlphaElectrons() % _numofalpha)
               .str());
     }
     if (orb.getBasisSetSize() != _dftbasis.AOBasisSize()) {
@@ -740,9 +1085,10 @@ void DFTEngine::ConfigOrbfile(Orbitals& orb) {
                               .str());
     }
   } else {
-    orb.setNumberOfAlphaElectrons(_numofelectrons / 2);
-    orb.setNumberOfOccupiedLevels(_numofelectrons / 2);
+    orb.setNumberOfAlphaElectrons(_numofalpha);
+    orb.setNumberOfOccupiedLevels(_numofalpha);
   }
+  orb.setNumberOfBetaElectrons(_unrestricted ? _numofbeta : 0);
   return;
 }
 
@@ -807,12 +1153,32 @@ void DFTEngine::Prepare(QMMolecule& mol) {
   for (const QMAtom& atom : mol) {
     _numofelectrons += atom.getNuccharge();
   }
+  _numofelectrons -= _charge;
+  const Index unpaired = _spin - 1;
+  if (_spin < 1 || unpaired > _numofelectrons ||
+      (_numofelectrons - unpaired) % 2 != 0) {
+    throw std::runtime_error(
+        (boost::format("Spin multiplicity %1% is not possible for %2% "
+                       "electrons") %
+         _spin % _numofelectrons)
+            .str());
+  }
+  _numofalpha = (_numofelectrons + unpaired) / 2;
+  _numofbeta = (_numofelectrons - unpaired) / 2;
+  if (_spin != 1) {
+    _unrestricted = true;
+  }
 
   // here number of electrons is actually the total number, everywhere else in
   // votca it is just alpha_electrons
   XTP_LOG(Log::error, *_pLog)
       << TimeStamp() << " Total number of electrons: " << _numofelectrons
       << flush;
+  if (_unrestricted) {
+    XTP_LOG(Log::error, *_pLog)
+        << TimeStamp() << " Unrestricted calculation with " << _numofalpha
+        << " alpha and " << _numofbeta << " beta electrons" << flush;
+  }
 
   SetupInvariantMatrices();
   return;
@@ -826,7 +1192,26 @@ Vxc_Potential<Vxc_Grid> DFTEngine::SetupVxc(const QMMolecule& mol) {
         << flush;
   }
   Vxc_Grid grid;
-  grid.GridSetup(_grid_name, mol, _dftbasis);
+  bool reused = false;
+  if (_reuse_grid) {
+    reused = VxcGridCache::Instance().Find(_grid_name, _dftbasis_name, mol,
+                                           _dftbasis, grid);
+  }
+  if (reused) {
+    XTP_LOG(Log::info, *_pLog)
+        << TimeStamp() << " Reusing grid of a previous calculation" << flush;
+  } else {
+    grid.GridSetup(_grid_name, mol, _dftbasis);
+  }
+  if (_reuse_grid && !reused) {
+    VxcGridCache::Instance().Add(_grid_name, _dftbasis_name, mol, grid);
+  }
+  if (_ao_cache_memory > 0) {
+    Index cached = grid.CacheAOValues(_ao_cache_memory, _ao_cache_single);
+    XTP_LOG(Log::info, *_pLog)
+        << TimeStamp() << " Cached AO values of " << cached << " of "
+        << grid.getBoxesSize() << " boxes" << flush;
+  }
   Vxc_Potential<Vxc_Grid> vxc(grid);
   vxc.setXCfunctional(_xc_functional_name);
   XTP_LOG(Log::error, *_pLog)
@@ -955,10 +1340,17 @@ Mat_p_Energy DFTEngine::IntegrateExternalMultipoles(
   Mat_p_Energy result(_dftbasis.AOBasisSize(), _dftbasis.AOBasisSize());
   AOMultipole dftAOESP;
 
-  dftAOESP.FillPotential(_dftbasis, multipoles);
+  dftAOESP.FillPotential(_dftbasis, multipoles, _external_multipole_tolerance,
+                         _external_multipole_density_threshold);
   XTP_LOG(Log::error, *_pLog)
       << TimeStamp() << " Filled DFT external multipole potential matrix"
       << flush;
+  if (_external_multipole_tolerance > 0) {
+    XTP_LOG(Log::info, *_pLog)
+        << TimeStamp() << " Used on average " << dftAOESP.AverageExactSites()
+        << " exact external sites and " << dftAOESP.AverageClusters()
+        << " clusters per shell pair" << flush;
+  }
   result.matrix() = dftAOESP.Matrix();
   result.energy() = ExternalRepulsion(mol, multipoles);
 
@@ -971,29 +1363,69 @@ Mat_p_Energy DFTEngine::IntegrateExternalDensity(
   basis.Load(extdensity.getDFTbasisName());
   AOBasis aobasis;
   aobasis.Fill(basis, extdensity.QMAtoms());
+  Eigen::MatrixXd dmat = extdensity.DensityMatrixFull(_state);
+
+  AOMultipole esp;
+  esp.FillPotential(_dftbasis, extdensity.QMAtoms());
+  double nuc_energy = 0.0;
+  for (const QMAtom& atom : mol) {
+    for (const QMAtom& extatom : extdensity.QMAtoms()) {
+      const double dist = (atom.getPos() - extatom.getPos()).norm();
+      nuc_energy +=
+          double(atom.getNuccharge()) * double(extatom.getNuccharge()) / dist;
+    }
+  }
+
+  const std::string auxbasis_name = extdensity.hasAuxbasisName()
+                                        ? extdensity.getAuxbasisName()
+                                        : _auxbasis_name;
+  if (!auxbasis_name.empty()) {
+    // the external density is fitted once into an aux basis on the external
+    // atoms, its potential then follows from one three-center contraction
+    BasisSet auxbasisset;
+    auxbasisset.Load(auxbasis_name);
+    AOBasis auxbasis;
+    auxbasis.Fill(auxbasisset, extdensity.QMAtoms());
+    Eigen::VectorXd coefficients;
+    {
+      ERIs ext_eris;
+      ext_eris.Initialize(aobasis, auxbasis, _threecenter_max_memory,
+                          _scratch_dir);
+      coefficients = ext_eris.FitDensity(dmat);
+    }
+    XTP_LOG(Log::error, *_pLog)
+        << TimeStamp() << " Fitted external density into " << auxbasis_name
+        << " with " << auxbasis.AOBasisSize() << " functions" << flush;
+    ERIs coupling;
+    coupling.Initialize(_dftbasis, auxbasis, _threecenter_max_memory,
+                        _scratch_dir);
+    Eigen::MatrixXd e_contrib = coupling.ContractFit(coefficients);
+    XTP_LOG(Log::error, *_pLog)
+        << TimeStamp() << " Calculated potential from electron density"
+        << flush;
+    // attraction of the external electrons by the nuclei of mol
+    AOMultipole nuc_potential;
+    nuc_potential.FillPotential(aobasis, mol);
+    nuc_energy += dmat.cwiseProduct(nuc_potential.Matrix()).sum();
+    XTP_LOG(Log::error, *_pLog)
+        << TimeStamp() << " Calculated potential from nuclei" << flush;
+    XTP_LOG(Log::error, *_pLog)
+        << TimeStamp() << " Electrostatic: " << nuc_energy << flush;
+    return Mat_p_Energy(nuc_energy, e_contrib + esp.Matrix());
+  }
+
   Vxc_Grid grid;
   grid.GridSetup(_gridquality, extdensity.QMAtoms(), aobasis);
   DensityIntegration<Vxc_Grid> numint(grid);
-  Eigen::MatrixXd dmat = extdensity.DensityMatrixFull(_state);
-
   numint.IntegrateDensity(dmat);
   XTP_LOG(Log::error, *_pLog)
       << TimeStamp() << " Calculated external density" << flush;
   Eigen::MatrixXd e_contrib = numint.IntegratePotential(_dftbasis);
   XTP_LOG(Log::error, *_pLog)
       << TimeStamp() << " Calculated potential from electron density" << flush;
-  AOMultipole esp;
-  esp.FillPotential(_dftbasis, extdensity.QMAtoms());
-
-  double nuc_energy = 0.0;
   for (const QMAtom& atom : mol) {
     nuc_energy +=
         numint.IntegratePotential(atom.getPos()) * double(atom.getNuccharge());
-    for (const QMAtom& extatom : extdensity.QMAtoms()) {
-      const double dist = (atom.getPos() - extatom.getPos()).norm();
-      nuc_energy +=
-          double(atom.getNuccharge()) * double(extatom.getNuccharge()) / dist;
-    }
   }
   XTP_LOG(Log::error, *_pLog)
       << TimeStamp() << " Calculated potential from nuclei" << flush;
@@ -1009,11 +1441,22 @@ Mat_p_Energy DFTEngine::CalculateERIs(const Eigen::MatrixXd& DMAT) const {
     return _ERIs.CalculateERIs_4c_small_molecule(DMAT);
   } else if (_four_center_method == "direct") {
     return _ERIs.CalculateERIs_4c_direct(_dftbasis, DMAT);
+  } else if (_four_center_method == "semidirect") {
+    return _ERIs.CalculateERIs_EXX_4c_semidirect(_dftbasis, DMAT, false).first;
   } else {
     throw std::runtime_error("ERI method not known.");
   }
 }
 
+Eigen::MatrixXd DFTEngine::CalculateERIs_diff(
+    const Eigen::MatrixXd& dDMAT) const {
+  if (_four_center_method == "RI") {
+    return _ERIs.CalculateERIs_diff(dDMAT, _incremental_fock_eps);
+  } else {
+    return CalculateERIs(dDMAT).matrix();
+  }
+}
+
 Eigen::MatrixXd DFTEngine::OrthogonalizeGuess(
     const Eigen::MatrixXd& GuessMOs) const {
   Eigen::MatrixXd nonortho =
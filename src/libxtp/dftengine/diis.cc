@@ -38,14 +38,15 @@ void DIIS::Update(Index maxerrorindex, const Eigen::MatrixXd& errormatrix) {
 
   _errormatrixhist.push_back(errormatrix);
 
+  // Tr(e_i^T e_j), the error matrices do not have to be square, for
+  // unrestricted calculations they hold both spins side by side
   std::vector<double> Bijs;
   for (Index i = 0; i < Index(_errormatrixhist.size()) - 1; i++) {
-    double value =
-        errormatrix.cwiseProduct((_errormatrixhist[i]).transpose()).sum();
+    double value = errormatrix.cwiseProduct(_errormatrixhist[i]).sum();
     Bijs.push_back(value);
     _Diis_Bs[i].push_back(value);
   }
-  Bijs.push_back(errormatrix.cwiseProduct(errormatrix.transpose()).sum());
+  Bijs.push_back(errormatrix.squaredNorm());
   _Diis_Bs.push_back(Bijs);
   return;
 }
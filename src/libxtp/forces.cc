@@ -52,6 +52,9 @@ void Forces::Calculate(const Orbitals& orbitals) {
 
   Index natoms = orbitals.QMAtoms().size();
   _forces = Eigen::MatrixX3d::Zero(natoms, 3);
+  // the displaced geometries are no trajectory, each one starts from the
+  // density of the reference geometry instead of an extrapolation
+  _gwbse_engine.setDisplacedGeometry(true);
 
   for (Index atom_index = 0; atom_index < natoms; atom_index++) {
 
@@ -67,6 +70,7 @@ void Forces::Calculate(const Orbitals& orbitals) {
     }
     _forces.row(atom_index) = atom_force.transpose();
   }
+  _gwbse_engine.setDisplacedGeometry(false);
   if (_remove_total_force) {
     RemoveTotalForce();
   }
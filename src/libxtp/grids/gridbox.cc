@@ -25,6 +25,7 @@ namespace xtp {
 
 void GridBox::FindSignificantShells(const AOBasis& basis) {
 
+  Index shellindex = 0;
   for (const AOShell& store : basis) {
     const double decay = store.getMinDecay();
     const Eigen::Vector3d& shellpos = store.getPos();
@@ -33,10 +34,17 @@ void GridBox::FindSignificantShells(const AOBasis& basis) {
       double distsq = dist.squaredNorm();
       // if contribution is smaller than -ln(1e-10), add shell to list
       if ((decay * distsq) < 20.7) {
-        addShell(&store);
+        addShell(&store, shellindex);
         break;
       }
     }
+    shellindex++;
+  }
+}
+
+void GridBox::RebindShells(const AOBasis& basis) {
+  for (Index j = 0; j < Shellsize(); ++j) {
+    significant_shells[j] = &basis.getShell(significant_shell_indices[j]);
   }
 }
 
@@ -53,6 +61,71 @@ Eigen::VectorXd GridBox::CalcAOValue_and_Grad(
   return ao;
 }
 
+Eigen::MatrixX3d GridBox::GridPointMatrix() const {
+  Eigen::MatrixX3d points(size(), 3);
+  for (Index p = 0; p < size(); p++) {
+    points.row(p) = grid_pos[p];
+  }
+  return points;
+}
+
+AOValues GridBox::CalcAOValues_and_Grad() const {
+  AOValues result(size(), Matrixsize());
+  const Eigen::MatrixX3d points = GridPointMatrix();
+  for (Index j = 0; j < Shellsize(); ++j) {
+    const Index start = aoranges[j].start;
+    const Index nfunc = aoranges[j].size;
+    significant_shells[j]->EvalAOspace(
+        points, result.values.middleCols(start, nfunc),
+        result.derivatives_x.middleCols(start, nfunc),
+        result.derivatives_y.middleCols(start, nfunc),
+        result.derivatives_z.middleCols(start, nfunc));
+  }
+  return result;
+}
+
+Eigen::MatrixXd GridBox::CalcAOValues() const {
+  Eigen::MatrixXd values = Eigen::MatrixXd::Zero(size(), Matrixsize());
+  const Eigen::MatrixX3d points = GridPointMatrix();
+  for (Index j = 0; j < Shellsize(); ++j) {
+    significant_shells[j]->EvalAOspace(
+        points, values.middleCols(aoranges[j].start, aoranges[j].size));
+  }
+  return values;
+}
+
+AOValues GridBox::getAOValues() const {
+  if (!hasAOCache()) {
+    return CalcAOValues_and_Grad();
+  }
+  AOValues result(0, 0);
+  const Index n = size();
+  if (_aocache_d) {
+    result.values = _aocache_d->topRows(n);
+    result.derivatives_x = _aocache_d->middleRows(n, n);
+    result.derivatives_y = _aocache_d->middleRows(2 * n, n);
+    result.derivatives_z = _aocache_d->bottomRows(n);
+  } else {
+    result.values = _aocache_f->topRows(n).cast<double>();
+    result.derivatives_x = _aocache_f->middleRows(n, n).cast<double>();
+    result.derivatives_y = _aocache_f->middleRows(2 * n, n).cast<double>();
+    result.derivatives_z = _aocache_f->bottomRows(n).cast<double>();
+  }
+  return result;
+}
+
+void GridBox::CacheAOValues(bool single_precision) {
+  const AOValues ao = CalcAOValues_and_Grad();
+  Eigen::MatrixXd stacked(4 * size(), Matrixsize());
+  stacked << ao.values, ao.derivatives_x, ao.derivatives_y, ao.derivatives_z;
+  ClearAOCache();
+  if (single_precision) {
+    _aocache_f = std::make_shared<const Eigen::MatrixXf>(stacked.cast<float>());
+  } else {
+    _aocache_d = std::make_shared<const Eigen::MatrixXd>(std::move(stacked));
+  }
+}
+
 Eigen::VectorXd GridBox::CalcAOValues(const Eigen::Vector3d& pos) const {
   Eigen::VectorXd ao = Eigen::VectorXd::Zero(Matrixsize());
   for (Index j = 0; j < Shellsize(); ++j) {
@@ -17,6 +17,16 @@
  *
  */
 
+// Standard includes
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+// Third party includes
+#include <boost/functional/hash.hpp>
+
 // Local VOTCA includes
 #include "votca/xtp/vxc_grid.h"
 #include "votca/xtp/qmmolecule.h"
@@ -29,68 +39,81 @@ namespace xtp {
 void Vxc_Grid::SortGridpointsintoBlocks(
     const std::vector<std::vector<GridContainers::Cartesian_gridpoint> >&
         grid) {
-  const double boxsize = 1;  // 1 bohr
 
   Eigen::Array3d min =
       Eigen::Array3d::Ones() * std::numeric_limits<double>::max();
   Eigen::Array3d max =
-      Eigen::Array3d::Ones() * std::numeric_limits<double>::min();
+      Eigen::Array3d::Ones() * std::numeric_limits<double>::lowest();
 
+  std::vector<const GridContainers::Cartesian_gridpoint*> points;
   for (const auto& atom_grid : grid) {
     for (const auto& gridpoint : atom_grid) {
       const Eigen::Vector3d& pos = gridpoint.grid_pos;
       max = max.max(pos.array()).eval();
       min = min.min(pos.array()).eval();
+      points.push_back(&gridpoint);
     }
   }
-
-  Eigen::Array3d molextension = max - min;
-  Eigen::Array<Index, 3, 1> numberofboxes =
-      (molextension / boxsize).ceil().cast<Index>();
-
-  std::vector<std::vector<
-      std::vector<std::vector<const GridContainers::Cartesian_gridpoint*> > > >
-      boxes;
-  // creating temparray
-  for (Index i = 0; i < numberofboxes.x(); i++) {
-    std::vector<
-        std::vector<std::vector<const GridContainers::Cartesian_gridpoint*> > >
-        boxes_yz;
-    for (Index j = 0; j < numberofboxes.y(); j++) {
-      std::vector<std::vector<const GridContainers::Cartesian_gridpoint*> >
-          boxes_z;
-      for (Index k = 0; k < numberofboxes.z(); k++) {
-        std::vector<const GridContainers::Cartesian_gridpoint*> box;
-        box.reserve(100);
-        boxes_z.push_back(box);
-      }
-      boxes_yz.push_back(boxes_z);
-    }
-    boxes.push_back(boxes_yz);
+  if (points.empty()) {
+    return;
   }
+  const Eigen::Vector3d center = 0.5 * (max + min).matrix();
+  const double halfsize = 0.5 * (max - min).maxCoeff();
+  SplitIntoOctants(points, center, halfsize, 0);
+  return;
+}
 
-  for (const auto& atomgrid : grid) {
-    for (const auto& gridpoint : atomgrid) {
-      Eigen::Array3d pos = gridpoint.grid_pos - min.matrix();
-      Eigen::Array<Index, 3, 1> index = (pos / boxsize).floor().cast<Index>();
-      boxes[index.x()][index.y()][index.z()].push_back(&gridpoint);
+void Vxc_Grid::SplitIntoOctants(
+    std::vector<const GridContainers::Cartesian_gridpoint*>& points,
+    const Eigen::Vector3d& center, double halfsize, Index depth) {
+  // dense regions are split further, sparse regions stay in large boxes
+  constexpr Index maxdepth = 20;
+  if (Index(points.size()) <= _target_boxsize || depth >= maxdepth) {
+    GridBox gridbox;
+    for (const auto* point : points) {
+      gridbox.addGridPoint(*point);
     }
+    _grid_boxes.push_back(gridbox);
+    return;
   }
-  for (auto& boxes_xy : boxes) {
-    for (auto& boxes_z : boxes_xy) {
-      for (auto& box : boxes_z) {
-        if (box.empty()) {
-          continue;
-        }
-        GridBox gridbox;
-        for (const auto& point : box) {
-          gridbox.addGridPoint(*point);
-        }
-        _grid_boxes.push_back(gridbox);
+  std::array<std::vector<const GridContainers::Cartesian_gridpoint*>, 8>
+      octants;
+  for (const auto* point : points) {
+    const Eigen::Vector3d& pos = point->grid_pos;
+    Index octant = (pos.x() >= center.x() ? 1 : 0) +
+                   (pos.y() >= center.y() ? 2 : 0) +
+                   (pos.z() >= center.z() ? 4 : 0);
+    octants[octant].push_back(point);
+  }
+  points.clear();
+  points.shrink_to_fit();
+  const double quartersize = 0.5 * halfsize;
+  // octants which are small enough become leaves, neighbouring small leaves
+  // share a box as long as it stays below the target size
+  GridBox sparse;
+  for (Index octant = 0; octant < 8; octant++) {
+    const Index octantsize = Index(octants[octant].size());
+    if (octantsize == 0) {
+      continue;
+    } else if (octantsize <= _target_boxsize) {
+      if (sparse.size() + octantsize > _target_boxsize) {
+        _grid_boxes.push_back(sparse);
+        sparse = GridBox();
+      }
+      for (const auto* point : octants[octant]) {
+        sparse.addGridPoint(*point);
       }
+      continue;
     }
+    Eigen::Vector3d shift;
+    shift << ((octant & 1) ? quartersize : -quartersize),
+        ((octant & 2) ? quartersize : -quartersize),
+        ((octant & 4) ? quartersize : -quartersize);
+    SplitIntoOctants(octants[octant], center + shift, quartersize, depth + 1);
+  }
+  if (sparse.size() > 0) {
+    _grid_boxes.push_back(sparse);
   }
-  return;
 }
 
 void Vxc_Grid::FindSignificantShells(const AOBasis& basis) {
@@ -100,26 +123,26 @@ void Vxc_Grid::FindSignificantShells(const AOBasis& basis) {
     _grid_boxes[i].FindSignificantShells(basis);
   }
 
+  // boxes with the same significant shells are merged until they reach the
+  // target size, the open box for each shell list is found via a hash map
+  using ShellList = std::vector<const AOShell*>;
+  std::unordered_map<ShellList, Index, boost::hash<ShellList> > open_boxes;
   std::vector<GridBox> grid_boxes_copy;
-  // use vector of bool to indicate if a gridbox has already been merged into
-  // another
-  std::vector<bool> Merged = std::vector<bool>(_grid_boxes.size(), false);
-  for (Index i = 0; i < Index(_grid_boxes.size()); i++) {
-    if (Merged[i]) {
-      continue;
-    }
-    GridBox box = _grid_boxes[i];
+  for (const GridBox& box : _grid_boxes) {
     if (box.Shellsize() < 1) {
       continue;
     }
-    Merged[i] = true;
-    for (Index j = i + 1; j < Index(_grid_boxes.size()); j++) {
-      if (GridBox::compareGridboxes(_grid_boxes[i], _grid_boxes[j])) {
-        Merged[j] = true;
-        box.addGridBox(_grid_boxes[j]);
-      }
+    auto open = open_boxes.find(box.getShells());
+    if (open == open_boxes.end()) {
+      grid_boxes_copy.push_back(box);
+      const Index index = Index(grid_boxes_copy.size()) - 1;
+      open = open_boxes.emplace(box.getShells(), index).first;
+    } else {
+      grid_boxes_copy[open->second].addGridBox(box);
+    }
+    if (grid_boxes_copy[open->second].size() >= _target_boxsize) {
+      open_boxes.erase(open);
     }
-    grid_boxes_copy.push_back(box);
   }
 
   _totalgridsize = 0;
@@ -127,9 +150,46 @@ void Vxc_Grid::FindSignificantShells(const AOBasis& basis) {
     _totalgridsize += box.size();
     box.PrepareForIntegration();
   }
+  // expensive boxes first, so that dynamic scheduling over the boxes balances
+  // the load between threads
+  std::stable_sort(grid_boxes_copy.begin(), grid_boxes_copy.end(),
+                   [](const GridBox& box1, const GridBox& box2) {
+                     return box1.EstimatedCost() > box2.EstimatedCost();
+                   });
   _grid_boxes = grid_boxes_copy;
 }
 
+Index Vxc_Grid::CacheAOValues(double max_memory_mb, bool single_precision) {
+  const double max_bytes = max_memory_mb * 1024 * 1024;
+  double bytes = 0.0;
+  // boxes are sorted by cost, so the expensive ones are cached first
+  std::vector<Index> tocache;
+  Index cached = 0;
+  for (Index i = 0; i < getBoxesSize(); i++) {
+    const GridBox& box = _grid_boxes[i];
+    double boxbytes = double(box.AOCacheSize(single_precision));
+    if (bytes + boxbytes > max_bytes) {
+      continue;
+    }
+    bytes += boxbytes;
+    cached++;
+    if (!box.hasAOCache()) {
+      tocache.push_back(i);
+    }
+  }
+#pragma omp parallel for schedule(dynamic)
+  for (Index i = 0; i < Index(tocache.size()); i++) {
+    _grid_boxes[tocache[i]].CacheAOValues(single_precision);
+  }
+  return cached;
+}
+
+void Vxc_Grid::RebindShells(const AOBasis& basis) {
+  for (GridBox& box : _grid_boxes) {
+    box.RebindShells(basis);
+  }
+}
+
 std::vector<const Eigen::Vector3d*> Vxc_Grid::getGridpoints() const {
   std::vector<const Eigen::Vector3d*> gridpoints;
   gridpoints.reserve(this->getGridSize());
@@ -142,17 +202,76 @@ std::vector<const Eigen::Vector3d*> Vxc_Grid::getGridpoints() const {
   return gridpoints;
 }
 
-Eigen::MatrixXd Vxc_Grid::CalcInverseAtomDist(const QMMolecule& atoms) const {
-  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(atoms.size(), atoms.size());
-#pragma omp parallel for
-  for (Index i = 0; i < atoms.size(); ++i) {
-    const Eigen::Vector3d& pos_a = atoms[i].getPos();
-    for (Index j = 0; j < i; ++j) {
-      const Eigen::Vector3d& pos_b = atoms[j].getPos();
-      result(j, i) = 1 / (pos_a - pos_b).norm();
+Vxc_Grid::AtomCells::AtomCells(const QMMolecule& atoms, double cellsize)
+    : _cellsize(cellsize) {
+  Eigen::Array3d min =
+      Eigen::Array3d::Ones() * std::numeric_limits<double>::max();
+  Eigen::Array3d max =
+      Eigen::Array3d::Ones() * std::numeric_limits<double>::lowest();
+  for (const QMAtom& atom : atoms) {
+    _pos.push_back(atom.getPos());
+    min = min.min(atom.getPos().array()).eval();
+    max = max.max(atom.getPos().array()).eval();
+  }
+  _min = min.matrix();
+  _ncells = ((max - min) / _cellsize).floor().cast<Index>() + 1;
+  _cells.resize(_ncells.prod());
+  for (Index i = 0; i < Index(_pos.size()); i++) {
+    Eigen::Array<Index, 3, 1> index =
+        ((_pos[i] - _min).array() / _cellsize).floor().cast<Index>();
+    index = index.min(_ncells - 1);
+    _cells[(index.x() * _ncells.y() + index.y()) * _ncells.z() + index.z()]
+        .push_back(i);
+  }
+}
+
+void Vxc_Grid::AtomCells::AtomsInSphere(const Eigen::Vector3d& pos,
+                                        double radius,
+                                        std::vector<Index>& result) const {
+  Eigen::Array<Index, 3, 1> start =
+      (((pos - _min).array() - radius) / _cellsize).floor().cast<Index>();
+  Eigen::Array<Index, 3, 1> end =
+      (((pos - _min).array() + radius) / _cellsize).floor().cast<Index>();
+  start = start.max(0);
+  end = end.min(_ncells - 1);
+  const Index oldsize = Index(result.size());
+  const double radius2 = radius * radius;
+  for (Index x = start.x(); x <= end.x(); x++) {
+    for (Index y = start.y(); y <= end.y(); y++) {
+      for (Index z = start.z(); z <= end.z(); z++) {
+        for (Index atom : _cells[(x * _ncells.y() + y) * _ncells.z() + z]) {
+          if ((_pos[atom] - pos).squaredNorm() <= radius2) {
+            result.push_back(atom);
+          }
+        }
+      }
+    }
+  }
+  std::sort(result.begin() + oldsize, result.end());
+}
+
+Eigen::VectorXd Vxc_Grid::AtomCells::NearestNeighbourDistances() const {
+  Eigen::VectorXd result = Eigen::VectorXd::Constant(
+      Index(_pos.size()), std::numeric_limits<double>::max());
+  if (_pos.size() < 2) {
+    return result;
+  }
+  std::vector<Index> neighbours;
+  for (Index i = 0; i < Index(_pos.size()); i++) {
+    // grow the search sphere until it contains another atom
+    double radius = _cellsize;
+    do {
+      neighbours.clear();
+      AtomsInSphere(_pos[i], radius, neighbours);
+      radius *= 2;
+    } while (neighbours.size() < 2);
+    for (Index j : neighbours) {
+      if (j != i) {
+        result[i] = std::min(result[i], (_pos[i] - _pos[j]).norm());
+      }
     }
   }
-  return result + result.transpose();
+  return result;
 }
 
 Index Vxc_Grid::UpdateOrder(LebedevGrid& sphericalgridofElement, Index maxorder,
@@ -209,35 +328,118 @@ GridContainers::Cartesian_gridpoint Vxc_Grid::CreateCartesianGridpoint(
   return gridpoint;
 }
 
-Eigen::MatrixXd Vxc_Grid::CalcDistanceAtomsGridpoints(
-    const QMMolecule& atoms,
-    std::vector<GridContainers::Cartesian_gridpoint>& atomgrid) const {
-  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(atoms.size(), atomgrid.size());
-#pragma omp parallel for
-  for (Index i = 0; i < atoms.size(); ++i) {
-    const Eigen::Vector3d& atom_pos = atoms[i].getPos();
-    for (Index j = 0; j < Index(atomgrid.size()); ++j) {
-      const auto& gridpoint = atomgrid[j];
-      result(i, j) = (atom_pos - gridpoint.grid_pos).norm();
+/*
+ * With the SSW cutoff a = 0.725 the partition function p_B of atom B vanishes
+ * at a point, if any atom C has (r_B - r_C) > a R_BC. From the triangle
+ * inequality it follows that, with r_N the distance of the nearest atom,
+ *  - p_A = 1 and all other p_B = 0 if r_A <= (1-a)/2 R_nn(A)
+ *  - p_B = 0 if r_B - r_N > a R_BN, which implies r_B > r_N (1+a)/(1-a)
+ *  - atom C does not change p_B if r_C - r_B >= a R_BC, which holds for all
+ *    r_C >= r_B (1+a)/(1-a)
+ * so only the atoms around each point which can change p_A or the sum over
+ * all p_B have to enter SSWpartition.
+ */
+std::vector<Index> Vxc_Grid::PartitionAtoms(const QMMolecule& atoms,
+                                            const AtomCells& cells,
+                                            const Eigen::Vector3d& point,
+                                            Index i_atom) const {
+  const double ass = 0.725;
+  const double ratio = (1.0 + ass) / (1.0 - ass);
+  const double r_A = (point - atoms[i_atom].getPos()).norm();
+  std::vector<Index> near;
+  cells.AtomsInSphere(point, r_A, near);
+  Index atom_N = i_atom;
+  double r_N = r_A;
+  for (Index atom : near) {
+    double r = (point - atoms[atom].getPos()).norm();
+    if (r < r_N) {
+      r_N = r;
+      atom_N = atom;
     }
   }
-  return result;
+  const Eigen::Vector3d& pos_N = atoms[atom_N].getPos();
+  // candidates can have p_B > 0
+  std::vector<Index> candidates;
+  double r_max = 0.0;
+  near.clear();
+  cells.AtomsInSphere(point, ratio * r_N, near);
+  for (Index atom : near) {
+    const Eigen::Vector3d& pos_B = atoms[atom].getPos();
+    double r_B = (point - pos_B).norm();
+    if (r_B - r_N <= ass * (pos_B - pos_N).norm()) {
+      candidates.push_back(atom);
+      r_max = std::max(r_max, r_B);
+    }
+  }
+  if (std::find(candidates.begin(), candidates.end(), i_atom) ==
+      candidates.end()) {
+    return candidates;
+  }
+  near.clear();
+  cells.AtomsInSphere(point, ratio * r_max, near);
+  std::vector<Index> relevant;
+  for (Index atom_C : near) {
+    const Eigen::Vector3d& pos_C = atoms[atom_C].getPos();
+    const double r_C = (point - pos_C).norm();
+    for (Index atom_B : candidates) {
+      const Eigen::Vector3d& pos_B = atoms[atom_B].getPos();
+      if (atom_B == atom_C ||
+          r_C - (point - pos_B).norm() < ass * (pos_B - pos_C).norm()) {
+        relevant.push_back(atom_C);
+        break;
+      }
+    }
+  }
+  return relevant;
 }
 
 void Vxc_Grid::SSWpartitionAtom(
     const QMMolecule& atoms,
     std::vector<GridContainers::Cartesian_gridpoint>& atomgrid, Index i_atom,
-    const Eigen::MatrixXd& Rij) const {
-  Eigen::MatrixXd AtomGridDist = CalcDistanceAtomsGridpoints(atoms, atomgrid);
+    const AtomCells& cells, double nearest_neighbour) const {
+  const double ass = 0.725;
+  const double inner_radius = 0.5 * (1.0 - ass) * nearest_neighbour;
+  const Eigen::Vector3d& pos_A = atoms[i_atom].getPos();
 
 #pragma omp parallel for schedule(guided)
   for (Index i_grid = 0; i_grid < Index(atomgrid.size()); i_grid++) {
-    Eigen::VectorXd p = SSWpartition(AtomGridDist.col(i_grid), Rij);
+    const Eigen::Vector3d& point = atomgrid[i_grid].grid_pos;
+    std::vector<Index> relevant;
+    if (_screen_partition) {
+      if ((point - pos_A).norm() <= inner_radius) {
+        continue;
+      }
+      relevant = PartitionAtoms(atoms, cells, point, i_atom);
+    } else {
+      relevant.resize(atoms.size());
+      std::iota(relevant.begin(), relevant.end(), 0);
+    }
+    if (std::find(relevant.begin(), relevant.end(), i_atom) ==
+        relevant.end()) {
+      atomgrid[i_grid].grid_weight = 0.0;
+      continue;
+    }
+    const Index size = Index(relevant.size());
+    Eigen::VectorXd rq_i = Eigen::VectorXd::Zero(size);
+    Eigen::MatrixXd Rij = Eigen::MatrixXd::Zero(size, size);
+    Index index_A = 0;
+    for (Index i = 0; i < size; i++) {
+      const Eigen::Vector3d& pos_i = atoms[relevant[i]].getPos();
+      rq_i(i) = (point - pos_i).norm();
+      for (Index j = 0; j < i; j++) {
+        Rij(j, i) = 1 / (pos_i - atoms[relevant[j]].getPos()).norm();
+        Rij(i, j) = Rij(j, i);
+      }
+      if (relevant[i] == i_atom) {
+        index_A = i;
+      }
+    }
+    Eigen::VectorXd p = SSWpartition(rq_i, Rij);
     // check weight sum
     double wsum = p.sum();
     if (wsum != 0.0) {
       // update the weight of this grid point
-      atomgrid[i_grid].grid_weight *= p[i_atom] / wsum;
+      atomgrid[i_grid].grid_weight *= p[index_A] / wsum;
     } else {
       std::cerr << "\nSum of partition weights of grid point " << i_grid
                 << " of atom " << i_atom << " is zero! ";
@@ -257,9 +459,10 @@ void Vxc_Grid::GridSetup(const std::string& type, const QMMolecule& atoms,
   initialgrids.spherical_grids =
       sphericalgridofElement.CalculateSphericalGrids(atoms, type);
 
-  // for the partitioning, we need all inter-center distances later, stored in
-  // matrix
-  Eigen::MatrixXd Rij = CalcInverseAtomDist(atoms);
+  // for the partitioning, we only need the atoms close to each grid point
+  const double cellsize = 4.0;  // bohr
+  AtomCells cells(atoms, cellsize);
+  Eigen::VectorXd nearest_neighbours = cells.NearestNeighbourDistances();
   std::vector<std::vector<GridContainers::Cartesian_gridpoint> > grid;
 
   for (Index i_atom = 0; i_atom < atoms.size(); ++i_atom) {
@@ -300,7 +503,8 @@ void Vxc_Grid::GridSetup(const std::string& type, const QMMolecule& atoms,
       }  // spherical gridpoints
     }    // radial gridpoint
 
-    SSWpartitionAtom(atoms, atomgrid, i_atom, Rij);
+    SSWpartitionAtom(atoms, atomgrid, i_atom, cells,
+                     nearest_neighbours[i_atom]);
     // now remove points from the grid with negligible weights
     std::vector<GridContainers::Cartesian_gridpoint> atomgrid_cleanedup;
     for (const auto& point : atomgrid) {
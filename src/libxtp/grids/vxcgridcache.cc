@@ -0,0 +1,105 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Third party includes
+#include <boost/functional/hash.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/qmmolecule.h"
+#include "votca/xtp/vxcgridcache.h"
+
+namespace votca {
+namespace xtp {
+
+VxcGridCache& VxcGridCache::Instance() {
+  static VxcGridCache cache;
+  return cache;
+}
+
+std::size_t VxcGridCache::GeometryHash(const QMMolecule& mol) {
+  std::size_t hash = 0;
+  for (const QMAtom& atom : mol) {
+    boost::hash_combine(hash, atom.getElement());
+    const Eigen::Vector3d& pos = atom.getPos();
+    boost::hash_range(hash, pos.data(), pos.data() + 3);
+  }
+  return hash;
+}
+
+bool VxcGridCache::isSameGeometry(const Entry& entry, const QMMolecule& mol) {
+  if (Index(entry.elements.size()) != mol.size()) {
+    return false;
+  }
+  for (Index i = 0; i < mol.size(); i++) {
+    if (entry.elements[i] != mol[i].getElement() ||
+        entry.positions[i] != mol[i].getPos()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool VxcGridCache::Find(const std::string& gridtype,
+                        const std::string& basisset, const QMMolecule& mol,
+                        const AOBasis& basis, Vxc_Grid& grid) {
+  const std::size_t hash = GeometryHash(mol);
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (const Entry& entry : _entries) {
+    if (entry.hash == hash && entry.gridtype == gridtype &&
+        entry.basisset == basisset && isSameGeometry(entry, mol)) {
+      grid = entry.grid;
+      grid.RebindShells(basis);
+      return true;
+    }
+  }
+  return false;
+}
+
+void VxcGridCache::Add(const std::string& gridtype,
+                       const std::string& basisset, const QMMolecule& mol,
+                       const Vxc_Grid& grid) {
+  Entry entry;
+  entry.hash = GeometryHash(mol);
+  entry.gridtype = gridtype;
+  entry.basisset = basisset;
+  for (const QMAtom& atom : mol) {
+    entry.elements.push_back(atom.getElement());
+    entry.positions.push_back(atom.getPos());
+  }
+  entry.grid = grid;
+  entry.grid.ClearAOCache();
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries.push_back(std::move(entry));
+  if (Index(_entries.size()) > _max_entries) {
+    _entries.pop_front();
+  }
+}
+
+void VxcGridCache::Clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries.clear();
+}
+
+Index VxcGridCache::size() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return Index(_entries.size());
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -27,6 +27,8 @@
 #include "votca/xtp/gw.h"
 #include "votca/xtp/newton_rapson.h"
 #include "votca/xtp/rpa.h"
+#include "votca/xtp/sigma_ac.h"
+#include "votca/xtp/sigma_cd.h"
 #include "votca/xtp/sigma_exact.h"
 #include "votca/xtp/sigma_ppm.h"
 
@@ -41,6 +43,10 @@ void GW::configure(const options& opt) {
     _sigma = std::make_unique<Sigma_Exact>(Sigma_Exact(_Mmn, _rpa));
   } else if (_opt.sigma_integration == "ppm") {
     _sigma = std::make_unique<Sigma_PPM>(Sigma_PPM(_Mmn, _rpa));
+  } else if (_opt.sigma_integration == "cd") {
+    _sigma = std::make_unique<Sigma_CD>(Sigma_CD(_Mmn, _rpa));
+  } else if (_opt.sigma_integration == "ac") {
+    _sigma = std::make_unique<Sigma_AC>(Sigma_AC(_Mmn, _rpa));
   }
   Sigma_base::options sigma_opt;
   sigma_opt.homo = _opt.homo;
@@ -49,6 +55,8 @@ void GW::configure(const options& opt) {
   sigma_opt.rpamin = _opt.rpamin;
   sigma_opt.rpamax = _opt.rpamax;
   sigma_opt.eta = _opt.eta;
+  sigma_opt.quadrature_tolerance = _opt.quadrature_tolerance;
+  sigma_opt.residue_memory = _opt.residue_memory;
   _sigma->configure(sigma_opt);
   _Sigma_x = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
   _Sigma_c = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
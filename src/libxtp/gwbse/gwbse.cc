@@ -58,6 +58,12 @@ void GWBSE::Initialize(tools::Property& options) {
 
   std::string key = Identify();
 
+  if (_orbitals.hasBetaMOs()) {
+    throw std::runtime_error(
+        "GWBSE requires closed shell orbitals, the DFT calculation was "
+        "unrestricted");
+  }
+
   // getting level ranges
   Index rpamax = 0;
   Index rpamin = 0;  // never changes
@@ -195,6 +201,9 @@ void GWBSE::Initialize(tools::Property& options) {
                               << bse_size << "x" << bse_size << flush;
 
   _gwopt.reset_3c = options.get(key + ".rebuild_threecenter_freq").as<Index>();
+  _naf_threshold = options.get(key + ".naf_threshold").as<double>();
+  _threecenter_screening_eps =
+      options.get(key + ".threecenter_screening_eps").as<double>();
 
   _bseopt.nmax = options.get(key + ".exctotal").as<Index>();
   if (_bseopt.nmax > bse_size || _bseopt.nmax < 0) {
@@ -357,6 +366,17 @@ void GWBSE::Initialize(tools::Property& options) {
     XTP_LOG(Log::error, *_pLog)
         << " RPA Hamiltonian size: " << (homo + 1 - rpamin) * (rpamax - homo)
         << flush;
+    _gwopt.residue_memory = options.get(key + ".residue_memory").as<double>();
+    if (_gwopt.residue_memory > 0.0) {
+      XTP_LOG(Log::error, *_pLog)
+          << " Residue memory limit (MB): " << _gwopt.residue_memory << flush;
+    }
+  } else if (_gwopt.sigma_integration == "cd" ||
+             _gwopt.sigma_integration == "ac") {
+    _gwopt.quadrature_tolerance =
+        options.get(key + ".quadrature_tolerance").as<double>();
+    XTP_LOG(Log::error, *_pLog)
+        << " Quadrature tolerance: " << _gwopt.quadrature_tolerance << flush;
   }
   XTP_LOG(Log::error, *_pLog) << " eta: " << _gwopt.eta << flush;
 
@@ -618,6 +638,8 @@ bool GWBSE::Evaluate() {
   Index max_3c = std::max(_bseopt.cmax, _gwopt.qpmax);
   Mmn.Initialize(auxbasis.AOBasisSize(), _gwopt.rpamin, max_3c, _gwopt.rpamin,
                  _gwopt.rpamax);
+  Mmn.setNAFThreshold(_naf_threshold);
+  Mmn.setScreening(_threecenter_screening_eps);
   XTP_LOG(Log::error, *_pLog)
       << TimeStamp()
       << " Calculating Mmn_beta (3-center-repulsion x orbitals)  " << flush;
@@ -84,6 +84,10 @@ void GWBSEEngine::Initialize(tools::Property& options,
   return;
 }
 
+void GWBSEEngine::setDisplacedGeometry(bool displaced) {
+  _qmpackage->setDisplacedGeometry(displaced);
+}
+
 /*
  *    CALL DFT and GWBSE modules to get excitation energies
  *
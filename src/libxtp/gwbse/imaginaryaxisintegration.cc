@@ -0,0 +1,176 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Standard includes
+#include <cmath>
+#include <complex>
+
+// Third party includes
+#include <boost/math/constants/constants.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/imaginaryaxisintegration.h"
+#include "votca/xtp/rpa.h"
+
+namespace votca {
+namespace xtp {
+
+// Gauss-Legendre nodes and weights on [-1,1] via Golub-Welsch
+void ImaginaryAxisIntegration::configure(Index order) {
+  Eigen::MatrixXd jacobi = Eigen::MatrixXd::Zero(order, order);
+  for (Index i = 1; i < order; i++) {
+    double b = double(i) / std::sqrt(4.0 * double(i * i) - 1.0);
+    jacobi(i, i - 1) = b;
+    jacobi(i - 1, i) = b;
+  }
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(jacobi);
+  const Eigen::ArrayXd x = es.eigenvalues();
+  const Eigen::ArrayXd w =
+      2 * es.eigenvectors().row(0).transpose().array().square();
+  // t = s (1+x)/(1-x) maps [-1,1] onto [0,inf)
+  _gridpoints = _scale * (1 + x) / (1 - x);
+  _weights = w * 2 * _scale / (1 - x).square();
+
+  Eigen::VectorXd frequencies(order + 1);
+  frequencies << 0.0, _gridpoints;
+  _screening = _rpa.calculate_epsilon_i(frequencies);
+#pragma omp parallel for schedule(dynamic)
+  for (Index k = 0; k < order + 1; k++) {
+    _screening[k] = CalcScreening(_screening[k]);
+  }
+  _screening_static = std::move(_screening[0]);
+  _screening.erase(_screening.begin());
+}
+
+void ImaginaryAxisIntegration::clear() {
+  _gridpoints.resize(0);
+  _weights.resize(0);
+  _screening_static.resize(0, 0);
+  _screening.clear();
+  _screening.shrink_to_fit();
+}
+
+Eigen::MatrixXd ImaginaryAxisIntegration::CalcScreening(
+    const Eigen::MatrixXd& eps) const {
+  const Index size = eps.rows();
+  return Eigen::MatrixXd::Identity(size, size) -
+         eps.llt().solve(Eigen::MatrixXd::Identity(size, size));
+}
+
+Eigen::MatrixXd ImaginaryAxisIntegration::CalcKernel(
+    const Eigen::MatrixXd& Mmn1, const Eigen::MatrixXd& Mmn2) const {
+  return CalcKernels(Mmn1, {&Mmn2})[0];
+}
+
+std::vector<Eigen::MatrixXd> ImaginaryAxisIntegration::CalcKernels(
+    const Eigen::MatrixXd& Mmn1,
+    const std::vector<const Eigen::MatrixXd*>& Mmn2) const {
+  const Index columns = Index(_screening.size());
+  std::vector<Eigen::MatrixXd> kernels(
+      Mmn2.size(), Eigen::MatrixXd(Mmn1.rows(), columns + 1));
+  Eigen::MatrixXd screened = Mmn1 * _screening_static;
+  for (Index i = 0; i < Index(Mmn2.size()); i++) {
+    kernels[i].col(0) =
+        0.25 * screened.cwiseProduct(*Mmn2[i]).rowwise().sum();
+  }
+  for (Index k = 0; k < columns; k++) {
+    screened.noalias() = Mmn1 * _screening[k];
+    for (Index i = 0; i < Index(Mmn2.size()); i++) {
+      kernels[i].col(k + 1) =
+          0.25 * screened.cwiseProduct(*Mmn2[i]).rowwise().sum() -
+          kernels[i].col(0);
+    }
+  }
+  return kernels;
+}
+
+// int_0^inf dt 2 omega/pi W(it)/(t^2+omega^2). W at the peak of the
+// lorentzian, t=0 for real omega, is integrated analytically, so the
+// remaining integrand is smooth.
+double ImaginaryAxisIntegration::PoleSum(
+    const Eigen::Ref<const Eigen::RowVectorXd>& kernel, double omega) const {
+  const Index order = _gridpoints.size();
+  const Eigen::ArrayXd t2 = _gridpoints.array().square();
+  double integral = (kernel.segment(1, order).transpose().array() *
+                     _weights.array() / (t2 + omega * omega))
+                        .sum();
+  integral *= 2.0 * omega / boost::math::constants::pi<double>();
+  return (omega < 0.0) ? integral - kernel(0) : integral + kernel(0);
+}
+
+// For complex omega=a+ib the lorentzian has width |a| around t=|b|, which
+// no fixed grid resolves. W(it)-W(0) is therefore interpolated linearly
+// between the gridpoints and integrated analytically against
+// 1/(t^2+omega^2)=(1/(t-i omega)-1/(t+i omega))/(2i omega). Beyond the last
+// gridpoint W decays as 1/t^2. Neither logarithm crosses its branch cut for
+// a!=0.
+std::complex<double> ImaginaryAxisIntegration::PoleSum(
+    const Eigen::Ref<const Eigen::RowVectorXd>& kernel,
+    std::complex<double> omega) const {
+  const std::complex<double> i_omega(-omega.imag(), omega.real());
+  // antiderivatives of 1/(t^2+omega^2) and t/(t^2+omega^2)
+  auto int0 = [&](double t) {
+    return (std::log(t - i_omega) - std::log(t + i_omega)) / (2.0 * i_omega);
+  };
+  auto int1 = [&](double t) {
+    return 0.5 * (std::log(t - i_omega) + std::log(t + i_omega));
+  };
+  const Index order = _gridpoints.size();
+  std::complex<double> integral = 0.0;
+  double t_lower = 0.0;
+  double f_lower = 0.0;
+  std::complex<double> int0_lower = int0(t_lower);
+  std::complex<double> int1_lower = int1(t_lower);
+  for (Index k = 0; k < order; k++) {
+    const double t_upper = _gridpoints(k);
+    const double f_upper = kernel(k + 1);
+    const std::complex<double> int0_upper = int0(t_upper);
+    const std::complex<double> int1_upper = int1(t_upper);
+    const double slope = (f_upper - f_lower) / (t_upper - t_lower);
+    integral += (f_lower - slope * t_lower) * (int0_upper - int0_lower) +
+                slope * (int1_upper - int1_lower);
+    t_lower = t_upper;
+    f_lower = f_upper;
+    int0_lower = int0_upper;
+    int1_lower = int1_upper;
+  }
+  // W(it) ~ W(it_N) t_N^2/t^2 for t>t_N
+  const std::complex<double> tail0 = -int0_lower;
+  const std::complex<double> tail2 =
+      (1.0 / t_lower - tail0) / (omega * omega);
+  const double w_last = f_lower + kernel(0);
+  integral += -kernel(0) * tail0 + w_last * t_lower * t_lower * tail2;
+  integral *= 2.0 * omega / boost::math::constants::pi<double>();
+  return (omega.real() < 0.0) ? integral - kernel(0) : integral + kernel(0);
+}
+
+double ImaginaryAxisIntegration::PoleSumDerivative(
+    const Eigen::Ref<const Eigen::RowVectorXd>& kernel, double omega) const {
+  const Index order = _gridpoints.size();
+  const Eigen::ArrayXd t2 = _gridpoints.array().square();
+  const double omega2 = omega * omega;
+  const Eigen::ArrayXd factor = (t2 - omega2) / (t2 + omega2).square();
+  double integral = (kernel.segment(1, order).transpose().array() *
+                     _weights.array() * factor)
+                        .sum();
+  return 2 * integral / boost::math::constants::pi<double>();
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -0,0 +1,65 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Local VOTCA includes
+#include "votca/xtp/padeapprox.h"
+
+namespace votca {
+namespace xtp {
+
+void PadeApprox::Fit(const Eigen::VectorXcd& points,
+                     const Eigen::VectorXcd& values) {
+  const Index size = points.size();
+  _points = points;
+  _coeffs = Eigen::VectorXcd(size);
+  // g(p,i) is stored in place, the recursion only needs row p-1
+  Eigen::VectorXcd g = values;
+  _coeffs(0) = g(0);
+  for (Index p = 1; p < size; p++) {
+    for (Index i = p; i < size; i++) {
+      g(i) = (g(p - 1) - g(i)) / ((points(i) - points(p - 1)) * g(i));
+    }
+    _coeffs(p) = g(p);
+  }
+}
+
+// C(z)=a_0/(1+a_1(z-z_0)/(1+a_2(z-z_1)/(1+...))) evaluated from the tail
+std::complex<double> PadeApprox::value(std::complex<double> frequency) const {
+  std::complex<double> tail = 1.0;
+  for (Index p = _coeffs.size() - 1; p > 0; p--) {
+    tail = 1.0 + _coeffs(p) * (frequency - _points(p - 1)) / tail;
+  }
+  return _coeffs(0) / tail;
+}
+
+std::complex<double> PadeApprox::derivative(
+    std::complex<double> frequency) const {
+  std::complex<double> tail = 1.0;
+  std::complex<double> dtail = 0.0;
+  for (Index p = _coeffs.size() - 1; p > 0; p--) {
+    const std::complex<double> numerator =
+        _coeffs(p) * (frequency - _points(p - 1));
+    dtail = (_coeffs(p) * tail - numerator * dtail) / (tail * tail);
+    tail = 1.0 + numerator / tail;
+  }
+  return -_coeffs(0) * dtail / (tail * tail);
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -28,9 +28,13 @@ namespace xtp {
 
 void PPM::PPM_construct_parameters(const RPA& rpa) {
 
+  // both dielectric matrices in one pass over Mmn
+  std::vector<Eigen::MatrixXd> epsilon =
+      rpa.calculate_epsilon(Eigen::VectorXd::Constant(1, screening_r),
+                            Eigen::VectorXd::Constant(1, screening_i));
+
   // Solve Eigensystem
-  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(
-      rpa.calculate_epsilon_r(screening_r));
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(epsilon[0]);
   _ppm_phi = es.eigenvectors();
 
   // store PPM weights from eigenvalues
@@ -38,8 +42,7 @@ void PPM::PPM_construct_parameters(const RPA& rpa) {
 
   // a) phi^t * epsilon(1) * phi e.g. transform epsilon(1) to the same space as
   // epsilon(0)
-  Eigen::MatrixXd ortho =
-      _ppm_phi.transpose() * rpa.calculate_epsilon_i(screening_i) * _ppm_phi;
+  Eigen::MatrixXd ortho = _ppm_phi.transpose() * epsilon[1] * _ppm_phi;
   Eigen::MatrixXd epsilon_1_inv = ortho.inverse();
   // determine PPM frequencies
   _ppm_freq.resize(es.eigenvalues().size());
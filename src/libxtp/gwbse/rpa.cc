@@ -54,43 +54,106 @@ void RPA::UpdateRPAInputEnergies(const Eigen::VectorXd& dftenergies,
       max_correction_virt;
 }
 
-template <bool imag>
-Eigen::MatrixXd RPA::calculate_epsilon(double frequency) const {
+// Every occupied level is read once and added to all frequencies. Only the
+// lower triangle is accumulated, split into column panels, so that threads
+// write to disjoint blocks and need no private copies of epsilon. Levels are
+// stacked into tiles, which gives each (frequency, panel) task a larger GEMM
+// and needs one parallel region per tile instead of one per level.
+std::vector<Eigen::MatrixXd> RPA::calculate_epsilon(
+    const Eigen::VectorXd& real_frequencies,
+    const Eigen::VectorXd& imaginary_frequencies) const {
   const Index size = _Mmn.auxsize();
+  const Index n_real = real_frequencies.size();
+  const Index n_freq = n_real + imaginary_frequencies.size();
 
-  Eigen::MatrixXd result = Eigen::MatrixXd::Identity(size, size);
+  std::vector<Eigen::MatrixXd> result(n_freq,
+                                      Eigen::MatrixXd::Identity(size, size));
 
   const Index lumo = _homo + 1;
   const Index n_occ = lumo - _rpamin;
   const Index n_unocc = _rpamax - lumo + 1;
-  const double freq2 = frequency * frequency;
   const double eta2 = _eta * _eta;
-#pragma omp parallel for schedule(dynamic) reduction(+ : result)
+  const Index n_panels = (size + _panelsize - 1) / _panelsize;
+  const Index tile =
+      std::max(Index(1), _tilerows / std::max(Index(1), n_unocc));
+
+  for (Index m_start = 0; m_start < n_occ; m_start += tile) {
+    const Index n_levels = std::min(tile, n_occ - m_start);
+    Eigen::MatrixXd Mmn_RPA(n_levels * n_unocc, size);
+    Eigen::MatrixXd denom(n_levels * n_unocc, n_freq);
+#pragma omp parallel for
+    for (Index i = 0; i < n_levels; i++) {
+      const Index m_level = m_start + i;
+      Mmn_RPA.middleRows(i * n_unocc, n_unocc) =
+          _Mmn[m_level].bottomRows(n_unocc);
+      const Eigen::ArrayXd deltaE =
+          _energies.tail(n_unocc).array() - _energies(m_level);
+      for (Index f = 0; f < n_real; f++) {
+        const double frequency = real_frequencies(f);
+        Eigen::ArrayXd deltEf = deltaE - frequency;
+        Eigen::ArrayXd sum = deltEf / (deltEf.square() + eta2);
+        deltEf = deltaE + frequency;
+        sum += deltEf / (deltEf.square() + eta2);
+        denom.block(i * n_unocc, f, n_unocc, 1) = 2 * sum;
+      }
+      for (Index f = n_real; f < n_freq; f++) {
+        const double freq2 = imaginary_frequencies(f - n_real) *
+                             imaginary_frequencies(f - n_real);
+        denom.block(i * n_unocc, f, n_unocc, 1) =
+            4 * deltaE / (deltaE.square() + freq2);
+      }
+    }
+#pragma omp parallel for schedule(dynamic)
+    for (Index task = 0; task < n_freq * n_panels; task++) {
+      const Index f = task / n_panels;
+      const Index start = (task % n_panels) * _panelsize;
+      const Index width = std::min(_panelsize, size - start);
+      result[f].block(start, start, size - start, width).noalias() +=
+          Mmn_RPA.rightCols(size - start).transpose() *
+          (denom.col(f).asDiagonal() * Mmn_RPA.middleCols(start, width));
+    }
+  }
+
+#pragma omp parallel for
+  for (Index f = 0; f < n_freq; f++) {
+    result[f].triangularView<Eigen::StrictlyUpper>() =
+        result[f].transpose();
+  }
+  return result;
+}
+
+Eigen::MatrixXcd RPA::calculate_epsilon_complex(
+    std::complex<double> frequency) const {
+  const Index size = _Mmn.auxsize();
+
+  Eigen::MatrixXd real = Eigen::MatrixXd::Identity(size, size);
+  Eigen::MatrixXd imag = Eigen::MatrixXd::Zero(size, size);
+
+  const Index lumo = _homo + 1;
+  const Index n_occ = lumo - _rpamin;
+  const Index n_unocc = _rpamax - lumo + 1;
+#pragma omp parallel for schedule(dynamic) reduction(+ : real, imag)
   for (Index m_level = 0; m_level < n_occ; m_level++) {
     const double qp_energy_m = _energies(m_level);
 
     const Eigen::MatrixXd Mmn_RPA = _Mmn[m_level].bottomRows(n_unocc);
 
-    const Eigen::ArrayXd deltaE = _energies.tail(n_unocc).array() - qp_energy_m;
-    Eigen::VectorXd denom;
-    if (imag) {
-      denom = 4 * deltaE / (deltaE.square() + freq2);
-    } else {
-      Eigen::ArrayXd deltEf = deltaE - frequency;
-      Eigen::ArrayXd sum = deltEf / (deltEf.square() + eta2);
-      deltEf = deltaE + frequency;
-      sum += deltEf / (deltEf.square() + eta2);
-      denom = 2 * sum;
-    }
-    result += Mmn_RPA.transpose() * denom.asDiagonal() * Mmn_RPA;
+    const Eigen::ArrayXcd deltaE =
+        (_energies.tail(n_unocc).array() - qp_energy_m)
+            .cast<std::complex<double>>();
+    const Eigen::ArrayXcd denom =
+        2.0 * ((deltaE - frequency).inverse() + (deltaE + frequency).inverse());
+    const Eigen::VectorXd denom_real = denom.real();
+    const Eigen::VectorXd denom_imag = denom.imag();
+    real += Mmn_RPA.transpose() * denom_real.asDiagonal() * Mmn_RPA;
+    imag += Mmn_RPA.transpose() * denom_imag.asDiagonal() * Mmn_RPA;
   }
-
+  Eigen::MatrixXcd result(size, size);
+  result.real() = real;
+  result.imag() = imag;
   return result;
 }
 
-template Eigen::MatrixXd RPA::calculate_epsilon<true>(double frequency) const;
-template Eigen::MatrixXd RPA::calculate_epsilon<false>(double frequency) const;
-
 RPA::rpa_eigensolution RPA::Diagonalize_H2p() const {
   const Index lumo = _homo + 1;
   const Index n_occ = lumo - _rpamin;
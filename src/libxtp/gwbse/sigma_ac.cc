@@ -0,0 +1,195 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Standard includes
+#include <algorithm>
+
+// Local VOTCA includes
+#include "votca/xtp/logger.h"
+#include "votca/xtp/rpa.h"
+#include "votca/xtp/sigma_ac.h"
+#include "votca/xtp/threecenter.h"
+
+namespace votca {
+namespace xtp {
+
+void Sigma_AC::PrepareScreening() {
+  const Eigen::VectorXd& energies = _rpa.getRPAInputEnergies();
+  const Index homo = _opt.homo - _opt.rpamin;
+  _fermi_level = 0.5 * (energies(homo) + energies(homo + 1));
+
+  // fit points concentrated at small nu, where sigma varies most
+  _fitpoints = Eigen::VectorXcd(_fit_points);
+  for (Index j = 0; j < _fit_points; j++) {
+    double x = 0.8 * double(j) / double(_fit_points);
+    _fitpoints(j) = std::complex<double>(_fermi_level, 0.5 * x / (1 - x));
+  }
+
+  // The interpolation error of the imaginary axis integral goes as
+  // 1/order^2, so successive doublings are Richardson extrapolated.
+  std::vector<Eigen::VectorXcd> sigma(_qptotal);
+  std::vector<Eigen::VectorXcd> extrapolated(_qptotal);
+  Index order = _min_order;
+  _fine = 0;
+  _grids[_fine].configure(order);
+#pragma omp parallel for schedule(dynamic)
+  for (Index gw_level = 0; gw_level < _qptotal; gw_level++) {
+    sigma[gw_level] =
+        CalcImaginaryAxisSigma(_grids[_fine], gw_level, gw_level);
+  }
+  bool first = true;
+  double diff = 0.0;
+  while (order < _max_order) {
+    order *= 2;
+    _fine = 1 - _fine;
+    _grids[_fine].configure(order);
+    diff = 0.0;
+#pragma omp parallel for schedule(dynamic) reduction(max : diff)
+    for (Index gw_level = 0; gw_level < _qptotal; gw_level++) {
+      Eigen::VectorXcd sigma_new =
+          CalcImaginaryAxisSigma(_grids[_fine], gw_level, gw_level);
+      Eigen::VectorXcd extrapolated_new =
+          (4.0 * sigma_new - sigma[gw_level]) / 3.0;
+      if (!first) {
+        diff = std::max(diff, (extrapolated_new - extrapolated[gw_level])
+                                  .cwiseAbs()
+                                  .maxCoeff());
+      }
+      sigma[gw_level] = sigma_new;
+      extrapolated[gw_level] = extrapolated_new;
+    }
+    if (!first && diff < _opt.quadrature_tolerance) {
+      break;
+    }
+    first = false;
+  }
+  _order = order;
+  Logger& log = _rpa.getLogger();
+  if (diff < _opt.quadrature_tolerance) {
+    XTP_LOG(Log::info, log)
+        << TimeStamp() << " Sigma_AC quadrature converged at order " << order
+        << ", change " << diff << std::flush;
+  } else {
+    XTP_LOG(Log::error, log)
+        << TimeStamp() << " WARNING! Sigma_AC quadrature not converged at "
+        << "maximal order " << order << ", change " << diff
+        << " above quadrature_tolerance " << _opt.quadrature_tolerance
+        << std::flush;
+  }
+
+  _pade = std::vector<PadeApprox>(_qptotal);
+  for (Index gw_level = 0; gw_level < _qptotal; gw_level++) {
+    _pade[gw_level].Fit(_fitpoints, extrapolated[gw_level]);
+  }
+  // the off-diagonal elements need both grids, afterwards the screening is
+  // no longer needed
+  FitOffDiag();
+  _grids[0].clear();
+  _grids[1].clear();
+}
+
+void Sigma_AC::FitOffDiag() {
+  const Index qpoffset = _opt.qpmin - _opt.rpamin;
+  _pade_offdiag = std::vector<PadeApprox>((_qptotal * (_qptotal - 1)) / 2);
+#pragma omp parallel for schedule(dynamic)
+  for (Index gw_level1 = 0; gw_level1 < _qptotal; gw_level1++) {
+    const Eigen::MatrixXd& Mmn1 = _Mmn[gw_level1 + qpoffset];
+    for (Index start = gw_level1 + 1; start < _qptotal;
+         start += _kernel_batch) {
+      const Index batch = std::min(_kernel_batch, _qptotal - start);
+      std::vector<const Eigen::MatrixXd*> Mmn2;
+      for (Index gw_level2 = start; gw_level2 < start + batch; gw_level2++) {
+        Mmn2.push_back(&_Mmn[gw_level2 + qpoffset]);
+      }
+      const std::vector<Eigen::MatrixXd> kernels_fine =
+          _grids[_fine].CalcKernels(Mmn1, Mmn2);
+      const std::vector<Eigen::MatrixXd> kernels_coarse =
+          _grids[1 - _fine].CalcKernels(Mmn1, Mmn2);
+      for (Index i = 0; i < batch; i++) {
+        const Eigen::VectorXcd sigma =
+            (4.0 * CalcImaginaryAxisSigma(_grids[_fine], kernels_fine[i]) -
+             CalcImaginaryAxisSigma(_grids[1 - _fine], kernels_coarse[i])) /
+            3.0;
+        _pade_offdiag[PairIndex(gw_level1, start + i)].Fit(_fitpoints, sigma);
+      }
+    }
+  }
+}
+
+// Sigma(z)=Sum_m Sum_s r_s^2/(z-e_m+-Omega_s) at the fit points. For
+// Re(z) in the gap the imaginary axis integral needs no residues.
+Eigen::VectorXcd Sigma_AC::CalcImaginaryAxisSigma(
+    const ImaginaryAxisIntegration& grid, Index gw_level1,
+    Index gw_level2) const {
+  const Index qpoffset = _opt.qpmin - _opt.rpamin;
+  return CalcImaginaryAxisSigma(
+      grid, grid.CalcKernel(_Mmn[gw_level1 + qpoffset],
+                            _Mmn[gw_level2 + qpoffset]));
+}
+
+Eigen::VectorXcd Sigma_AC::CalcImaginaryAxisSigma(
+    const ImaginaryAxisIntegration& grid, const Eigen::MatrixXd& kernel) const {
+  const Eigen::VectorXd& energies = _rpa.getRPAInputEnergies();
+  const Index n_occ = _opt.homo - _opt.rpamin + 1;
+  Eigen::VectorXcd result = Eigen::VectorXcd::Zero(_fitpoints.size());
+  for (Index j = 0; j < _fitpoints.size(); j++) {
+    const std::complex<double> z = _fitpoints(j);
+    for (Index m = 0; m < n_occ; m++) {
+      result(j) += grid.PoleSum(kernel.row(m), z - energies(m));
+    }
+    for (Index m = n_occ; m < _rpatotal; m++) {
+      result(j) -= grid.PoleSum(kernel.row(m), energies(m) - z);
+    }
+  }
+  // Multiply with factor 2.0 to sum over both (identical) spin states
+  return 2.0 * result;
+}
+
+double Sigma_AC::CalcCorrelationDiagElement(Index gw_level,
+                                            double frequency) const {
+  return _pade[gw_level]
+      .value(std::complex<double>(frequency, _opt.eta))
+      .real();
+}
+
+double Sigma_AC::CalcCorrelationDiagElementDerivative(Index gw_level,
+                                                      double frequency) const {
+  return _pade[gw_level]
+      .derivative(std::complex<double>(frequency, _opt.eta))
+      .real();
+}
+
+double Sigma_AC::CalcCorrelationOffDiagElement(Index gw_level1,
+                                               Index gw_level2,
+                                               double frequency1,
+                                               double frequency2) const {
+  if (gw_level1 == gw_level2) {
+    return 0.5 * (CalcCorrelationDiagElement(gw_level1, frequency1) +
+                  CalcCorrelationDiagElement(gw_level1, frequency2));
+  }
+  const PadeApprox& pade =
+      _pade_offdiag[PairIndex(std::min(gw_level1, gw_level2),
+                              std::max(gw_level1, gw_level2))];
+  return 0.5 * (pade.value(std::complex<double>(frequency1, _opt.eta)) +
+                pade.value(std::complex<double>(frequency2, _opt.eta)))
+                   .real();
+}
+
+}  // namespace xtp
+}  // namespace votca
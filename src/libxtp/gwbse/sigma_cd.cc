@@ -0,0 +1,295 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Standard includes
+#include <algorithm>
+#include <limits>
+
+// Local VOTCA includes
+#include "votca/xtp/logger.h"
+#include "votca/xtp/rpa.h"
+#include "votca/xtp/sigma_cd.h"
+#include "votca/xtp/threecenter.h"
+
+namespace votca {
+namespace xtp {
+
+void Sigma_CD::SetupGrid(Index order) {
+  _grid.configure(order);
+  _kernel.resize(_qptotal);
+#pragma omp parallel for schedule(dynamic)
+  for (Index gw_level = 0; gw_level < _qptotal; gw_level++) {
+    _kernel[gw_level] = CalcKernel(gw_level, gw_level);
+  }
+}
+
+Eigen::MatrixXd Sigma_CD::CalcKernel(Index gw_level1, Index gw_level2) const {
+  const Index qpoffset = _opt.qpmin - _opt.rpamin;
+  return _grid.CalcKernel(_Mmn[gw_level1 + qpoffset],
+                          _Mmn[gw_level2 + qpoffset]);
+}
+
+void Sigma_CD::PrepareScreening() {
+  // the RPA energies change between GW iterations
+  _residue_cache = std::vector<ResidueSolutions>(OPENMP::getMaxThreads());
+  Index order = _min_order;
+  SetupGrid(order);
+  Eigen::VectorXd sigma = CalcImaginaryAxisDiag();
+  // the residues do not depend on the grid, so only the integral is checked
+  double diff = std::numeric_limits<double>::max();
+  while (order < _max_order) {
+    order *= 2;
+    SetupGrid(order);
+    Eigen::VectorXd sigma_new = CalcImaginaryAxisDiag();
+    diff = (sigma_new - sigma).cwiseAbs().maxCoeff();
+    sigma = sigma_new;
+    if (diff < _opt.quadrature_tolerance) {
+      break;
+    }
+  }
+  Logger& log = _rpa.getLogger();
+  if (diff < _opt.quadrature_tolerance) {
+    XTP_LOG(Log::info, log)
+        << TimeStamp() << " Sigma_CD quadrature converged at order " << order
+        << ", change " << diff << std::flush;
+  } else {
+    XTP_LOG(Log::error, log)
+        << TimeStamp() << " WARNING! Sigma_CD quadrature not converged at "
+        << "maximal order " << order << ", change " << diff
+        << " above quadrature_tolerance " << _opt.quadrature_tolerance
+        << std::flush;
+  }
+}
+
+Eigen::VectorXd Sigma_CD::CalcImaginaryAxisDiag() const {
+  const Eigen::VectorXd& energies = _rpa.getRPAInputEnergies();
+  const Index qpoffset = _opt.qpmin - _opt.rpamin;
+  Eigen::VectorXd result = Eigen::VectorXd::Zero(_qptotal);
+  for (Index gw_level = 0; gw_level < _qptotal; gw_level++) {
+    result(gw_level) = CalcImaginaryAxis(
+        _kernel[gw_level], energies(gw_level + qpoffset), false);
+  }
+  return 2 * result;
+}
+
+// The exact RPA self-energy Sum_m Sum_s r_s^2/(w-e_m+-Omega_s+i eta) written
+// per level m as +-F(+-(w-e_m)) with F(omega)=Sum_s r_s^2/(omega+Omega_s).
+// This is the imaginary axis integral of F, for omega<0 the residues are
+// missing.
+double Sigma_CD::CalcImaginaryAxis(const Eigen::MatrixXd& kernel,
+                                   double frequency, bool derivative) const {
+  const Eigen::VectorXd& energies = _rpa.getRPAInputEnergies();
+  const Index n_occ = _opt.homo - _opt.rpamin + 1;
+  double sigma = 0.0;
+  for (Index m = 0; m < _rpatotal; m++) {
+    const bool occupied = m < n_occ;
+    const double omega =
+        occupied ? frequency - energies(m) : energies(m) - frequency;
+    double value = derivative ? _grid.PoleSumDerivative(kernel.row(m), omega)
+                              : _grid.PoleSum(kernel.row(m), omega);
+    if (!occupied && !derivative) {
+      value = -value;
+    }
+    sigma += value;
+  }
+  return sigma;
+}
+
+// The Green's function poles m between frequency and the Fermi level, i.e.
+// omega<0, need eps at -omega+i eta. eps is built and factorised once per
+// distinct pole, levels with the same energy share it.
+void Sigma_CD::SolveResidues(const Eigen::MatrixXd& Mmn, double frequency,
+                             ResidueSolutions& result) const {
+  const Eigen::VectorXd& energies = _rpa.getRPAInputEnergies();
+  const Index n_occ = _opt.homo - _opt.rpamin + 1;
+  result.levels.clear();
+  result.solutions.clear();
+  for (Index m = 0; m < _rpatotal; m++) {
+    const double omega =
+        (m < n_occ) ? frequency - energies(m) : energies(m) - frequency;
+    if (omega < 0.0) {
+      result.levels.push_back(m);
+    }
+  }
+  std::stable_sort(
+      result.levels.begin(), result.levels.end(),
+      [&energies](Index a, Index b) { return energies(a) < energies(b); });
+  Index start = 0;
+  while (start < Index(result.levels.size())) {
+    const double energy = energies(result.levels[start]);
+    const std::complex<double> z(std::abs(frequency - energy), _opt.eta);
+    Eigen::PartialPivLU<Eigen::MatrixXcd> lu(_rpa.calculate_epsilon_complex(z));
+    for (; start < Index(result.levels.size()) &&
+           energies(result.levels[start]) == energy;
+         start++) {
+      const Index m = result.levels[start];
+      result.solutions.push_back(
+          lu.solve(Mmn.row(m).transpose().cast<std::complex<double>>()));
+    }
+  }
+}
+
+const Sigma_CD::ResidueSolutions& Sigma_CD::getResidueSolutions(
+    Index gw_level, double frequency) const {
+  ResidueSolutions& cache = _residue_cache[OPENMP::getThreadId()];
+  if (cache.gw_level != gw_level || cache.frequency != frequency) {
+    const Index qpoffset = _opt.qpmin - _opt.rpamin;
+    SolveResidues(_Mmn[gw_level + qpoffset], frequency, cache);
+    cache.gw_level = gw_level;
+    cache.frequency = frequency;
+  }
+  return cache;
+}
+
+// Derivative of 1/2 M^T (1-eps^-1(-omega+i eta)) M with respect to omega
+// from solution=eps^-1 M. d/domega = -d/dz and
+// d(1-eps^-1)/dz = eps^-1 deps/dz eps^-1
+double Sigma_CD::ResidueDerivative(const Eigen::VectorXcd& solution,
+                                   double omega) const {
+  const std::complex<double> z(-omega, _opt.eta);
+  const Eigen::VectorXd& energies = _rpa.getRPAInputEnergies();
+  const Index n_occ = _opt.homo - _opt.rpamin + 1;
+  const Index n_unocc = _opt.rpamax - _opt.homo;
+  std::complex<double> deps = 0.0;
+  for (Index v = 0; v < n_occ; v++) {
+    const Eigen::MatrixXd Mmn_v = _Mmn[v].bottomRows(n_unocc);
+    const Eigen::ArrayXcd deltaE =
+        (energies.tail(n_unocc).array() - energies(v))
+            .cast<std::complex<double>>();
+    const Eigen::ArrayXcd ddenom =
+        2.0 *
+        ((deltaE - z).square().inverse() - (deltaE + z).square().inverse());
+    const Eigen::ArrayXcd p = Mmn_v * solution;
+    deps += (ddenom * p.square()).sum();
+  }
+  return -0.5 * deps.real();
+}
+
+// Difference between Sum_s |r_s|^2/(omega+Omega_s) and the imaginary axis
+// integral for omega<0, i.e. 1/2 M^T (1-eps^-1(-omega+i eta)) M, summed
+// like CalcImaginaryAxis
+double Sigma_CD::CalcResidues(Index gw_level, double frequency,
+                              bool derivative) const {
+  const Eigen::VectorXd& energies = _rpa.getRPAInputEnergies();
+  const Index n_occ = _opt.homo - _opt.rpamin + 1;
+  const Index qpoffset = _opt.qpmin - _opt.rpamin;
+  const Eigen::MatrixXd& Mmn = _Mmn[gw_level + qpoffset];
+  const ResidueSolutions& residues = getResidueSolutions(gw_level, frequency);
+  double sigma = 0.0;
+  for (Index i = 0; i < Index(residues.levels.size()); i++) {
+    const Index m = residues.levels[i];
+    const bool occupied = m < n_occ;
+    if (derivative) {
+      const double omega =
+          occupied ? frequency - energies(m) : energies(m) - frequency;
+      sigma += ResidueDerivative(residues.solutions[i], omega);
+    } else {
+      const double value =
+          0.5 * (Mmn.row(m).squaredNorm() -
+                 residues.solutions[i].real().dot(Mmn.row(m).transpose()));
+      sigma += occupied ? value : -value;
+    }
+  }
+  return sigma;
+}
+
+// Residues of gw_level at frequency with every level, eps is symmetric, so
+// M1^T eps^-1 M2 only needs the solutions of gw_level
+Eigen::VectorXd Sigma_CD::CalcResidueRow(Index gw_level,
+                                         double frequency) const {
+  const Index n_occ = _opt.homo - _opt.rpamin + 1;
+  const Index qpoffset = _opt.qpmin - _opt.rpamin;
+  const Eigen::MatrixXd& Mmn1 = _Mmn[gw_level + qpoffset];
+  const ResidueSolutions& residues = getResidueSolutions(gw_level, frequency);
+  Eigen::VectorXd row = Eigen::VectorXd::Zero(_qptotal);
+  for (Index i = 0; i < Index(residues.levels.size()); i++) {
+    const Index m = residues.levels[i];
+    const double sign = (m < n_occ) ? 1.0 : -1.0;
+    const Eigen::VectorXd solution = residues.solutions[i].real();
+    for (Index gw_level2 = 0; gw_level2 < _qptotal; gw_level2++) {
+      const Eigen::MatrixXd& Mmn2 = _Mmn[gw_level2 + qpoffset];
+      row(gw_level2) += sign * 0.5 *
+                        (Mmn1.row(m).dot(Mmn2.row(m)) -
+                         solution.dot(Mmn2.row(m).transpose()));
+    }
+  }
+  return row;
+}
+
+double Sigma_CD::CalcCorrelationDiagElement(Index gw_level,
+                                            double frequency) const {
+  // Multiply with factor 2.0 to sum over both (identical) spin states
+  return 2.0 * (CalcImaginaryAxis(_kernel[gw_level], frequency, false) +
+                CalcResidues(gw_level, frequency, false));
+}
+
+double Sigma_CD::CalcCorrelationDiagElementDerivative(Index gw_level,
+                                                      double frequency) const {
+  return 2.0 * (CalcImaginaryAxis(_kernel[gw_level], frequency, true) +
+                CalcResidues(gw_level, frequency, true));
+}
+
+double Sigma_CD::CalcCorrelationOffDiagElement(Index gw_level1,
+                                               Index gw_level2,
+                                               double frequency1,
+                                               double frequency2) const {
+  const Eigen::MatrixXd kernel = CalcKernel(gw_level1, gw_level2);
+  // the mean of the elements at both frequencies, times 2 for the spin
+  return CalcImaginaryAxis(kernel, frequency1, false) +
+         CalcImaginaryAxis(kernel, frequency2, false) +
+         CalcResidueRow(gw_level1, frequency1)(gw_level2) +
+         CalcResidueRow(gw_level2, frequency2)(gw_level1);
+}
+
+Eigen::MatrixXd Sigma_CD::CalcCorrelationOffDiag(
+    const Eigen::VectorXd& frequencies) const {
+  const Index qpoffset = _opt.qpmin - _opt.rpamin;
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
+  // row gw_level1 holds the residues at frequencies[gw_level1]
+  Eigen::MatrixXd residues = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
+#pragma omp parallel for schedule(dynamic)
+  for (Index gw_level1 = 0; gw_level1 < _qptotal; gw_level1++) {
+    residues.row(gw_level1) =
+        CalcResidueRow(gw_level1, frequencies[gw_level1]).transpose();
+    const Eigen::MatrixXd& Mmn1 = _Mmn[gw_level1 + qpoffset];
+    for (Index start = gw_level1 + 1; start < _qptotal;
+         start += _kernel_batch) {
+      const Index batch = std::min(_kernel_batch, _qptotal - start);
+      std::vector<const Eigen::MatrixXd*> Mmn2;
+      for (Index gw_level2 = start; gw_level2 < start + batch; gw_level2++) {
+        Mmn2.push_back(&_Mmn[gw_level2 + qpoffset]);
+      }
+      const std::vector<Eigen::MatrixXd> kernels =
+          _grid.CalcKernels(Mmn1, Mmn2);
+      for (Index i = 0; i < batch; i++) {
+        const Index gw_level2 = start + i;
+        result(gw_level2, gw_level1) =
+            CalcImaginaryAxis(kernels[i], frequencies[gw_level1], false) +
+            CalcImaginaryAxis(kernels[i], frequencies[gw_level2], false);
+      }
+    }
+  }
+  result = result.selfadjointView<Eigen::Lower>();
+  result += residues + residues.transpose();
+  result.diagonal().setZero();
+  return result;
+}
+
+}  // namespace xtp
+}  // namespace votca
@@ -17,9 +17,13 @@
  *
  */
 
+// Standard includes
+#include <algorithm>
+
 // Local VOTCA includes
-#include "votca/xtp/sigma_exact.h"
+#include "votca/xtp/logger.h"
 #include "votca/xtp/rpa.h"
+#include "votca/xtp/sigma_exact.h"
 #include "votca/xtp/threecenter.h"
 #include "votca/xtp/vc2index.h"
 
@@ -28,24 +32,60 @@ namespace xtp {
 
 void Sigma_Exact::PrepareScreening() {
   _rpa_solution = _rpa.Diagonalize_H2p();
-  _residues = std::vector<Eigen::MatrixXd>(_qptotal);
+  _streamed = std::vector<StreamedResidues>(OPENMP::getMaxThreads());
+  Index stored_levels = _qptotal;
+  _batchsize = 0;
+  if (_opt.residue_memory > 0.0) {
+    const double level_memory = double(_rpatotal) *
+                                double(_rpa_solution.omega.size()) *
+                                double(sizeof(double)) / 1024.0 / 1024.0;
+    // each thread holds one streamed level for the diagonal elements and the
+    // off-diagonal elements need two batches of at least one level
+    const Index min_levels = std::max(Index(2), Index(_streamed.size()));
+    Index budget = Index(_opt.residue_memory / level_memory);
+    if (budget < min_levels) {
+      XTP_LOG(Log::error, _rpa.getLogger())
+          << TimeStamp() << " WARNING! residue_memory of "
+          << _opt.residue_memory << " MB is below the "
+          << double(min_levels) * level_memory << " MB needed for "
+          << min_levels << " levels of residues, which are used instead"
+          << std::flush;
+      budget = min_levels;
+    }
+    stored_levels = std::min(budget - min_levels, _qptotal);
+    _batchsize = std::max(Index(1), (budget - stored_levels) / 2);
+  }
+  _residues = std::vector<Eigen::MatrixXd>(stored_levels);
 #pragma omp parallel for schedule(dynamic)
-  for (Index gw_level = 0; gw_level < _qptotal; gw_level++) {
+  for (Index gw_level = 0; gw_level < stored_levels; gw_level++) {
     _residues[gw_level] = CalcResidues(gw_level);
   }
   return;
 }
 
+const Eigen::MatrixXd& Sigma_Exact::getResidues(Index gw_level) const {
+  if (gw_level < Index(_residues.size())) {
+    return _residues[gw_level];
+  }
+  StreamedResidues& streamed = _streamed[OPENMP::getThreadId()];
+  if (streamed.gw_level != gw_level) {
+    streamed.gw_level = gw_level;
+    streamed.residues = CalcResidues(gw_level);
+  }
+  return streamed.residues;
+}
+
 double Sigma_Exact::CalcCorrelationDiagElement(Index gw_level,
                                                double frequency) const {
   const double eta2 = _opt.eta * _opt.eta;
   const Index lumo = _opt.homo + 1;
   const Index n_occ = lumo - _opt.rpamin;
   const Index n_unocc = _opt.rpamax - _opt.homo;
+  const Eigen::MatrixXd& residues = getResidues(gw_level);
   double sigma = 0.0;
   for (Index s = 0; s < _rpa_solution.omega.size(); s++) {
     const double eigenvalue = _rpa_solution.omega(s);
-    const Eigen::ArrayXd res_12 = _residues[gw_level].col(s).cwiseAbs2();
+    const Eigen::ArrayXd res_12 = residues.col(s).cwiseAbs2();
     Eigen::ArrayXd temp = -_rpa.getRPAInputEnergies().array() + frequency;
     temp.segment(0, n_occ) += eigenvalue;
     temp.segment(n_occ, n_unocc) -= eigenvalue;
@@ -61,10 +101,11 @@ double Sigma_Exact::CalcCorrelationDiagElementDerivative(
   const Index lumo = _opt.homo + 1;
   const Index n_occ = lumo - _opt.rpamin;
   const Index n_unocc = _opt.rpamax - _opt.homo;
+  const Eigen::MatrixXd& residues = getResidues(gw_level);
   double dsigma_domega = 0.0;
   for (Index s = 0; s < _rpa_solution.omega.size(); s++) {
     const double eigenvalue = _rpa_solution.omega(s);
-    const Eigen::ArrayXd res_12 = _residues[gw_level].col(s).cwiseAbs2();
+    const Eigen::ArrayXd res_12 = residues.col(s).cwiseAbs2();
     Eigen::ArrayXd temp = -_rpa.getRPAInputEnergies().array() + frequency;
     temp.segment(0, n_occ) += eigenvalue;
     temp.segment(n_occ, n_unocc) -= eigenvalue;
@@ -78,6 +119,20 @@ double Sigma_Exact::CalcCorrelationOffDiagElement(Index gw_level1,
                                                   Index gw_level2,
                                                   double frequency1,
                                                   double frequency2) const {
+  const Eigen::MatrixXd& residues1 = getResidues(gw_level1);
+  // the streamed slot of the thread holds gw_level1
+  if (gw_level2 < Index(_residues.size())) {
+    return CalcOffDiagElement(residues1, _residues[gw_level2], frequency1,
+                              frequency2);
+  }
+  return CalcOffDiagElement(residues1, CalcResidues(gw_level2), frequency1,
+                            frequency2);
+}
+
+double Sigma_Exact::CalcOffDiagElement(const Eigen::MatrixXd& residues1,
+                                       const Eigen::MatrixXd& residues2,
+                                       double frequency1,
+                                       double frequency2) const {
   const double eta2 = _opt.eta * _opt.eta;
   const Index lumo = _opt.homo + 1;
   const Index n_occ = lumo - _opt.rpamin;
@@ -86,9 +141,8 @@ double Sigma_Exact::CalcCorrelationOffDiagElement(Index gw_level1,
   double sigma_c = 0.0;
   for (Index s = 0; s < rpasize; s++) {
     const double eigenvalue = _rpa_solution.omega(s);
-    const Eigen::VectorXd& res1 = _residues[gw_level1].col(s);
-    const Eigen::VectorXd& res2 = _residues[gw_level2].col(s);
-    const Eigen::VectorXd res_12 = res1.cwiseProduct(res2);
+    const Eigen::VectorXd res_12 =
+        residues1.col(s).cwiseProduct(residues2.col(s));
     Eigen::ArrayXd temp1 = -_rpa.getRPAInputEnergies().array();
     temp1.segment(0, n_occ) += eigenvalue;
     temp1.segment(n_occ, n_unocc) -= eigenvalue;
@@ -104,6 +158,73 @@ double Sigma_Exact::CalcCorrelationOffDiagElement(Index gw_level1,
   return 2.0 * sigma_c;
 }
 
+// The levels beyond the stored ones are computed in batches. All elements of
+// two batches are formed before one of them is replaced, so each batch is
+// computed once per batch before it.
+Eigen::MatrixXd Sigma_Exact::CalcCorrelationOffDiag(
+    const Eigen::VectorXd& frequencies) const {
+  Eigen::MatrixXd result = Eigen::MatrixXd::Zero(_qptotal, _qptotal);
+  const Index stored = Index(_residues.size());
+  // the memory of the streamed levels is used by the batches
+  for (StreamedResidues& streamed : _streamed) {
+    streamed = StreamedResidues();
+  }
+  std::vector<const Eigen::MatrixXd*> held(_qptotal, nullptr);
+  for (Index gw_level = 0; gw_level < stored; gw_level++) {
+    held[gw_level] = &_residues[gw_level];
+  }
+  // elements gw_level1>gw_level2 of two ranges of held levels
+  auto fill = [&](Index begin1, Index end1, Index begin2, Index end2) {
+#pragma omp parallel for schedule(dynamic)
+    for (Index gw_level1 = begin1; gw_level1 < end1; gw_level1++) {
+      for (Index gw_level2 = begin2; gw_level2 < std::min(end2, gw_level1);
+           gw_level2++) {
+        result(gw_level1, gw_level2) = CalcOffDiagElement(
+            *held[gw_level1], *held[gw_level2], frequencies[gw_level1],
+            frequencies[gw_level2]);
+      }
+    }
+  };
+  auto load = [&](std::vector<Eigen::MatrixXd>& batch, Index begin,
+                  Index end) {
+    batch.resize(end - begin);
+#pragma omp parallel for schedule(dynamic)
+    for (Index gw_level = begin; gw_level < end; gw_level++) {
+      batch[gw_level - begin] = CalcResidues(gw_level);
+    }
+    for (Index gw_level = begin; gw_level < end; gw_level++) {
+      held[gw_level] = &batch[gw_level - begin];
+    }
+  };
+
+  fill(0, stored, 0, stored);
+  std::vector<Eigen::MatrixXd> batch1;
+  std::vector<Eigen::MatrixXd> batch2;
+  bool loaded = false;
+  for (Index begin1 = stored; begin1 < _qptotal; begin1 += _batchsize) {
+    const Index end1 = std::min(begin1 + _batchsize, _qptotal);
+    if (!loaded) {
+      load(batch1, begin1, end1);
+    }
+    fill(begin1, end1, 0, stored);
+    fill(begin1, end1, begin1, end1);
+    if (end1 == _qptotal) {
+      break;
+    }
+    // the batch after batch1 comes last, so that it becomes the next batch1
+    const Index last = end1 + ((_qptotal - end1 - 1) / _batchsize) * _batchsize;
+    for (Index begin2 = last; begin2 >= end1; begin2 -= _batchsize) {
+      const Index end2 = std::min(begin2 + _batchsize, _qptotal);
+      load(batch2, begin2, end2);
+      fill(begin2, end2, begin1, end1);
+    }
+    std::swap(batch1, batch2);
+    loaded = true;
+  }
+  result = result.selfadjointView<Eigen::Lower>();
+  return result;
+}
+
 Eigen::MatrixXd Sigma_Exact::CalcResidues(Index gw_level) const {
   const Index lumo = _opt.homo + 1;
   const Index n_occ = lumo - _opt.rpamin;
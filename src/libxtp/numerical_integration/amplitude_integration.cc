@@ -31,19 +31,18 @@ std::vector<std::vector<double> >
 
   auto result = SetupAmplitudeContainer();
 
-#pragma omp parallel for schedule(guided)
+#pragma omp parallel for schedule(dynamic)
   for (Index i = 0; i < _grid.getBoxesSize(); ++i) {
     const GridBox& box = _grid[i];
     if (!box.Matrixsize()) {
       continue;
     }
     const Eigen::VectorXd amplitude_here = box.ReadFromBigVector(amplitude);
-    const std::vector<Eigen::Vector3d>& points = box.getGridPoints();
     const std::vector<double>& weights = box.getGridWeights();
+    const Eigen::VectorXd ampl = box.CalcAOValues() * amplitude_here;
     // iterate over gridpoints
     for (Index p = 0; p < box.size(); p++) {
-      Eigen::VectorXd ao = box.CalcAOValues(points[p]);
-      result[i][p] = weights[p] * amplitude_here.dot(ao);
+      result[i][p] = weights[p] * ampl(p);
     }
   }
   return result;
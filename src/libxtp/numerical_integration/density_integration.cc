@@ -73,19 +73,20 @@ double DensityIntegration<Grid>::IntegrateDensity(
   double N = 0.0;
   SetupDensityContainer();
 
-#pragma omp parallel for schedule(guided) reduction(+ : N)
+#pragma omp parallel for schedule(dynamic) reduction(+ : N)
   for (Index i = 0; i < _grid.getBoxesSize(); ++i) {
     const GridBox& box = _grid[i];
     if (!box.Matrixsize()) {
       continue;
     }
     const Eigen::MatrixXd DMAT_here = box.ReadFromBigMatrix(density_matrix);
-    const std::vector<Eigen::Vector3d>& points = box.getGridPoints();
     const std::vector<double>& weights = box.getGridWeights();
+    const Eigen::MatrixXd ao = box.CalcAOValues();
+    const Eigen::VectorXd rho_here =
+        (ao * DMAT_here).cwiseProduct(ao).rowwise().sum();
     // iterate over gridpoints
     for (Index p = 0; p < box.size(); p++) {
-      Eigen::VectorXd ao = box.CalcAOValues(points[p]);
-      double rho = (ao.transpose() * DMAT_here * ao)(0, 0) * weights[p];
+      double rho = rho_here(p) * weights[p];
       _densities[i][p] = rho;
       N += rho;
     }
@@ -101,7 +102,7 @@ Gyrationtensor DensityIntegration<Grid>::IntegrateGyrationTensor(
   Eigen::Matrix3d gyration = Eigen::Matrix3d::Zero();
 
   SetupDensityContainer();
-#pragma omp parallel for schedule(guided)reduction(+:N)reduction(+:centroid)reduction(+:gyration)
+#pragma omp parallel for schedule(dynamic)reduction(+:N)reduction(+:centroid)reduction(+:gyration)
   for (Index i = 0; i < _grid.getBoxesSize(); ++i) {
     const GridBox& box = _grid[i];
     if (!box.Matrixsize()) {
@@ -111,10 +112,12 @@ Gyrationtensor DensityIntegration<Grid>::IntegrateGyrationTensor(
     const Eigen::MatrixXd DMAT_here = box.ReadFromBigMatrix(density_matrix);
     const std::vector<Eigen::Vector3d>& points = box.getGridPoints();
     const std::vector<double>& weights = box.getGridWeights();
+    const Eigen::MatrixXd ao = box.CalcAOValues();
+    const Eigen::VectorXd rho_here =
+        (ao * DMAT_here).cwiseProduct(ao).rowwise().sum();
     // iterate over gridpoints
     for (Index p = 0; p < box.size(); p++) {
-      Eigen::VectorXd ao = box.CalcAOValues(points[p]);
-      double rho = (ao.transpose() * DMAT_here * ao).value() * weights[p];
+      double rho = rho_here(p) * weights[p];
       _densities[i][p] = rho;
       N += rho;
       centroid += rho * points[p];
@@ -30,12 +30,48 @@
 
 namespace votca {
 namespace xtp {
+
+namespace {
+// density and its gradient on all points of a box, from the symmetrised
+// block D+D^T of a density matrix
+struct BoxDensity {
+  BoxDensity(const AOValues& ao, const Eigen::MatrixXd& DMAT_symm) {
+    const Eigen::MatrixXd ao_dmat = ao.values * DMAT_symm;
+    rho = 0.5 * ao_dmat.cwiseProduct(ao.values).rowwise().sum();
+    grad_x = ao_dmat.cwiseProduct(ao.derivatives_x).rowwise().sum();
+    grad_y = ao_dmat.cwiseProduct(ao.derivatives_y).rowwise().sum();
+    grad_z = ao_dmat.cwiseProduct(ao.derivatives_z).rowwise().sum();
+  }
+  Eigen::VectorXd rho;
+  Eigen::VectorXd grad_x;
+  Eigen::VectorXd grad_y;
+  Eigen::VectorXd grad_z;
+};
+
+// potential matrix of a box up to symmetrisation, from the weighted
+// derivative of f_xc with respect to the density and the weighted vector that
+// multiplies the gradients of the basisfunctions
+Eigen::MatrixXd BoxPotential(const AOValues& ao,
+                             const Eigen::VectorXd& rho_factor,
+                             const Eigen::VectorXd& grad_factor_x,
+                             const Eigen::VectorXd& grad_factor_y,
+                             const Eigen::VectorXd& grad_factor_z) {
+  Eigen::MatrixXd addXC = rho_factor.asDiagonal() * ao.values;
+  addXC.noalias() += grad_factor_x.asDiagonal() * ao.derivatives_x;
+  addXC.noalias() += grad_factor_y.asDiagonal() * ao.derivatives_y;
+  addXC.noalias() += grad_factor_z.asDiagonal() * ao.derivatives_z;
+  return addXC.transpose() * ao.values;
+}
+}  // namespace
+
 template <class Grid>
 Vxc_Potential<Grid>::~Vxc_Potential() {
   if (_setXC) {
     xc_func_end(&xfunc);
+    xc_func_end(&xfunc_polarized);
     if (_use_separate) {
       xc_func_end(&cfunc);
+      xc_func_end(&cfunc_polarized);
     }
   }
 }
@@ -97,7 +133,8 @@ void Vxc_Potential<Grid>::setXCfunctional(const std::string& functional) {
         "functionals");
   }
 
-  if (xc_func_init(&xfunc, xfunc_id, XC_UNPOLARIZED) != 0) {
+  if (xc_func_init(&xfunc, xfunc_id, XC_UNPOLARIZED) != 0 ||
+      xc_func_init(&xfunc_polarized, xfunc_id, XC_POLARIZED) != 0) {
     throw std::runtime_error(
         (boost::format("Functional %s not found\n") % strs[0]).str());
   }
@@ -107,7 +144,8 @@ void Vxc_Potential<Grid>::setXCfunctional(const std::string& functional) {
         "another functional, separated by whitespace");
   }
   if (_use_separate) {
-    if (xc_func_init(&cfunc, cfunc_id, XC_UNPOLARIZED) != 0) {
+    if (xc_func_init(&cfunc, cfunc_id, XC_UNPOLARIZED) != 0 ||
+        xc_func_init(&cfunc_polarized, cfunc_id, XC_POLARIZED) != 0) {
       throw std::runtime_error(
           (boost::format("Functional %s not found\n") % strs[1]).str());
     }
@@ -120,34 +158,53 @@ void Vxc_Potential<Grid>::setXCfunctional(const std::string& functional) {
   return;
 }
 template <class Grid>
-typename Vxc_Potential<Grid>::XC_entry Vxc_Potential<Grid>::EvaluateXC(
-    double rho, double sigma) const {
+void Vxc_Potential<Grid>::EvaluateFunctional(const xc_func_type& func,
+                                             const Eigen::VectorXd& rho,
+                                             const Eigen::VectorXd& sigma,
+                                             XC_entry& result) const {
+  const int size = int(rho.size());
+  switch (func.info->family) {
+    case XC_FAMILY_LDA:
+      xc_lda_exc_vxc(&func, size, rho.data(), result.f_xc.data(),
+                     result.df_drho.data());
+      break;
+    case XC_FAMILY_GGA:
+    case XC_FAMILY_HYB_GGA:
+      xc_gga_exc_vxc(&func, size, rho.data(), sigma.data(), result.f_xc.data(),
+                     result.df_drho.data(), result.df_dsigma.data());
+      break;
+  }
+}
 
-  Vxc_Potential<Grid>::XC_entry result;
-  switch (xfunc.info->family) {
+template <class Grid>
+void Vxc_Potential<Grid>::EvaluateFunctional(const xc_func_type& func,
+                                             const SpinMatrix2& rho,
+                                             const SpinMatrix3& sigma,
+                                             XC_entry_polarized& result) const {
+  const int size = int(rho.rows());
+  switch (func.info->family) {
     case XC_FAMILY_LDA:
-      xc_lda_exc_vxc(&xfunc, 1, &rho, &result.f_xc, &result.df_drho);
+      xc_lda_exc_vxc(&func, size, rho.data(), result.f_xc.data(),
+                     result.df_drho.data());
       break;
     case XC_FAMILY_GGA:
     case XC_FAMILY_HYB_GGA:
-      xc_gga_exc_vxc(&xfunc, 1, &rho, &sigma, &result.f_xc, &result.df_drho,
-                     &result.df_dsigma);
+      xc_gga_exc_vxc(&func, size, rho.data(), sigma.data(), result.f_xc.data(),
+                     result.df_drho.data(), result.df_dsigma.data());
       break;
   }
+}
+
+template <class Grid>
+typename Vxc_Potential<Grid>::XC_entry Vxc_Potential<Grid>::EvaluateXC(
+    const Eigen::VectorXd& rho, const Eigen::VectorXd& sigma) const {
+
+  typename Vxc_Potential<Grid>::XC_entry result(rho.size());
+  EvaluateFunctional(xfunc, rho, sigma, result);
   if (_use_separate) {
-    typename Vxc_Potential<Grid>::XC_entry temp;
     // via libxc correlation part only
-    switch (cfunc.info->family) {
-      case XC_FAMILY_LDA:
-        xc_lda_exc_vxc(&cfunc, 1, &rho, &temp.f_xc, &temp.df_drho);
-        break;
-      case XC_FAMILY_GGA:
-      case XC_FAMILY_HYB_GGA:
-        xc_gga_exc_vxc(&cfunc, 1, &rho, &sigma, &temp.f_xc, &temp.df_drho,
-                       &temp.df_dsigma);
-        break;
-    }
-
+    typename Vxc_Potential<Grid>::XC_entry temp(rho.size());
+    EvaluateFunctional(cfunc, rho, sigma, temp);
     result.f_xc += temp.f_xc;
     result.df_drho += temp.df_drho;
     result.df_dsigma += temp.df_dsigma;
@@ -155,19 +212,36 @@ typename Vxc_Potential<Grid>::XC_entry Vxc_Potential<Grid>::EvaluateXC(
 
   return result;
 }
+
+template <class Grid>
+typename Vxc_Potential<Grid>::XC_entry_polarized
+Vxc_Potential<Grid>::EvaluateXC(const SpinMatrix2& rho,
+                                const SpinMatrix3& sigma) const {
+
+  typename Vxc_Potential<Grid>::XC_entry_polarized result(rho.rows());
+  EvaluateFunctional(xfunc_polarized, rho, sigma, result);
+  if (_use_separate) {
+    typename Vxc_Potential<Grid>::XC_entry_polarized temp(rho.rows());
+    EvaluateFunctional(cfunc_polarized, rho, sigma, temp);
+    result.f_xc += temp.f_xc;
+    result.df_drho += temp.df_drho;
+    result.df_dsigma += temp.df_dsigma;
+  }
+  return result;
+}
+
 template <class Grid>
 Mat_p_Energy Vxc_Potential<Grid>::IntegrateVXC(
     const Eigen::MatrixXd& density_matrix) const {
 
   Mat_p_Energy vxc = Mat_p_Energy(density_matrix.rows(), density_matrix.cols());
 
-#pragma omp parallel for schedule(guided) reduction(+ : vxc)
+#pragma omp parallel for schedule(dynamic) reduction(+ : vxc)
   for (Index i = 0; i < _grid.getBoxesSize(); ++i) {
     const GridBox& box = _grid[i];
     if (!box.Matrixsize()) {
       continue;
     }
-    double EXC_box = 0.0;
     const Eigen::MatrixXd DMAT_here = box.ReadFromBigMatrix(density_matrix);
     const Eigen::MatrixXd DMAT_symm = DMAT_here + DMAT_here.transpose();
     double cutoff =
@@ -175,28 +249,39 @@ Mat_p_Energy Vxc_Potential<Grid>::IntegrateVXC(
     if (DMAT_here.cwiseAbs2().maxCoeff() < cutoff) {
       continue;
     }
-    Eigen::MatrixXd Vxc_here =
-        Eigen::MatrixXd::Zero(DMAT_here.rows(), DMAT_here.cols());
-    const std::vector<Eigen::Vector3d>& points = box.getGridPoints();
-    const std::vector<double>& weights = box.getGridWeights();
 
-    // iterate over gridpoints
+    // all gridpoints of the box are treated as one batch, rows are points
+    const AOValues ao = box.getAOValues();
+    const BoxDensity density(ao, DMAT_symm);
+    const Eigen::VectorXd& rho = density.rho;
+    const Eigen::VectorXd sigma = density.grad_x.cwiseAbs2() +
+                                  density.grad_y.cwiseAbs2() +
+                                  density.grad_z.cwiseAbs2();
+
+    // skip points with very small density by zeroing their weight
+    Eigen::VectorXd weights = Eigen::Map<const Eigen::VectorXd>(
+        box.getGridWeights().data(), box.size());
     for (Index p = 0; p < box.size(); p++) {
-      Eigen::MatrixX3d ao_grad = Eigen::MatrixX3d::Zero(box.Matrixsize(), 3);
-      Eigen::VectorXd ao = box.CalcAOValue_and_Grad(ao_grad, points[p]);
-      const double rho = 0.5 * (ao.transpose() * DMAT_symm * ao).value();
-      const double weight = weights[p];
-      if (rho * weight < 1.e-20) {
-        continue;  // skip the rest, if density is very small
+      if (rho[p] * weights[p] < 1.e-20) {
+        weights[p] = 0.0;
       }
-      const Eigen::Vector3d rho_grad = ao.transpose() * DMAT_symm * ao_grad;
-      const double sigma = (rho_grad.transpose() * rho_grad).value();
-      const Eigen::VectorXd grad = ao_grad * rho_grad;
-      typename Vxc_Potential<Grid>::XC_entry xc = EvaluateXC(rho, sigma);
-      EXC_box += weight * rho * xc.f_xc;
-      auto addXC = weight * (0.5 * xc.df_drho * ao + 2.0 * xc.df_dsigma * grad);
-      Vxc_here.noalias() += addXC * ao.transpose();
     }
+    if (weights.isZero(0.0)) {
+      continue;
+    }
+
+    const typename Vxc_Potential<Grid>::XC_entry xc = EvaluateXC(rho, sigma);
+    const double EXC_box =
+        weights.cwiseProduct(rho).cwiseProduct(xc.f_xc).sum();
+
+    const Eigen::VectorXd rho_factor =
+        0.5 * weights.cwiseProduct(xc.df_drho);
+    const Eigen::VectorXd sigma_factor =
+        2.0 * weights.cwiseProduct(xc.df_dsigma);
+    Eigen::MatrixXd Vxc_here = BoxPotential(
+        ao, rho_factor, sigma_factor.cwiseProduct(density.grad_x),
+        sigma_factor.cwiseProduct(density.grad_y),
+        sigma_factor.cwiseProduct(density.grad_z));
     box.AddtoBigMatrix(vxc.matrix(), Vxc_here);
     vxc.energy() += EXC_box;
   }
@@ -204,6 +289,85 @@ Mat_p_Energy Vxc_Potential<Grid>::IntegrateVXC(
   return Mat_p_Energy(vxc.energy(), vxc.matrix() + vxc.matrix().transpose());
 }
 
+template <class Grid>
+std::array<Mat_p_Energy, 2> Vxc_Potential<Grid>::IntegrateVXC(
+    const Eigen::MatrixXd& dmat_alpha, const Eigen::MatrixXd& dmat_beta) const {
+
+  Mat_p_Energy vxc_alpha = Mat_p_Energy(dmat_alpha.rows(), dmat_alpha.cols());
+  Mat_p_Energy vxc_beta = Mat_p_Energy(dmat_beta.rows(), dmat_beta.cols());
+
+#pragma omp parallel for schedule(dynamic) reduction(+ : vxc_alpha, vxc_beta)
+  for (Index i = 0; i < _grid.getBoxesSize(); ++i) {
+    const GridBox& box = _grid[i];
+    if (!box.Matrixsize()) {
+      continue;
+    }
+    const Eigen::MatrixXd DMAT_alpha = box.ReadFromBigMatrix(dmat_alpha);
+    const Eigen::MatrixXd DMAT_beta = box.ReadFromBigMatrix(dmat_beta);
+    double cutoff =
+        1.e-40 / double(dmat_alpha.rows()) / double(dmat_alpha.rows());
+    if (DMAT_alpha.cwiseAbs2().maxCoeff() < cutoff &&
+        DMAT_beta.cwiseAbs2().maxCoeff() < cutoff) {
+      continue;
+    }
+
+    const AOValues ao = box.getAOValues();
+    const BoxDensity alpha(ao, DMAT_alpha + DMAT_alpha.transpose());
+    const BoxDensity beta(ao, DMAT_beta + DMAT_beta.transpose());
+
+    SpinMatrix2 rho(box.size(), 2);
+    rho.col(0) = alpha.rho;
+    rho.col(1) = beta.rho;
+    SpinMatrix3 sigma(box.size(), 3);
+    sigma.col(0) = alpha.grad_x.cwiseAbs2() + alpha.grad_y.cwiseAbs2() +
+                   alpha.grad_z.cwiseAbs2();
+    sigma.col(1) = alpha.grad_x.cwiseProduct(beta.grad_x) +
+                   alpha.grad_y.cwiseProduct(beta.grad_y) +
+                   alpha.grad_z.cwiseProduct(beta.grad_z);
+    sigma.col(2) = beta.grad_x.cwiseAbs2() + beta.grad_y.cwiseAbs2() +
+                   beta.grad_z.cwiseAbs2();
+
+    const Eigen::VectorXd rho_total = alpha.rho + beta.rho;
+    Eigen::VectorXd weights = Eigen::Map<const Eigen::VectorXd>(
+        box.getGridWeights().data(), box.size());
+    for (Index p = 0; p < box.size(); p++) {
+      if (rho_total[p] * weights[p] < 1.e-20) {
+        weights[p] = 0.0;
+      }
+    }
+    if (weights.isZero(0.0)) {
+      continue;
+    }
+
+    const typename Vxc_Potential<Grid>::XC_entry_polarized xc =
+        EvaluateXC(rho, sigma);
+    vxc_alpha.energy() +=
+        weights.cwiseProduct(rho_total).cwiseProduct(xc.f_xc).sum();
+
+    // dE/dgrad(rho_alpha) = 2*df/dsigma_aa*grad(rho_alpha)
+    //                       + df/dsigma_ab*grad(rho_beta) and vice versa
+    const Eigen::VectorXd saa = 2.0 * weights.cwiseProduct(xc.df_dsigma.col(0));
+    const Eigen::VectorXd sab = weights.cwiseProduct(xc.df_dsigma.col(1));
+    const Eigen::VectorXd sbb = 2.0 * weights.cwiseProduct(xc.df_dsigma.col(2));
+    Eigen::MatrixXd Vxc_alpha = BoxPotential(
+        ao, 0.5 * weights.cwiseProduct(xc.df_drho.col(0)),
+        saa.cwiseProduct(alpha.grad_x) + sab.cwiseProduct(beta.grad_x),
+        saa.cwiseProduct(alpha.grad_y) + sab.cwiseProduct(beta.grad_y),
+        saa.cwiseProduct(alpha.grad_z) + sab.cwiseProduct(beta.grad_z));
+    Eigen::MatrixXd Vxc_beta = BoxPotential(
+        ao, 0.5 * weights.cwiseProduct(xc.df_drho.col(1)),
+        sbb.cwiseProduct(beta.grad_x) + sab.cwiseProduct(alpha.grad_x),
+        sbb.cwiseProduct(beta.grad_y) + sab.cwiseProduct(alpha.grad_y),
+        sbb.cwiseProduct(beta.grad_z) + sab.cwiseProduct(alpha.grad_z));
+    box.AddtoBigMatrix(vxc_alpha.matrix(), Vxc_alpha);
+    box.AddtoBigMatrix(vxc_beta.matrix(), Vxc_beta);
+  }
+
+  return {Mat_p_Energy(vxc_alpha.energy(),
+                       vxc_alpha.matrix() + vxc_alpha.matrix().transpose()),
+          Mat_p_Energy(0.0, vxc_beta.matrix() + vxc_beta.matrix().transpose())};
+}
+
 template class Vxc_Potential<Vxc_Grid>;
 
 }  // namespace xtp
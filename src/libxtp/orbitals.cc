@@ -105,6 +105,12 @@ Eigen::MatrixXd Orbitals::DensityMatrixGroundState() const {
     throw std::runtime_error("Orbitals file does not contain MO coefficients");
   }
   Eigen::MatrixXd occstates = _mos.eigenvectors().leftCols(_occupied_levels);
+  if (hasBetaMOs()) {
+    Eigen::MatrixXd occstates_beta =
+        _mos_beta.eigenvectors().leftCols(_number_beta_electrons);
+    return occstates * occstates.transpose() +
+           occstates_beta * occstates_beta.transpose();
+  }
   Eigen::MatrixXd dmatGS = 2.0 * occstates * occstates.transpose();
   return dmatGS;
 }
@@ -510,8 +516,10 @@ void Orbitals::WriteToCpt(CheckpointWriter w) const {
   w(_basis_set_size, "basis_set_size");
   w(_occupied_levels, "occupied_levels");
   w(_number_alpha_electrons, "number_alpha_electrons");
+  w(_number_beta_electrons, "number_beta_electrons");
 
   w(_mos, "mos");
+  w(_mos_beta, "mos_beta");
 
   CheckpointWriter molgroup = w.openChild("qmmolecule");
   _atoms.WriteToCpt(molgroup);
@@ -563,6 +571,14 @@ void Orbitals::ReadFromCpt(CheckpointReader r) {
   r(_number_alpha_electrons, "number_alpha_electrons");
 
   r(_mos, "mos");
+  // files before version 2 only hold restricted orbitals
+  try {
+    r(_number_beta_electrons, "number_beta_electrons");
+    r(_mos_beta, "mos_beta");
+  } catch (std::runtime_error& e) {
+    _number_beta_electrons = 0;
+    _mos_beta = tools::EigenSystem();
+  }
 
   // Read qmatoms
   CheckpointReader molgroup = r.openChild("qmmolecule");
@@ -42,11 +42,28 @@ void XTPDFT::Initialize(const tools::Property& options) {
   _log_file_name = job_name + ".orb";
   _mo_file_name = _log_file_name;
   _xtpdft_options = ParseCommonOptions(options);
+  _write_orb_file = _xtpdft_options.ifExistsReturnElseReturnDefault<bool>(
+      "package.xtpdft.write_orb_file", _write_orb_file);
+  const std::string extrapolation =
+      _xtpdft_options.ifExistsReturnElseReturnDefault<std::string>(
+          "package.xtpdft.density_extrapolation", "none");
+  if (extrapolation == "aspc") {
+    _extrapolate_density = true;
+    _density_history.setOrder(
+        _xtpdft_options.ifExistsReturnElseReturnDefault<Index>(
+            "package.xtpdft.aspc_order", 2));
+  } else if (extrapolation == "none") {
+    _extrapolate_density = false;
+  } else {
+    throw std::runtime_error("density_extrapolation " + extrapolation +
+                             " not known, use none or aspc");
+  }
 }
 
 bool XTPDFT::WriteInputFile(const Orbitals& orbitals) {
   _orbitals = orbitals;
   _orbitals.setQMpackage(getPackageName());
+  _orbitals_in_memory = false;
   return true;
 }
 
@@ -57,15 +74,27 @@ bool XTPDFT::Run() {
   DFTEngine xtpdft;
   xtpdft.Initialize(_xtpdft_options);
   xtpdft.setLogger(_pLog);
+  // the charge may have been changed by the region after Initialize
+  xtpdft.setChargeAndSpin(_charge, _spin);
 
   if (_settings.get<bool>("write_charges")) {
     xtpdft.setExternalcharges(&_externalsites);
   }
+  DensityExtrapolation reference;
+  if (_extrapolate_density && _displaced_geometry) {
+    reference = _density_history.Reference();
+    xtpdft.setDensityHistory(&reference);
+  } else if (_extrapolate_density) {
+    xtpdft.setDensityHistory(&_density_history);
+  }
   bool success = xtpdft.Evaluate(_orbitals);
-  std::string file_name = _run_dir + "/" + _log_file_name;
-  XTP_LOG(Log::error, *_pLog)
-      << "Writing result to " << _log_file_name << flush;
-  _orbitals.WriteToCpt(file_name);
+  _orbitals_in_memory = success;
+  if (_write_orb_file) {
+    std::string file_name = _run_dir + "/" + _log_file_name;
+    XTP_LOG(Log::error, *_pLog)
+        << "Writing result to " << _log_file_name << flush;
+    _orbitals.WriteToCpt(file_name);
+  }
   return success;
 }
 
@@ -91,7 +120,21 @@ void XTPDFT::CleanUp() {
  */
 bool XTPDFT::ParseMOsFile(Orbitals&) { return true; }
 
+/**
+ * If the DFT run happened in this process, the orbitals are handed over
+ * directly instead of being read back from the .orb file
+ */
 bool XTPDFT::ParseLogFile(Orbitals& orbitals) {
+  if (_orbitals_in_memory) {
+    orbitals = std::move(_orbitals);
+    _orbitals = Orbitals();
+    _orbitals_in_memory = false;
+    XTP_LOG(Log::error, *_pLog) << (boost::format("QM energy[Hrt]: %4.8f ") %
+                                    orbitals.getDFTTotalEnergy())
+                                       .str()
+                                << flush;
+    return true;
+  }
   try {
     std::string file_name = _run_dir + "/" + _log_file_name;
     orbitals.ReadFromCpt(file_name);
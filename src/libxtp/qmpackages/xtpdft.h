@@ -25,6 +25,7 @@
 #include <string>
 
 // Local VOTCA includes
+#include "votca/xtp/densityextrapolation.h"
 #include "votca/xtp/dftengine.h"
 #include "votca/xtp/orbitals.h"
 #include "votca/xtp/polarsite.h"
@@ -93,8 +94,15 @@ class XTPDFT : public QMPackage {
 
   void WriteChargeOption() final { return; }
   tools::Property _xtpdft_options;
+  bool _write_orb_file = true;
+  // densities of previous runs of this package, e.g. of earlier geometry
+  // optimization steps or QM/MM iterations
+  bool _extrapolate_density = false;
+  DensityExtrapolation _density_history;
 
   Orbitals _orbitals;
+  // true if _orbitals holds the result of Run() which was not handed over yet
+  bool _orbitals_in_memory = false;
 };
 
 }  // namespace xtp
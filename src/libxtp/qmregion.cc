@@ -189,13 +189,18 @@ void QMRegion::AppendResult(tools::Property& prop) const {
 }
 
 void QMRegion::Reset() {
-
-  std::string dft_package_name =
-      _dftoptions.get("package.name").as<std::string>();
-  _qmpackage =
-      std::unique_ptr<QMPackage>(QMPackages().Create(dft_package_name));
-  _qmpackage->setLog(&_log);
-  _qmpackage->Initialize(_dftoptions);
+  // the package is kept alive between iterations, so that it can reuse
+  // results of earlier iterations, e.g. the density history of xtpdft
+  if (_qmpackage == nullptr) {
+    std::string dft_package_name =
+        _dftoptions.get("package.name").as<std::string>();
+    _qmpackage =
+        std::unique_ptr<QMPackage>(QMPackages().Create(dft_package_name));
+    _qmpackage->setLog(&_log);
+    _qmpackage->Initialize(_dftoptions);
+  } else {
+    _qmpackage->ClearExternalSites();
+  }
   Index charge = 0;
   if (_initstate.Type() == QMStateType::Electron) {
     charge = -1;
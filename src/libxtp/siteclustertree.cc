@@ -0,0 +1,201 @@
+/*
+ *            Copyright 2009-2020 The VOTCA Development Team
+ *                       (http://www.votca.org)
+ *
+ *      Licensed under the Apache License, Version 2.0 (the "License")
+ *
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *              http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Standard includes
+#include <array>
+#include <cmath>
+#include <limits>
+
+// Local VOTCA includes
+#include "votca/xtp/siteclustertree.h"
+
+namespace votca {
+namespace xtp {
+
+SiteClusterTree::SiteClusterTree(
+    const std::vector<std::unique_ptr<StaticSite> >& sites, Index leafsize)
+    : _leafsize(leafsize) {
+  _sites.reserve(sites.size());
+  for (const std::unique_ptr<StaticSite>& site : sites) {
+    _sites.push_back(site.get());
+  }
+  _order.resize(_sites.size());
+  for (Index i = 0; i < size(); i++) {
+    _order[i] = i;
+  }
+  if (size() > 0) {
+    Build(0, size(), 0);
+  }
+}
+
+Index SiteClusterTree::Build(Index start, Index end, Index depth) {
+  Node node;
+  node.start = start;
+  node.end = end;
+  Eigen::Vector3d min =
+      Eigen::Vector3d::Constant(std::numeric_limits<double>::max());
+  Eigen::Vector3d max = -min;
+  for (Index i = start; i < end; i++) {
+    const Eigen::Vector3d& pos = _sites[_order[i]]->getPos();
+    min = min.cwiseMin(pos);
+    max = max.cwiseMax(pos);
+  }
+  node.center = 0.5 * (min + max);
+  node.radius = 0.0;
+  // third moment of charges, dipoles and the second moments of the
+  // quadrupoles shifted to the center, slice a holds the components a.. The
+  // traceless second moment of a quadrupole is 2/3 of its cartesian form
+  std::array<Eigen::Matrix3d, 3> third;
+  third.fill(Eigen::Matrix3d::Zero());
+  for (Index i = start; i < end; i++) {
+    const StaticSite& site = *_sites[_order[i]];
+    const Eigen::Vector3d d = site.getPos() - node.center;
+    const double q = site.getCharge();
+    const Eigen::Vector3d mu = site.getDipole();
+    const Eigen::Matrix3d quad = site.CalculateCartesianMultipole();
+    node.radius = std::max(node.radius, d.norm());
+    node.abs_charge += std::abs(q);
+    node.abs_dipole += mu.norm();
+    node.abs_quadrupole += quad.norm();
+    const Eigen::Matrix3d dd = d * d.transpose();
+    const Eigen::Matrix3d dmu = d * mu.transpose() + mu * d.transpose();
+    for (Index a = 0; a < 3; a++) {
+      third[a] += (q * d[a]) * dd + d[a] * dmu + mu[a] * dd +
+                  2.0 / 3.0 * (d[a] * quad + quad.col(a) * d.transpose() +
+                               d * quad.row(a));
+    }
+  }
+  for (const Eigen::Matrix3d& slice : third) {
+    node.third_moment += slice.squaredNorm();
+  }
+  node.third_moment = std::sqrt(node.third_moment);
+  const Index id = Index(_nodes.size());
+  _nodes.push_back(node);
+
+  const Index maxdepth = 32;
+  if (node.size() <= _leafsize || node.radius == 0.0 || depth >= maxdepth) {
+    return id;
+  }
+  std::array<std::vector<Index>, 8> octants;
+  for (Index i = start; i < end; i++) {
+    const Eigen::Vector3d& pos = _sites[_order[i]]->getPos();
+    Index octant = 0;
+    for (Index k = 0; k < 3; k++) {
+      if (pos[k] > node.center[k]) {
+        octant += Index(1) << k;
+      }
+    }
+    octants[octant].push_back(_order[i]);
+  }
+  std::vector<std::pair<Index, Index> > ranges;
+  Index offset = start;
+  for (const std::vector<Index>& octant : octants) {
+    if (octant.empty()) {
+      continue;
+    }
+    std::copy(octant.begin(), octant.end(), _order.begin() + offset);
+    ranges.push_back({offset, offset + Index(octant.size())});
+    offset += Index(octant.size());
+  }
+  // _nodes grows during the recursion, so no references into it are kept
+  for (const auto& range : ranges) {
+    const Index child = Build(range.first, range.second, depth + 1);
+    _nodes[id].children.push_back(child);
+  }
+  return id;
+}
+
+void SiteClusterTree::Partition(const Eigen::Vector3d& center, double radius,
+                                double tolerance,
+                                std::vector<const StaticSite*>& exact,
+                                std::vector<StaticSite>& clusters) const {
+  if (size() == 0) {
+    return;
+  }
+  Partition(0, center, radius, tolerance, exact, clusters);
+}
+
+void SiteClusterTree::Partition(Index id, const Eigen::Vector3d& center,
+                                double radius, double tolerance,
+                                std::vector<const StaticSite*>& exact,
+                                std::vector<StaticSite>& clusters) const {
+  const Node& node = _nodes[id];
+  const double dist = (node.center - center).norm() - radius;
+  const double r = node.radius;
+  if (node.size() > 1 && dist > r) {
+    // truncation error of the expansion up to the quadrupole, the third
+    // moment gives the leading term, all higher ones are bounded by the
+    // absolute multipoles shifted to the center
+    const double d3 = dist * dist * dist;
+    const double higher = (node.abs_charge * r * r * r * r +
+                           4.0 * node.abs_dipole * r * r * r +
+                           6.0 * node.abs_quadrupole * r * r) /
+                          (d3 * dist * (dist - r));
+    const double estimate = node.third_moment / (d3 * (dist - r)) + higher;
+    // errors of different clusters have random signs, so each cluster gets
+    // the share of the tolerance which keeps their root sum square below it
+    const double share = std::sqrt(double(node.size()) / double(size()));
+    if (estimate < tolerance * share) {
+      clusters.push_back(MakeCluster(node));
+      return;
+    }
+  }
+  if (node.children.empty()) {
+    for (Index i = node.start; i < node.end; i++) {
+      exact.push_back(_sites[_order[i]]);
+    }
+    return;
+  }
+  for (Index child : node.children) {
+    Partition(child, center, radius, tolerance, exact, clusters);
+  }
+}
+
+StaticSite SiteClusterTree::MakeCluster(const Node& node) const {
+  double charge = 0.0;
+  Eigen::Vector3d dipole = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d quadrupole = Eigen::Matrix3d::Zero();
+  const Eigen::Matrix3d identity = Eigen::Matrix3d::Identity();
+  // quadrupoles in the cartesian form of StaticSite, which is
+  // 1.5*sum q*(r*r^T-r^2/3)
+  for (Index i = node.start; i < node.end; i++) {
+    const StaticSite& site = *_sites[_order[i]];
+    const Eigen::Vector3d d = site.getPos() - node.center;
+    const double q = site.getCharge();
+    const Eigen::Vector3d mu = site.getDipole();
+    charge += q;
+    dipole += q * d + mu;
+    quadrupole +=
+        1.5 * q * (d * d.transpose() - d.squaredNorm() / 3.0 * identity);
+    quadrupole += 1.5 * (d * mu.transpose() + mu * d.transpose() -
+                         2.0 / 3.0 * d.dot(mu) * identity);
+    quadrupole += site.CalculateCartesianMultipole();
+  }
+  StaticSite cluster(-1, "", node.center);
+  Vector9d multipoles = Vector9d::Zero();
+  multipoles(0) = charge;
+  multipoles.segment<3>(1) = dipole;
+  multipoles.segment<5>(4) =
+      StaticSite::CalculateSphericalMultipole(quadrupole);
+  cluster.setMultipole(multipoles, 2);
+  return cluster;
+}
+
+}  // namespace xtp
+}  // namespace votca
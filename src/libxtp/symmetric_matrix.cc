@@ -37,6 +37,14 @@ Symmetric_Matrix::Symmetric_Matrix(const Eigen::MatrixXd& full)
   }
 }
 
+Symmetric_Matrix::Symmetric_Matrix(
+    Index dim, const Eigen::Ref<const Eigen::VectorXd>& packed)
+    : dimension(dim) {
+  assert(packed.size() == (dim + 1) * dim / 2 &&
+         "Packed vector does not fit dimension");
+  data = std::vector<double>(packed.data(), packed.data() + packed.size());
+}
+
 std::ostream& operator<<(std::ostream& out, const Symmetric_Matrix& a) {
 
   out << "[" << a.dimension << "," << a.dimension << "]\n";
@@ -17,6 +17,13 @@
  *
  */
 
+// Standard includes
+#include <unistd.h>
+
+// Third party includes
+#include <H5Cpp.h>
+#include <boost/filesystem.hpp>
+
 // Local VOTCA includes
 #include "votca/xtp/aobasis.h"
 #include "votca/xtp/aomatrix.h"
@@ -26,6 +33,166 @@
 namespace votca {
 namespace xtp {
 
+// HDF5 scratch file holding the integrals as a (aux x packed pairs) dataset,
+// the file is removed once the last TCMatrix_dft using it is destroyed
+class TCMatrix_dft::ScratchFile {
+ public:
+  ScratchFile(const std::string& scratchdir, Index auxsize, Index pairsize,
+              Index auxblocksize) {
+    boost::filesystem::path dir(scratchdir);
+    boost::filesystem::create_directories(dir);
+    _filename =
+        (dir / boost::filesystem::unique_path("xtp_threecenter_%%%%-%%%%.h5"))
+            .string();
+    _file = H5::H5File(_filename, H5F_ACC_TRUNC);
+    hsize_t dims[2] = {hsize_t(auxsize), hsize_t(pairsize)};
+    H5::DataSpace space(2, dims);
+    // chunks hold a few thousand pairs for as many aux functions as fit into
+    // _chunkbytes, well below the 4 GB HDF5 limit. Writes cover all aux
+    // functions of a long range of pairs, reads whole aux blocks, so both
+    // touch only few partial chunks.
+    const hsize_t pairchunk =
+        std::max<hsize_t>(1, std::min<hsize_t>(hsize_t(pairsize), 4096));
+    const hsize_t auxchunk = std::max<hsize_t>(
+        1, std::min<hsize_t>(hsize_t(auxblocksize),
+                             _chunkbytes / (pairchunk * sizeof(double))));
+    hsize_t chunk[2] = {auxchunk, pairchunk};
+    H5::DSetCreatPropList props;
+    props.setChunk(2, chunk);
+    _dataset = _file.createDataSet("threecenter", H5::PredType::NATIVE_DOUBLE,
+                                   space, props);
+  }
+
+  ~ScratchFile() {
+    _dataset.close();
+    _file.close();
+    boost::system::error_code ec;
+    boost::filesystem::remove(_filename, ec);
+  }
+
+  // data is a column major (pairs x aux) matrix, i.e. row major (aux x pairs)
+  void Write(const double* data, Index auxstart, Index auxsize,
+             Index pairstart, Index pairsize) {
+    hsize_t offset[2] = {hsize_t(auxstart), hsize_t(pairstart)};
+    hsize_t count[2] = {hsize_t(auxsize), hsize_t(pairsize)};
+    H5::DataSpace filespace = _dataset.getSpace();
+    filespace.selectHyperslab(H5S_SELECT_SET, count, offset);
+    H5::DataSpace memspace(2, count);
+    _dataset.write(data, H5::PredType::NATIVE_DOUBLE, memspace, filespace);
+  }
+
+  void Read(double* data, Index auxstart, Index auxsize, Index pairstart,
+            Index pairsize) const {
+    hsize_t offset[2] = {hsize_t(auxstart), hsize_t(pairstart)};
+    hsize_t count[2] = {hsize_t(auxsize), hsize_t(pairsize)};
+    H5::DataSpace filespace = _dataset.getSpace();
+    filespace.selectHyperslab(H5S_SELECT_SET, count, offset);
+    H5::DataSpace memspace(2, count);
+    _dataset.read(data, H5::PredType::NATIVE_DOUBLE, memspace, filespace);
+  }
+
+ private:
+  static constexpr hsize_t _chunkbytes = 4 * 1024 * 1024;
+  std::string _filename;
+  H5::H5File _file;
+  H5::DataSet _dataset;
+};
+
+// Collects all pairs (i,j) with i>=j whose shells form a significant shell
+// pair, the pairs of one shell stay contiguous
+void TCMatrix_dft::SetupPairs(const AOBasis& dftbasis) {
+  _pairindex.clear();
+  _shellpairstart = std::vector<Index>(dftbasis.getNumofShells() + 1, 0);
+  for (Index a = 0; a < dftbasis.getNumofShells(); a++) {
+    _shellpairstart[a] = Index(_pairindex.size());
+    std::vector<bool> significant(_dftsize, false);
+    for (Index b : _shellpairs[a]) {
+      const AOShell& shell_b = dftbasis.getShell(b);
+      for (Index j = 0; j < shell_b.getNumFunc(); j++) {
+        significant[shell_b.getStartIndex() + j] = true;
+      }
+    }
+    const AOShell& shell_a = dftbasis.getShell(a);
+    for (Index i = 0; i < shell_a.getNumFunc(); i++) {
+      Index row = shell_a.getStartIndex() + i;
+      for (Index col = 0; col <= row; col++) {
+        if (significant[col]) {
+          _pairindex.push_back((row * (row + 1)) / 2 + col);
+        }
+      }
+    }
+  }
+  _shellpairstart.back() = Index(_pairindex.size());
+}
+
+Eigen::VectorXd TCMatrix_dft::GatherPairs(const Eigen::VectorXd& packed) const {
+  Eigen::VectorXd stored = Eigen::VectorXd(pairsize());
+  for (Index k = 0; k < pairsize(); k++) {
+    stored[k] = packed[_pairindex[k]];
+  }
+  return stored;
+}
+
+Eigen::VectorXd TCMatrix_dft::ScatterPairs(
+    const Eigen::Ref<const Eigen::VectorXd>& stored) const {
+  Eigen::VectorXd packed = Eigen::VectorXd::Zero((_dftsize + 1) * _dftsize / 2);
+  for (Index k = 0; k < pairsize(); k++) {
+    packed[_pairindex[k]] = stored[k];
+  }
+  return packed;
+}
+
+void TCMatrix_dft::SetupStorage() {
+  double max_memory = _max_memory_mb * 1024.0 * 1024.0;
+  if (max_memory <= 0.0) {
+    max_memory =
+        double(sysconf(_SC_PHYS_PAGES)) * double(sysconf(_SC_PAGESIZE));
+  }
+  const double required =
+      double(pairsize()) * double(_auxsize) * sizeof(double);
+
+  _scratch = nullptr;
+  _matrix.resize(0, 0);
+  if (required < max_memory) {
+    try {
+      _matrix = Eigen::MatrixXd::Zero(pairsize(), _auxsize);
+      _auxblocksize = _auxsize;
+      _pairblocksize = pairsize();
+      return;
+    } catch (std::bad_alloc&) {
+      // fall through to out of core storage
+    }
+  }
+  // a quarter of the budget is used for one block of aux functions, when
+  // reading, or one block of pairs, when writing
+  const double blockmemory = 0.25 * max_memory;
+  _auxblocksize = std::max<Index>(
+      1, std::min<Index>(_auxsize, Index(blockmemory / (double(pairsize()) *
+                                                        sizeof(double)))));
+  _pairblocksize = std::max<Index>(
+      1, std::min<Index>(pairsize(), Index(blockmemory / (double(_auxsize) *
+                                                          sizeof(double)))));
+  try {
+    _scratch = std::make_shared<ScratchFile>(_scratchdir, _auxsize, pairsize(),
+                                             _auxblocksize);
+  } catch (H5::Exception&) {
+    throw std::runtime_error(
+        "Basisset/aux basis too large for 3c calculation in RAM and scratch "
+        "file in " +
+        _scratchdir + " could not be created.");
+  }
+}
+
+Eigen::Ref<const Eigen::MatrixXd> TCMatrix_dft::getAuxBlock(
+    Index start, Index size, Eigen::MatrixXd& buffer) const {
+  if (isInCore()) {
+    return _matrix.middleCols(start, size);
+  }
+  buffer.resize(pairsize(), size);
+  _scratch->Read(buffer.data(), start, size, 0, pairsize());
+  return buffer;
+}
+
 void TCMatrix_dft::Fill(const AOBasis& auxbasis, const AOBasis& dftbasis) {
 
   AOCoulomb auxAOcoulomb;
@@ -33,16 +200,46 @@ void TCMatrix_dft::Fill(const AOBasis& auxbasis, const AOBasis& dftbasis) {
   _inv_sqrt = auxAOcoulomb.Pseudo_InvSqrt(1e-8);
   _removedfunctions = auxAOcoulomb.Removedfunctions();
 
-  for (Index i = 0; i < auxbasis.AOBasisSize(); i++) {
-    try {
-      _matrix.push_back(Symmetric_Matrix(dftbasis.AOBasisSize()));
-    } catch (std::bad_alloc&) {
-      throw std::runtime_error(
-          "Basisset/aux basis too large for 3c calculation. Not enough RAM.");
+  _dftsize = dftbasis.AOBasisSize();
+  _auxsize = auxbasis.AOBasisSize();
+  ComputeShellPairs(dftbasis, auxbasis, auxAOcoulomb.Matrix());
+  SetupPairs(dftbasis);
+  SetupStorage();
+
+  // Shells are filled in batches of at most _pairblocksize stored pairs. Out
+  // of core a batch is buffered and written for all aux functions at once.
+  const Index nshells = dftbasis.getNumofShells();
+  Eigen::MatrixXd buffer;
+  Index shell_begin = 0;
+  while (shell_begin < nshells) {
+    Index shell_end = shell_begin + 1;
+    while (shell_end < nshells &&
+           _shellpairstart[shell_end + 1] - _shellpairstart[shell_begin] <=
+               _pairblocksize) {
+      shell_end++;
+    }
+    const Index first = isInCore() ? 0 : _shellpairstart[shell_begin];
+    if (!isInCore()) {
+      buffer.resize(_shellpairstart[shell_end] - first, _auxsize);
     }
+    Eigen::MatrixXd& target = isInCore() ? _matrix : buffer;
+    FillShells(shell_begin, shell_end, target, first, dftbasis, auxbasis);
+    if (!isInCore()) {
+      _scratch->Write(buffer.data(), 0, _auxsize, first, buffer.rows());
+    }
+    shell_begin = shell_end;
   }
+  return;
+}
+
+// integrals of all stored pairs of shells [shell_begin,shell_end) into the
+// rows of target, starting at row pair index - first
+void TCMatrix_dft::FillShells(Index shell_begin, Index shell_end,
+                              Eigen::MatrixXd& target, Index first,
+                              const AOBasis& dftbasis,
+                              const AOBasis& auxbasis) {
 #pragma omp parallel for schedule(dynamic)
-  for (Index is = dftbasis.getNumofShells() - 1; is >= 0; is--) {
+  for (Index is = shell_end - 1; is >= shell_begin; is--) {
     const AOShell& dftshell = dftbasis.getShell(is);
     std::vector<Eigen::MatrixXd> block;
     for (Index i = 0; i < dftshell.getNumFunc(); i++) {
@@ -50,17 +247,21 @@ void TCMatrix_dft::Fill(const AOBasis& auxbasis, const AOBasis& dftbasis) {
       block.push_back(Eigen::MatrixXd::Zero(auxbasis.AOBasisSize(), size));
     }
     FillBlock(block, is, dftbasis, auxbasis);
+    // the rows of all functions of a shell form one contiguous range of pairs
     Index offset = dftshell.getStartIndex();
+    Index pairstart = (offset * (offset + 1)) / 2;
+    Index end = offset + dftshell.getNumFunc();
+    Eigen::MatrixXd pairs = Eigen::MatrixXd((end * (end + 1)) / 2 - pairstart,
+                                            auxbasis.AOBasisSize());
     for (Index i = 0; i < Index(block.size()); ++i) {
-      Eigen::MatrixXd temp = _inv_sqrt * block[i];
-      for (Index mu = 0; mu < temp.rows(); ++mu) {
-        for (Index j = 0; j < temp.cols(); ++j) {
-          _matrix[mu](i + offset, j) = temp(mu, j);
-        }
-      }
+      Index row = i + offset;
+      pairs.middleRows((row * (row + 1)) / 2 - pairstart, row + 1) =
+          (_inv_sqrt * block[i]).transpose();
+    }
+    for (Index k = _shellpairstart[is]; k < _shellpairstart[is + 1]; k++) {
+      target.row(k - first) = pairs.row(_pairindex[k] - pairstart);
     }
   }
-  return;
 }
 
 /*
@@ -73,13 +274,19 @@ void TCMatrix_dft::FillBlock(std::vector<Eigen::MatrixXd>& block,
                              Index shellindex, const AOBasis& dftbasis,
                              const AOBasis& auxbasis) {
   const AOShell& left_dftshell = dftbasis.getShell(shellindex);
+  const AOShellPairs& shellpairs = dftbasis.ShellPairs();
+  const AOShellTrafos& auxtrafos = auxbasis.ShellTrafos();
 
   Index start = left_dftshell.getStartIndex();
   // alpha-loop over the aux basis function
-  for (const AOShell& shell_aux : auxbasis) {
+  for (Index auxshell = 0; auxshell < auxbasis.getNumofShells(); auxshell++) {
+    const AOShell& shell_aux = auxbasis.getShell(auxshell);
     Index aux_start = shell_aux.getStartIndex();
 
-    for (Index is = 0; is <= shellindex; is++) {
+    for (Index is : _shellpairs[shellindex]) {
+      if (!isSignificant(auxshell, shellindex, is)) {
+        continue;
+      }
 
       const AOShell& shell_col = dftbasis.getShell(is);
       Index col_start = shell_col.getStartIndex();
@@ -88,8 +295,9 @@ void TCMatrix_dft::FillBlock(std::vector<Eigen::MatrixXd>& block,
                                             shell_col.getNumFunc());
       threec_block.setZero();
 
-      bool nonzero = FillThreeCenterRepBlock(threec_block, shell_aux,
-                                             left_dftshell, shell_col);
+      bool nonzero =
+          FillThreeCenterRepBlock(threec_block, shell_aux, left_dftshell,
+                                  shell_col, &shellpairs, &auxtrafos);
       if (nonzero) {
 
         for (Index left = 0; left < left_dftshell.getNumFunc(); left++) {
@@ -77,6 +77,15 @@ void TCMatrix_gwbse::Fill(const AOBasis& gwbasis, const AOBasis& dftbasis,
   _dftbasis = &dftbasis;
   _dft_orbitals = &dft_orbitals;
 
+  // a previous compression reduced the aux dimension
+  if (_auxbasissize != gwbasis.AOBasisSize()) {
+    Initialize(gwbasis.AOBasisSize(), _mmin, _mmax, _nmin, _nmax);
+  }
+
+  AOCoulomb auxcoulomb;
+  auxcoulomb.Fill(gwbasis);
+  ComputeShellPairs(dftbasis, gwbasis, auxcoulomb.Matrix());
+
   // If cuda is enabled the dft orbitals are sent first to the cuda gpu
   // and memory in the cuda gpu is allocated for the intermediate matrices
 #if defined(USE_CUDA)
@@ -90,22 +99,74 @@ void TCMatrix_gwbse::Fill(const AOBasis& gwbasis, const AOBasis& dftbasis,
 #endif
   AOOverlap auxoverlap;
   auxoverlap.Fill(gwbasis);
-  AOCoulomb auxcoulomb;
-  auxcoulomb.Fill(gwbasis);
   Eigen::MatrixXd inv_sqrt = auxcoulomb.Pseudo_InvSqrt_GWBSE(auxoverlap, 5e-7);
   _removedfunctions = auxcoulomb.Removedfunctions();
   MultiplyRightWithAuxMatrix(inv_sqrt);
+  if (_naf_threshold > 0.0) {
+    CompressAuxBasis();
+  }
 
   return;
 }
 
+/*
+ * Natural auxiliary functions, M. Kallay, J. Chem. Phys. 141, 244113 (2014):
+ * the eigenvectors of the aux metric of the actual tensor span the aux
+ * space, which the products M_mn^T M_kl need. Dropping the ones with small
+ * eigenvalues shrinks the aux dimension for all later steps. The threshold is
+ * relative to the largest eigenvalue, which grows with the number of levels.
+ */
+void TCMatrix_gwbse::CompressAuxBasis() {
+  // levels are stacked into batches and only the lower triangle is summed,
+  // split into column panels, so that all threads add into the one metric
+  const Index panelsize = 64;
+  const Index n_panels = (_auxbasissize + panelsize - 1) / panelsize;
+  const Index batch = std::max(Index(1), Index(512) / _ntotal);
+  Eigen::MatrixXd metric = Eigen::MatrixXd::Zero(_auxbasissize, _auxbasissize);
+  for (Index m_start = 0; m_start < _mtotal; m_start += batch) {
+    const Index n_levels = std::min(batch, _mtotal - m_start);
+    Eigen::MatrixXd stacked(n_levels * _ntotal, _auxbasissize);
+    for (Index i = 0; i < n_levels; i++) {
+      stacked.middleRows(i * _ntotal, _ntotal) = _matrix[m_start + i];
+    }
+#pragma omp parallel for schedule(dynamic)
+    for (Index panel = 0; panel < n_panels; panel++) {
+      const Index start = panel * panelsize;
+      const Index width = std::min(panelsize, _auxbasissize - start);
+      metric.block(start, start, _auxbasissize - start, width).noalias() +=
+          stacked.rightCols(_auxbasissize - start).transpose() *
+          stacked.middleCols(start, width);
+    }
+  }
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(metric);
+  const double cutoff = _naf_threshold * es.eigenvalues().maxCoeff();
+  // the largest natural function is always kept, so that a threshold above
+  // the whole spectrum does not leave an empty aux basis
+  Index kept = 1;
+  for (Index i = 0; i < _auxbasissize - 1; i++) {
+    if (es.eigenvalues()(i) >= cutoff) {
+      kept = _auxbasissize - i;
+      break;
+    }
+  }
+  XTP_LOG(Log::error, _log)
+      << TimeStamp() << " Natural auxiliary functions: kept " << kept << " of "
+      << _auxbasissize << flush;
+  MultiplyRightWithAuxMatrix(es.eigenvectors().rightCols(kept));
+  _auxbasissize = kept;
+}
+
 /*
  * Determines the 3-center integrals for a given shell in the GW basis
  * by calculating the 3-center overlap integral of the functions in the
  * GW shell with ALL functions in the DFT basis set (FillThreeCenterOLBlock)
  */
 std::vector<Eigen::MatrixXd> TCMatrix_gwbse::ComputeSymmStorage(
-    const AOShell& auxshell, const AOBasis& dftbasis) const {
+    Index auxshellindex, const AOBasis& gwbasis,
+    const AOBasis& dftbasis) const {
+  const AOShell& auxshell = gwbasis.getShell(auxshellindex);
+  const AOShellPairs& shellpairs = dftbasis.ShellPairs();
+  const AOShellTrafos& auxtrafos = gwbasis.ShellTrafos();
   std::vector<Eigen::MatrixXd> symmstorage = std::vector<Eigen::MatrixXd>(
       auxshell.getNumFunc(),
       Eigen::MatrixXd::Zero(dftbasis.AOBasisSize(), dftbasis.AOBasisSize()));
@@ -115,8 +176,11 @@ std::vector<Eigen::MatrixXd> TCMatrix_gwbse::ComputeSymmStorage(
     const AOShell& shell_row = dftbasis.getShell(row);
     const Index row_start = shell_row.getStartIndex();
     // ThreecMatrix is symmetric, restrict explicit calculation to triangular
-    // matrix
-    for (Index col = 0; col <= row; col++) {
+    // matrix, shell pairs with a negligible Schwarz bound are skipped
+    for (Index col : _shellpairs[row]) {
+      if (!isSignificant(auxshellindex, row, col)) {
+        continue;
+      }
       const AOShell& shell_col = dftbasis.getShell(col);
       const Index col_start = shell_col.getStartIndex();
 
@@ -126,7 +190,8 @@ std::vector<Eigen::MatrixXd> TCMatrix_gwbse::ComputeSymmStorage(
       threec_block.setZero();
 
       bool nonzero =
-          FillThreeCenterRepBlock(threec_block, auxshell, shell_row, shell_col);
+          FillThreeCenterRepBlock(threec_block, auxshell, shell_row, shell_col,
+                                  &shellpairs, &auxtrafos);
       if (nonzero) {
         for (Index aux_c = 0; aux_c < auxshell.getNumFunc(); aux_c++) {
           for (Index row_c = 0; row_c < shell_row.getNumFunc(); row_c++) {
@@ -200,7 +265,7 @@ void TCMatrix_gwbse::FillAllBlocksOpenMP(const AOBasis& gwbasis,
     // Fill block for this shell (3-center overlap with _dft_basis +
     // multiplication with _dft_orbitals )
     std::vector<Eigen::MatrixXd> symmstorage =
-        ComputeSymmStorage(shell, dftbasis);
+        ComputeSymmStorage(is, gwbasis, dftbasis);
 
     std::vector<Eigen::MatrixXd> block = FillBlock(symmstorage, dft_orbitals);
 
@@ -281,7 +346,7 @@ void TCMatrix_gwbse::FillAllBlocksCuda(const AOBasis& gwbasis,
     // Fill block for this shell (3-center overlap with _dft_basis +
     // multiplication with _dft_orbitals )
     std::vector<Eigen::MatrixXd> symmstorage =
-        ComputeSymmStorage(shell, dftbasis);
+        ComputeSymmStorage(is, gwbasis, dftbasis);
 
     // If cuda is enable all the GPU communication happens through a single
     // thread that reuses all memory allocated in the GPU and it's dynamically
@@ -22,6 +22,7 @@
 
 // Local VOTCA includes
 #include "votca/xtp/aopotential.h"
+#include "votca/xtp/ecpmatrixcache.h"
 #include "votca/xtp/orbitals.h"
 #include <votca/tools/eigenio_matrixmarket.h>
 
@@ -322,4 +323,88 @@ BOOST_AUTO_TEST_CASE(large_l_test) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(aomultipole_clusters) {
+
+  Orbitals orbitals;
+  orbitals.QMAtoms().LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                                  "/aopotential/molecule.xyz");
+  BasisSet basis;
+  basis.Load(std::string(XTP_TEST_DATA_FOLDER) + "/aopotential/3-21G.xml");
+  AOBasis aobasis;
+  aobasis.Fill(basis, orbitals.QMAtoms());
+
+  // lattice of charges and dipoles around the molecule
+  std::vector<std::unique_ptr<StaticSite> > externalsites;
+  Index id = 0;
+  for (Index i = -6; i <= 6; i++) {
+    for (Index j = -6; j <= 6; j++) {
+      for (Index k = -6; k <= 6; k++) {
+        Eigen::Vector3d pos = 4.0 * Eigen::Vector3d(i, j, k);
+        if (pos.norm() < 10.0) {
+          continue;
+        }
+        std::unique_ptr<StaticSite> site(new StaticSite(id, "", pos));
+        Vector9d multipoles = Vector9d::Zero();
+        multipoles(0) = ((i + j + k) % 2 == 0) ? 0.4 : -0.4;
+        multipoles(1) = 0.05 * double(j);
+        multipoles(3) = 0.05 * double(i);
+        site->setMultipole(multipoles, 1);
+        externalsites.push_back(std::move(site));
+        id++;
+      }
+    }
+  }
+
+  AOMultipole exact;
+  exact.FillPotential(aobasis, externalsites);
+
+  AOMultipole notol;
+  notol.FillPotential(aobasis, externalsites, 0.0, 1e-10);
+  BOOST_CHECK(notol.Matrix().isApprox(exact.Matrix(), 1e-10));
+
+  AOMultipole merged;
+  merged.FillPotential(aobasis, externalsites, 1e-3, 1e-10);
+  BOOST_CHECK(merged.AverageClusters() > 0);
+  BOOST_CHECK(merged.AverageExactSites() + merged.AverageClusters() <
+              double(externalsites.size()));
+  double maxdiff = (merged.Matrix() - exact.Matrix()).cwiseAbs().maxCoeff();
+  BOOST_CHECK_LT(maxdiff, 1e-3);
+  BOOST_CHECK(merged.Matrix().isApprox(merged.Matrix().transpose(), 1e-12));
+}
+
+BOOST_AUTO_TEST_CASE(ecp_cache) {
+  Orbitals orbitals;
+  orbitals.QMAtoms().LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                                  "/aopotential/molecule.xyz");
+  BasisSet basis;
+  basis.Load(std::string(XTP_TEST_DATA_FOLDER) + "/aopotential/3-21G.xml");
+  AOBasis aobasis;
+  aobasis.Fill(basis, orbitals.QMAtoms());
+  ECPBasisSet ecps;
+  ecps.Load(std::string(XTP_TEST_DATA_FOLDER) + "/aopotential/ecp.xml");
+  ECPAOBasis ecpbasis;
+  ecpbasis.Fill(ecps, orbitals.QMAtoms());
+
+  ECPMatrixCache& cache = ECPMatrixCache::Instance();
+  cache.Clear();
+  Eigen::MatrixXd reused;
+  BOOST_CHECK(!cache.Find(aobasis, ecpbasis, reused));
+
+  AOECP ecp;
+  ecp.FillPotential(aobasis, ecpbasis);
+  cache.Add(aobasis, ecpbasis, ecp.Matrix());
+  BOOST_CHECK(cache.Find(aobasis, ecpbasis, reused));
+  BOOST_CHECK(reused.isApprox(ecp.Matrix(), 1e-14));
+
+  orbitals.QMAtoms()[0].setPos(orbitals.QMAtoms()[0].getPos() +
+                               Eigen::Vector3d(0.1, 0, 0));
+  AOBasis moved;
+  moved.Fill(basis, orbitals.QMAtoms());
+  ECPAOBasis movedecp;
+  movedecp.Fill(ecps, orbitals.QMAtoms());
+  BOOST_CHECK(!cache.Find(moved, movedecp, reused));
+  cache.Clear();
+  BOOST_CHECK_EQUAL(cache.size(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
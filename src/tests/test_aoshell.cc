@@ -30,6 +30,7 @@
 
 using namespace votca::xtp;
 using namespace std;
+using votca::Index;
 
 BOOST_AUTO_TEST_SUITE(aoshell_test)
 
@@ -123,4 +124,43 @@ BOOST_AUTO_TEST_CASE(EvalAOspace) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(EvalAOspace_batch) {
+
+  QMMolecule mol = QMMolecule("", 0);
+  mol.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) + "/aoshell/Al.xyz");
+  BasisSet basis;
+  basis.Load(std::string(XTP_TEST_DATA_FOLDER) + "/aoshell/largeshell.xml");
+  AOBasis aobasis;
+  aobasis.Fill(basis, mol);
+
+  Eigen::MatrixX3d points = Eigen::MatrixX3d::Zero(5, 3);
+  points << 1.0, 1.0, 1.0, 0.0, 0.0, 0.0, -0.5, 0.3, 0.2, 2.0, -1.0, 0.5, 0.1,
+      0.1, -1.5;
+
+  for (const AOShell& shell : aobasis) {
+    const Index nfunc = shell.getNumFunc();
+    Eigen::MatrixXd values = Eigen::MatrixXd::Zero(points.rows(), nfunc);
+    Eigen::MatrixXd der_x = Eigen::MatrixXd::Zero(points.rows(), nfunc);
+    Eigen::MatrixXd der_y = Eigen::MatrixXd::Zero(points.rows(), nfunc);
+    Eigen::MatrixXd der_z = Eigen::MatrixXd::Zero(points.rows(), nfunc);
+    shell.EvalAOspace(points, values, der_x, der_y, der_z);
+    Eigen::MatrixXd values_2 = Eigen::MatrixXd::Zero(points.rows(), nfunc);
+    shell.EvalAOspace(points, values_2);
+
+    for (Index p = 0; p < points.rows(); p++) {
+      Eigen::VectorXd aoval = Eigen::VectorXd::Zero(nfunc);
+      Eigen::MatrixX3d aograd = Eigen::MatrixX3d::Zero(nfunc, 3);
+      Eigen::Block<Eigen::MatrixX3d> grad_block = aograd.block(0, 0, nfunc, 3);
+      Eigen::VectorBlock<Eigen::VectorXd> ao_block = aoval.segment(0, nfunc);
+      shell.EvalAOspace(ao_block, grad_block, points.row(p).transpose());
+
+      BOOST_CHECK(values.row(p).transpose().isApprox(aoval, 1e-10));
+      BOOST_CHECK(values_2.row(p).transpose().isApprox(aoval, 1e-10));
+      BOOST_CHECK(der_x.row(p).transpose().isApprox(aograd.col(0), 1e-10));
+      BOOST_CHECK(der_y.row(p).transpose().isApprox(aograd.col(1), 1e-10));
+      BOOST_CHECK(der_z.row(p).transpose().isApprox(aograd.col(2), 1e-10));
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
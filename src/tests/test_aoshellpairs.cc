@@ -0,0 +1,153 @@
+/*
+ * Copyright 2009-2020 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE aoshellpairs_test
+
+// Third party includes
+#include <boost/test/unit_test.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/aobasis.h"
+#include "votca/xtp/aoshellpairs.h"
+#include "votca/xtp/aotransform.h"
+#include "votca/xtp/basisset.h"
+#include "votca/xtp/qmmolecule.h"
+
+using namespace votca::xtp;
+using votca::Index;
+
+BOOST_AUTO_TEST_SUITE(aoshellpairs_test)
+
+// methane and a carbon atom 8 bohr away, so that the products of the tight
+// primitives of both are screened
+AOBasis MethaneAndCarbon(const Eigen::Vector3d& shift) {
+  QMMolecule mol(" ", 0);
+  mol.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                   "/aomatrix/molecule.xyz");
+  mol.push_back(QMAtom(5, "C", Eigen::Vector3d(8.0, 0.0, 0.0)));
+  mol.Translate(shift);
+  BasisSet basis;
+  basis.Load(std::string(XTP_TEST_DATA_FOLDER) + "/aomatrix/3-21G.xml");
+  AOBasis aobasis;
+  aobasis.Fill(basis, mol);
+  return aobasis;
+}
+
+BOOST_AUTO_TEST_CASE(screening) {
+  AOBasis aobasis = MethaneAndCarbon(Eigen::Vector3d::Zero());
+  AOShellPairs table(aobasis);
+  const Index nshells = aobasis.getNumofShells();
+  BOOST_CHECK_EQUAL(table.NumShells(), nshells);
+  BOOST_CHECK_EQUAL(table.NumShellPairs(), (nshells * (nshells + 1)) / 2);
+
+  Index allpairs = 0;
+  Index keptpairs = 0;
+  for (Index row = 0; row < nshells; row++) {
+    const AOShell& shell_row = aobasis.getShell(row);
+    for (Index col = 0; col <= row; col++) {
+      const AOShell& shell_col = aobasis.getShell(col);
+      AOShellPairs buffer;
+      AOShellPair pairs =
+          AOShellPairs::Lookup(&table, shell_row, shell_col, buffer);
+      BOOST_REQUIRE_EQUAL(buffer.NumPrimitivePairs(), 0);
+      const double distsq =
+          (shell_row.getPos() - shell_col.getPos()).squaredNorm();
+      Index i = 0;
+      for (const AOGaussianPrimitive& gaussian_row : shell_row) {
+        // the significant pairs of this row primitive in the order of the
+        // column primitives
+        std::vector<AOPrimitivePair> expected;
+        for (const AOGaussianPrimitive& gaussian_col : shell_col) {
+          allpairs++;
+          const double decay_row = gaussian_row.getDecay();
+          const double decay_col = gaussian_col.getDecay();
+          double exparg = decay_row * decay_col / (decay_row + decay_col) *
+                          distsq;
+          if (exparg <= AOShellPairs::ExpargCutoff) {
+            expected.push_back(
+                AOShellPairs::Product(gaussian_row, gaussian_col));
+          }
+        }
+        AOShellPair::Range range = pairs.Row(i);
+        BOOST_REQUIRE_EQUAL(range.size(), Index(expected.size()));
+        Index j = 0;
+        for (const AOPrimitivePair& pair : range) {
+          BOOST_CHECK_CLOSE(pair.decay_col, expected[j].decay_col, 1e-12);
+          BOOST_CHECK_CLOSE(pair.expfactor, expected[j].expfactor, 1e-10);
+          BOOST_CHECK(pair.P.isApprox(expected[j].P, 1e-12));
+          BOOST_CHECK(pair.expfactor >=
+                      std::exp(-AOShellPairs::ExpargCutoff) * (1 - 1e-12));
+          j++;
+        }
+        keptpairs += range.size();
+        i++;
+      }
+    }
+  }
+  BOOST_CHECK_EQUAL(keptpairs, table.NumPrimitivePairs());
+  // the tight primitives of the two carbons do not overlap
+  BOOST_CHECK(keptpairs < allpairs);
+}
+
+BOOST_AUTO_TEST_CASE(lookup_fallback) {
+  AOBasis aobasis = MethaneAndCarbon(Eigen::Vector3d::Zero());
+  AOShellPairs table(aobasis);
+  const AOShell& shell_first = aobasis.getShell(0);
+  const AOShell& shell_last = aobasis.getShell(aobasis.getNumofShells() - 1);
+
+  // pairs with row<col are not stored and are computed into the buffer
+  AOShellPairs buffer;
+  AOShellPair pairs =
+      AOShellPairs::Lookup(&table, shell_first, shell_last, buffer);
+  BOOST_CHECK_EQUAL(buffer.NumShellPairs(), 1);
+  BOOST_CHECK_EQUAL(pairs.size(), buffer.NumPrimitivePairs());
+  AOShellPairs buffer_transposed;
+  AOShellPair transposed =
+      AOShellPairs::Lookup(&table, shell_last, shell_first, buffer_transposed);
+  BOOST_CHECK_EQUAL(buffer_transposed.NumPrimitivePairs(), 0);
+  BOOST_CHECK_EQUAL(pairs.size(), transposed.size());
+
+  // the transformations are taken from the table without recomputing them
+  AOShellTrafos trafos(aobasis);
+  std::vector<Eigen::MatrixXd> trafo_buffer;
+  const Eigen::MatrixXd* trafo =
+      AOShellTrafos::Lookup(&trafos, shell_last, trafo_buffer);
+  BOOST_CHECK(trafo_buffer.empty());
+  for (const AOGaussianPrimitive& gaussian : shell_last) {
+    BOOST_CHECK(trafo->isApprox(AOTransform::getTrafo(gaussian), 1e-12));
+    trafo++;
+  }
+}
+
+BOOST_AUTO_TEST_CASE(foreign_shell) {
+  AOBasis aobasis = MethaneAndCarbon(Eigen::Vector3d::Zero());
+  AOBasis shifted = MethaneAndCarbon(Eigen::Vector3d(0.0, 0.0, 1.0));
+  AOShellPairs table(aobasis);
+  AOShellTrafos trafos(aobasis);
+
+  // the shells of the shifted basis have the same start indices, but belong
+  // to another geometry
+  const AOShell& shell = shifted.getShell(0);
+  AOShellPairs buffer;
+  BOOST_CHECK_THROW(AOShellPairs::Lookup(&table, shell, shell, buffer),
+                    std::runtime_error);
+  std::vector<Eigen::MatrixXd> trafo_buffer;
+  BOOST_CHECK_THROW(AOShellTrafos::Lookup(&trafos, shell, trafo_buffer),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
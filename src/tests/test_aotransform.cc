@@ -146,6 +146,10 @@ BOOST_AUTO_TEST_CASE(xintegrate) {
     std::cout << "result" << std::endl;
     std::cout << res6 << std::endl;
   }
+
+  Eigen::Matrix<double, 5, 1> res7;
+  AOTransform::XIntegrate(res7, 15);
+  BOOST_CHECK(res7.isApprox(res6, 1e-14));
 }
 
 BOOST_AUTO_TEST_CASE(blocksize) {
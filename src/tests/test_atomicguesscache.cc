@@ -0,0 +1,77 @@
+/*
+ * Copyright 2009-2020 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE atomicguesscache_test
+
+// Third party includes
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/atomicguesscache.h"
+
+using namespace votca::xtp;
+
+BOOST_AUTO_TEST_SUITE(atomicguesscache_test)
+
+BOOST_AUTO_TEST_CASE(memory) {
+  AtomicGuessCache& cache = AtomicGuessCache::Instance();
+  cache.Clear();
+  std::string key_C = AtomicGuessCache::MakeKey("C", "3-21G", "aux-def2-svp",
+                                                "", "PBE", "xfine");
+  std::string key_O = AtomicGuessCache::MakeKey("O", "3-21G", "aux-def2-svp",
+                                                "", "PBE", "xfine");
+  BOOST_CHECK(key_C != key_O);
+
+  Eigen::MatrixXd dmat = Eigen::MatrixXd::Random(9, 9);
+  Eigen::MatrixXd result;
+  BOOST_CHECK_EQUAL(cache.Find(key_C, "", result), false);
+  cache.Add(key_C, "", dmat);
+  BOOST_CHECK_EQUAL(cache.Find(key_C, "", result), true);
+  BOOST_CHECK(result.isApprox(dmat));
+  BOOST_CHECK_EQUAL(cache.Find(key_O, "", result), false);
+}
+
+BOOST_AUTO_TEST_CASE(file) {
+  AtomicGuessCache& cache = AtomicGuessCache::Instance();
+  cache.Clear();
+  std::string filename = "atomicguesses.hdf5";
+  boost::filesystem::remove(filename);
+
+  std::string key_C =
+      AtomicGuessCache::MakeKey("C", "3-21G", "", "", "PBE", "xfine");
+  std::string key_H =
+      AtomicGuessCache::MakeKey("H", "3-21G", "", "", "PBE", "xfine");
+  Eigen::MatrixXd dmat_C = Eigen::MatrixXd::Random(9, 9);
+  Eigen::MatrixXd dmat_H = Eigen::MatrixXd::Random(2, 2);
+  Eigen::MatrixXd result;
+  BOOST_CHECK_EQUAL(cache.Find(key_C, filename, result), false);
+  cache.Add(key_C, filename, dmat_C);
+  // another process, which has not read the file, adds to it
+  cache.Clear();
+  cache.Add(key_H, filename, dmat_H);
+
+  // a new process only sees the file
+  cache.Clear();
+  BOOST_CHECK_EQUAL(cache.Find(key_C, filename, result), true);
+  BOOST_CHECK(result.isApprox(dmat_C));
+  BOOST_CHECK_EQUAL(cache.Find(key_H, filename, result), true);
+  BOOST_CHECK(result.isApprox(dmat_H));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2009-2020 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE densityextrapolation_test
+
+// Third party includes
+#include <boost/test/unit_test.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/densityextrapolation.h"
+
+using namespace votca::xtp;
+
+BOOST_AUTO_TEST_SUITE(densityextrapolation_test)
+
+BOOST_AUTO_TEST_CASE(coefficients) {
+  Eigen::VectorXd k0 = DensityExtrapolation::Coefficients(0);
+  Eigen::VectorXd k0_ref = Eigen::VectorXd::Zero(2);
+  k0_ref << 2.0, -1.0;
+  BOOST_CHECK(k0.isApprox(k0_ref, 1e-12));
+
+  Eigen::VectorXd k1 = DensityExtrapolation::Coefficients(1);
+  Eigen::VectorXd k1_ref = Eigen::VectorXd::Zero(3);
+  k1_ref << 2.5, -2.0, 0.5;
+  BOOST_CHECK(k1.isApprox(k1_ref, 1e-12));
+
+  Eigen::VectorXd k2 = DensityExtrapolation::Coefficients(2);
+  Eigen::VectorXd k2_ref = Eigen::VectorXd::Zero(4);
+  k2_ref << 2.8, -2.8, 1.2, -0.2;
+  BOOST_CHECK(k2.isApprox(k2_ref, 1e-12));
+
+  for (votca::Index k = 0; k < 6; k++) {
+    BOOST_CHECK_CLOSE(DensityExtrapolation::Coefficients(k).sum(), 1.0, 1e-9);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(extrapolate) {
+  DensityExtrapolation history;
+  history.setOrder(2);
+  BOOST_CHECK(!history.hasGuess("3-21G:H:H:H"));
+
+  Eigen::MatrixXd D0 = Eigen::MatrixXd::Identity(3, 3);
+  Eigen::MatrixXd dD = Eigen::MatrixXd::Ones(3, 3);
+  history.Push(D0, "3-21G:H:H:H");
+  BOOST_CHECK(history.hasGuess("3-21G:H:H:H"));
+  BOOST_CHECK(!history.hasGuess("3-21G:He:H:H"));
+  BOOST_CHECK(history.Extrapolate().isApprox(D0, 1e-12));
+
+  // a linear drift is extrapolated exactly by every order
+  for (votca::Index step = 1; step < 6; step++) {
+    history.Push(D0 + double(step) * dD, "3-21G:H:H:H");
+    BOOST_CHECK(history.size() <= 4);
+    Eigen::MatrixXd expected = D0 + double(step + 1) * dD;
+    BOOST_CHECK(history.Extrapolate().isApprox(expected, 1e-12));
+  }
+
+  // the reference starts from the newest density and does not change the
+  // history
+  DensityExtrapolation reference = history.Reference();
+  BOOST_CHECK_EQUAL(reference.size(), 1);
+  BOOST_CHECK(reference.hasGuess("3-21G:H:H:H"));
+  BOOST_CHECK(reference.Extrapolate().isApprox(D0 + 5.0 * dD, 1e-12));
+  reference.Push(D0, "3-21G:H:H:H");
+  BOOST_CHECK_EQUAL(history.size(), 4);
+  BOOST_CHECK(history.Extrapolate().isApprox(D0 + 6.0 * dD, 1e-12));
+
+  // a different basis resets the history, even if it has the same size
+  history.Push(D0, "3-21G:He:H:H");
+  BOOST_CHECK_EQUAL(history.size(), 1);
+  BOOST_CHECK(history.hasGuess("3-21G:He:H:H"));
+  BOOST_CHECK(!history.hasGuess("3-21G:H:H:H"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
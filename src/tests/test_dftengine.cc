@@ -348,4 +348,93 @@ BOOST_AUTO_TEST_CASE(density_guess) {
   }
 }
 
+votca::tools::Property UnrestrictedOptions(votca::Index charge,
+                                           votca::Index spin) {
+  std::ofstream xml("dftengine_unrestricted.xml");
+  xml << "<package>" << std::endl;
+  xml << "<spin>" << spin << "</spin>" << std::endl;
+  xml << "<name>xtp</name>" << std::endl;
+  xml << "<charge>" << charge << "</charge>" << std::endl;
+  xml << "<functional>XC_HYB_GGA_XC_PBEH</functional>" << std::endl;
+  xml << "<basisset>3-21G.xml</basisset>" << std::endl;
+  xml << "<use_auxbasisset>false</use_auxbasisset>" << std::endl;
+  xml << "<use_ecp>false</use_ecp>" << std::endl;
+  xml << "<read_guess>0</read_guess>" << std::endl;
+  xml << "<xtpdft>" << std::endl;
+  xml << "<unrestricted>true</unrestricted>" << std::endl;
+  xml << "<use_external_field>false</use_external_field>" << std::endl;
+  xml << "<use_external_density>false</use_external_density>" << std::endl;
+  xml << "<with_screening choices=\"bool\">true</with_screening>\n";
+  xml << "<screening_eps  choices=\"float+\">1e-9</screening_eps>\n";
+  xml << "<four_center_method>cache</four_center_method>\n";
+  xml << "<convergence>" << std::endl;
+  xml << "    <energy>1e-7</energy>" << std::endl;
+  xml << "    <method>DIIS</method>" << std::endl;
+  xml << "    <DIIS_start>0.002</DIIS_start>" << std::endl;
+  xml << "    <ADIIS_start>0.8</ADIIS_start>" << std::endl;
+  xml << "    <DIIS_length>20</DIIS_length>" << std::endl;
+  xml << "    <levelshift>0.0</levelshift>" << std::endl;
+  xml << "    <levelshift_end>0.2</levelshift_end>" << std::endl;
+  xml << "    <max_iterations choices=\"int+\">100</max_iterations>\n";
+  xml << "    <error choices=\"float+\">1e-7</error>\n";
+  xml << "    <DIIS_maxout choices=\"bool\">false</DIIS_maxout>\n";
+  xml << "    <mixing choices=\"float+\">0.7</mixing>\n";
+  xml << "</convergence>" << std::endl;
+  xml << "<initial_guess>independent</initial_guess>" << std::endl;
+  xml << "<integration_grid>xcoarse</integration_grid>" << std::endl;
+  xml << "<integration_grid_small>0</integration_grid_small>" << std::endl;
+  xml << "<max_iterations>200</max_iterations>" << std::endl;
+  xml << "</xtpdft>" << std::endl;
+  xml << "</package>" << std::endl;
+  xml.close();
+  votca::tools::Property prop;
+  prop.LoadFromXML("dftengine_unrestricted.xml");
+  return prop;
+}
+
+BOOST_AUTO_TEST_CASE(dft_unrestricted) {
+  WriteBasis321G();
+
+  // for a closed shell both spins have to reproduce the restricted result
+  Orbitals orb;
+  orb.QMAtoms() = Water();
+  votca::tools::Property prop = UnrestrictedOptions(0, 1);
+  DFTEngine dft;
+  Logger log;
+  dft.setLogger(&log);
+  dft.Initialize(prop);
+  BOOST_CHECK(dft.Evaluate(orb));
+  BOOST_CHECK(orb.hasBetaMOs());
+  BOOST_CHECK_CLOSE(orb.getDFTTotalEnergy(), -75.891017293070945, 1e-5);
+
+  Eigen::VectorXd MOs_energy_ref = Eigen::VectorXd::Zero(13);
+  MOs_energy_ref << -19.0739, -1.01904, -0.520731, -0.341996, -0.27356,
+      0.118834, 0.210783, 0.953576, 1.04314, 1.46895, 1.54729, 1.67293, 2.77584;
+  BOOST_CHECK(MOs_energy_ref.isApprox(orb.MOs().eigenvalues(), 1e-5));
+  BOOST_CHECK(MOs_energy_ref.isApprox(orb.MOs_beta().eigenvalues(), 1e-5));
+
+  Eigen::MatrixXd dmat = orb.DensityMatrixGroundState();
+  AOBasis basis = orb.SetupDftBasis();
+  AOOverlap overlap;
+  overlap.Fill(basis);
+  BOOST_CHECK_CLOSE(dmat.cwiseProduct(overlap.Matrix()).sum(), 10.0, 1e-8);
+
+  // the doublet cation
+  Orbitals cation;
+  cation.QMAtoms() = Water();
+  votca::tools::Property prop_cation = UnrestrictedOptions(1, 2);
+  DFTEngine dft_cation;
+  dft_cation.setLogger(&log);
+  dft_cation.Initialize(prop_cation);
+  BOOST_CHECK(dft_cation.Evaluate(cation));
+  BOOST_CHECK_EQUAL(cation.getNumberOfAlphaElectrons(), 5);
+  BOOST_CHECK_EQUAL(cation.getNumberOfBetaElectrons(), 4);
+  // the ionisation energy of water is about 0.46 Ha
+  double ionisation = cation.getDFTTotalEnergy() - orb.getDFTTotalEnergy();
+  BOOST_CHECK(ionisation > 0.3 && ionisation < 0.6);
+  Eigen::MatrixXd dmat_cation = cation.DensityMatrixGroundState();
+  BOOST_CHECK_CLOSE(dmat_cation.cwiseProduct(overlap.Matrix()).sum(), 9.0,
+                    1e-8);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
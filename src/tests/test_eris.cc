@@ -563,6 +563,18 @@ BOOST_AUTO_TEST_CASE(threecenter) {
     std::cout << eris_ref << std::endl;
   }
   BOOST_CHECK_EQUAL(compare_eris, true);
+
+  Eigen::MatrixXd eri_diff = eris.CalculateERIs_diff(dmat, 0.0);
+  bool compare_eris_diff = eri_diff.isApprox(eri.matrix(), 1e-8);
+  BOOST_CHECK_EQUAL(compare_eris_diff, true);
+
+  Eigen::MatrixXd exx_diff = eris.CalculateEXX_diff(dmat, 0.0);
+  bool compare_exx_diff = exx_diff.isApprox(exx_dmat.matrix(), 1e-8);
+  BOOST_CHECK_EQUAL(compare_exx_diff, true);
+
+  Eigen::MatrixXd eri_fit = eris.ContractFit(eris.FitDensity(dmat));
+  bool compare_eris_fit = eri_fit.isApprox(eri.matrix(), 1e-8);
+  BOOST_CHECK_EQUAL(compare_eris_fit, true);
 }
 
 BOOST_AUTO_TEST_CASE(fourcenter_direct) {
@@ -712,6 +724,35 @@ BOOST_AUTO_TEST_CASE(fourcenter_direct) {
     std::cout << eris_cached.matrix() << std::endl;
   }
   BOOST_CHECK_EQUAL(check_eris, 1);
+
+  // only part of the quartets fit into the cache
+  ERIs eris3;
+  eris3.Initialize_4c_semidirect(aobasis, 1e-10, 0.05);
+  BOOST_CHECK(eris3.CachedQuartets() > 0);
+  std::pair<Mat_p_Energy, Mat_p_Energy> JK =
+      eris3.CalculateERIs_EXX_4c_semidirect(aobasis, dmat, true);
+  Mat_p_Energy exx_cached = eris2.CalculateEXX_4c_small_molecule(dmat);
+  bool check_J = JK.first.matrix().isApprox(eris_cached.matrix(), 1e-6);
+  bool check_K = JK.second.matrix().isApprox(exx_cached.matrix(), 1e-6);
+  if (!check_J || !check_K) {
+    std::cout << "J semidirect" << std::endl;
+    std::cout << JK.first.matrix() << std::endl;
+    std::cout << "K semidirect" << std::endl;
+    std::cout << JK.second.matrix() << std::endl;
+    std::cout << "K cached" << std::endl;
+    std::cout << exx_cached.matrix() << std::endl;
+  }
+  BOOST_CHECK_EQUAL(check_J, true);
+  BOOST_CHECK_EQUAL(check_K, true);
+
+  // unrestricted: J of the total and K of each spin density in one pass
+  Eigen::MatrixXd dmat_beta = 0.3 * dmat;
+  std::array<Eigen::MatrixXd, 3> JK_spin =
+      eris3.CalculateERIs_EXX_4c_semidirect(aobasis, dmat, dmat_beta);
+  Mat_p_Energy exx_beta = eris2.CalculateEXX_4c_small_molecule(dmat_beta);
+  BOOST_CHECK(JK_spin[0].isApprox(1.3 * eris_cached.matrix(), 1e-6));
+  BOOST_CHECK(JK_spin[1].isApprox(exx_cached.matrix(), 1e-6));
+  BOOST_CHECK(JK_spin[2].isApprox(exx_beta.matrix(), 1e-6));
 }
 
 BOOST_AUTO_TEST_SUITE_END()
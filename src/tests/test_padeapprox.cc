@@ -0,0 +1,61 @@
+/*
+ * Copyright 2009-2020 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE padeapprox_test
+
+// Third party includes
+#include <boost/test/unit_test.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/padeapprox.h"
+
+using namespace votca::xtp;
+using votca::Index;
+
+BOOST_AUTO_TEST_SUITE(padeapprox_test)
+
+BOOST_AUTO_TEST_CASE(rational_function) {
+  // three poles below the real axis, as for a retarded self-energy
+  auto f = [](std::complex<double> z) {
+    return 0.3 / (z - std::complex<double>(-0.5, -0.01)) +
+           0.2 / (z - std::complex<double>(0.8, -0.01)) +
+           0.1 / (z - std::complex<double>(1.5, -0.01));
+  };
+  auto df = [](std::complex<double> z) {
+    return -0.3 / std::pow(z - std::complex<double>(-0.5, -0.01), 2) -
+           0.2 / std::pow(z - std::complex<double>(0.8, -0.01), 2) -
+           0.1 / std::pow(z - std::complex<double>(1.5, -0.01), 2);
+  };
+
+  Eigen::VectorXcd points = Eigen::VectorXcd(8);
+  Eigen::VectorXcd values = Eigen::VectorXcd(8);
+  for (Index j = 0; j < points.size(); j++) {
+    points(j) = std::complex<double>(0.2, 0.25 * double(j + 1));
+    values(j) = f(points(j));
+  }
+  PadeApprox pade;
+  pade.Fit(points, values);
+
+  // a rational function of low enough degree is reproduced everywhere
+  for (double x = -1.0; x < 2.0; x += 0.1) {
+    const std::complex<double> z(x, 0.05);
+    BOOST_CHECK_SMALL(std::abs(pade.value(z) - f(z)), 1e-8);
+    BOOST_CHECK_SMALL(std::abs(pade.derivative(z) - df(z)), 1e-6);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
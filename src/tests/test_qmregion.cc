@@ -0,0 +1,201 @@
+/*
+ * Copyright 2009-2020 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE qmregion_test
+
+// Standard includes
+#include <sstream>
+
+// Third party includes
+#include <boost/test/unit_test.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/qmregion.h"
+#include "votca/xtp/staticregion.h"
+
+using namespace votca::xtp;
+
+BOOST_AUTO_TEST_SUITE(qmregion_test)
+
+QMMolecule Water() {
+  std::ofstream xyzfile("molecule.xyz");
+  xyzfile << "3" << std::endl;
+  xyzfile << "Water molecule" << std::endl;
+  xyzfile << "O          0.00000        0.00000        0.11779" << std::endl;
+  xyzfile << "H          0.00000        0.75545       -0.47116" << std::endl;
+  xyzfile << "H          0.00000       -0.75545       -0.47116" << std::endl;
+
+  xyzfile.close();
+  QMMolecule mol("water", 0);
+  mol.LoadFromFile("molecule.xyz");
+  return mol;
+}
+
+void WriteBasis321G() {
+  std::ofstream basisfile("3-21G.xml");
+  basisfile << "<basis name=\"3-21G\">" << std::endl;
+  basisfile << "  <!--Basis set created by xtp_basisset from 3-21G.nwchem at "
+               "Thu Sep 15 15:40:33 2016-->"
+            << std::endl;
+  basisfile << "  <element name=\"H\">" << std::endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"S\">" << std::endl;
+  basisfile << "      <constant decay=\"5.447178e+00\">" << std::endl;
+  basisfile << "        <contractions factor=\"1.562850e-01\" type=\"S\"/>"
+            << std::endl;
+  basisfile << "      </constant>" << std::endl;
+  basisfile << "      <constant decay=\"8.245470e-01\">" << std::endl;
+  basisfile << "        <contractions factor=\"9.046910e-01\" type=\"S\"/>"
+            << std::endl;
+  basisfile << "      </constant>" << std::endl;
+  basisfile << "    </shell>" << std::endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"S\">" << std::endl;
+  basisfile << "      <constant decay=\"1.831920e-01\">" << std::endl;
+  basisfile << "        <contractions factor=\"1.000000e+00\" type=\"S\"/>"
+            << std::endl;
+  basisfile << "      </constant>" << std::endl;
+  basisfile << "    </shell>" << std::endl;
+  basisfile << "  </element>" << std::endl;
+  basisfile << "  <element name=\"O\">" << std::endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"S\">" << std::endl;
+  basisfile << "      <constant decay=\"3.220370e+02\">" << std::endl;
+  basisfile << "        <contractions factor=\"5.923940e-02\" type=\"S\"/>"
+            << std::endl;
+  basisfile << "      </constant>" << std::endl;
+  basisfile << "      <constant decay=\"4.843080e+01\">" << std::endl;
+  basisfile << "        <contractions factor=\"3.515000e-01\" type=\"S\"/>"
+            << std::endl;
+  basisfile << "      </constant>" << std::endl;
+  basisfile << "      <constant decay=\"1.042060e+01\">" << std::endl;
+  basisfile << "        <contractions factor=\"7.076580e-01\" type=\"S\"/>"
+            << std::endl;
+  basisfile << "      </constant>" << std::endl;
+  basisfile << "    </shell>" << std::endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"SP\">" << std::endl;
+  basisfile << "      <constant decay=\"7.402940e+00\">" << std::endl;
+  basisfile << "        <contractions factor=\"-4.044530e-01\" type=\"S\"/>"
+            << std::endl;
+  basisfile << "        <contractions factor=\"2.445860e-01\" type=\"P\"/>"
+            << std::endl;
+  basisfile << "      </constant>" << std::endl;
+  basisfile << "      <constant decay=\"1.576200e+00\">" << std::endl;
+  basisfile << "        <contractions factor=\"1.221560e+00\" type=\"S\"/>"
+            << std::endl;
+  basisfile << "        <contractions factor=\"8.539550e-01\" type=\"P\"/>"
+            << std::endl;
+  basisfile << "      </constant>" << std::endl;
+  basisfile << "    </shell>" << std::endl;
+  basisfile << "    <shell scale=\"1.0\" type=\"SP\">" << std::endl;
+  basisfile << "      <constant decay=\"3.736840e-01\">" << std::endl;
+  basisfile << "        <contractions factor=\"1.000000e+00\" type=\"S\"/>"
+            << std::endl;
+  basisfile << "        <contractions factor=\"1.000000e+00\" type=\"P\"/>"
+            << std::endl;
+  basisfile << "      </constant>" << std::endl;
+  basisfile << "    </shell>" << std::endl;
+  basisfile << "  </element>" << std::endl;
+  basisfile << "</basis>" << std::endl;
+  basisfile.close();
+}
+
+void WriteOptions() {
+  std::ofstream xml("qmregion.xml");
+  xml << "<region>" << std::endl;
+  xml << "<state>groundstate</state>" << std::endl;
+  xml << "<options_dft>" << std::endl;
+  xml << "<package>" << std::endl;
+  xml << "<name>xtp</name>" << std::endl;
+  xml << "<spin>1</spin>" << std::endl;
+  xml << "<charge>0</charge>" << std::endl;
+  xml << "<functional>XC_HYB_GGA_XC_PBEH</functional>" << std::endl;
+  xml << "<basisset>3-21G.xml</basisset>" << std::endl;
+  xml << "<use_auxbasisset>false</use_auxbasisset>" << std::endl;
+  xml << "<use_ecp>false</use_ecp>" << std::endl;
+  xml << "<read_guess>0</read_guess>" << std::endl;
+  xml << "<write_charges>true</write_charges>" << std::endl;
+  xml << "<xtpdft>" << std::endl;
+  xml << "<write_orb_file>false</write_orb_file>" << std::endl;
+  xml << "<density_extrapolation>aspc</density_extrapolation>" << std::endl;
+  xml << "<aspc_order>2</aspc_order>" << std::endl;
+  xml << "<use_external_field>false</use_external_field>" << std::endl;
+  xml << "<use_external_density>false</use_external_density>" << std::endl;
+  xml << "<with_screening choices=\"bool\">true</with_screening>\n";
+  xml << "<screening_eps  choices=\"float+\">1e-9</screening_eps>\n";
+  xml << "<four_center_method>cache</four_center_method>\n";
+  xml << "<convergence>" << std::endl;
+  xml << "    <energy>1e-7</energy>" << std::endl;
+  xml << "    <method>DIIS</method>" << std::endl;
+  xml << "    <DIIS_start>0.002</DIIS_start>" << std::endl;
+  xml << "    <ADIIS_start>0.8</ADIIS_start>" << std::endl;
+  xml << "    <DIIS_length>20</DIIS_length>" << std::endl;
+  xml << "    <levelshift>0.0</levelshift>" << std::endl;
+  xml << "    <levelshift_end>0.2</levelshift_end>" << std::endl;
+  xml << "    <max_iterations choices=\"int+\">100</max_iterations>\n";
+  xml << "    <error choices=\"float+\">1e-7</error>\n";
+  xml << "    <DIIS_maxout choices=\"bool\">false</DIIS_maxout>\n";
+  xml << "    <mixing choices=\"float+\">0.7</mixing>\n";
+  xml << "</convergence>" << std::endl;
+  xml << "<initial_guess>independent</initial_guess>" << std::endl;
+  xml << "<integration_grid>xcoarse</integration_grid>" << std::endl;
+  xml << "<integration_grid_small>0</integration_grid_small>" << std::endl;
+  xml << "<max_iterations>200</max_iterations>" << std::endl;
+  xml << "</xtpdft>" << std::endl;
+  xml << "</package>" << std::endl;
+  xml << "</options_dft>" << std::endl;
+  xml << "</region>" << std::endl;
+  xml.close();
+}
+
+BOOST_AUTO_TEST_CASE(two_qmmm_iterations) {
+  WriteBasis321G();
+  WriteOptions();
+  votca::tools::Property prop;
+  prop.LoadFromXML("qmregion.xml");
+
+  Logger log;
+  std::vector<std::unique_ptr<Region> > regions;
+  QMRegion* qmregion = new QMRegion(0, log, ".");
+  regions.push_back(std::unique_ptr<Region>(qmregion));
+  qmregion->Initialize(prop.get("region"));
+  qmregion->push_back(Water());
+
+  StaticRegion* staticregion = new StaticRegion(1, log);
+  regions.push_back(std::unique_ptr<Region>(staticregion));
+  StaticSegment seg("charge", 0);
+  StaticSite site(0, "H", Eigen::Vector3d(0.0, 0.0, 6.0));
+  site.setCharge(0.5);
+  seg.push_back(site);
+  staticregion->push_back(seg);
+
+  // same loop as in the qmmm calculator, the static environment does not
+  // change, so the second iteration must reproduce the first one
+  for (votca::Index iteration = 0; iteration < 2; iteration++) {
+    for (std::unique_ptr<Region>& region : regions) {
+      region->Reset();
+      region->Evaluate(regions);
+      BOOST_CHECK(region->Successful());
+    }
+  }
+  BOOST_CHECK(qmregion->Converged());
+
+  // the density history of the first iteration survives the Reset
+  std::stringstream messages;
+  messages << log;
+  BOOST_CHECK(messages.str().find("Extrapolating initial guess from 1 "
+                                  "previous densities") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -116,6 +116,76 @@ BOOST_AUTO_TEST_CASE(rpa_full) {
   }
 
   BOOST_CHECK_EQUAL(r_check, 1);
+
+  // on the imaginary axis the complex dielectric matrix is real
+  Eigen::MatrixXcd e_c =
+      rpa.calculate_epsilon_complex(std::complex<double>(0.0, 0.5));
+  bool c_check = i_ref.isApprox(e_c.real(), 0.0001);
+  if (!c_check) {
+    cout << "Epsilon_c" << endl;
+    cout << e_c.real() << endl;
+    cout << "Epsilon_i_ref" << endl;
+    cout << i_ref << endl;
+  }
+  BOOST_CHECK_EQUAL(c_check, 1);
+  BOOST_CHECK_SMALL(e_c.imag().cwiseAbs().maxCoeff(), 1e-10);
+
+  // several frequencies at once give the same matrices
+  std::vector<Eigen::MatrixXd> e_batch = rpa.calculate_epsilon(
+      Eigen::VectorXd::Constant(1, 0.0), Eigen::VectorXd::Constant(1, 0.5));
+  BOOST_CHECK_EQUAL(e_batch.size(), 2u);
+  bool batch_check =
+      r_ref.isApprox(e_batch[0], 0.0001) && i_ref.isApprox(e_batch[1], 0.0001);
+  BOOST_CHECK_EQUAL(batch_check, 1);
+}
+
+BOOST_AUTO_TEST_CASE(rpa_panels) {
+  // an aux basis of several column panels, filled with random integrals
+  const Index auxsize = 150;
+  Logger log;
+  TCMatrix_gwbse Mmn{log};
+  Mmn.Initialize(auxsize, 0, 16, 0, 16);
+  for (Index m = 0; m < 17; m++) {
+    Mmn[m] = 0.1 * Eigen::MatrixXd::Random(17, auxsize);
+  }
+  Eigen::VectorXd energies = Eigen::VectorXd::LinSpaced(17, -1.0, 2.0);
+
+  RPA rpa(log, Mmn);
+  rpa.configure(4, 0, 16);
+  rpa.setRPAInputEnergies(energies);
+
+  Eigen::VectorXd real_frequencies = Eigen::VectorXd::LinSpaced(3, 0.0, 0.6);
+  Eigen::VectorXd imaginary_frequencies =
+      Eigen::VectorXd::LinSpaced(9, 0.0, 4.0);
+  std::vector<Eigen::MatrixXd> eps =
+      rpa.calculate_epsilon(real_frequencies, imaginary_frequencies);
+  BOOST_REQUIRE_EQUAL(eps.size(), 12u);
+
+  const double eta2 = 1e-8;
+  for (Index f = 0; f < 12; f++) {
+    Eigen::MatrixXd ref = Eigen::MatrixXd::Identity(auxsize, auxsize);
+    for (Index v = 0; v < 5; v++) {
+      const Eigen::MatrixXd Mmn_RPA = Mmn[v].bottomRows(12);
+      const Eigen::ArrayXd deltaE = energies.tail(12).array() - energies(v);
+      Eigen::VectorXd denom;
+      if (f < 3) {
+        const Eigen::ArrayXd minus = deltaE - real_frequencies(f);
+        const Eigen::ArrayXd plus = deltaE + real_frequencies(f);
+        denom = 2 * (minus / (minus.square() + eta2) +
+                     plus / (plus.square() + eta2));
+      } else {
+        const double freq2 =
+            imaginary_frequencies(f - 3) * imaginary_frequencies(f - 3);
+        denom = 4 * deltaE / (deltaE.square() + freq2);
+      }
+      ref += Mmn_RPA.transpose() * denom.asDiagonal() * Mmn_RPA;
+    }
+    BOOST_CHECK_SMALL((eps[f] - ref).cwiseAbs().maxCoeff(), 1e-10);
+  }
+
+  // a single frequency agrees with the same frequency in the batched call
+  Eigen::MatrixXd eps_single = rpa.calculate_epsilon_i(1.0);
+  BOOST_CHECK_SMALL((eps_single - eps[5]).cwiseAbs().maxCoeff(), 1e-10);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
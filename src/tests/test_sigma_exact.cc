@@ -19,6 +19,7 @@
 
 // Standard includes
 #include <fstream>
+#include <sstream>
 
 // Third party includes
 #include <boost/test/unit_test.hpp>
@@ -34,6 +35,7 @@
 #include "votca/xtp/threecenter.h"
 
 using namespace votca::xtp;
+using votca::Index;
 using namespace std;
 
 BOOST_AUTO_TEST_SUITE(sigma_test)
@@ -113,6 +115,42 @@ BOOST_AUTO_TEST_CASE(sigma_full) {
     cout << c_ref << endl;
   }
   BOOST_CHECK_EQUAL(check_c, true);
+
+  // a memory limit below the levels needed by the threads warns and
+  // recomputes all residues on demand
+  Sigma_Exact sigma_streamed = Sigma_Exact(Mmn, rpa);
+  opt.residue_memory = 1e-6;
+  sigma_streamed.configure(opt);
+  sigma_streamed.PrepareScreening();
+  Eigen::MatrixXd c_streamed = sigma_streamed.CalcCorrelationOffDiag(mo_energy);
+  c_streamed.diagonal() = sigma_streamed.CalcCorrelationDiag(mo_energy);
+  bool check_c_streamed = c_streamed.isApprox(c, 1e-10);
+  if (!check_c_streamed) {
+    cout << "Sigma C streamed" << endl;
+    cout << c_streamed << endl;
+    cout << "Sigma C" << endl;
+    cout << c << endl;
+  }
+  BOOST_CHECK_EQUAL(check_c_streamed, true);
+  std::stringstream messages;
+  messages << log;
+  BOOST_CHECK(messages.str().find("WARNING! residue_memory") !=
+              std::string::npos);
+
+  // ten stored levels and the remaining seven in batches
+  const double level_memory = 17.0 * 60.0 * sizeof(double) / 1024.0 / 1024.0;
+  const Index min_levels = std::max(Index(2), OPENMP::getMaxThreads());
+  Sigma_Exact sigma_batched = Sigma_Exact(Mmn, rpa);
+  opt.residue_memory = (double(min_levels) + 10.5) * level_memory;
+  sigma_batched.configure(opt);
+  sigma_batched.PrepareScreening();
+  Eigen::MatrixXd c_batched = sigma_batched.CalcCorrelationOffDiag(mo_energy);
+  c_batched.diagonal() = sigma_batched.CalcCorrelationDiag(mo_energy);
+  BOOST_CHECK(c_batched.isApprox(c, 1e-10));
+  BOOST_CHECK_SMALL(sigma_batched.CalcCorrelationOffDiagElement(
+                        12, 15, mo_energy(12), mo_energy(15)) -
+                        c(12, 15),
+                    1e-10);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
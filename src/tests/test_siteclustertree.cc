@@ -0,0 +1,117 @@
+/*
+ * Copyright 2009-2020 The VOTCA Development Team (http://www.votca.org)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#define BOOST_TEST_MAIN
+
+#define BOOST_TEST_MODULE siteclustertree_test
+
+// Third party includes
+#include <boost/test/unit_test.hpp>
+
+// Local VOTCA includes
+#include "votca/xtp/classicalsegment.h"
+#include "votca/xtp/eeinteractor.h"
+#include "votca/xtp/siteclustertree.h"
+
+using namespace votca::xtp;
+using votca::Index;
+
+BOOST_AUTO_TEST_SUITE(siteclustertree_test)
+
+BOOST_AUTO_TEST_CASE(cluster_multipoles) {
+
+  // charges, dipoles and quadrupoles in a box of about 1.5 bohr
+  std::vector<std::unique_ptr<StaticSite> > sites;
+  StaticSegment exact_seg("exact", 0);
+  Index id = 0;
+  for (Index i = 0; i < 3; i++) {
+    for (Index j = 0; j < 3; j++) {
+      for (Index k = 0; k < 3; k++) {
+        Eigen::Vector3d pos(0.7 * double(i) + 0.1 * double(j),
+                            0.6 * double(j) - 0.05 * double(k),
+                            0.8 * double(k) + 0.1 * double(i));
+        std::unique_ptr<StaticSite> site(new StaticSite(id, "", pos));
+        Vector9d multipoles = Vector9d::Zero();
+        multipoles(0) = 0.3 * double((i + 2 * j + k) % 3 - 1);
+        const Index rank = id % 3;
+        if (rank > 0) {
+          multipoles(1) = 0.1 * double(i - 1);
+          multipoles(2) = 0.05 * double(j - k);
+          multipoles(3) = 0.08 * double(k - 1);
+        }
+        if (rank > 1) {
+          for (Index c = 4; c < 9; c++) {
+            multipoles(c) = 0.05 * double((c + id) % 5 - 2);
+          }
+        }
+        site->setMultipole(multipoles, rank);
+        exact_seg.push_back(*site);
+        sites.push_back(std::move(site));
+        id++;
+      }
+    }
+  }
+
+  // seen from far away, the whole tree is a single cluster
+  SiteClusterTree tree(sites);
+  std::vector<const StaticSite*> exact;
+  std::vector<StaticSite> clusters;
+  tree.Partition(Eigen::Vector3d(100, 0, 0), 1.0, 1.0, exact, clusters);
+  BOOST_CHECK_EQUAL(exact.size(), 0);
+  BOOST_REQUIRE_EQUAL(clusters.size(), 1);
+  const StaticSite& cluster = clusters[0];
+  BOOST_CHECK_EQUAL(cluster.getRank(), 2);
+
+  double charge = 0.0;
+  Eigen::Vector3d dipole = Eigen::Vector3d::Zero();
+  for (const StaticSite& site : exact_seg) {
+    charge += site.getCharge();
+    dipole += site.getCharge() * (site.getPos() - cluster.getPos()) +
+              site.getDipole();
+  }
+  BOOST_CHECK_CLOSE(cluster.getCharge(), charge, 1e-10);
+  BOOST_CHECK(cluster.getDipole().isApprox(dipole, 1e-10));
+
+  // the quadrupole is checked via the energy of a probe charge, the error of
+  // the cluster has to be far below the quadrupole contribution, it only
+  // comes from the octupole and higher moments
+  StaticSegment cluster_seg("cluster", 1);
+  cluster_seg.push_back(cluster);
+  StaticSegment dipole_seg("dipole", 2);
+  StaticSite dipole_only = cluster;
+  dipole_only.setMultipole(cluster.Q(), 1);
+  dipole_seg.push_back(dipole_only);
+
+  eeInteractor interactor;
+  double max_error = 0.0;
+  double max_quadrupole = 0.0;
+  for (Index d = 0; d < 6; d++) {
+    Eigen::Vector3d dir = Eigen::Vector3d(0.3, 0.2, 0.1);
+    dir[d % 3] += (d < 3) ? 1.0 : -1.0;
+    StaticSegment probe("probe", 3);
+    StaticSite charge_site(0, "", cluster.getPos() + 50.0 * dir.normalized());
+    charge_site.setCharge(1.0);
+    probe.push_back(charge_site);
+    const double e_exact = interactor.CalcStaticEnergy(probe, exact_seg);
+    const double e_cluster = interactor.CalcStaticEnergy(probe, cluster_seg);
+    const double e_dipole = interactor.CalcStaticEnergy(probe, dipole_seg);
+    max_error = std::max(max_error, std::abs(e_exact - e_cluster));
+    max_quadrupole = std::max(max_quadrupole, std::abs(e_cluster - e_dipole));
+  }
+  BOOST_CHECK(max_quadrupole > 0.0);
+  BOOST_CHECK_LT(max_error, 0.05 * max_quadrupole);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -51,6 +51,22 @@ BOOST_AUTO_TEST_CASE(Constructor_test) {
   BOOST_CHECK_EQUAL(check_matrices, 1);
 }
 
+BOOST_AUTO_TEST_CASE(Packed_Constructor_test) {
+  Index dim = 4;
+  Eigen::VectorXd packed = Eigen::VectorXd::Random((dim + 1) * dim / 2);
+  Symmetric_Matrix sym = Symmetric_Matrix(dim, packed);
+  Eigen::MatrixXd full = sym.FullMatrix();
+
+  Index index = 0;
+  for (Index i = 0; i < dim; ++i) {
+    for (Index j = 0; j <= i; ++j) {
+      BOOST_CHECK_EQUAL(full(i, j), packed(index));
+      BOOST_CHECK_EQUAL(full(j, i), packed(index));
+      index++;
+    }
+  }
+}
+
 BOOST_AUTO_TEST_CASE(Add_test) {
 
   Index dim = 3;
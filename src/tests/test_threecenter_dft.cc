@@ -92,6 +92,68 @@ BOOST_AUTO_TEST_CASE(small_basis) {
   BOOST_CHECK_EQUAL(check_three2, true);
 }
 
+BOOST_AUTO_TEST_CASE(screening) {
+
+  QMMolecule mol(" ", 0);
+  mol.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                   "/threecenter_dft/molecule.xyz");
+  BasisSet basis;
+  basis.Load(std::string(XTP_TEST_DATA_FOLDER) + "/threecenter_dft/3-21G.xml");
+  AOBasis aobasis;
+  aobasis.Fill(basis, mol);
+  TCMatrix_dft threec;
+  threec.Fill(aobasis, aobasis);
+
+  TCMatrix_dft threec_full;
+  threec_full.setScreening(0.0);
+  threec_full.Fill(aobasis, aobasis);
+  Index dftsize = aobasis.AOBasisSize();
+  BOOST_CHECK_EQUAL(threec_full.pairsize(), (dftsize * (dftsize + 1)) / 2);
+  BOOST_CHECK(threec.pairsize() <= threec_full.pairsize());
+
+  for (Index i = 0; i < threec.size(); i++) {
+    bool check = threec[i].FullMatrix().isApprox(threec_full[i].FullMatrix(),
+                                                 1e-9);
+    BOOST_CHECK_EQUAL(check, true);
+  }
+
+  Eigen::VectorXd packed = Eigen::VectorXd::Random(threec_full.pairsize());
+  Eigen::VectorXd roundtrip =
+      threec_full.ScatterPairs(threec_full.GatherPairs(packed));
+  BOOST_CHECK(roundtrip.isApprox(packed));
+}
+
+BOOST_AUTO_TEST_CASE(out_of_core) {
+
+  QMMolecule mol(" ", 0);
+  mol.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                   "/threecenter_dft/molecule.xyz");
+  BasisSet basis;
+  basis.Load(std::string(XTP_TEST_DATA_FOLDER) + "/threecenter_dft/3-21G.xml");
+  AOBasis aobasis;
+  aobasis.Fill(basis, mol);
+  TCMatrix_dft threec;
+  threec.Fill(aobasis, aobasis);
+  BOOST_CHECK_EQUAL(threec.isInCore(), true);
+
+  TCMatrix_dft threec_disk;
+  threec_disk.setMemoryLimit(1e-4, ".");
+  threec_disk.Fill(aobasis, aobasis);
+  BOOST_CHECK_EQUAL(threec_disk.isInCore(), false);
+  BOOST_CHECK_EQUAL(threec_disk.size(), threec.size());
+
+  for (Index i = 0; i < threec.size(); i++) {
+    bool check = threec[i].FullMatrix().isApprox(threec_disk[i].FullMatrix(),
+                                                 1e-10);
+    BOOST_CHECK_EQUAL(check, true);
+  }
+
+  Eigen::MatrixXd buffer;
+  Eigen::MatrixXd block = threec_disk.getAuxBlock(1, 3, buffer);
+  Eigen::MatrixXd block_ref = threec.getAuxBlock(1, 3, buffer);
+  BOOST_CHECK_EQUAL(block.isApprox(block_ref, 1e-10), true);
+}
+
 BOOST_AUTO_TEST_CASE(large_l_test) {
 
   QMMolecule mol("C", 0);
@@ -27,10 +27,12 @@
 // Local VOTCA includes
 #include "votca/xtp/aobasis.h"
 #include "votca/xtp/qmmolecule.h"
+#include "votca/xtp/rpa.h"
 #include "votca/xtp/threecenter.h"
 
 using namespace votca::xtp;
 using namespace std;
+using votca::Index;
 
 BOOST_AUTO_TEST_SUITE(threecenter_gwbse_test)
 BOOST_AUTO_TEST_CASE(threecenter_gwbse) {
@@ -123,4 +125,81 @@ BOOST_AUTO_TEST_CASE(threecenter_gwbse) {
 
   BOOST_CHECK_EQUAL(check4_after, true);
 }
+
+BOOST_AUTO_TEST_CASE(threecenter_gwbse_naf) {
+
+  QMMolecule mol(" ", 0);
+  mol.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                   "/threecenter_gwbse/molecule.xyz");
+  BasisSet basis;
+  basis.Load(std::string(XTP_TEST_DATA_FOLDER) +
+             "/threecenter_gwbse/3-21G.xml");
+  AOBasis aobasis;
+  aobasis.Fill(basis, mol);
+
+  Eigen::MatrixXd MOs = votca::tools::EigenIO_MatrixMarket::ReadMatrix(
+      std::string(XTP_TEST_DATA_FOLDER) + "/threecenter_gwbse/MOs.mm");
+
+  Logger log;
+  TCMatrix_gwbse tc{log};
+  tc.Initialize(aobasis.AOBasisSize(), 0, 5, 0, 7);
+  tc.Fill(aobasis, aobasis, MOs);
+
+  // threshold between the fourth and fifth smallest eigenvalue of the metric
+  Eigen::MatrixXd metric = Eigen::MatrixXd::Zero(tc.auxsize(), tc.auxsize());
+  for (Index m = 0; m < tc.msize(); m++) {
+    metric += tc[m].transpose() * tc[m];
+  }
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> es(metric);
+  const double threshold = 0.5 * (es.eigenvalues()(3) + es.eigenvalues()(4)) /
+                           es.eigenvalues().maxCoeff();
+  // the error of any product over the aux index is bounded by the sum of the
+  // dropped eigenvalues
+  const double dropped = es.eigenvalues().head(4).sum();
+
+  TCMatrix_gwbse tc_naf{log};
+  tc_naf.Initialize(aobasis.AOBasisSize(), 0, 5, 0, 7);
+  tc_naf.setNAFThreshold(threshold);
+  tc_naf.Fill(aobasis, aobasis, MOs);
+  BOOST_REQUIRE_EQUAL(tc_naf.auxsize(), tc.auxsize() - 4);
+
+  for (Index rebuild = 0; rebuild < 2; rebuild++) {
+    for (Index m = 0; m < tc.msize(); m++) {
+      for (Index k = 0; k < tc.msize(); k++) {
+        Eigen::MatrixXd full = tc[m] * tc[k].transpose();
+        Eigen::MatrixXd naf = tc_naf[m] * tc_naf[k].transpose();
+        BOOST_CHECK_LE((full - naf).cwiseAbs().maxCoeff(), dropped);
+      }
+    }
+    tc_naf.Rebuild();
+  }
+  BOOST_CHECK_EQUAL(tc_naf.auxsize(), tc.auxsize() - 4);
+
+  // the screened interaction M_m (epsilon^-1 - 1) M_m^T, which enters sigma,
+  // changes by less than the dropped weight
+  Eigen::VectorXd energies = Eigen::VectorXd::LinSpaced(8, -0.8, 0.6);
+  RPA rpa(log, tc);
+  rpa.configure(4, 0, 7);
+  rpa.setRPAInputEnergies(energies);
+  RPA rpa_naf(log, tc_naf);
+  rpa_naf.configure(4, 0, 7);
+  rpa_naf.setRPAInputEnergies(energies);
+  Eigen::MatrixXd screening = rpa.calculate_epsilon_i(0.5).inverse();
+  screening.diagonal().array() -= 1.0;
+  Eigen::MatrixXd screening_naf = rpa_naf.calculate_epsilon_i(0.5).inverse();
+  screening_naf.diagonal().array() -= 1.0;
+  for (Index m = 0; m < tc.msize(); m++) {
+    Eigen::MatrixXd full = tc[m] * screening * tc[m].transpose();
+    Eigen::MatrixXd naf = tc_naf[m] * screening_naf * tc_naf[m].transpose();
+    BOOST_CHECK_LE((full - naf).cwiseAbs().maxCoeff(), dropped);
+  }
+
+  // a threshold above the whole spectrum keeps the largest function
+  TCMatrix_gwbse tc_one{log};
+  tc_one.Initialize(aobasis.AOBasisSize(), 0, 5, 0, 7);
+  tc_one.setNAFThreshold(2.0);
+  tc_one.Fill(aobasis, aobasis, MOs);
+  BOOST_CHECK_EQUAL(tc_one.auxsize(), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -18,7 +18,10 @@
 #define BOOST_TEST_MODULE vxc_grid_test
 
 // Standard includes
+#include <algorithm>
+#include <array>
 #include <fstream>
+#include <limits>
 
 // Third party includes
 #include <boost/test/unit_test.hpp>
@@ -26,9 +29,11 @@
 // Local VOTCA includes
 #include "votca/xtp/orbitals.h"
 #include "votca/xtp/vxc_grid.h"
+#include "votca/xtp/vxcgridcache.h"
 
 using namespace votca::xtp;
 using namespace std;
+using votca::Index;
 
 BOOST_AUTO_TEST_SUITE(vxc_grid_test)
 
@@ -54,7 +59,183 @@ BOOST_AUTO_TEST_CASE(vxc_grid_build) {
 
   BOOST_CHECK_EQUAL(grid.getGridSize(), grid.getGridpoints().size());
   BOOST_CHECK_EQUAL(grid.getGridSize(), 53404);
-  BOOST_CHECK_EQUAL(grid.getBoxesSize(), 51);
+
+  // boxes are sorted by cost
+  double last_cost = std::numeric_limits<double>::max();
+  for (const GridBox& box : grid) {
+    BOOST_CHECK(box.Shellsize() > 0);
+    BOOST_CHECK(box.EstimatedCost() <= last_cost);
+    last_cost = box.EstimatedCost();
+  }
+
+  // every point ends up in exactly one box, independent of the box size. With
+  // a huge target size all points stay in a single box
+  Vxc_Grid single_box;
+  single_box.setTargetBoxSize(std::numeric_limits<Index>::max());
+  single_box.GridSetup("medium", mol, aobasis);
+  BOOST_CHECK_EQUAL(single_box.getBoxesSize(), 1);
+  Vxc_Grid small_boxes;
+  small_boxes.setTargetBoxSize(16);
+  small_boxes.GridSetup("medium", mol, aobasis);
+
+  auto sorted_points = [](const Vxc_Grid& g) {
+    std::vector<std::array<double, 4> > points;
+    for (const GridBox& box : g) {
+      for (Index p = 0; p < box.size(); p++) {
+        const Eigen::Vector3d& pos = box.getGridPoints()[p];
+        points.push_back({pos.x(), pos.y(), pos.z(), box.getGridWeights()[p]});
+      }
+    }
+    std::sort(points.begin(), points.end());
+    return points;
+  };
+  std::vector<std::array<double, 4> > ref = sorted_points(single_box);
+  BOOST_CHECK_EQUAL(ref.size(), 53404);
+  BOOST_CHECK(std::adjacent_find(ref.begin(), ref.end()) == ref.end());
+  BOOST_CHECK(sorted_points(grid) == ref);
+  BOOST_CHECK(sorted_points(small_boxes) == ref);
+}
+
+BOOST_AUTO_TEST_CASE(partition_screening) {
+
+  QMMolecule methane("none", 0);
+  methane.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                       "/vxc_grid/molecule.xyz");
+  // 2x2x2 methanes, so that the atoms are spread over several cells
+  QMMolecule mol("none", 0);
+  for (Index i = 0; i < 8; i++) {
+    Eigen::Vector3d shift(double(i % 2), double((i / 2) % 2), double(i / 4));
+    for (const QMAtom& atom : methane) {
+      mol.push_back(QMAtom(mol.size(), atom.getElement(),
+                           atom.getPos() + 6.5 * shift));
+    }
+  }
+  AOBasis aobasis = CreateBasis(mol);
+
+  Vxc_Grid screened;
+  screened.GridSetup("coarse", mol, aobasis);
+  Vxc_Grid full;
+  full.setPartitionScreening(false);
+  full.GridSetup("coarse", mol, aobasis);
+
+  // the boxes only depend on the points, so both grids have the same boxes
+  BOOST_REQUIRE_EQUAL(screened.getGridSize(), full.getGridSize());
+  BOOST_REQUIRE_EQUAL(screened.getBoxesSize(), full.getBoxesSize());
+  double max_diff = 0.0;
+  double max_weight = 0.0;
+  for (Index i = 0; i < screened.getBoxesSize(); i++) {
+    const GridBox& box = screened[i];
+    const GridBox& box_full = full[i];
+    BOOST_REQUIRE_EQUAL(box.size(), box_full.size());
+    for (Index p = 0; p < box.size(); p++) {
+      BOOST_CHECK(box.getGridPoints()[p].isApprox(box_full.getGridPoints()[p],
+                                                  1e-14));
+      max_diff = std::max(max_diff, std::abs(box.getGridWeights()[p] -
+                                             box_full.getGridWeights()[p]));
+      max_weight = std::max(max_weight, box_full.getGridWeights()[p]);
+    }
+  }
+  BOOST_CHECK_SMALL(max_diff / max_weight, 1e-11);
+}
+
+BOOST_AUTO_TEST_CASE(gridbox_aovalues) {
+
+  QMMolecule mol("none", 0);
+
+  mol.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                   "/vxc_grid/molecule.xyz");
+  AOBasis aobasis = CreateBasis(mol);
+
+  Vxc_Grid grid;
+  grid.GridSetup("medium", mol, aobasis);
+
+  for (Index i = 0; i < grid.getBoxesSize(); i++) {
+    const GridBox& box = grid[i];
+    AOValues ao = box.CalcAOValues_and_Grad();
+    BOOST_CHECK_EQUAL(ao.values.rows(), box.size());
+    BOOST_CHECK_EQUAL(ao.values.cols(), box.Matrixsize());
+    for (Index p = 0; p < box.size(); p++) {
+      Eigen::MatrixX3d ao_grad = Eigen::MatrixX3d::Zero(box.Matrixsize(), 3);
+      Eigen::VectorXd ao_ref =
+          box.CalcAOValue_and_Grad(ao_grad, box.getGridPoints()[p]);
+      bool check_values = ao.values.row(p).transpose().isApprox(ao_ref, 1e-10);
+      bool check_grad_x =
+          ao.derivatives_x.row(p).transpose().isApprox(ao_grad.col(0), 1e-10);
+      bool check_grad_y =
+          ao.derivatives_y.row(p).transpose().isApprox(ao_grad.col(1), 1e-10);
+      bool check_grad_z =
+          ao.derivatives_z.row(p).transpose().isApprox(ao_grad.col(2), 1e-10);
+      BOOST_CHECK_EQUAL(check_values, true);
+      BOOST_CHECK_EQUAL(check_grad_x, true);
+      BOOST_CHECK_EQUAL(check_grad_y, true);
+      BOOST_CHECK_EQUAL(check_grad_z, true);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ao_cache) {
+
+  QMMolecule mol("none", 0);
+
+  mol.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                   "/vxc_grid/molecule.xyz");
+  AOBasis aobasis = CreateBasis(mol);
+
+  Vxc_Grid grid;
+  grid.GridSetup("medium", mol, aobasis);
+  BOOST_CHECK_EQUAL(grid.CacheAOValues(0.0, false), 0);
+
+  Vxc_Grid grid_single = grid;
+  BOOST_CHECK_EQUAL(grid.CacheAOValues(1e6, false), grid.getBoxesSize());
+  BOOST_CHECK_EQUAL(grid_single.CacheAOValues(1e6, true),
+                    grid_single.getBoxesSize());
+  for (Index i = 0; i < grid.getBoxesSize(); i++) {
+    BOOST_CHECK(grid[i].hasAOCache());
+    AOValues ref = grid[i].CalcAOValues_and_Grad();
+    AOValues cached = grid[i].getAOValues();
+    BOOST_CHECK(cached.values.isApprox(ref.values, 1e-14));
+    BOOST_CHECK(cached.derivatives_z.isApprox(ref.derivatives_z, 1e-14));
+    AOValues single = grid_single[i].getAOValues();
+    BOOST_CHECK(single.values.isApprox(ref.values, 1e-6));
+    BOOST_CHECK(single.derivatives_x.isApprox(ref.derivatives_x, 1e-6));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(grid_reuse) {
+
+  QMMolecule mol("none", 0);
+
+  mol.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                   "/vxc_grid/molecule.xyz");
+  VxcGridCache& cache = VxcGridCache::Instance();
+  cache.Clear();
+
+  Vxc_Grid grid;
+  {
+    AOBasis aobasis = CreateBasis(mol);
+    grid.GridSetup("medium", mol, aobasis);
+    grid.CacheAOValues(1000.0, false);
+    cache.Add("medium", "3-21G", mol, grid);
+  }
+  AOBasis aobasis = CreateBasis(mol);
+  Vxc_Grid reused;
+  BOOST_CHECK(!cache.Find("fine", "3-21G", mol, aobasis, reused));
+  BOOST_CHECK(cache.Find("medium", "3-21G", mol, aobasis, reused));
+  BOOST_CHECK_EQUAL(reused.getGridSize(), 53404);
+  // AO values stay with the grid that cached them
+  BOOST_CHECK(grid[0].hasAOCache());
+  BOOST_CHECK(!reused[0].hasAOCache());
+
+  grid.RebindShells(aobasis);
+  for (Index i = 0; i < grid.getBoxesSize(); i++) {
+    AOValues ref = grid[i].CalcAOValues_and_Grad();
+    AOValues ao = reused[i].CalcAOValues_and_Grad();
+    BOOST_CHECK(ao.values.isApprox(ref.values, 1e-14));
+  }
+
+  mol[0].setPos(mol[0].getPos() + Eigen::Vector3d(0.1, 0, 0));
+  BOOST_CHECK(!cache.Find("medium", "3-21G", mol, aobasis, reused));
+  cache.Clear();
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -64,7 +64,6 @@ BOOST_AUTO_TEST_CASE(vxc_test) {
 
   BOOST_CHECK_EQUAL(grid.getGridSize(), grid.getGridpoints().size());
   BOOST_CHECK_EQUAL(grid.getGridSize(), 53404);
-  BOOST_CHECK_EQUAL(grid.getBoxesSize(), 51);
 
   BOOST_CHECK_CLOSE(num.getExactExchange("XC_GGA_X_PBE XC_GGA_C_PBE"), 0.0,
                     1e-5);
@@ -86,4 +85,41 @@ BOOST_AUTO_TEST_CASE(vxc_test) {
   BOOST_CHECK_EQUAL(check_vxc, 1);
 }
 
+BOOST_AUTO_TEST_CASE(vxc_polarized_test) {
+
+  QMMolecule mol("none", 0);
+
+  mol.LoadFromFile(std::string(XTP_TEST_DATA_FOLDER) +
+                   "/vxc_potential/molecule.xyz");
+  AOBasis aobasis = CreateBasis(mol);
+
+  Eigen::MatrixXd dmat = DMat();
+  Vxc_Grid grid;
+  grid.GridSetup("medium", mol, aobasis);
+  Vxc_Potential<Vxc_Grid> num(grid);
+  num.setXCfunctional("XC_GGA_X_PBE XC_GGA_C_PBE");
+
+  // equal spin densities have to reproduce the unpolarized potential
+  std::array<Mat_p_Energy, 2> e_vxc =
+      num.IntegrateVXC(0.5 * dmat, 0.5 * dmat);
+
+  Eigen::MatrixXd vxc_ref = votca::tools::EigenIO_MatrixMarket::ReadMatrix(
+      std::string(XTP_TEST_DATA_FOLDER) + "/vxc_potential/vxc_ref.mm");
+
+  BOOST_CHECK_CLOSE(e_vxc[0].energy(), -4.6303432151572643, 1e-5);
+  BOOST_CHECK_SMALL(e_vxc[1].energy(), 1e-12);
+  bool check_alpha = e_vxc[0].matrix().isApprox(vxc_ref, 0.0001);
+  bool check_beta = e_vxc[1].matrix().isApprox(vxc_ref, 0.0001);
+  if (!check_alpha || !check_beta) {
+    std::cout << "ref" << std::endl;
+    std::cout << vxc_ref << std::endl;
+    std::cout << "calc alpha" << std::endl;
+    std::cout << e_vxc[0].matrix() << std::endl;
+    std::cout << "calc beta" << std::endl;
+    std::cout << e_vxc[1].matrix() << std::endl;
+  }
+  BOOST_CHECK_EQUAL(check_alpha, 1);
+  BOOST_CHECK_EQUAL(check_beta, 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()